@@ -0,0 +1,122 @@
+// Gmsh - Copyright (C) 1997-2019 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
+
+#include <algorithm>
+#include "BoundingBoxTree.h"
+
+class centerLessThan {
+private:
+  const std::vector<double> &_bbs;
+  int _axis;
+
+public:
+  centerLessThan(const std::vector<double> &bbs, int axis)
+    : _bbs(bbs), _axis(axis)
+  {
+  }
+  bool operator()(int a, int b) const
+  {
+    double ca = _bbs[6 * a + _axis] + _bbs[6 * a + 3 + _axis];
+    double cb = _bbs[6 * b + _axis] + _bbs[6 * b + 3 + _axis];
+    if(ca != cb) return ca < cb;
+    return a < b;
+  }
+};
+
+void BoundingBoxTree::build(const std::vector<double> &bbs)
+{
+  _bbs = bbs;
+  const int n = (int)size();
+  _order.resize(n);
+  for(int i = 0; i < n; i++) _order[i] = i;
+  _nodes.clear();
+  if(!n) return;
+
+  // create the tree level by level, splitting the nodes of each level in
+  // parallel (the nodes of a level cover disjoint ranges of _order)
+  std::vector<int> levels(1, 0);
+  _nodes.resize(1);
+  _nodes[0].begin = 0;
+  _nodes[0].end = n;
+  while(true) {
+    const int first = levels.back(), last = (int)_nodes.size();
+    bool split = false;
+    for(int i = first; i < last; i++) {
+      if(_nodes[i].end - _nodes[i].begin > _maxBoxesPerLeaf) split = true;
+    }
+    if(!split) break;
+    _nodes.resize(2 * last + 1);
+    levels.push_back(last);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int i = first; i < last; i++) {
+      const int b = _nodes[i].begin, e = _nodes[i].end;
+      node &left = _nodes[2 * i + 1], &right = _nodes[2 * i + 2];
+      if(e - b <= _maxBoxesPerLeaf) {
+        left.begin = left.end = right.begin = right.end = 0;
+        continue;
+      }
+      // split along the largest extent of the box centers
+      double cmin[3], cmax[3];
+      for(int k = 0; k < 3; k++) {
+        cmin[k] = _bbs[6 * _order[b] + k] + _bbs[6 * _order[b] + 3 + k];
+        cmax[k] = cmin[k];
+      }
+      for(int j = b + 1; j < e; j++) {
+        for(int k = 0; k < 3; k++) {
+          double c = _bbs[6 * _order[j] + k] + _bbs[6 * _order[j] + 3 + k];
+          cmin[k] = std::min(cmin[k], c);
+          cmax[k] = std::max(cmax[k], c);
+        }
+      }
+      int axis = 0;
+      for(int k = 1; k < 3; k++)
+        if(cmax[k] - cmin[k] > cmax[axis] - cmin[axis]) axis = k;
+      const int mid = (b + e) / 2;
+      std::nth_element(_order.begin() + b, _order.begin() + mid,
+                       _order.begin() + e, centerLessThan(_bbs, axis));
+      left.begin = b;
+      left.end = mid;
+      right.begin = mid;
+      right.end = e;
+    }
+  }
+
+  // compute the bounding boxes of the nodes, from the leaves up
+  for(int l = (int)levels.size() - 1; l >= 0; l--) {
+    const int first = levels[l];
+    const int last =
+      (l + 1 < (int)levels.size()) ? levels[l + 1] : (int)_nodes.size();
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+    for(int i = first; i < last; i++) {
+      node &n = _nodes[i];
+      if(n.begin == n.end) continue;
+      if(n.end - n.begin <= _maxBoxesPerLeaf) {
+        const double *bb0 = &_bbs[6 * _order[n.begin]];
+        for(int k = 0; k < 3; k++) {
+          n.min[k] = bb0[k];
+          n.max[k] = bb0[3 + k];
+        }
+        for(int j = n.begin + 1; j < n.end; j++) {
+          const double *bb = &_bbs[6 * _order[j]];
+          for(int k = 0; k < 3; k++) {
+            n.min[k] = std::min(n.min[k], bb[k]);
+            n.max[k] = std::max(n.max[k], bb[3 + k]);
+          }
+        }
+      }
+      else {
+        const node &left = _nodes[2 * i + 1], &right = _nodes[2 * i + 2];
+        for(int k = 0; k < 3; k++) {
+          n.min[k] = std::min(left.min[k], right.min[k]);
+          n.max[k] = std::max(left.max[k], right.max[k]);
+        }
+      }
+    }
+  }
+}
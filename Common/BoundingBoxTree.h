@@ -0,0 +1,64 @@
+// Gmsh - Copyright (C) 1997-2019 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
+
+#ifndef _BOUNDING_BOX_TREE_
+#define _BOUNDING_BOX_TREE_
+
+#include <vector>
+#include <cstddef>
+
+// Bounding volume hierarchy of axis-aligned boxes, used to locate the boxes
+// containing a point. The tree is built in parallel and is never modified
+// afterwards, so that searches can be performed concurrently.
+class BoundingBoxTree {
+private:
+  // node covering the boxes _order[begin, end); the children of node i are
+  // nodes 2 * i + 1 and 2 * i + 2 (nodes are split at the median, so that the
+  // shape of the tree only depends on the number of boxes)
+  struct node {
+    int begin, end;
+    double min[3], max[3];
+  };
+  static const int _maxBoxesPerLeaf = 8; // memory vs. speed trade-off
+  std::vector<double> _bbs;
+  std::vector<int> _order;
+  std::vector<node> _nodes;
+  static bool _inBox(const double *min, const double *max, const double P[3])
+  {
+    return P[0] >= min[0] && P[0] <= max[0] && P[1] >= min[1] &&
+           P[1] <= max[1] && P[2] >= min[2] && P[2] <= max[2];
+  }
+
+public:
+  // build the tree from boxes given by their min and max corners (6 values
+  // per box: xmin, ymin, zmin, xmax, ymax, zmax)
+  void build(const std::vector<double> &bbs);
+  std::size_t size() const { return _bbs.size() / 6; }
+  // call f(i) for each box i containing the point P, in no particular order
+  template <class F> void search(const double P[3], F &f) const
+  {
+    if(_nodes.empty()) return;
+    // the depth of the tree is at most log2(number of boxes) + 1, and the 2
+    // children of a node are pushed after it has been popped
+    int stack[128], top = 0;
+    stack[top++] = 0;
+    while(top) {
+      const int i = stack[--top];
+      const node &n = _nodes[i];
+      if(n.begin == n.end || !_inBox(n.min, n.max, P)) continue;
+      if(n.end - n.begin > _maxBoxesPerLeaf) {
+        stack[top++] = 2 * i + 2;
+        stack[top++] = 2 * i + 1;
+        continue;
+      }
+      for(int j = n.begin; j < n.end; j++) {
+        const int k = _order[j];
+        if(_inBox(&_bbs[6 * k], &_bbs[6 * k + 3], P)) f(k);
+      }
+    }
+  }
+};
+
+#endif
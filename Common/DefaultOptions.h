@@ -1242,7 +1242,9 @@ StringXNumber MeshOptions_Number[] = {
   { F|O, "RefineSteps" , opt_mesh_refine_steps , 10 ,
     "Number of refinement steps in the MeshAdapt-based 2D algorithms" },
   { F|O, "Renumber" , opt_mesh_renumber , 1 ,
-    "Renumber nodes and elements in a continuous sequence after mesh generation" },
+    "Renumber nodes and elements in a continuous sequence after mesh generation "
+    "(0: no renumbering, 1: entity by entity, 2: along a Hilbert curve in each "
+    "entity, 3: along a Hilbert curve across all entities)" },
 
   { F,   "SaveAll" , opt_mesh_save_all , 0. ,
     "Save all elements, even if they don't belong to physical groups" },
@@ -1405,6 +1407,11 @@ StringXNumber PostProcessingOptions_Number[] = {
     "Save the mesh when exporting model-based data" },
   { F|O, "Smoothing" , opt_post_smooth , 0. ,
     "Apply (non-reversible) smoothing to post-processing view when merged" },
+  { F|O, "StepMemoryLimit" , opt_post_step_memory_limit , 0. ,
+    "Maximum memory (in Mb) used by the time steps of model-based views merged "
+    "from MSH files (0: no limit). If non-zero, the values of the time steps are "
+    "only read from the files when they are accessed, and the least recently "
+    "accessed time steps are unloaded when the limit is exceeded" },
 
   { 0, 0 , 0 , 0. }
 } ;
@@ -5,10 +5,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 
 #include "MallocUtils.h"
 #include "GmshMessage.h"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 void *Malloc(size_t size)
 {
   void *ptr;
@@ -42,3 +47,133 @@ void Free(void *ptr)
   if(ptr == NULL) return;
   free(ptr);
 }
+
+class MemoryPool::subPool {
+public:
+  struct freeBlock {
+    freeBlock *next;
+  };
+  std::vector<char *> slabs;
+  freeBlock *freeList;
+  char *current, *end;
+#if defined(_OPENMP)
+  omp_lock_t lock;
+#endif
+  subPool() : freeList(0), current(0), end(0)
+  {
+#if defined(_OPENMP)
+    omp_init_lock(&lock);
+#endif
+  }
+  ~subPool()
+  {
+    clear();
+#if defined(_OPENMP)
+    omp_destroy_lock(&lock);
+#endif
+  }
+  void clear()
+  {
+    for(std::size_t i = 0; i < slabs.size(); i++) free(slabs[i]);
+    slabs.clear();
+    freeList = 0;
+    current = end = 0;
+  }
+};
+
+MemoryPool::MemoryPool(size_t blockSize, size_t blocksPerSlab)
+  : _blocksPerSlab(blocksPerSlab), _numAllocated(0)
+{
+  // make sure all blocks are suitably aligned
+  const size_t align = 2 * sizeof(void *);
+  _blockSize = ((blockSize + align - 1) / align) * align;
+#if defined(_OPENMP)
+  int n = std::max(omp_get_num_procs(), omp_get_max_threads());
+#else
+  int n = 1;
+#endif
+  for(int i = 0; i < n; i++) _subPools.push_back(new subPool());
+}
+
+MemoryPool::~MemoryPool()
+{
+  for(std::size_t i = 0; i < _subPools.size(); i++) delete _subPools[i];
+}
+
+MemoryPool::subPool *MemoryPool::_getSubPool()
+{
+#if defined(_OPENMP)
+  subPool *p = _subPools[omp_get_thread_num() % _subPools.size()];
+  omp_set_lock(&p->lock);
+  return p;
+#else
+  return _subPools[0];
+#endif
+}
+
+void *MemoryPool::allocate()
+{
+  subPool *p = _getSubPool();
+  void *ptr;
+  if(p->freeList) {
+    ptr = p->freeList;
+    p->freeList = p->freeList->next;
+  }
+  else {
+    if(p->current == p->end) {
+      char *slab = (char *)Malloc(_blockSize * _blocksPerSlab);
+      p->slabs.push_back(slab);
+      p->current = slab;
+      p->end = slab + _blockSize * _blocksPerSlab;
+    }
+    ptr = p->current;
+    p->current += _blockSize;
+  }
+#if defined(_OPENMP)
+  omp_unset_lock(&p->lock);
+#endif
+#if __cplusplus >= 201103L
+  _numAllocated++;
+#else
+#if defined(_OPENMP)
+#pragma omp atomic
+#endif
+  _numAllocated++;
+#endif
+  return ptr;
+}
+
+void MemoryPool::deallocate(void *ptr)
+{
+  if(!ptr) return;
+  // blocks are pushed on the free list of the calling thread, whatever the
+  // sub-pool they were allocated from
+  subPool *p = _getSubPool();
+  subPool::freeBlock *b = (subPool::freeBlock *)ptr;
+  b->next = p->freeList;
+  p->freeList = b;
+#if defined(_OPENMP)
+  omp_unset_lock(&p->lock);
+#endif
+  long left;
+#if __cplusplus >= 201103L
+  left = --_numAllocated;
+#else
+#if defined(_OPENMP)
+#pragma omp atomic capture
+#endif
+  left = --_numAllocated;
+#endif
+  // release all the memory at once when the last block is freed (only outside
+  // of parallel regions, where no other thread can be using the pool)
+#if defined(_OPENMP)
+  if(!left && !omp_in_parallel()) _release();
+#else
+  if(!left) _release();
+#endif
+}
+
+void MemoryPool::_release()
+{
+  for(std::size_t i = 0; i < _subPools.size(); i++) _subPools[i]->clear();
+}
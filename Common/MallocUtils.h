@@ -7,10 +7,43 @@
 #define _MALLOC_UTILS_H_
 
 #include <stdlib.h>
+#include <vector>
+#if __cplusplus >= 201103L
+#include <atomic>
+#endif
 
 void *Malloc(size_t size);
 void *Calloc(size_t num, size_t size);
 void *Realloc(void *ptr, size_t size);
 void Free(void *ptr);
 
+// A pool of fixed-size memory blocks, carved out of large contiguous slabs:
+// this avoids the per-object overhead of malloc for the millions of small
+// objects (mesh nodes and elements) created during mesh generation, and keeps
+// objects created together close in memory. Freed blocks are recycled, and all
+// the slabs are released at once when the last block is freed. Each thread
+// allocates from its own sub-pool, so that concurrent allocations do not
+// contend on a single lock.
+class MemoryPool {
+private:
+  class subPool;
+  size_t _blockSize, _blocksPerSlab;
+  std::vector<subPool *> _subPools;
+#if __cplusplus >= 201103L
+  std::atomic<long> _numAllocated;
+#else
+  long _numAllocated;
+#endif
+  subPool *_getSubPool();
+  void _release();
+
+public:
+  MemoryPool(size_t blockSize, size_t blocksPerSlab = 4096);
+  ~MemoryPool();
+  size_t getBlockSize() const { return _blockSize; }
+  long getNumAllocated() const { return _numAllocated; }
+  void *allocate();
+  void deallocate(void *ptr);
+};
+
 #endif
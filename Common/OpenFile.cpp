@@ -518,7 +518,9 @@ int MergeFile(const std::string &fileName, bool warnIfMissing,
       }
       mesh = true;
 #if defined(HAVE_POST)
-      if(status > 1) status = PView::readMSH(fileName, -1, partitionToRead);
+      if(status > 1)
+        status = PView::readMSH(fileName, -1, partitionToRead,
+                                CTX::instance()->post.stepMemoryLimit > 0.);
 #endif
     }
 #if defined(HAVE_POST)
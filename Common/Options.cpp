@@ -6798,6 +6798,13 @@ double opt_post_save_mesh(OPT_ARGS_NUM)
   return CTX::instance()->post.saveMesh;
 }
 
+double opt_post_step_memory_limit(OPT_ARGS_NUM)
+{
+  if(action & GMSH_SET)
+    CTX::instance()->post.stepMemoryLimit = (val > 0.) ? val : 0.;
+  return CTX::instance()->post.stepMemoryLimit;
+}
+
 double opt_post_save_interpolation_matrices(OPT_ARGS_NUM)
 {
   if(action & GMSH_SET)
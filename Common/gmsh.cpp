@@ -9,6 +9,7 @@
 #include "GmshGlobal.h"
 #include "MallocUtils.h"
 #include "GModel.h"
+#include "GModelMeshSnapshot.h"
 #include "GModelIO_GEO.h"
 #include "GModelIO_OCC.h"
 #include "GVertex.h"
@@ -897,6 +898,7 @@ GMSH_API void gmsh::model::mesh::splitQuadrangles(const double quality,
     GFace *gf = static_cast<GFace*>(entities[i]);
     quadsToTriangles(gf, quality);
   }
+  GModel::current()->destroyMeshCaches();
   CTX::instance()->mesh.changed = ENT_ALL;
 #else
   Msg::Error("splitQuadrangles requires the mesh module");
@@ -1014,6 +1016,13 @@ GMSH_API void gmsh::model::mesh::getNodes(std::vector<std::size_t> &nodeTags,
   nodeTags.clear();
   coord.clear();
   parametricCoord.clear();
+  if(dim < 0 && !includeBoundary) {
+    // all the nodes: copy the contiguous snapshot of the mesh
+    const GModelMeshSnapshot *snapshot = GModel::current()->getMeshSnapshot();
+    nodeTags = snapshot->getNodeTags();
+    coord = snapshot->getCoordinates();
+    return;
+  }
   std::vector<GEntity *> entities;
   if(dim >= 0 && tag >= 0) {
     GEntity *ge = GModel::current()->getEntityByTag(dim, tag);
@@ -1047,6 +1056,14 @@ GMSH_API void gmsh::model::mesh::getNodes(std::vector<std::size_t> &nodeTags,
   }
 }
 
+GMSH_API int gmsh::model::mesh::getVersion()
+{
+  if(!_isInitialized()) {
+    throw -1;
+  }
+  return GModel::current()->getMeshVersion();
+}
+
 GMSH_API void gmsh::model::mesh::getNode(const std::size_t nodeTag,
                                          std::vector<double> &coord,
                                          std::vector<double> &parametricCoord)
@@ -1179,6 +1196,7 @@ GMSH_API void gmsh::model::mesh::relocateNodes(const int dim,
   }
   for(std::size_t i = 0; i < entities.size(); i++)
     entities[i]->relocateMeshVertices();
+  GModel::current()->destroyMeshCaches();
 }
 
 static void _getEntitiesForElementTypes(
@@ -1444,6 +1462,7 @@ GMSH_API void gmsh::model::mesh::setElementsByType(
     throw 2;
   }
   _addElements(dim, tag, ge, elementType, elementTags, nodeTags);
+  GModel::current()->destroyMeshCaches();
 }
 
 GMSH_API void gmsh::model::mesh::getElementTypes(std::vector<int> &elementTypes,
@@ -1521,10 +1540,17 @@ gmsh::model::mesh::getElementsByType(const int elementType,
   }
   int dim = ElementType::getDimension(elementType);
   std::map<int, std::vector<GEntity *> > typeEnt;
-  _getEntitiesForElementTypes(dim, tag, typeEnt);
+  // for all the elements of the given type, use the contiguous snapshot of
+  // the mesh; with several tasks, which can be called concurrently, the
+  // snapshot is not built here, but by preallocateElementsByType()
+  const GModelMeshSnapshot *snapshot = 0;
+  if(tag < 0) snapshot = GModel::current()->getMeshSnapshot(numTasks <= 1);
+  if(!snapshot) _getEntitiesForElementTypes(dim, tag, typeEnt);
   const std::vector<GEntity *> &entities(typeEnt[elementType]);
   int familyType = ElementType::getParentType(elementType);
   std::size_t numElements = 0;
+  if(snapshot)
+    numElements = snapshot->getElementTags(elementType).size();
   for(std::size_t i = 0; i < entities.size(); i++)
     numElements += entities[i]->getNumMeshElementsByType(familyType);
   const int numNodes = ElementType::getNumVertices(elementType);
@@ -1555,6 +1581,18 @@ gmsh::model::mesh::getElementsByType(const int elementType,
                numElements * numNodes);
     throw 4;
   }
+  if(snapshot) {
+    const std::vector<std::size_t> &e = snapshot->getElementTags(elementType);
+    const std::vector<std::size_t> &n =
+      snapshot->getElementNodeTags(elementType);
+    if(haveElementTags)
+      std::copy(e.begin() + begin, e.begin() + end,
+                elementTags.begin() + begin);
+    if(haveNodeTags)
+      std::copy(n.begin() + begin * numNodes, n.begin() + end * numNodes,
+                nodeTags.begin() + begin * numNodes);
+    return;
+  }
   size_t o = 0;
   size_t idx = begin * numNodes;
   for(std::size_t i = 0; i < entities.size(); i++) {
@@ -1585,10 +1623,17 @@ GMSH_API void gmsh::model::mesh::preallocateElementsByType(
   }
   int dim = ElementType::getDimension(elementType);
   std::map<int, std::vector<GEntity *> > typeEnt;
-  _getEntitiesForElementTypes(dim, tag, typeEnt);
+  // build the snapshot of the mesh used by getElementsByType() for all the
+  // entities
+  const GModelMeshSnapshot *snapshot = 0;
+  if(tag < 0)
+    snapshot = GModel::current()->getMeshSnapshot();
+  else
+    _getEntitiesForElementTypes(dim, tag, typeEnt);
   const std::vector<GEntity *> &entities(typeEnt[elementType]);
   int familyType = ElementType::getParentType(elementType);
   std::size_t numElements = 0;
+  if(snapshot) numElements = snapshot->getElementTags(elementType).size();
   for(std::size_t i = 0; i < entities.size(); i++)
     numElements += entities[i]->getNumMeshElementsByType(familyType);
   const int numNodesPerEle = ElementType::getNumVertices(elementType);
@@ -2485,22 +2530,32 @@ gmsh::model::mesh::reorderElements(const int elementType, const int tag,
       throw 3;
     }
   }
+  GModel::current()->destroyMeshCaches();
+}
+
+static int _getRenumberingMethod(const std::string &method)
+{
+  if(method.empty()) return 0;
+  if(method == "Hilbert") return 1;
+  if(method == "HilbertGlobal") return 2;
+  Msg::Error("Unknown renumbering method '%s'", method.c_str());
+  throw 2;
 }
 
-GMSH_API void gmsh::model::mesh::renumberNodes()
+GMSH_API void gmsh::model::mesh::renumberNodes(const std::string &method)
 {
   if(!_isInitialized()) {
     throw -1;
   }
-  GModel::current()->renumberMeshVertices();
+  GModel::current()->renumberMeshVertices(_getRenumberingMethod(method));
 }
 
-GMSH_API void gmsh::model::mesh::renumberElements()
+GMSH_API void gmsh::model::mesh::renumberElements(const std::string &method)
 {
   if(!_isInitialized()) {
     throw -1;
   }
-  GModel::current()->renumberMeshElements();
+  GModel::current()->renumberMeshElements(_getRenumberingMethod(method));
 }
 
 GMSH_API void
@@ -2601,6 +2656,7 @@ GMSH_API void gmsh::model::mesh::classifySurfaces(const double angle,
     throw -1;
   }
   GModel::current()->classifyAllFaces(angle, boundary);
+  GModel::current()->destroyMeshCaches();
 }
 
 GMSH_API void gmsh::model::mesh::createTopology()
@@ -2609,6 +2665,7 @@ GMSH_API void gmsh::model::mesh::createTopology()
     throw -1;
   }
   GModel::current()->createTopologyFromMesh();
+  GModel::current()->destroyMeshCaches();
 }
 
 GMSH_API void gmsh::model::mesh::createGeometry()
@@ -2617,6 +2674,7 @@ GMSH_API void gmsh::model::mesh::createGeometry()
     throw -1;
   }
   GModel::current()->createGeometryOfDiscreteEntities();
+  GModel::current()->destroyMeshCaches();
 }
 
 GMSH_API void
@@ -4153,23 +4211,18 @@ GMSH_API void gmsh::view::getModelData(const int tag, const int step,
   data.clear();
   time = s->getTime();
   numComponents = s->getNumComponents();
-  int numEnt = 0;
-  for(std::size_t i = 0; i < s->getNumData(); i++) {
-    if(s->getData(i)) numEnt++;
-  }
+  std::vector<int> entTags;
+  s->getTags(entTags);
+  int numEnt = entTags.size();
   if(!numEnt) return;
   data.resize(numEnt);
   tags.resize(numEnt);
-  std::size_t j = 0;
-  for(std::size_t i = 0; i < s->getNumData(); i++) {
-    double *dd = s->getData(i);
-    if(dd) {
-      tags[j] = i;
-      int mult = s->getMult(i);
-      data[j].resize(numComponents * mult);
-      for(int k = 0; k < numComponents * mult; k++) data[j][k] = dd[k];
-      j++;
-    }
+  for(int j = 0; j < numEnt; j++) {
+    double *dd = s->getData(entTags[j]);
+    tags[j] = entTags[j];
+    int mult = s->getMult(entTags[j]);
+    data[j].resize(numComponents * mult);
+    for(int k = 0; k < numComponents * mult; k++) data[j][k] = dd[k];
   }
 #else
   Msg::Error("Views require the post-processing module");
@@ -4222,27 +4275,22 @@ GMSH_API void gmshViewGetModelData(const int tag, const int step, char **dataTyp
   *data_nn = 0;
   *time = s->getTime();
   *numComponents = s->getNumComponents();
-  int numEnt = 0;
-  for(size_t i = 0; i < s->getNumData(); i++) {
-    if(s->getData(i)) numEnt++;
-  }
+  std::vector<int> entTags;
+  s->getTags(entTags);
+  int numEnt = entTags.size();
   if(!numEnt) return;
   *tags_n = numEnt;
   *tags = (size_t *)Malloc(numEnt * sizeof(int));
   *data_nn = numEnt;
   *data_n = (size_t *)Malloc(numEnt * sizeof(size_t *));
   *data = (double **)Malloc(numEnt * sizeof(double *));
-  size_t j = 0;
-  for(size_t i = 0; i < s->getNumData(); i++) {
-    double *dd = s->getData(i);
-    if(dd) {
-      (*tags)[j] = i;
-      int mult = s->getMult(i);
-      (*data_n)[j] = *numComponents * mult;
-      (*data)[j] = (double *)Malloc(*numComponents * mult * sizeof(double));
-      for(int k = 0; k < *numComponents * mult; k++) (*data)[j][k] = dd[k];
-      j++;
-    }
+  for(int j = 0; j < numEnt; j++) {
+    double *dd = s->getData(entTags[j]);
+    (*tags)[j] = entTags[j];
+    int mult = s->getMult(entTags[j]);
+    (*data_n)[j] = *numComponents * mult;
+    (*data)[j] = (double *)Malloc(*numComponents * mult * sizeof(double));
+    for(int k = 0; k < *numComponents * mult; k++) (*data)[j][k] = dd[k];
   }
   if(ierr) *ierr = 0;
 #else
@@ -0,0 +1,128 @@
+// Gmsh - Copyright (C) 1997-2019 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include "DuplicatePoints.h"
+#include "SBoundingBox3d.h"
+
+// uniform grid of cells of size at least 2 * tolerance, so that duplicates of a
+// point can only be in the same cell or in one of its 26 neighbors; the points
+// are stored as (cell key, point index) pairs, sorted by key then by index
+class pointGrid {
+private:
+  // the 3 cell indices are packed in a 64 bit key
+  static const int64_t _maxCells = (int64_t)1 << 20;
+  const std::vector<SPoint3> &_points;
+  double _tol, _h, _min[3];
+  std::vector<std::pair<uint64_t, std::size_t> > _cells;
+  void _getCell(const SPoint3 &p, int64_t c[3]) const
+  {
+    for(int k = 0; k < 3; k++) {
+      c[k] = (int64_t)((p[k] - _min[k]) / _h);
+      c[k] = std::min(std::max(c[k], (int64_t)0), _maxCells - 1);
+    }
+  }
+  static uint64_t _key(const int64_t c[3])
+  {
+    return (uint64_t)c[0] | ((uint64_t)c[1] << 21) | ((uint64_t)c[2] << 42);
+  }
+  bool _close(std::size_t i, std::size_t j) const
+  {
+    const SPoint3 &p = _points[i], &q = _points[j];
+    return std::abs(p.x() - q.x()) <= 2 * _tol &&
+           std::abs(p.y() - q.y()) <= 2 * _tol &&
+           std::abs(p.z() - q.z()) <= 2 * _tol;
+  }
+
+public:
+  pointGrid(const std::vector<SPoint3> &points, double tolerance)
+    : _points(points), _tol(tolerance)
+  {
+    SBoundingBox3d bbox;
+    for(std::size_t i = 0; i < points.size(); i++) bbox += points[i];
+    // larger cells are still correct (with more candidates to check): use
+    // them if the tolerance is too small to index all the cells
+    _h = 2 * _tol;
+    for(int k = 0; k < 3; k++) {
+      _min[k] = bbox.min()[k];
+      _h = std::max(_h, (bbox.max()[k] - bbox.min()[k]) / (_maxCells - 1));
+    }
+    if(_h <= 0.) _h = 1.;
+
+    const int n = (int)points.size();
+    _cells.resize(n);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+    for(int i = 0; i < n; i++) {
+      int64_t c[3];
+      _getCell(points[i], c);
+      _cells[i] = std::make_pair(_key(c), (std::size_t)i);
+    }
+    std::sort(_cells.begin(), _cells.end());
+  }
+  // smallest index j < i of a point close to point i (and kept, if kept is
+  // provided), or i if there is none
+  std::size_t findEarlier(std::size_t i, const std::vector<char> *kept) const
+  {
+    int64_t c[3];
+    _getCell(_points[i], c);
+    std::size_t best = i;
+    for(int dx = -1; dx <= 1; dx++) {
+      for(int dy = -1; dy <= 1; dy++) {
+        for(int dz = -1; dz <= 1; dz++) {
+          int64_t nc[3] = {c[0] + dx, c[1] + dy, c[2] + dz};
+          bool inside = true;
+          for(int k = 0; k < 3; k++)
+            if(nc[k] < 0 || nc[k] >= _maxCells) inside = false;
+          if(!inside) continue;
+          uint64_t key = _key(nc);
+          std::vector<std::pair<uint64_t, std::size_t> >::const_iterator it =
+            std::lower_bound(_cells.begin(), _cells.end(),
+                             std::make_pair(key, (std::size_t)0));
+          for(; it != _cells.end() && it->first == key; ++it) {
+            std::size_t j = it->second;
+            if(j >= best) break;
+            if((!kept || (*kept)[j]) && _close(i, j)) best = j;
+          }
+        }
+      }
+    }
+    return best;
+  }
+};
+
+std::size_t FindDuplicatePoints(const std::vector<SPoint3> &points,
+                                double tolerance,
+                                std::vector<std::size_t> &rep)
+{
+  rep.resize(points.size());
+  if(points.empty()) return 0;
+
+  pointGrid grid(points, tolerance);
+
+  // find the first point close to each point in parallel: in most cases this
+  // is the replacement point
+  const int n = (int)points.size();
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+  for(int i = 0; i < n; i++) rep[i] = grid.findEarlier(i, 0);
+
+  // decide which points are kept by traversing them in order; the search only
+  // needs to be redone when the first close point is itself a duplicate
+  std::vector<char> kept(points.size(), 0);
+  std::size_t num = 0;
+  for(std::size_t i = 0; i < points.size(); i++) {
+    if(rep[i] != i && !kept[rep[i]]) rep[i] = grid.findEarlier(i, &kept);
+    if(rep[i] == i)
+      kept[i] = 1;
+    else
+      num++;
+  }
+  return num;
+}
@@ -0,0 +1,26 @@
+// Gmsh - Copyright (C) 1997-2019 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
+
+#ifndef _DUPLICATE_POINTS_
+#define _DUPLICATE_POINTS_
+
+#include <vector>
+#include <cstddef>
+#include "SPoint3.h"
+
+// Find duplicate points, i.e. points whose coordinates all differ by at most 2
+// * tolerance from the ones of a point appearing before them in the list (this
+// is the criterion used by MVertexRTree, which stores boxes of half-width
+// tolerance around the points). On output, rep[i] is the index of the point
+// that replaces point i (rep[i] == i if point i is kept); a point is only ever
+// replaced by a kept point, with the smallest index if there are several
+// candidates. The points are bucketed in a uniform grid and searched in
+// parallel, so that the result does not depend on the number of
+// threads. Returns the number of duplicate points.
+std::size_t FindDuplicatePoints(const std::vector<SPoint3> &points,
+                                double tolerance,
+                                std::vector<std::size_t> &rep);
+
+#endif
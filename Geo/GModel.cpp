@@ -23,6 +23,7 @@
 #include "MTrihedron.h"
 #include "MElementCut.h"
 #include "MElementOctree.h"
+#include "GModelMeshSnapshot.h"
 #include "discreteRegion.h"
 #include "discreteFace.h"
 #include "discreteEdge.h"
@@ -42,6 +43,8 @@
 #include "CreateFile.h"
 #include "Options.h"
 #include "GModelCreateTopologyFromMesh.h"
+#include "HilbertCurve.h"
+#include "DuplicatePoints.h"
 
 #if defined(HAVE_MESH)
 #include "meshGEdge.h"
@@ -64,12 +67,16 @@
 std::vector<GModel *> GModel::list;
 int GModel::_current = -1;
 
+// each reset of the vertex or element numbering of any model gets a new epoch
+static std::size_t numberingEpoch = 0;
+
 GModel::GModel(const std::string &name)
-  : _maxVertexNum(0), _maxElementNum(0), _checkPointedMaxVertexNum(0),
+  : _maxVertexNum(0), _maxElementNum(0), _vertexNumEpoch(++numberingEpoch),
+    _elementNumEpoch(++numberingEpoch), _checkPointedMaxVertexNum(0),
     _checkPointedMaxElementNum(0), _destroying(false), _name(name), _visible(1),
-    _elementOctree(0), _geo_internals(0), _occ_internals(0), _acis_internals(0),
-    _fields(0), _currentMeshEntity(0), _numPartitions(0),
-    normals(0)
+    _elementOctree(0), _meshVersion(0), _meshSnapshot(0), _geo_internals(0),
+    _occ_internals(0), _acis_internals(0), _fields(0), _currentMeshEntity(0),
+    _numPartitions(0), normals(0)
 {
   // hide all other models
   for(std::size_t i = 0; i < list.size(); i++) list[i]->setVisibility(0);
@@ -164,7 +171,8 @@ void GModel::destroy(bool keepName)
     _fileNames.clear();
   }
 
-  _maxVertexNum = _maxElementNum = 0;
+  setMaxVertexNumber(0);
+  setMaxElementNumber(0);
   _checkPointedMaxVertexNum = _checkPointedMaxElementNum = 0;
   _currentMeshEntity = 0;
   _lastMeshEntityError.clear();
@@ -203,18 +211,28 @@ void GModel::destroy(bool keepName)
 
 void GModel::destroyMeshCaches()
 {
-  _vertexVectorCache.clear();
-  std::vector<MVertex *>().swap(_vertexVectorCache);
-  _vertexMapCache.clear();
-  std::map<int, MVertex *>().swap(_vertexMapCache);
-  _elementVectorCache.clear();
-  std::vector<MElement *>().swap(_elementVectorCache);
-  _elementMapCache.clear();
-  std::map<int, MElement *>().swap(_elementMapCache);
+  _vertexTagCache.clear();
+  _elementTagCache.clear();
   _elementIndexCache.clear();
   std::map<int, int>().swap(_elementIndexCache);
   delete _elementOctree;
   _elementOctree = 0;
+  delete _meshSnapshot;
+  _meshSnapshot = 0;
+  _meshVersion++;
+}
+
+const GModelMeshSnapshot *GModel::getMeshSnapshot(bool create)
+{
+  if(!create) return _meshSnapshot;
+#if defined(_OPENMP)
+#pragma omp critical(meshSnapshot)
+#endif
+  {
+    if(!_meshSnapshot)
+      _meshSnapshot = new GModelMeshSnapshot(this, _meshVersion);
+  }
+  return _meshSnapshot;
 }
 
 void GModel::deleteMesh(bool deleteOnlyElements)
@@ -878,6 +896,7 @@ int GModel::mesh(int dimension)
 {
 #if defined(HAVE_MESH)
   GenerateMesh(this, dimension);
+  destroyMeshCaches();
   return true;
 #else
   Msg::Error("Mesh module not compiled");
@@ -1198,6 +1217,7 @@ int GModel::optimizeMesh(const std::string &how)
     OptimizeMeshNetgen(this);
   else
     OptimizeMesh(this);
+  destroyMeshCaches();
   return 1;
 #else
   Msg::Error("Mesh module not compiled");
@@ -1273,7 +1293,171 @@ std::size_t GModel::getNumMeshParentElements() const
   return n;
 }
 
-void GModel::renumberMeshVertices()
+void GModel::setMaxVertexNumber(std::size_t num)
+{
+  _maxVertexNum = num;
+  _vertexNumEpoch = ++numberingEpoch;
+}
+
+void GModel::setMaxElementNumber(std::size_t num)
+{
+  _maxElementNum = num;
+  _elementNumEpoch = ++numberingEpoch;
+}
+
+// without C++11 atomics, fall back to a critical section
+template <class T> static std::size_t fetchAndAdd(T &max, std::size_t n)
+{
+#if __cplusplus >= 201103L
+  return max.fetch_add(n);
+#else
+  std::size_t prev;
+#if defined(_OPENMP)
+#pragma omp critical(GModelNumbering)
+#endif
+  {
+    prev = max;
+    max += n;
+  }
+  return prev;
+#endif
+}
+
+template <class T> static void atomicMax(T &max, std::size_t num)
+{
+#if __cplusplus >= 201103L
+  std::size_t prev = max.load();
+  while(prev < num && !max.compare_exchange_weak(prev, num)) {
+  }
+#else
+#if defined(_OPENMP)
+#pragma omp critical(GModelNumbering)
+#endif
+  {
+    if(max < num) max = num;
+  }
+#endif
+}
+
+template <class T> static bool decrementIfEqual(T &max, std::size_t num)
+{
+#if __cplusplus >= 201103L
+  return max.compare_exchange_strong(num, num - 1);
+#else
+  bool ret = false;
+#if defined(_OPENMP)
+#pragma omp critical(GModelNumbering)
+#endif
+  {
+    if(max == num) {
+      max = num - 1;
+      ret = true;
+    }
+  }
+  return ret;
+#endif
+}
+
+std::size_t GModel::reserveVertexNumbers(std::size_t n)
+{
+  return fetchAndAdd(_maxVertexNum, n) + 1;
+}
+
+std::size_t GModel::reserveElementNumbers(std::size_t n)
+{
+  return fetchAndAdd(_maxElementNum, n) + 1;
+}
+
+void GModel::updateMaxVertexNumber(std::size_t num)
+{
+  atomicMax(_maxVertexNum, num);
+}
+
+void GModel::updateMaxElementNumber(std::size_t num)
+{
+  atomicMax(_maxElementNum, num);
+}
+
+bool GModel::releaseVertexNumber(std::size_t num)
+{
+  return decrementIfEqual(_maxVertexNum, num);
+}
+
+bool GModel::releaseElementNumber(std::size_t num)
+{
+  return decrementIfEqual(_maxElementNum, num);
+}
+
+static void getMeshItems(GEntity *ge, std::vector<MVertex *> &items)
+{
+  for(std::size_t j = 0; j < ge->getNumMeshVertices(); j++)
+    items.push_back(ge->getMeshVertex(j));
+}
+
+static void getMeshItems(GEntity *ge, std::vector<MElement *> &items)
+{
+  for(std::size_t j = 0; j < ge->getNumMeshElements(); j++)
+    items.push_back(ge->getMeshElement(j));
+}
+
+static SPoint3 getLocation(MVertex *v) { return v->point(); }
+
+static SPoint3 getLocation(MElement *e) { return e->barycenter(); }
+
+// sort the items in [begin, end) along a Hilbert curve; items with the same
+// Hilbert index keep their relative order
+template <class T>
+static void
+sortAlongHilbertCurve(std::vector<std::pair<T *, GEntity *> > &items,
+                      std::size_t begin, std::size_t end,
+                      const SBoundingBox3d &bbox)
+{
+  const int n = (int)(end - begin);
+  std::vector<std::pair<uint64_t, int> > keys(n);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for(int i = 0; i < n; i++)
+    keys[i] = std::make_pair(
+      HilbertIndex(getLocation(items[begin + i].first), bbox), i);
+  std::sort(keys.begin(), keys.end());
+  std::vector<std::pair<T *, GEntity *> > sorted(n);
+  for(int i = 0; i < n; i++) sorted[i] = items[begin + keys[i].second];
+  std::copy(sorted.begin(), sorted.end(), items.begin() + begin);
+}
+
+// get the mesh vertices or the mesh elements of the entities (with their
+// entity), in the order in which they should be numbered
+template <class T>
+static void
+getRenumberingOrder(const std::vector<GEntity *> &entities, int method,
+                    std::vector<std::pair<T *, GEntity *> > &items)
+{
+  std::vector<std::size_t> offsets(1, 0);
+  for(std::size_t i = 0; i < entities.size(); i++) {
+    std::vector<T *> v;
+    getMeshItems(entities[i], v);
+    for(std::size_t j = 0; j < v.size(); j++)
+      items.push_back(std::make_pair(v[j], entities[i]));
+    offsets.push_back(items.size());
+  }
+  if(method != 1 && method != 2) return;
+
+  SBoundingBox3d bbox;
+  for(std::size_t i = 0; i < entities.size(); i++) {
+    for(std::size_t j = 0; j < entities[i]->getNumMeshVertices(); j++)
+      bbox += entities[i]->getMeshVertex(j)->point();
+  }
+  if(method == 1) {
+    for(std::size_t i = 0; i < entities.size(); i++)
+      sortAlongHilbertCurve(items, offsets[i], offsets[i + 1], bbox);
+  }
+  else {
+    sortAlongHilbertCurve(items, 0, items.size(), bbox);
+  }
+}
+
+void GModel::renumberMeshVertices(int method)
 {
   destroyMeshCaches();
   setMaxVertexNumber(0);
@@ -1292,22 +1476,18 @@ void GModel::renumberMeshVertices()
     }
   }
 
+  std::vector<std::pair<MVertex *, GEntity *> > vertices;
+  getRenumberingOrder(entities, method, vertices);
+
   std::size_t n = 0;
   if(potentiallySaveSubset){
     Msg::Debug("Renumbering for potentially partial mesh save");
     // if we potentially only save a subset of elements, make sure to first
     // renumber the vertices that belong to those elements (so that we end up
     // with a dense vertex numbering in the output file)
-    std::size_t nv = 0;
-    for(std::size_t i = 0; i < entities.size(); i++) {
-      GEntity *ge = entities[i];
-      nv += ge->getNumMeshVertices();
-    }
-    for(std::size_t i = 0; i < entities.size(); i++) {
-      GEntity *ge = entities[i];
-      for(std::size_t j = 0; j < ge->getNumMeshVertices(); j++) {
-        ge->getMeshVertex(j)->forceNum(nv + 1);
-      }
+    std::size_t nv = vertices.size();
+    for(std::size_t i = 0; i < vertices.size(); i++) {
+      vertices[i].first->forceNum(nv + 1);
     }
     for(std::size_t i = 0; i < entities.size(); i++) {
       GEntity *ge = entities[i];
@@ -1320,33 +1500,24 @@ void GModel::renumberMeshVertices()
         }
       }
     }
-    for(std::size_t i = 0; i < entities.size(); i++) {
-      GEntity *ge = entities[i];
-      for(std::size_t j = 0; j < ge->getNumMeshVertices(); j++) {
-        MVertex *v = ge->getMeshVertex(j);
-        if(v->getNum() == 0) v->forceNum(++n);
-      }
+    for(std::size_t i = 0; i < vertices.size(); i++) {
+      MVertex *v = vertices[i].first;
+      if(v->getNum() == 0) v->forceNum(++n);
     }
-    for(std::size_t i = 0; i < entities.size(); i++) {
-      GEntity *ge = entities[i];
-      for(std::size_t j = 0; j < ge->getNumMeshVertices(); j++) {
-        MVertex *v = ge->getMeshVertex(j);
-        if(v->getNum() == nv + 1) v->forceNum(++n);
-      }
+    for(std::size_t i = 0; i < vertices.size(); i++) {
+      MVertex *v = vertices[i].first;
+      if(v->getNum() == nv + 1) v->forceNum(++n);
     }
   }
   else{
     // no physical groups
-    for(std::size_t i = 0; i < entities.size(); i++) {
-      GEntity *ge = entities[i];
-      for(std::size_t j = 0; j < ge->getNumMeshVertices(); j++) {
-        ge->getMeshVertex(j)->forceNum(++n);
-      }
+    for(std::size_t i = 0; i < vertices.size(); i++) {
+      vertices[i].first->forceNum(++n);
     }
   }
 }
 
-void GModel::renumberMeshElements()
+void GModel::renumberMeshElements(int method)
 {
   destroyMeshCaches();
   setMaxElementNumber(0);
@@ -1365,31 +1536,23 @@ void GModel::renumberMeshElements()
     }
   }
 
+  std::vector<std::pair<MElement *, GEntity *> > elements;
+  getRenumberingOrder(entities, method, elements);
+
   std::size_t n = 0;
   if(potentiallySaveSubset){
-    for(std::size_t i = 0; i < entities.size(); i++) {
-      GEntity *ge = entities[i];
-      if(ge->physicals.size()){
-        for(std::size_t j = 0; j < ge->getNumMeshElements(); j++) {
-          ge->getMeshElement(j)->forceNum(++n);
-        }
-      }
+    for(std::size_t i = 0; i < elements.size(); i++) {
+      if(elements[i].second->physicals.size())
+        elements[i].first->forceNum(++n);
     }
-    for(std::size_t i = 0; i < entities.size(); i++) {
-      GEntity *ge = entities[i];
-      if(ge->physicals.empty()){
-        for(std::size_t j = 0; j < ge->getNumMeshElements(); j++) {
-          ge->getMeshElement(j)->forceNum(++n);
-        }
-      }
+    for(std::size_t i = 0; i < elements.size(); i++) {
+      if(elements[i].second->physicals.empty())
+        elements[i].first->forceNum(++n);
     }
   }
   else{
-    for(std::size_t i = 0; i < entities.size(); i++) {
-      GEntity *ge = entities[i];
-      for(std::size_t j = 0; j < ge->getNumMeshElements(); j++) {
-        ge->getMeshElement(j)->forceNum(++n);
-      }
+    for(std::size_t i = 0; i < elements.size(); i++) {
+      elements[i].first->forceNum(++n);
     }
   }
 }
@@ -1433,52 +1596,49 @@ std::vector<MElement *> GModel::getMeshElementsByCoord(SPoint3 &p, int dim,
   return _elementOctree->findAll(p.x(), p.y(), p.z(), dim, strict);
 }
 
+void GModel::getMeshElementsByCoord(const std::vector<double> &xyz,
+                                    std::vector<MElement *> &elements,
+                                    std::vector<double> &uvw, int dim,
+                                    bool strict)
+{
+  if(!_elementOctree) {
+    Msg::Debug("Rebuilding mesh element octree");
+    _elementOctree = new MElementOctree(this);
+  }
+  _elementOctree->find(xyz, elements, uvw, dim, strict);
+}
+
 void GModel::rebuildMeshVertexCache(bool onlyIfNecessary)
 {
-  if(!onlyIfNecessary ||
-     (_vertexVectorCache.empty() && _vertexMapCache.empty())) {
-    _vertexVectorCache.clear();
-    _vertexMapCache.clear();
-    bool dense = false;
-    if(_maxVertexNum == getNumMeshVertices()) {
-      Msg::Debug("We have a dense vertex numbering in the cache");
-      dense = true;
-    }
-    else if(_maxVertexNum < 10 * getNumMeshVertices()) {
-      Msg::Debug(
-        "We have a fairly dense vertex numbering - still using cache vector");
-      dense = true;
-    }
+  if(!onlyIfNecessary || _vertexTagCache.empty()) {
     std::vector<GEntity *> entities;
     getEntities(entities);
-    if(dense) {
-      // numbering starts at 1
-      _vertexVectorCache.resize(_maxVertexNum + 1, (MVertex *)0);
-      for(std::size_t i = 0; i < entities.size(); i++)
-        for(std::size_t j = 0; j < entities[i]->mesh_vertices.size(); j++)
-          _vertexVectorCache[entities[i]->mesh_vertices[j]->getNum()] =
-            entities[i]->mesh_vertices[j];
-    }
-    else {
-      for(std::size_t i = 0; i < entities.size(); i++)
-        for(std::size_t j = 0; j < entities[i]->mesh_vertices.size(); j++)
-          _vertexMapCache[entities[i]->mesh_vertices[j]->getNum()] =
-            entities[i]->mesh_vertices[j];
+    std::vector<std::size_t> offset(entities.size() + 1, 0);
+    for(std::size_t i = 0; i < entities.size(); i++)
+      offset[i + 1] = offset[i] + entities[i]->mesh_vertices.size();
+    std::vector<std::pair<std::size_t, MVertex *> > vertices(offset.back());
+    for(std::size_t i = 0; i < entities.size(); i++) {
+      const std::vector<MVertex *> &v = entities[i]->mesh_vertices;
+      const int n = v.size();
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+      for(int j = 0; j < n; j++)
+        vertices[offset[i] + j] = std::make_pair(v[j]->getNum(), v[j]);
     }
+    _vertexTagCache.build(vertices, false);
   }
 }
 
-MVertex *GModel::getMeshVertexByTag(int n)
+MVertex *GModel::getMeshVertexByTag(std::size_t n)
 {
-  if(_vertexVectorCache.empty() && _vertexMapCache.empty()) {
+  if(_vertexTagCache.empty()) {
     Msg::Debug("Rebuilding mesh vertex cache");
     rebuildMeshVertexCache();
   }
-
-  if(n < (int)_vertexVectorCache.size())
-    return _vertexVectorCache[n];
-  else
-    return _vertexMapCache[n];
+  // lookups do not modify the cache, so that concurrent lookups are safe once
+  // the cache is built
+  return _vertexTagCache.find(n);
 }
 
 void GModel::getMeshVerticesForPhysicalGroup(int dim, int num,
@@ -1507,46 +1667,37 @@ void GModel::getMeshVerticesForPhysicalGroup(int dim, int num,
   v.insert(v.begin(), sv.begin(), sv.end());
 }
 
-MElement *GModel::getMeshElementByTag(int n)
+void GModel::rebuildMeshElementCache(bool onlyIfNecessary)
 {
-  if(_elementVectorCache.empty() && _elementMapCache.empty()) {
-    Msg::Debug("Rebuilding mesh element cache");
-    _elementVectorCache.clear();
-    _elementMapCache.clear();
-    bool dense = false;
-    if(_maxElementNum == getNumMeshElements()) {
-      Msg::Debug("We have a dense element numbering in the cache");
-      dense = true;
-    }
-    else if(_maxElementNum < 10 * getNumMeshElements()) {
-      Msg::Debug(
-        "We have a fairly dense element numbering - still using cache vector");
-      dense = true;
-    }
+  if(!onlyIfNecessary || _elementTagCache.empty()) {
     std::vector<GEntity *> entities;
     getEntities(entities);
-    if(dense) {
-      // numbering starts at 1
-      _elementVectorCache.resize(_maxElementNum + 1, (MElement *)0);
-      for(std::size_t i = 0; i < entities.size(); i++)
-        for(std::size_t j = 0; j < entities[i]->getNumMeshElements(); j++) {
-          MElement *e = entities[i]->getMeshElement(j);
-          _elementVectorCache[e->getNum()] = e;
-        }
-    }
-    else {
-      for(std::size_t i = 0; i < entities.size(); i++)
-        for(std::size_t j = 0; j < entities[i]->getNumMeshElements(); j++) {
-          MElement *e = entities[i]->getMeshElement(j);
-          _elementMapCache[e->getNum()] = e;
-        }
+    std::vector<std::size_t> offset(entities.size() + 1, 0);
+    for(std::size_t i = 0; i < entities.size(); i++)
+      offset[i + 1] = offset[i] + entities[i]->getNumMeshElements();
+    std::vector<std::pair<std::size_t, MElement *> > elements(offset.back());
+    for(std::size_t i = 0; i < entities.size(); i++) {
+      GEntity *ge = entities[i];
+      const int n = ge->getNumMeshElements();
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+      for(int j = 0; j < n; j++) {
+        MElement *e = ge->getMeshElement(j);
+        elements[offset[i] + j] = std::make_pair(e->getNum(), e);
+      }
     }
+    _elementTagCache.build(elements, false);
   }
+}
 
-  if(n < (int)_elementVectorCache.size())
-    return _elementVectorCache[n];
-  else
-    return _elementMapCache[n];
+MElement *GModel::getMeshElementByTag(std::size_t n)
+{
+  if(_elementTagCache.empty()) {
+    Msg::Debug("Rebuilding mesh element cache");
+    rebuildMeshElementCache();
+  }
+  return _elementTagCache.find(n);
 }
 
 int GModel::getMeshElementIndex(MElement *e)
@@ -1668,6 +1819,7 @@ void GModel::scaleMesh(double factor)
       v->y() *= factor;
       v->z() *= factor;
     }
+  destroyMeshCaches();
 }
 
 int GModel::partitionMesh(int numPart)
@@ -1677,6 +1829,7 @@ int GModel::partitionMesh(int numPart)
   if(numPart > 0) {
     if(_numPartitions > 0) UnpartitionMesh(this);
     int ier = PartitionMesh(this);
+    destroyMeshCaches();
     return ier;
   }
   else {
@@ -1691,7 +1844,9 @@ int GModel::partitionMesh(int numPart)
 int GModel::unpartitionMesh()
 {
 #if defined(HAVE_MESH)
-  return UnpartitionMesh(this);
+  int ier = UnpartitionMesh(this);
+  destroyMeshCaches();
+  return ier;
 #else
   Msg::Error("Mesh module not compiled");
   return 1;
@@ -1894,6 +2049,26 @@ void GModel::_associateEntityWithMeshVertices(bool force)
   }
 }
 
+void GModel::_cacheMeshVertices(std::map<int, MVertex *> &vertices)
+{
+  std::vector<std::pair<std::size_t, MVertex *> > v;
+  v.reserve(vertices.size());
+  for(std::map<int, MVertex *>::iterator it = vertices.begin();
+      it != vertices.end(); ++it)
+    if(it->second) v.push_back(std::make_pair(it->first, it->second));
+  _vertexTagCache.build(v);
+}
+
+void GModel::_cacheMeshVertices(std::vector<MVertex *> &vertices)
+{
+  // the vector is indexed by tag, and is allowed to have null entries
+  std::vector<std::pair<std::size_t, MVertex *> > v;
+  v.reserve(vertices.size());
+  for(std::size_t i = 0; i < vertices.size(); i++)
+    if(vertices[i]) v.push_back(std::make_pair(i, vertices[i]));
+  _vertexTagCache.build(v);
+}
+
 void GModel::_storeVerticesInEntities(std::map<int, MVertex *> &vertices)
 {
   std::map<int, MVertex *>::iterator it = vertices.begin();
@@ -1907,6 +2082,8 @@ void GModel::_storeVerticesInEntities(std::map<int, MVertex *> &vertices)
       it->second = 0;
     }
   }
+  // the cache might reference deleted vertices
+  _vertexTagCache.clear();
 }
 
 void GModel::_storeVerticesInEntities(std::vector<MVertex *> &vertices)
@@ -1923,6 +2100,8 @@ void GModel::_storeVerticesInEntities(std::vector<MVertex *> &vertices)
       }
     }
   }
+  // the cache might reference deleted vertices
+  _vertexTagCache.clear();
 }
 
 void GModel::pruneMeshVertexAssociations()
@@ -1960,6 +2139,7 @@ void GModel::pruneMeshVertexAssociations()
     _associateEntityWithElementVertices(*it, (*it)->points, true);
   }
   _storeVerticesInEntities(vertices);
+  destroyMeshCaches();
 }
 
 void GModel::_storePhysicalTagsInEntities(
@@ -2255,6 +2435,27 @@ void GModel::checkMeshCoherence(double tolerance)
   Msg::StatusBar(true, "Done checking mesh coherence");
 }
 
+// map from the vertices indexed in removeDuplicateMeshVertices() to their
+// replacement; returns 0 for vertices that were not indexed (e.g. vertices of
+// elements that are not stored in any entity)
+class duplicateVertexMap {
+private:
+  const std::vector<MVertex *> &_vertices, &_replacement;
+
+public:
+  duplicateVertexMap(const std::vector<MVertex *> &vertices,
+                     const std::vector<MVertex *> &replacement)
+    : _vertices(vertices), _replacement(replacement)
+  {
+  }
+  MVertex *operator()(MVertex *v) const
+  {
+    long int i = v->getIndex();
+    if(i < 0 || i >= (long int)_vertices.size() || _vertices[i] != v) return 0;
+    return _replacement[i];
+  }
+};
+
 int GModel::removeDuplicateMeshVertices(double tolerance)
 {
   Msg::StatusBar(true, "Removing duplicate mesh vertices...");
@@ -2269,31 +2470,21 @@ int GModel::removeDuplicateMeshVertices(double tolerance)
   // re-index all vertices (don't use MVertex::getNum(), as we want to be able
   // to remove diplicate vertices from "incorrect" meshes, where vertices with
   // the same number are duplicated)
-  int n = 0;
-  for(std::size_t i = 0; i < entities.size(); i++) {
-    GEntity *ge = entities[i];
-    for(std::size_t j = 0; j < ge->mesh_vertices.size(); j++) {
-      MVertex *v = ge->mesh_vertices[j];
-      v->setIndex(++n);
-    }
-  }
-
-  MVertexRTree pos(eps);
-  std::map<int, MVertex *> vertices;
-  std::map<MVertex *, MVertex *> duplicates;
+  std::vector<MVertex *> vertices;
   for(std::size_t i = 0; i < entities.size(); i++) {
     GEntity *ge = entities[i];
     for(std::size_t j = 0; j < ge->mesh_vertices.size(); j++) {
       MVertex *v = ge->mesh_vertices[j];
-      MVertex *v2 = pos.insert(v);
-      if(v2)
-        duplicates[v] = v2; // v should be removed
-      else
-        vertices[v->getIndex()] = v;
+      v->setIndex(vertices.size());
+      vertices.push_back(v);
     }
   }
 
-  int num = (int)duplicates.size();
+  std::vector<SPoint3> points(vertices.size());
+  for(std::size_t i = 0; i < vertices.size(); i++)
+    points[i] = vertices[i]->point();
+  std::vector<std::size_t> rep;
+  int num = (int)FindDuplicatePoints(points, eps, rep);
   Msg::Info("Found %d duplicate vertices ", num);
 
   if(!num) {
@@ -2301,26 +2492,38 @@ int GModel::removeDuplicateMeshVertices(double tolerance)
     return 0;
   }
 
+  // flat map from old to new vertices (the vertices that are kept are mapped
+  // to themselves)
+  std::vector<MVertex *> replacement(vertices.size());
+  std::vector<MVertex *> duplicates;
+  for(std::size_t i = 0; i < vertices.size(); i++) {
+    replacement[i] = vertices[rep[i]];
+    if(rep[i] != i) duplicates.push_back(vertices[i]);
+  }
+  duplicateVertexMap map(vertices, replacement);
+
   for(std::size_t i = 0; i < entities.size(); i++) {
     GEntity *ge = entities[i];
     // clear list of vertices owned by entity
     ge->mesh_vertices.clear();
-    // replace vertices in element
-    for(std::size_t j = 0; j < ge->getNumMeshElements(); j++) {
+    // replace vertices in elements
+    const int ne = (int)ge->getNumMeshElements();
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+    for(int j = 0; j < ne; j++) {
       MElement *e = ge->getMeshElement(j);
       for(std::size_t k = 0; k < e->getNumVertices(); k++) {
-        std::map<MVertex *, MVertex *>::iterator it =
-          duplicates.find(e->getVertex(k));
-        if(it != duplicates.end()) e->setVertex(k, it->second);
+        MVertex *v = map(e->getVertex(k));
+        if(v) e->setVertex(k, v);
       }
     }
     // replace vertices in periodic copies
     std::map<MVertex *, MVertex *> &corrVtcs = ge->correspondingVertices;
     if(corrVtcs.size()) {
-      std::map<MVertex *, MVertex *>::iterator cIter;
-      for(cIter = duplicates.begin(); cIter != duplicates.end(); ++cIter) {
-        MVertex *oldTgt = cIter->first;
-        MVertex *newTgt = cIter->second;
+      for(std::size_t j = 0; j < duplicates.size(); j++) {
+        MVertex *oldTgt = duplicates[j];
+        MVertex *newTgt = map(oldTgt);
         std::map<MVertex *, MVertex *>::iterator cvIter = corrVtcs.find(oldTgt);
         if(cvIter != corrVtcs.end()) {
           MVertex *src = cvIter->second;
@@ -2328,29 +2531,24 @@ int GModel::removeDuplicateMeshVertices(double tolerance)
           corrVtcs[newTgt] = src;
         }
       }
+      std::map<MVertex *, MVertex *>::iterator cIter;
       for(cIter = corrVtcs.begin(); cIter != corrVtcs.end(); ++cIter) {
-        MVertex *oldSrc = cIter->second;
-        std::map<MVertex *, MVertex *>::iterator nIter =
-          duplicates.find(oldSrc);
-        if(nIter != duplicates.end()) {
-          MVertex *tgt = cIter->first;
-          MVertex *newSrc = nIter->second;
-          corrVtcs[tgt] = newSrc;
-        }
+        MVertex *newSrc = map(cIter->second);
+        if(newSrc) cIter->second = newSrc;
       }
     }
   }
 
+  // only keep the vertices that are not duplicates
+  for(std::size_t i = 0; i < vertices.size(); i++)
+    if(rep[i] != i) vertices[i] = 0;
+
   destroyMeshCaches();
   _associateEntityWithMeshVertices();
   _storeVerticesInEntities(vertices);
 
   // delete duplicates
-  std::vector<MVertex *> to_delete;
-  for(std::map<MVertex *, MVertex *>::iterator it = duplicates.begin();
-      it != duplicates.end(); it++)
-    to_delete.push_back(it->first);
-  for(std::size_t i = 0; i < to_delete.size(); i++) delete to_delete[i];
+  for(std::size_t i = 0; i < duplicates.size(); i++) delete duplicates[i];
 
   if(num)
     Msg::Info("Removed %d duplicate mesh %s", num,
@@ -11,12 +11,16 @@
 #include <set>
 #include <map>
 #include <string>
+#if __cplusplus >= 201103L
+#include <atomic>
+#endif
 #include "GVertex.h"
 #include "GEdge.h"
 #include "GFace.h"
 #include "GRegion.h"
 #include "SPoint3.h"
 #include "SBoundingBox3d.h"
+#include "MTagIndex.h"
 
 template <class scalar> class simpleFunction;
 
@@ -30,6 +34,7 @@ class gLevelset;
 class discreteFace;
 class discreteRegion;
 class MElementOctree;
+class GModelMeshSnapshot;
 
 // A geometric model. The model is a "not yet" non-manifold B-Rep.
 class GModel {
@@ -42,8 +47,16 @@ private:
   std::set<GEdge *, GEntityLessThan> _chainEdges;
   std::set<GVertex *, GEntityLessThan> _chainVertices;
 
-  // the maximum vertex and element id number in the mesh
+  // the maximum vertex and element id number in the mesh (these are updated
+  // concurrently when mesh entities are created in parallel)
+#if __cplusplus >= 201103L
+  std::atomic<std::size_t> _maxVertexNum, _maxElementNum;
+#else
   std::size_t _maxVertexNum, _maxElementNum;
+#endif
+  // changed each time the maximum numbers are reset, to invalidate the ranges
+  // of numbers reserved by threads
+  std::size_t _vertexNumEpoch, _elementNumEpoch;
   std::size_t _checkPointedMaxVertexNum, _checkPointedMaxElementNum;
   // flag set to true when the model is being destroyed
   bool _destroying;
@@ -86,10 +99,8 @@ protected:
 
   // vertex and element caches to speed-up direct access by tag (mostly
   // used for post-processing I/O)
-  std::vector<MVertex *> _vertexVectorCache;
-  std::map<int, MVertex *> _vertexMapCache;
-  std::vector<MElement *> _elementVectorCache;
-  std::map<int, MElement *> _elementMapCache;
+  MTagIndex<MVertex> _vertexTagCache;
+  MTagIndex<MElement> _elementTagCache;
   std::map<int, int> _elementIndexCache;
 
   // ghost cell information (stores partitions for each element acting
@@ -100,6 +111,11 @@ protected:
   // an octree for fast mesh element lookup
   MElementOctree *_elementOctree;
 
+  // mesh version, incremented each time the mesh caches are destroyed, and
+  // contiguous copy of the mesh for that version (for bulk access)
+  std::size_t _meshVersion;
+  GModelMeshSnapshot *_meshSnapshot;
+
   // Geo (Gmsh native) model internal data
   GEO_Internals *_geo_internals;
   // OpenCascade model internal data
@@ -160,8 +176,15 @@ protected:
   // geometrical entity
   void _associateEntityWithMeshVertices(bool force = false);
 
+  // fill the vertex cache with vertices that are not stored in the
+  // geometrical entities yet (e.g. when reading a mesh file), so that they
+  // can be accessed by tag
+  void _cacheMeshVertices(std::map<int, MVertex *> &vertices);
+  void _cacheMeshVertices(std::vector<MVertex *> &vertices);
+
   // store the vertices in the geometrical entity they are associated
-  // with, and delete those that are not associated with any entity
+  // with, and delete those that are not associated with any entity (this
+  // clears the vertex cache)
   void _storeVerticesInEntities(std::map<int, MVertex *> &vertices);
   void _storeVerticesInEntities(std::vector<MVertex *> &vertices);
 
@@ -211,11 +234,23 @@ public:
   void destroy(bool keepName = false);
   bool isBeingDestroyed() const { return _destroying; }
 
-  // get/set global vertex/element num
-  std::size_t getMaxVertexNumber() { return _maxVertexNum; }
-  std::size_t getMaxElementNumber() { return _maxElementNum; }
-  void setMaxVertexNumber(std::size_t num) { _maxVertexNum = num; }
-  void setMaxElementNumber(std::size_t num) { _maxElementNum = num; }
+  // get/set global vertex/element num (the setters are not thread-safe)
+  std::size_t getMaxVertexNumber() const { return _maxVertexNum; }
+  std::size_t getMaxElementNumber() const { return _maxElementNum; }
+  void setMaxVertexNumber(std::size_t num);
+  void setMaxElementNumber(std::size_t num);
+
+  // thread-safe vertex/element numbering: reserve n consecutive new numbers
+  // and return the first one; make sure that the maximum number is at least
+  // num; or decrement the maximum number if it is equal to num
+  std::size_t reserveVertexNumbers(std::size_t n);
+  std::size_t reserveElementNumbers(std::size_t n);
+  void updateMaxVertexNumber(std::size_t num);
+  void updateMaxElementNumber(std::size_t num);
+  bool releaseVertexNumber(std::size_t num);
+  bool releaseElementNumber(std::size_t num);
+  std::size_t getVertexNumberEpoch() const { return _vertexNumEpoch; }
+  std::size_t getElementNumberEpoch() const { return _elementNumEpoch; }
   void checkPointMaxNumbers()
   {
     _checkPointedMaxVertexNum = _maxVertexNum;
@@ -228,13 +263,23 @@ public:
   }
 
   // renumber mesh vertices and elements in a continuous sequence (this
-  // invalidates the mesh caches)
-  void renumberMeshVertices();
-  void renumberMeshElements();
+  // invalidates the mesh caches); the vertices and elements are numbered entity
+  // by entity (method = 0), along a Hilbert curve in each entity (method = 1),
+  // or along a Hilbert curve across all the entities (method = 2)
+  void renumberMeshVertices(int method = 0);
+  void renumberMeshElements(int method = 0);
 
   // delete all the mesh-related caches (this must be called when the
   // mesh is changed)
   void destroyMeshCaches();
+  // get the mesh version, which changes each time the mesh caches are
+  // destroyed
+  std::size_t getMeshVersion() const { return _meshVersion; }
+  // get a contiguous copy of the current mesh (nodes, and elements by type),
+  // kept until the mesh caches are destroyed; it is built on demand if create
+  // is set (this can be requested concurrently from several threads), and 0
+  // is returned otherwise if it does not exist yet
+  const GModelMeshSnapshot *getMeshSnapshot(bool create = true);
   // delete the mesh stored in entities and call destroMeshCaches
   void deleteMesh(bool onlyDeleteElements = false);
 
@@ -444,9 +489,18 @@ public:
   MElement *getMeshElementByCoord(SPoint3 &p, int dim = -1, bool strict = true);
   std::vector<MElement *> getMeshElementsByCoord(SPoint3 &p, int dim = -1,
                                                  bool strict = true);
+  // locate many points (3 coordinates per point in xyz) in parallel, and get
+  // the parametric coordinates of each point in its element
+  void getMeshElementsByCoord(const std::vector<double> &xyz,
+                              std::vector<MElement *> &elements,
+                              std::vector<double> &uvw, int dim = -1,
+                              bool strict = true);
+
+  // recompute the element cache
+  void rebuildMeshElementCache(bool onlyIfNecessary = false);
 
   // access a mesh element by tag, using the element cache
-  MElement *getMeshElementByTag(int n);
+  MElement *getMeshElementByTag(std::size_t n);
 
   // access temporary mesh element index
   int getMeshElementIndex(MElement *e);
@@ -455,12 +509,12 @@ public:
   // return the total number of vertices in the mesh
   std::size_t getNumMeshVertices(int dim = -1) const;
 
-  // recompute _vertexVectorCache if there is a dense vertex numbering or
-  // _vertexMapCache if not.
+  // recompute the vertex cache (contiguous ranges of tags are stored in
+  // tables, the remaining tags in a hash table)
   void rebuildMeshVertexCache(bool onlyIfNecessary = false);
 
   // access a mesh vertex by tag, using the vertex cache
-  MVertex *getMeshVertexByTag(int n);
+  MVertex *getMeshVertexByTag(std::size_t n);
 
   // get all the mesh vertices associated with the physical group
   // of dimension "dim" and id number "num"
@@ -49,7 +49,7 @@ int GModel::readACTRAN(const std::string &name)
     return 0;
   }
 
-  _vertexMapCache.clear();
+  std::map<int, MVertex *> vertexMap;
   std::map<int, std::vector<MElement *> > elements[3];
   int nbv = 0, nbe = 0, dim = 0;
 
@@ -77,8 +77,9 @@ int GModel::readACTRAN(const std::string &name)
           sscanf(buffer, "%d %lf %lf %lf", &num, &x, &y, &z);
         else
           sscanf(buffer, "%d %lf %lf", &num, &x, &y);
-        _vertexMapCache[num] = new MVertex(x, y, z, 0, num);
+        vertexMap[num] = new MVertex(x, y, z, 0, num);
       }
+      _cacheMeshVertices(vertexMap);
     }
     else if(!strcmp(str, "BEGIN") && !strcmp(str2, "ELEMENT")) {
       Msg::Info("%d elements", nbe);
@@ -114,7 +115,7 @@ int GModel::readACTRAN(const std::string &name)
   for(int i = 0; i < (int)(sizeof(elements) / sizeof(elements[0])); i++)
     _storeElementsInEntities(elements[i]);
   _associateEntityWithMeshVertices();
-  _storeVerticesInEntities(_vertexMapCache);
+  _storeVerticesInEntities(vertexMap);
 
   fclose(fp);
   return 1;
@@ -603,12 +603,8 @@ int GModel::_readMSH2(const std::string &name)
       }
     }
     else if(!strncmp(&str[1], "NodeData", 8)) {
-      // there's some nodal post-processing data to read later on, so
-      // cache the vertex indexing data
-      if(vertexVector.size())
-        _vertexVectorCache = vertexVector;
-      else
-        _vertexMapCache = vertexMap;
+      // there's some nodal post-processing data to read later on (the vertex
+      // cache will be rebuilt from the entities when it is accessed)
       postpro = true;
       break;
     }
@@ -190,6 +190,8 @@ int GModel::_readMSH3(const std::string &name)
   bool binary = false, swap = false, postpro = false;
   int minVertex = 0;
   std::map<int, std::vector<MElement *> > elements[11];
+  std::map<int, MVertex *> vertexMap;
+  std::vector<MVertex *> vertexVector;
 
   while(1) {
     while(str[0] != '$') {
@@ -277,8 +279,8 @@ int GModel::_readMSH3(const std::string &name)
       }
       Msg::Info("%d vertices", numVertices);
       Msg::ResetProgressMeter();
-      _vertexMapCache.clear();
-      _vertexVectorCache.clear();
+      vertexMap.clear();
+      vertexVector.clear();
       int maxVertex = -1;
       minVertex = numVertices + 1;
       for(int i = 0; i < numVertices; i++) {
@@ -329,7 +331,7 @@ int GModel::_readMSH3(const std::string &name)
           switch(dim) {
           case 0: {
             GVertex *gv = getVertexByTag(entity);
-            // FIXME -- cannot call this: it destroys _vertexMapCache
+            // FIXME -- cannot call this: it destroys the vertex cache
             // if(gv) gv->deleteMesh();
             vertex = new MVertex(xyz[0], xyz[1], xyz[2], gv, num);
           } break;
@@ -396,29 +398,31 @@ int GModel::_readMSH3(const std::string &name)
         }
         minVertex = std::min(minVertex, num);
         maxVertex = std::max(maxVertex, num);
-        if(_vertexMapCache.count(num))
+        if(vertexMap.count(num))
           Msg::Warning("Skipping duplicate vertex %d", num);
-        _vertexMapCache[num] = vertex;
+        vertexMap[num] = vertex;
         if(numVertices > 100000)
           Msg::ProgressMeter(i + 1, numVertices, true, "Reading nodes");
       }
       // if the vertex numbering is dense, transfer the map into a vector to
       // speed up element creation
-      if((int)_vertexMapCache.size() == numVertices &&
+      if((int)vertexMap.size() == numVertices &&
          ((minVertex == 1 && maxVertex == numVertices) ||
           (minVertex == 0 && maxVertex == numVertices - 1))) {
         Msg::Debug("Vertex numbering is dense");
-        _vertexVectorCache.resize(_vertexMapCache.size() + 1);
+        vertexVector.resize(vertexMap.size() + 1);
         if(minVertex == 1)
-          _vertexVectorCache[0] = 0;
+          vertexVector[0] = 0;
         else
-          _vertexVectorCache[numVertices] = 0;
-        for(std::map<int, MVertex *>::const_iterator it =
-              _vertexMapCache.begin();
-            it != _vertexMapCache.end(); ++it)
-          _vertexVectorCache[it->first] = it->second;
-        _vertexMapCache.clear();
+          vertexVector[numVertices] = 0;
+        for(std::map<int, MVertex *>::const_iterator it = vertexMap.begin();
+            it != vertexMap.end(); ++it)
+          vertexVector[it->first] = it->second;
+        vertexMap.clear();
+        _cacheMeshVertices(vertexVector);
       }
+      else
+        _cacheMeshVertices(vertexMap);
     }
 
     // $Elements section
@@ -534,10 +538,10 @@ int GModel::_readMSH3(const std::string &name)
   _associateEntityWithMeshVertices();
 
   // store the vertices in their associated geometrical entity
-  if(_vertexVectorCache.size())
-    _storeVerticesInEntities(_vertexVectorCache);
+  if(vertexVector.size())
+    _storeVerticesInEntities(vertexVector);
   else
-    _storeVerticesInEntities(_vertexMapCache);
+    _storeVerticesInEntities(vertexMap);
 
   for(int i = 0; i < (int)(sizeof(elements) / sizeof(elements[0])); i++)
     _storeParentsInSubElements(elements[i]);
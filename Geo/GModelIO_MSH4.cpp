@@ -6,6 +6,7 @@
 // Contributed by Anthony Royer
 
 #include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <vector>
 #include <map>
@@ -473,13 +474,68 @@ static bool readMSH4Entities(GModel *const model, FILE *fp, bool partition,
   return true;
 }
 
-static std::pair<int, MVertex *> *
-readMSH4Nodes(GModel *const model, FILE *fp, bool binary, bool &dense,
-              unsigned long &nbrNodes, unsigned long &maxNodeNum, bool swap)
+static MVertex *createMSH4Vertex(GEntity *entity, int entityDim, bool parametric,
+                                 int nodeTag, const double *xyz,
+                                 const double *uv)
 {
-  unsigned long numBlock = 0;
-  nbrNodes = 0;
-  maxNodeNum = 0;
+  GModel *model = entity->model();
+  if(parametric && entityDim == 1)
+    return new MEdgeVertex(xyz[0], xyz[1], xyz[2], entity, uv[0], nodeTag,
+                           -1.0, model);
+  else if(parametric && entityDim == 2)
+    return new MFaceVertex(xyz[0], xyz[1], xyz[2], entity, uv[0], uv[1],
+                           nodeTag, model);
+  return new MVertex(xyz[0], xyz[1], xyz[2], entity, nodeTag, model);
+}
+
+static bool readMSH4NodeBlockBinary(FILE *fp, GEntity *entity, int entityDim,
+                                    bool parametric, unsigned long numNodes,
+                                    bool swap, std::vector<int> &tags,
+                                    std::vector<MVertex *> &vertices)
+{
+  // each node is stored as a tag followed by its coordinates and (if any) its
+  // parametric coordinates: read the whole block in a single call, then decode
+  // it and allocate the vertices in parallel
+  int numParams = 0;
+  if(parametric) numParams = (entityDim == 1) ? 1 : (entityDim == 2) ? 2 : 0;
+  const std::size_t nodeSize = sizeof(int) + (3 + numParams) * sizeof(double);
+
+  tags.resize(numNodes);
+  vertices.resize(numNodes);
+  if(!numNodes) return true;
+
+  std::vector<char> buffer(numNodes * nodeSize);
+  if(fread(&buffer[0], nodeSize, numNodes, fp) != numNodes) return false;
+
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for(std::size_t j = 0; j < numNodes; j++) {
+    char *p = &buffer[j * nodeSize];
+    if(swap) {
+      SwapBytes(p, sizeof(int), 1);
+      SwapBytes(p + sizeof(int), sizeof(double), 3 + numParams);
+    }
+    int nodeTag;
+    double xyz[3], uv[2] = {0., 0.};
+    memcpy(&nodeTag, p, sizeof(int));
+    memcpy(xyz, p + sizeof(int), 3 * sizeof(double));
+    if(numParams)
+      memcpy(uv, p + sizeof(int) + 3 * sizeof(double),
+             numParams * sizeof(double));
+    tags[j] = nodeTag;
+    vertices[j] =
+      createMSH4Vertex(entity, entityDim, parametric, nodeTag, xyz, uv);
+  }
+  return true;
+}
+
+static bool
+readMSH4Nodes(GModel *const model, FILE *fp, bool binary,
+              std::vector<std::pair<std::size_t, MVertex *> > &vertexCache,
+              bool swap)
+{
+  unsigned long numBlock = 0, nbrNodes = 0;
   if(binary) {
     unsigned long data[2];
     if(fread(data, sizeof(unsigned long), 2, fp) != 2) {
@@ -496,9 +552,7 @@ readMSH4Nodes(GModel *const model, FILE *fp, bool binary, bool &dense,
   }
 
   unsigned long nodeRead = 0;
-  unsigned long minNodeNum = nbrNodes + 1;
-  std::pair<int, MVertex *> *vertexCache =
-    new std::pair<int, MVertex *>[nbrNodes];
+  vertexCache.resize(nbrNodes);
   Msg::Info("%lu vertices", nbrNodes);
   for(unsigned int i = 0; i < numBlock; i++) {
     int parametric = 0;
@@ -508,7 +562,6 @@ readMSH4Nodes(GModel *const model, FILE *fp, bool binary, bool &dense,
     if(binary) {
       int data[3];
       if(fread(data, sizeof(int), 3, fp) != 3) {
-        delete [] vertexCache;
         return 0;
       }
       if(swap) SwapBytes((char *)data, sizeof(int), 3);
@@ -518,7 +571,6 @@ readMSH4Nodes(GModel *const model, FILE *fp, bool binary, bool &dense,
 
       unsigned long dataLong;
       if(fread(&dataLong, sizeof(unsigned long), 1, fp) != 1) {
-        delete [] vertexCache;
         return 0;
       }
       if(swap) SwapBytes((char *)&dataLong, sizeof(unsigned long), 1);
@@ -527,7 +579,6 @@ readMSH4Nodes(GModel *const model, FILE *fp, bool binary, bool &dense,
     else {
       if(fscanf(fp, "%d %d %d %lu", &entityTag, &entityDim, &parametric,
                 &numNodes) != 4) {
-        delete [] vertexCache;
         return 0;
       }
     }
@@ -535,195 +586,75 @@ readMSH4Nodes(GModel *const model, FILE *fp, bool binary, bool &dense,
     GEntity *entity = model->getEntityByTag(entityDim, entityTag);
     if(!entity) {
       Msg::Error("Unknown entity %d of dimension %d", entityTag, entityDim);
-      delete [] vertexCache;
+      return 0;
+    }
+    if(nodeRead + numNodes > nbrNodes) {
+      Msg::Error("Too many nodes in entity %d of dimension %d", entityTag,
+                 entityDim);
       return 0;
     }
 
-    for(unsigned int j = 0; j < numNodes; j++) {
-      double xyz[3];
-      int nodeTag = 0;
-      MVertex *vertex = 0;
-
-      if(parametric) {
-        double u = 0., v = 0.;
-
-        switch(entityDim) {
-        case 0:
-          if(binary) {
-            if(fread(&nodeTag, sizeof(int), 1, fp) != 1) {
-              delete [] vertexCache;
-              return 0;
-            }
-            if(swap) SwapBytes((char *)&nodeTag, sizeof(int), 1);
-
-            if(fread(xyz, sizeof(double), 3, fp) != 3) {
-              delete [] vertexCache;
-              return 0;
-            }
-            if(swap) SwapBytes((char *)xyz, sizeof(double), 3);
-          }
-          else {
-            if(fscanf(fp, "%d %lf %lf %lf", &nodeTag, &xyz[0], &xyz[1],
-                      &xyz[2]) != 4) {
-              delete [] vertexCache;
-              return 0;
-            }
-          }
-          vertex = new MVertex(xyz[0], xyz[1], xyz[2], entity, nodeTag);
-          break;
-        case 1:
-          if(binary) {
-            if(fread(&nodeTag, sizeof(int), 1, fp) != 1) {
-              delete [] vertexCache;
-              return 0;
-            }
-            if(swap) SwapBytes((char *)&nodeTag, sizeof(int), 1);
-
-            if(fread(xyz, sizeof(double), 3, fp) != 3) {
-              delete [] vertexCache;
-              return 0;
-            }
-            if(swap) SwapBytes((char *)xyz, sizeof(double), 3);
-
-            if(fread(&u, sizeof(double), 1, fp) != 1) {
-              delete [] vertexCache;
-              return 0;
-            }
-            if(swap) SwapBytes((char *)&u, sizeof(double), 1);
-          }
-          else {
-            if(fscanf(fp, "%d %lf %lf %lf %lf", &nodeTag, &xyz[0], &xyz[1],
-                      &xyz[2], &u) != 5) {
-              delete [] vertexCache;
-              return 0;
-            }
-          }
-          vertex =
-            new MEdgeVertex(xyz[0], xyz[1], xyz[2], entity, u, nodeTag);
-          break;
-        case 2:
-          if(binary) {
-            if(fread(&nodeTag, sizeof(int), 1, fp) != 1) {
-              delete [] vertexCache;
-              return 0;
-            }
-            if(swap) SwapBytes((char *)&nodeTag, sizeof(int), 1);
-
-            if(fread(xyz, sizeof(double), 3, fp) != 3) {
-              delete [] vertexCache;
-              return 0;
-            }
-            if(swap) SwapBytes((char *)xyz, sizeof(double), 3);
-
-            double uv[2];
-            if(fread(uv, sizeof(double), 2, fp) != 2) {
-              delete [] vertexCache;
-              return 0;
-            }
-            if(swap) SwapBytes((char *)uv, sizeof(double), 2);
-
-            u = uv[0];
-            v = uv[1];
-          }
-          else {
-            if(fscanf(fp, "%d %lf %lf %lf %lf %lf", &nodeTag, &xyz[0], &xyz[1],
-                      &xyz[2], &u, &v) != 6) {
-              delete [] vertexCache;
-              return 0;
-            }
-          }
-          vertex =
-            new MFaceVertex(xyz[0], xyz[1], xyz[2], entity, u, v, nodeTag);
-          break;
-        case 3:
-          if(binary) {
-            if(fread(&nodeTag, sizeof(int), 1, fp) != 1) {
-              delete [] vertexCache;
-              return 0;
-            }
-            if(swap) SwapBytes((char *)&nodeTag, sizeof(int), 1);
-
-            if(fread(xyz, sizeof(double), 3, fp) != 3) {
-              delete [] vertexCache;
-              return 0;
-            }
-            if(swap) SwapBytes((char *)xyz, sizeof(double), 3);
-          }
-          else {
-            if(fscanf(fp, "%d %lf %lf %lf", &nodeTag, &xyz[0], &xyz[1],
-                      &xyz[2]) != 4) {
-              delete [] vertexCache;
-              return 0;
-            }
-          }
-          vertex = new MVertex(xyz[0], xyz[1], xyz[2], entity, nodeTag);
-          break;
-        default: delete[]vertexCache; return 0; break;
-        }
+    std::vector<int> tags;
+    std::vector<MVertex *> vertices;
+    if(binary) {
+      if(!readMSH4NodeBlockBinary(fp, entity, entityDim, parametric, numNodes,
+                                  swap, tags, vertices)) {
+        return 0;
       }
-      else {
-        if(binary) {
-          if(fread(&nodeTag, sizeof(int), 1, fp) != 1) {
-            delete [] vertexCache;
+    }
+    else {
+      tags.resize(numNodes);
+      vertices.resize(numNodes);
+      for(unsigned long j = 0; j < numNodes; j++) {
+        int nodeTag = 0;
+        double xyz[3], uv[2] = {0., 0.};
+        if(parametric && entityDim == 1) {
+          if(fscanf(fp, "%d %lf %lf %lf %lf", &nodeTag, &xyz[0], &xyz[1],
+                    &xyz[2], &uv[0]) != 5) {
             return 0;
           }
-          if(swap) SwapBytes((char *)&nodeTag, sizeof(int), 1);
-
-          if(fread(xyz, sizeof(double), 3, fp) != 3) {
-            delete [] vertexCache;
+        }
+        else if(parametric && entityDim == 2) {
+          if(fscanf(fp, "%d %lf %lf %lf %lf %lf", &nodeTag, &xyz[0], &xyz[1],
+                    &xyz[2], &uv[0], &uv[1]) != 6) {
             return 0;
           }
-          if(swap) SwapBytes((char *)xyz, sizeof(double), 3);
         }
         else {
           if(fscanf(fp, "%d %lf %lf %lf", &nodeTag, &xyz[0], &xyz[1],
                     &xyz[2]) != 4) {
-            delete [] vertexCache;
             return 0;
           }
         }
-        vertex = new MVertex(xyz[0], xyz[1], xyz[2], entity, nodeTag);
+        tags[j] = nodeTag;
+        vertices[j] =
+          createMSH4Vertex(entity, entityDim, parametric, nodeTag, xyz, uv);
       }
+    }
+
+    entity->mesh_vertices.reserve(entity->mesh_vertices.size() + numNodes);
+    for(unsigned long j = 0; j < numNodes; j++) {
+      MVertex *vertex = vertices[j];
+      const int nodeTag = tags[j];
       entity->addMeshVertex(vertex);
       vertex->setEntity(entity);
-      minNodeNum = std::min(minNodeNum, (unsigned long)nodeTag);
-      maxNodeNum = std::max(maxNodeNum, (unsigned long)nodeTag);
-
-      vertexCache[nodeRead] = std::pair<int, MVertex *>(nodeTag, vertex);
+      vertexCache[nodeRead] = std::make_pair(nodeTag, vertex);
       nodeRead++;
-
-      if(nbrNodes > 100000)
-        Msg::ProgressMeter(nodeRead, nbrNodes, true, "Reading nodes");
     }
-  }
-  // if the vertex numbering is (fairly) dense, we fill the vector cache,
-  // otherwise we fill the map cache
-  if(minNodeNum == 1 && maxNodeNum == nbrNodes) {
-    Msg::Debug("Vertex numbering is dense");
-    dense = true;
-  }
-  else if(maxNodeNum < 10 * nbrNodes) { //
-    Msg::Debug(
-      "Vertex numbering is fairly dense - still caching with a vector");
-    dense = true;
-  }
-  else {
-    Msg::Debug("Vertex numbering is not dense");
-    dense = false;
-  }
 
-  return vertexCache;
+    if(nbrNodes > 100000)
+      Msg::ProgressMeter(nodeRead, nbrNodes, true, "Reading nodes");
+  }
+  return true;
 }
 
-static std::pair<int, MElement *> *
-readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
-                 unsigned long &nbrElements, unsigned long &maxElementNum,
+static bool
+readMSH4Elements(GModel *const model, FILE *fp, bool binary,
+                 std::vector<std::pair<std::size_t, MElement *> > &elementCache,
                  bool swap)
 {
   char str[1024];
-  unsigned long numBlock = 0;
-  nbrElements = 0;
-  maxElementNum = 0;
+  unsigned long numBlock = 0, nbrElements = 0;
   if(binary) {
     unsigned long data[2];
     if(fread(data, sizeof(unsigned long), 2, fp) != 2) {
@@ -741,9 +672,7 @@ readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
   }
 
   unsigned long elementRead = 0;
-  unsigned long minElementNum = nbrElements + 1;
-  std::pair<int, MElement *> *elementCache =
-    new std::pair<int, MElement *>[nbrElements];
+  elementCache.resize(nbrElements);
   Msg::Info("%lu elements", nbrElements);
   for(unsigned int i = 0; i < numBlock; i++) {
     int entityTag = 0, entityDim = 0, elmType = 0;
@@ -752,7 +681,6 @@ readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
     if(binary) {
       int data[3];
       if(fread(data, sizeof(int), 3, fp) != 3) {
-        delete[] elementCache;
         return 0;
       }
       if(swap) SwapBytes((char *)data, sizeof(int), 3);
@@ -763,7 +691,6 @@ readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
 
       unsigned long dataLong;
       if(fread(&dataLong, sizeof(unsigned long), 1, fp) != 1) {
-        delete[] elementCache;
         return 0;
       }
       if(swap) SwapBytes((char *)&dataLong, sizeof(unsigned long), 1);
@@ -772,7 +699,6 @@ readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
     else {
       if(fscanf(fp, "%d %d %d %lu", &entityTag, &entityDim, &elmType,
                 &numElements) != 4) {
-        delete[] elementCache;
         return 0;
       }
     }
@@ -780,7 +706,6 @@ readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
     GEntity *entity = model->getEntityByTag(entityDim, entityTag);
     if(!entity) {
       Msg::Error("Unknown entity %d of dimension %d", entityTag, entityDim);
-      delete[] elementCache;
       return 0;
     }
     if(entity->geomType() == GEntity::GhostCurve) {
@@ -798,29 +723,67 @@ readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
       int *data = new int[numElements * (nbrVertices + 1)];
       if(fread(data, sizeof(int), numElements * (nbrVertices + 1), fp) !=
          numElements * (nbrVertices + 1)) {
-        delete[] elementCache;
         delete[] data;
         return 0;
       }
       if(swap)
         SwapBytes((char *)data, sizeof(int), numElements * (nbrVertices + 1));
 
-      std::vector<MVertex *> vertices(nbrVertices, (MVertex *)0);
-      for(unsigned int j = 0; j < numElements * (nbrVertices + 1);
-          j += (nbrVertices + 1)) {
+      if(elementRead + numElements > nbrElements) {
+        Msg::Error("Too many elements in entity %d of dimension %d",
+                   entityTag, entityDim);
+        delete[] data;
+        return 0;
+      }
+
+      // make sure the vertex cache is built before the (read-only) concurrent
+      // lookups below
+      model->rebuildMeshVertexCache(true);
+
+      // create the elements of the block in parallel
+      std::vector<MElement *> elements(numElements, (MElement *)0);
+      bool missingVertex = false;
+      int unknownVertex = 0, unknownVertexElement = 0;
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+      for(std::size_t j = 0; j < numElements; j++) {
+        const int *ed = &data[j * (nbrVertices + 1)];
+        std::vector<MVertex *> vertices(nbrVertices, (MVertex *)0);
+        bool ok = true;
         for(int k = 0; k < nbrVertices; k++) {
-          vertices[k] = model->getMeshVertexByTag(data[j + k + 1]);
+          vertices[k] = model->getMeshVertexByTag(ed[k + 1]);
           if(!vertices[k]) {
-            Msg::Error("Unknown vertex %d in element %d", data[j + k + 1],
-                       data[j]);
-            delete[] elementCache;
-            return 0;
+#if defined(_OPENMP)
+#pragma omp critical(readMSH4UnknownVertex)
+#endif
+            {
+              missingVertex = true;
+              unknownVertex = ed[k + 1];
+              unknownVertexElement = ed[0];
+            }
+            ok = false;
+            break;
           }
         }
-
+        if(!ok) continue;
         MElementFactory elementFactory;
-        MElement *element = elementFactory.create(elmType, vertices, data[j], 0,
-                                                  false, 0, 0, 0, 0);
+        elements[j] = elementFactory.create(elmType, vertices, ed[0], 0, false,
+                                            0, 0, 0, 0);
+      }
+
+      if(missingVertex) {
+        Msg::Error("Unknown vertex %d in element %d", unknownVertex,
+                   unknownVertexElement);
+        for(std::size_t j = 0; j < numElements; j++)
+          if(elements[j]) delete elements[j];
+        delete[] data;
+        return 0;
+      }
+
+      for(std::size_t j = 0; j < numElements; j++) {
+        MElement *element = elements[j];
+        const int elmTag = data[j * (nbrVertices + 1)];
 
         if(entity->geomType() != GEntity::GhostCurve &&
            entity->geomType() != GEntity::GhostSurface &&
@@ -828,29 +791,22 @@ readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
           entity->addElement(element->getType(), element);
         }
 
-        minElementNum = std::min(minElementNum, (unsigned long)data[j]);
-        maxElementNum = std::max(maxElementNum, (unsigned long)data[j]);
-
-        elementCache[elementRead] =
-          std::pair<int, MElement *>(data[j], element);
+        elementCache[elementRead] = std::make_pair(elmTag, element);
         elementRead++;
-
-        if(nbrElements > 100000)
-          Msg::ProgressMeter(elementRead, nbrElements, true,
-                             "Reading elements");
       }
 
+      if(nbrElements > 100000)
+        Msg::ProgressMeter(elementRead, nbrElements, true, "Reading elements");
+
       delete[] data;
     }
     else {
       for(unsigned int j = 0; j < numElements; j++) {
         int elmTag = 0;
         if(fscanf(fp, "%d", &elmTag) != 1) {
-          delete[] elementCache;
           return 0;
         }
         if(!fgets(str, sizeof(str), fp)) {
-          delete[] elementCache;
           return 0;
         }
 
@@ -860,13 +816,11 @@ readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
           int vertexTag = 0;
           if(k != nbrVertices - 1) {
             if(sscanf(str, "%d %[0-9- ]", &vertexTag, str) != 2) {
-              delete[] elementCache;
               return 0;
             }
           }
           else {
             if(sscanf(str, "%d", &vertexTag) != 1) {
-              delete[] elementCache;
               return 0;
             }
           }
@@ -874,7 +828,6 @@ readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
           vertices[k] = model->getMeshVertexByTag(vertexTag);
           if(!vertices[k]) {
             Msg::Error("Unknown vertex %d in element %d", vertexTag, elmTag);
-            delete[] elementCache;
             return 0;
           }
         }
@@ -889,10 +842,7 @@ readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
           entity->addElement(element->getType(), element);
         }
 
-        minElementNum = std::min(minElementNum, (unsigned long)elmTag);
-        maxElementNum = std::max(maxElementNum, (unsigned long)elmTag);
-
-        elementCache[elementRead] = std::pair<int, MElement *>(elmTag, element);
+        elementCache[elementRead] = std::make_pair(elmTag, element);
         elementRead++;
 
         if(nbrElements > 100000)
@@ -901,23 +851,7 @@ readMSH4Elements(GModel *const model, FILE *fp, bool binary, bool &dense,
       }
     }
   }
-  // if the vertex numbering is dense, we fill the vector cache, otherwise we
-  // fill the map cache
-  if(minElementNum == 1 && maxElementNum == nbrElements) {
-    Msg::Debug("Element numbering is dense");
-    dense = true;
-  }
-  else if(maxElementNum < 10 * nbrElements) {
-    Msg::Debug(
-      "Element numbering is fairly dense - still caching with a vector");
-    dense = true;
-  }
-  else {
-    Msg::Debug("Element numbering is not dense");
-    dense = false;
-  }
-
-  return elementCache;
+  return true;
 }
 
 static bool readMSH4PeriodicNodes(GModel *const model, FILE *fp, bool binary,
@@ -1283,74 +1217,28 @@ int GModel::_readMSH4(const std::string &name)
       partitioned = true;
     }
     else if(!strncmp(&str[1], "Nodes", 5)) {
-      _vertexVectorCache.clear();
-      _vertexMapCache.clear();
       Msg::ResetProgressMeter();
-      bool dense = false;
-      unsigned long nbrNodes = 0, maxNodeNum;
-      std::pair<int, MVertex *> *vertexCache =
-        readMSH4Nodes(this, fp, binary, dense, nbrNodes, maxNodeNum, swap);
-      if(!vertexCache) {
+      std::vector<std::pair<std::size_t, MVertex *> > vertexCache;
+      if(!readMSH4Nodes(this, fp, binary, vertexCache, swap)) {
         Msg::Error("Could not read vertices");
         fclose(fp);
         return false;
       }
-      if(dense) {
-        _vertexVectorCache.resize(maxNodeNum + 1, 0);
-        for(unsigned int i = 0; i < nbrNodes; i++) {
-          if(!_vertexVectorCache[vertexCache[i].first]) {
-            _vertexVectorCache[vertexCache[i].first] = vertexCache[i].second;
-          }
-          else {
-            Msg::Info("Skipping duplicate vertex %d", vertexCache[i].first);
-          }
-        }
-      }
-      else {
-        for(unsigned int i = 0; i < nbrNodes; i++) {
-          if(_vertexMapCache.count(vertexCache[i].first) == 0) {
-            _vertexMapCache[vertexCache[i].first] = vertexCache[i].second;
-          }
-          else {
-            Msg::Info("Skipping duplicate vertex %d", vertexCache[i].first);
-          }
-        }
-      }
-      delete[] vertexCache;
+      std::size_t numDuplicates = _vertexTagCache.build(vertexCache);
+      if(numDuplicates)
+        Msg::Info("Skipping %d duplicate vertices", (int)numDuplicates);
     }
     else if(!strncmp(&str[1], "Elements", 8)) {
       Msg::ResetProgressMeter();
-      bool dense = false;
-      unsigned long nbrElements = 0, maxElementNum = 0;
-      std::pair<int, MElement *> *elementCache = readMSH4Elements(
-        this, fp, binary, dense, nbrElements, maxElementNum, swap);
-      if(!elementCache) {
+      std::vector<std::pair<std::size_t, MElement *> > elementCache;
+      if(!readMSH4Elements(this, fp, binary, elementCache, swap)) {
         Msg::Error("Could not read elements");
         fclose(fp);
         return 0;
       }
-      if(dense) {
-        _elementVectorCache.resize(maxElementNum + 1, (MElement *)0);
-        for(unsigned int i = 0; i < nbrElements; i++) {
-          if(!_elementVectorCache[elementCache[i].first]) {
-            _elementVectorCache[elementCache[i].first] = elementCache[i].second;
-          }
-          else {
-            Msg::Info("Skipping duplicate element %d", elementCache[i].first);
-          }
-        }
-      }
-      else {
-        for(unsigned int i = 0; i < nbrElements; i++) {
-          if(_elementMapCache.count(elementCache[i].first) == 0) {
-            _elementMapCache[elementCache[i].first] = elementCache[i].second;
-          }
-          else {
-            Msg::Info("Skipping duplicate element %d", elementCache[i].first);
-          }
-        }
-      }
-      delete[] elementCache;
+      std::size_t numDuplicates = _elementTagCache.build(elementCache);
+      if(numDuplicates)
+        Msg::Info("Skipping %d duplicate elements", (int)numDuplicates);
     }
     else if(!strncmp(&str[1], "Periodic", 8)) {
       if(!readMSH4PeriodicNodes(this, fp, binary, swap)) {
@@ -2013,6 +1901,54 @@ getAdditionalEntities(std::set<GRegion *, GEntityLessThan> &regions,
   return numVertices;
 }
 
+static void writeMSH4EntityNodes(GEntity *const entity, FILE *fp, bool binary,
+                                 int saveParametric, double scalingFactor)
+{
+  const std::size_t numVerts = entity->getNumMeshVertices();
+
+  if(!binary) {
+    fprintf(fp, "%d %d %d %lu\n", entity->tag(), entity->dim(), saveParametric,
+            (unsigned long)numVerts);
+    for(std::size_t i = 0; i < numVerts; i++)
+      entity->getMeshVertex(i)->writeMSH4(fp, binary, saveParametric,
+                                          scalingFactor);
+    return;
+  }
+
+  // in binary mode all the nodes of the block have the same size: serialize
+  // them in parallel in a memory buffer, and write the block (header included)
+  // with a single call
+  int numParams = 0;
+  if(saveParametric)
+    numParams = (entity->dim() == 1) ? 1 : (entity->dim() == 2) ? 2 : 0;
+  const std::size_t headerSize = 3 * sizeof(int) + sizeof(unsigned long);
+  const std::size_t nodeSize = sizeof(int) + (3 + numParams) * sizeof(double);
+
+  std::vector<char> buffer(headerSize + numVerts * nodeSize);
+  int header[3] = {entity->tag(), entity->dim(), saveParametric};
+  unsigned long numVertsLong = numVerts;
+  memcpy(&buffer[0], header, 3 * sizeof(int));
+  memcpy(&buffer[3 * sizeof(int)], &numVertsLong, sizeof(unsigned long));
+
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for(std::size_t i = 0; i < numVerts; i++) {
+    MVertex *v = entity->getMeshVertex(i);
+    char *p = &buffer[headerSize + i * nodeSize];
+    // FIXME change this for MSH4.1
+    int num = (int)v->getNum();
+    double data[5] = {v->x() * scalingFactor, v->y() * scalingFactor,
+                      v->z() * scalingFactor, 0., 0.};
+    if(numParams >= 1) v->getParameter(0, data[3]);
+    if(numParams == 2) v->getParameter(1, data[4]);
+    memcpy(p, &num, sizeof(int));
+    memcpy(p + sizeof(int), data, (3 + numParams) * sizeof(double));
+  }
+
+  fwrite(&buffer[0], 1, buffer.size(), fp);
+}
+
 static void writeMSH4Nodes(GModel *const model, FILE *fp, bool partitioned,
                            bool binary, int saveParametric,
                            double scalingFactor, bool saveAll)
@@ -2087,85 +2023,17 @@ static void writeMSH4Nodes(GModel *const model, FILE *fp, bool partitioned,
             numVertices);
   }
 
-  for(GModel::viter it = vertices.begin(); it != vertices.end(); ++it) {
-    if(binary) {
-      int entityTag = (*it)->tag();
-      int entityDim = (*it)->dim();
-      unsigned long numVerts = (*it)->getNumMeshVertices();
-      fwrite(&entityTag, sizeof(int), 1, fp);
-      fwrite(&entityDim, sizeof(int), 1, fp);
-      fwrite(&saveParametric, sizeof(int), 1, fp);
-      fwrite(&numVerts, sizeof(unsigned long), 1, fp);
-    }
-    else {
-      fprintf(fp, "%d %d %d %lu\n", (*it)->tag(), (*it)->dim(), saveParametric,
-              (unsigned long)(*it)->getNumMeshVertices());
-    }
+  for(GModel::viter it = vertices.begin(); it != vertices.end(); ++it)
+    writeMSH4EntityNodes(*it, fp, binary, saveParametric, scalingFactor);
 
-    for(std::size_t i = 0; i < (*it)->getNumMeshVertices(); i++)
-      (*it)->getMeshVertex(i)->writeMSH4(fp, binary, saveParametric,
-                                         scalingFactor);
-  }
+  for(GModel::eiter it = edges.begin(); it != edges.end(); ++it)
+    writeMSH4EntityNodes(*it, fp, binary, saveParametric, scalingFactor);
 
-  for(GModel::eiter it = edges.begin(); it != edges.end(); ++it) {
-    if(binary) {
-      int entityTag = (*it)->tag();
-      int entityDim = (*it)->dim();
-      unsigned long numVerts = (*it)->getNumMeshVertices();
-      fwrite(&entityTag, sizeof(int), 1, fp);
-      fwrite(&entityDim, sizeof(int), 1, fp);
-      fwrite(&saveParametric, sizeof(int), 1, fp);
-      fwrite(&numVerts, sizeof(unsigned long), 1, fp);
-    }
-    else {
-      fprintf(fp, "%d %d %d %lu\n", (*it)->tag(), (*it)->dim(), saveParametric,
-              (unsigned long)(*it)->getNumMeshVertices());
-    }
+  for(GModel::fiter it = faces.begin(); it != faces.end(); ++it)
+    writeMSH4EntityNodes(*it, fp, binary, saveParametric, scalingFactor);
 
-    for(std::size_t i = 0; i < (*it)->getNumMeshVertices(); i++)
-      (*it)->getMeshVertex(i)->writeMSH4(fp, binary, saveParametric,
-                                         scalingFactor);
-  }
-
-  for(GModel::fiter it = faces.begin(); it != faces.end(); ++it) {
-    if(binary) {
-      int entityTag = (*it)->tag();
-      int entityDim = (*it)->dim();
-      unsigned long numVerts = (*it)->getNumMeshVertices();
-      fwrite(&entityTag, sizeof(int), 1, fp);
-      fwrite(&entityDim, sizeof(int), 1, fp);
-      fwrite(&saveParametric, sizeof(int), 1, fp);
-      fwrite(&numVerts, sizeof(unsigned long), 1, fp);
-    }
-    else {
-      fprintf(fp, "%d %d %d %lu\n", (*it)->tag(), (*it)->dim(), saveParametric,
-              (unsigned long)(*it)->getNumMeshVertices());
-    }
-
-    for(std::size_t i = 0; i < (*it)->getNumMeshVertices(); i++)
-      (*it)->getMeshVertex(i)->writeMSH4(fp, binary, saveParametric,
-                                         scalingFactor);
-  }
-
-  for(GModel::riter it = regions.begin(); it != regions.end(); ++it) {
-    if(binary) {
-      int entityTag = (*it)->tag();
-      int entityDim = (*it)->dim();
-      unsigned long numVerts = (*it)->getNumMeshVertices();
-      fwrite(&entityTag, sizeof(int), 1, fp);
-      fwrite(&entityDim, sizeof(int), 1, fp);
-      fwrite(&saveParametric, sizeof(int), 1, fp);
-      fwrite(&numVerts, sizeof(unsigned long), 1, fp);
-    }
-    else {
-      fprintf(fp, "%d %d %d %lu\n", (*it)->tag(), (*it)->dim(), saveParametric,
-              (unsigned long)(*it)->getNumMeshVertices());
-    }
-
-    for(std::size_t i = 0; i < (*it)->getNumMeshVertices(); i++)
-      (*it)->getMeshVertex(i)->writeMSH4(fp, binary, saveParametric,
-                                         scalingFactor);
-  }
+  for(GModel::riter it = regions.begin(); it != regions.end(); ++it)
+    writeMSH4EntityNodes(*it, fp, binary, saveParametric, scalingFactor);
 
   if(binary) fprintf(fp, "\n");
 }
@@ -2327,16 +2195,18 @@ static void writeMSH4Elements(GModel *const model, FILE *fp, bool partitioned,
 
       if(binary) {
         const int nbrVertices = MElement::getInfoMSH(elmType);
-        int indexElement = 0;
-        int *elementData = new int[it->second.size() * (nbrVertices + 1)];
-        for(std::size_t i = 0; i < it->second.size() * (nbrVertices + 1);
-            i += (nbrVertices + 1)) {
-          elementData[i] = it->second[indexElement]->getNum();
+        const std::size_t numElm = it->second.size();
+        int *elementData = new int[numElm * (nbrVertices + 1)];
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+        for(std::size_t i = 0; i < numElm; i++) {
+          MElement *e = it->second[i];
+          int *ed = &elementData[i * (nbrVertices + 1)];
+          ed[0] = e->getNum();
           for(int j = 0; j < nbrVertices; j++) {
-            elementData[i + 1 + j] =
-              it->second[indexElement]->getVertex(j)->getNum();
+            ed[1 + j] = e->getVertex(j)->getNum();
           }
-          indexElement++;
         }
         fwrite(elementData, sizeof(int), it->second.size() * (nbrVertices + 1),
                fp);
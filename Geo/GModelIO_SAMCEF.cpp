@@ -38,7 +38,7 @@ int GModel::readSAMCEF(const std::string &name)
     return 0;
   }
 
-  _vertexMapCache.clear();
+  std::map<int, MVertex *> vertexMap;
   std::map<int, std::vector<MElement *> > elements[2];
   char buffer[256], dummy[256];
 
@@ -54,9 +54,10 @@ int GModel::readSAMCEF(const std::string &name)
         if(sscanf(buffer, "%s %d %s %lf %s %lf %s %lf", dummy, &num, dummy, &x,
                   dummy, &y, dummy, &z) != 8)
           return 0;
-        _vertexMapCache[num] = new MVertex(x, y, z, 0, num);
+        vertexMap[num] = new MVertex(x, y, z, 0, num);
       }
-      Msg::Info("Read %d mesh vertices", (int)_vertexMapCache.size());
+      _cacheMeshVertices(vertexMap);
+      Msg::Info("Read %d mesh vertices", (int)vertexMap.size());
     }
     else if(!strncmp(buffer, ".MAI", 4)) {
       while(!feof(fp)) {
@@ -90,7 +91,7 @@ int GModel::readSAMCEF(const std::string &name)
   for(int i = 0; i < (int)(sizeof(elements) / sizeof(elements[0])); i++)
     _storeElementsInEntities(elements[i]);
   _associateEntityWithMeshVertices();
-  _storeVerticesInEntities(_vertexMapCache);
+  _storeVerticesInEntities(vertexMap);
 
   fclose(fp);
   return 1;
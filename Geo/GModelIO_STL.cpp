@@ -9,7 +9,7 @@
 #include "MLine.h"
 #include "MTriangle.h"
 #include "MQuadrangle.h"
-#include "MVertexRTree.h"
+#include "DuplicatePoints.h"
 #include "discreteFace.h"
 #include "StringUtils.h"
 #include "Context.h"
@@ -140,25 +140,25 @@ int GModel::readSTL(const std::string &name, double tolerance)
 
   // create triangles using unique vertices
   double eps = norm(SVector3(bbox.max(), bbox.min())) * tolerance;
-  std::vector<MVertex *> vertices;
+  std::vector<SPoint3> allPoints;
   for(std::size_t i = 0; i < points.size(); i++)
-    for(std::size_t j = 0; j < points[i].size(); j++)
-      vertices.push_back(
-        new MVertex(points[i][j].x(), points[i][j].y(), points[i][j].z()));
-  MVertexRTree pos(eps);
-  pos.insert(vertices);
+    allPoints.insert(allPoints.end(), points[i].begin(), points[i].end());
+  std::vector<std::size_t> rep;
+  FindDuplicatePoints(allPoints, eps, rep);
+  std::vector<MVertex *> vertices(allPoints.size(), (MVertex *)0);
+  for(std::size_t i = 0; i < allPoints.size(); i++) {
+    if(rep[i] == i)
+      vertices[i] =
+        new MVertex(allPoints[i].x(), allPoints[i].y(), allPoints[i].z());
+  }
 
   std::set<MFace, Less_Face> unique;
   int nbDuplic = 0;
+  std::size_t offset = 0;
   for(std::size_t i = 0; i < points.size(); i++) {
     for(std::size_t j = 0; j < points[i].size(); j += 3) {
       MVertex *v[3];
-      for(int k = 0; k < 3; k++) {
-        double x = points[i][j + k].x();
-        double y = points[i][j + k].y();
-        double z = points[i][j + k].z();
-        v[k] = pos.find(x, y, z);
-      }
+      for(int k = 0; k < 3; k++) v[k] = vertices[rep[offset + j + k]];
       if(CTX::instance()->mesh.stlRemoveDuplicateTriangles){
         MFace mf(v[0], v[1], v[2]);
         if(unique.find(mf) == unique.end()) {
@@ -173,6 +173,7 @@ int GModel::readSTL(const std::string &name, double tolerance)
         faces[i]->triangles.push_back(new MTriangle(v[0], v[1], v[2]));
       }
     }
+    offset += points[i].size();
   }
   if(nbDuplic) Msg::Warning("%d duplicate triangles in STL file", nbDuplic);
 
@@ -45,7 +45,7 @@ int GModel::readUNV(const std::string &name)
   std::map<int, std::vector<MElement *> > elements[7];
   std::map<int, std::map<int, std::string> > physicals[4];
 
-  _vertexMapCache.clear();
+  std::map<int, MVertex *> vertexMap;
 
   while(!gmsheof(fp)) {
     if(!gmshgets(buffer, sizeof(buffer), fp)) break;
@@ -66,8 +66,9 @@ int GModel::readUNV(const std::string &name)
           for(std::size_t i = 0; i < strlen(buffer); i++)
             if(buffer[i] == 'D') buffer[i] = 'E';
           if(sscanf(buffer, "%lf %lf %lf", &x, &y, &z) != 3) break;
-          _vertexMapCache[num] = new MVertex(x, y, z, 0, num);
+          vertexMap[num] = new MVertex(x, y, z, 0, num);
         }
+        _cacheMeshVertices(vertexMap);
       }
       else if(record == 2412) { // elements
         Msg::Info("Reading elements");
@@ -261,7 +262,7 @@ int GModel::readUNV(const std::string &name)
   for(int i = 0; i < (int)(sizeof(elements) / sizeof(elements[0])); i++)
     _storeElementsInEntities(elements[i]);
   _associateEntityWithMeshVertices();
-  _storeVerticesInEntities(_vertexMapCache);
+  _storeVerticesInEntities(vertexMap);
 
   for(int i = 0; i < 4; i++) _storePhysicalTagsInEntities(i, physicals[i]);
 
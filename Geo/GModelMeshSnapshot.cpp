@@ -0,0 +1,133 @@
+// Gmsh - Copyright (C) 1997-2019 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
+
+#include "GModelMeshSnapshot.h"
+#include "GModel.h"
+#include "MElement.h"
+#include "ElementType.h"
+
+const std::vector<std::size_t> GModelMeshSnapshot::_empty;
+
+namespace {
+  // a block of elements of the same type, stored contiguously in an entity
+  struct elementBlock {
+    GEntity *entity;
+    int familyType;
+    std::size_t offset;
+  };
+
+  // the element families that are exported, for each dimension (this should
+  // match _getEntitiesForElementTypes() in the API)
+  void getFamilyTypes(int dim, std::vector<int> &families)
+  {
+    families.clear();
+    switch(dim) {
+    case 0: families.push_back(TYPE_PNT); break;
+    case 1: families.push_back(TYPE_LIN); break;
+    case 2:
+      families.push_back(TYPE_TRI);
+      families.push_back(TYPE_QUA);
+      break;
+    case 3:
+      families.push_back(TYPE_TET);
+      families.push_back(TYPE_HEX);
+      families.push_back(TYPE_PRI);
+      families.push_back(TYPE_PYR);
+      break;
+    }
+  }
+} // namespace
+
+GModelMeshSnapshot::GModelMeshSnapshot(GModel *model, std::size_t version)
+  : _version(version)
+{
+  std::vector<GEntity *> entities;
+  model->getEntities(entities);
+
+  // nodes
+  std::size_t numNodes = 0;
+  for(std::size_t i = 0; i < entities.size(); i++)
+    numNodes += entities[i]->mesh_vertices.size();
+  _nodeTags.resize(numNodes);
+  _coord.resize(3 * numNodes);
+  std::size_t offset = 0;
+  for(std::size_t i = 0; i < entities.size(); i++) {
+    const std::vector<MVertex *> &v = entities[i]->mesh_vertices;
+    if(v.empty()) continue;
+    std::size_t *tags = &_nodeTags[0] + offset;
+    double *xyz = &_coord[0] + 3 * offset;
+    const int n = v.size();
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+    for(int j = 0; j < n; j++) {
+      tags[j] = v[j]->getNum();
+      xyz[3 * j] = v[j]->x();
+      xyz[3 * j + 1] = v[j]->y();
+      xyz[3 * j + 2] = v[j]->z();
+    }
+    offset += n;
+  }
+
+  // elements: the type of each block is given by its first element, as in
+  // the API
+  std::map<int, std::vector<elementBlock> > blocks;
+  std::map<int, std::size_t> numElements;
+  std::vector<int> families;
+  for(std::size_t i = 0; i < entities.size(); i++) {
+    GEntity *ge = entities[i];
+    getFamilyTypes(ge->dim(), families);
+    for(std::size_t j = 0; j < families.size(); j++) {
+      std::size_t n = ge->getNumMeshElementsByType(families[j]);
+      if(!n) continue;
+      int type = ge->getMeshElementByType(families[j], 0)->getTypeForMSH();
+      elementBlock b = {ge, families[j], numElements[type]};
+      blocks[type].push_back(b);
+      numElements[type] += n;
+    }
+  }
+  for(std::map<int, std::vector<elementBlock> >::iterator it = blocks.begin();
+      it != blocks.end(); it++) {
+    const int type = it->first;
+    const std::size_t numNodesPerEle = ElementType::getNumVertices(type);
+    std::vector<std::size_t> &elementTags = _elementTags[type];
+    std::vector<std::size_t> &nodeTags = _elementNodeTags[type];
+    elementTags.resize(numElements[type]);
+    nodeTags.resize(numElements[type] * numNodesPerEle);
+    for(std::size_t i = 0; i < it->second.size(); i++) {
+      const elementBlock &b = it->second[i];
+      std::size_t *etags = &elementTags[0] + b.offset;
+      std::size_t *ntags = &nodeTags[0] + b.offset * numNodesPerEle;
+      const int n = b.entity->getNumMeshElementsByType(b.familyType);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+      for(int j = 0; j < n; j++) {
+        MElement *e = b.entity->getMeshElementByType(b.familyType, j);
+        etags[j] = e->getNum();
+        for(std::size_t k = 0; k < numNodesPerEle; k++)
+          ntags[j * numNodesPerEle + k] = e->getVertex(k)->getNum();
+      }
+    }
+  }
+}
+
+const std::vector<std::size_t> &
+GModelMeshSnapshot::getElementTags(int elementType) const
+{
+  std::map<int, std::vector<std::size_t> >::const_iterator it =
+    _elementTags.find(elementType);
+  if(it == _elementTags.end()) return _empty;
+  return it->second;
+}
+
+const std::vector<std::size_t> &
+GModelMeshSnapshot::getElementNodeTags(int elementType) const
+{
+  std::map<int, std::vector<std::size_t> >::const_iterator it =
+    _elementNodeTags.find(elementType);
+  if(it == _elementNodeTags.end()) return _empty;
+  return it->second;
+}
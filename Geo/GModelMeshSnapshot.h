@@ -0,0 +1,46 @@
+// Gmsh - Copyright (C) 1997-2019 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
+
+#ifndef _GMODEL_MESH_SNAPSHOT_H_
+#define _GMODEL_MESH_SNAPSHOT_H_
+
+#include <cstddef>
+#include <vector>
+#include <map>
+
+class GModel;
+
+// An immutable copy of the mesh of a model, stored as contiguous arrays
+// (structure of arrays): the node tags and coordinates of all the nodes, and
+// for each element type (in MSH numbering) the element tags and the node tags
+// of all the elements. The ordering is the same as the one of the
+// corresponding gmsh::model::mesh::getNodes() and getElementsByType() API
+// calls: entities in model order, then nodes or elements in entity order.
+//
+// A snapshot is created on demand by GModel::getMeshSnapshot() and is deleted
+// with the other mesh caches; it is thus valid as long as the mesh version of
+// the model (GModel::getMeshVersion()) does not change.
+class GModelMeshSnapshot {
+private:
+  // the mesh version of the model when the snapshot was created
+  std::size_t _version;
+  std::vector<std::size_t> _nodeTags;
+  std::vector<double> _coord;
+  std::map<int, std::vector<std::size_t> > _elementTags, _elementNodeTags;
+  static const std::vector<std::size_t> _empty;
+
+public:
+  GModelMeshSnapshot(GModel *model, std::size_t version);
+  std::size_t getVersion() const { return _version; }
+  // node tags and concatenated [x1, y1, z1, x2, ...] coordinates
+  const std::vector<std::size_t> &getNodeTags() const { return _nodeTags; }
+  const std::vector<double> &getCoordinates() const { return _coord; }
+  // element tags and concatenated node tags of the elements of the given type
+  // (empty if there are no such elements)
+  const std::vector<std::size_t> &getElementTags(int elementType) const;
+  const std::vector<std::size_t> &getElementNodeTags(int elementType) const;
+};
+
+#endif
@@ -31,40 +31,61 @@
 #include "qualityMeasuresJacobian.h"
 #endif
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 #define SQU(a) ((a) * (a))
 
 double MElement::_isInsideTolerance = 1.e-6;
 
-MElement::MElement(std::size_t num, int part) : _visible(1)
-{
 #if defined(_OPENMP)
-#pragma omp critical
+// in parallel regions element numbers are reserved by chunks, so that threads
+// creating elements concurrently do not all contend on the model counter
+struct elementNumberRange {
+  GModel *model;
+  std::size_t epoch, next, last;
+};
+static elementNumberRange threadElementRange = {0, 0, 1, 0};
+#pragma omp threadprivate(threadElementRange)
 #endif
-  {
-    // we should make GModel a mandatory argument to the constructor
-    GModel *m = GModel::current();
-    if(num) {
-      _num = num;
-      m->setMaxElementNumber(std::max(m->getMaxElementNumber(), _num));
-    }
-    else {
-      m->setMaxElementNumber(m->getMaxElementNumber() + 1);
-      _num = m->getMaxElementNumber();
-    }
-    _partition = (short)part;
-  }
-}
 
-void MElement::forceNum(std::size_t num)
+static std::size_t newElementNumber(GModel *m)
 {
 #if defined(_OPENMP)
-#pragma omp critical
+  if(omp_in_parallel()) {
+    elementNumberRange &r = threadElementRange;
+    if(r.model != m || r.epoch != m->getElementNumberEpoch() ||
+       r.next > r.last) {
+      const std::size_t chunk = 64;
+      r.model = m;
+      r.epoch = m->getElementNumberEpoch();
+      r.next = m->reserveElementNumbers(chunk);
+      r.last = r.next + chunk - 1;
+    }
+    return r.next++;
+  }
 #endif
-  {
-    GModel *m = GModel::current();
+  return m->reserveElementNumbers(1);
+}
+
+MElement::MElement(std::size_t num, int part, GModel *model) : _visible(1)
+{
+  GModel *m = model ? model : GModel::current();
+  if(num) {
     _num = num;
-    m->setMaxElementNumber(std::max(m->getMaxElementNumber(), _num));
+    m->updateMaxElementNumber(_num);
+  }
+  else {
+    _num = newElementNumber(m);
   }
+  _partition = (short)part;
+}
+
+void MElement::forceNum(std::size_t num)
+{
+  _num = num;
+  GModel::current()->updateMaxElementNumber(_num);
 }
 
 void MElement::setTolerance(const double tol) { _isInsideTolerance = tol; }
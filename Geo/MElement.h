@@ -55,7 +55,9 @@ protected:
                            int &rot);
 
 public:
-  MElement(std::size_t num = 0, int part = 0);
+  // if num is zero a new number is allocated in the model (the current model
+  // if model is not provided)
+  MElement(std::size_t num = 0, int part = 0, GModel *model = 0);
   virtual ~MElement() {}
 
   // set/get the tolerance for isInside() test
@@ -3,10 +3,11 @@
 // See the LICENSE.txt file for license information. Please report all
 // issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
 
+#include <algorithm>
+#include <set>
 #include "GModel.h"
 #include "MElement.h"
 #include "MElementOctree.h"
-#include "Octree.h"
 #include "Context.h"
 #include "fullMatrix.h"
 #include "bezierBasis.h"
@@ -59,26 +60,6 @@ void MElementBB(void *a, double *min, double *max)
   }
 }
 
-static void MElementCentroid(void *a, double *x)
-{
-  MElement *e = (MElement *)a;
-  MVertex *v = e->getVertex(0);
-  int n = e->getNumVertices();
-  x[0] = v->x();
-  x[1] = v->y();
-  x[2] = v->z();
-  for(int i = 1; i < n; i++) {
-    v = e->getVertex(i);
-    x[0] += v->x();
-    x[1] += v->y();
-    x[2] += v->z();
-  }
-  double oc = 1. / (double)n;
-  x[0] *= oc;
-  x[1] *= oc;
-  x[2] *= oc;
-}
-
 int MElementInEle(void *a, double *x)
 {
   MElement *e = (MElement *)a;
@@ -87,20 +68,66 @@ int MElementInEle(void *a, double *x)
   return e->isInside(uvw[0], uvw[1], uvw[2]) ? 1 : 0;
 }
 
+static bool MElementInEle(MElement *e, const double P[3], double uvw[3])
+{
+  double xyz[3] = {P[0], P[1], P[2]};
+  e->xyz2uvw(xyz, uvw);
+  return e->isInside(uvw[0], uvw[1], uvw[2]);
+}
+
+// keep the containing element with the smallest index
+class firstElementInside {
+private:
+  const std::vector<MElement *> &_elems;
+  const double *_P;
+  int _dim;
+
+public:
+  int best;
+  double uvw[3];
+  firstElementInside(const std::vector<MElement *> &elems, const double P[3],
+                     int dim)
+    : _elems(elems), _P(P), _dim(dim), best(-1)
+  {
+  }
+  void operator()(int k)
+  {
+    if(best >= 0 && k >= best) return;
+    MElement *e = _elems[k];
+    if(_dim != -1 && e->getDim() != _dim) return;
+    double u[3];
+    if(MElementInEle(e, _P, u)) {
+      best = k;
+      for(int i = 0; i < 3; i++) uvw[i] = u[i];
+    }
+  }
+};
+
+// collect the indices of all the containing elements
+class allElementsInside {
+private:
+  const std::vector<MElement *> &_elems;
+  const double *_P;
+  int _dim;
+
+public:
+  std::vector<int> found;
+  allElementsInside(const std::vector<MElement *> &elems, const double P[3],
+                    int dim)
+    : _elems(elems), _P(P), _dim(dim)
+  {
+  }
+  void operator()(int k)
+  {
+    MElement *e = _elems[k];
+    if(_dim != -1 && e->getDim() != _dim) return;
+    double u[3];
+    if(MElementInEle(e, _P, u)) found.push_back(k);
+  }
+};
+
 MElementOctree::MElementOctree(GModel *m) : _gm(m)
 {
-  SBoundingBox3d bb = m->bounds();
-  // make bounding box larger up to (absolute) geometrical tolerance
-  double eps = CTX::instance()->geom.tolerance;
-  SPoint3 bbmin = bb.min(), bbmax = bb.max(), bbeps(eps, eps, eps);
-  bbmin -= bbeps;
-  bbmax += bbeps;
-  double min[3] = {bbmin.x(), bbmin.y(), bbmin.z()};
-  double size[3] = {bbmax.x() - bbmin.x(), bbmax.y() - bbmin.y(),
-                    bbmax.z() - bbmin.z()};
-  const int maxElePerBucket = 100; // memory vs. speed trade-off
-  _octree = Octree_Create(maxElePerBucket, min, size, MElementBB,
-                          MElementCentroid, MElementInEle);
   std::vector<GEntity *> entities;
   m->getEntities(entities);
   // do not add Gvertex non-associated to any GEdge
@@ -109,44 +136,52 @@ MElementOctree::MElementOctree(GModel *m) : _gm(m)
       if(entities[i]->dim() == 0) {
         GVertex *gv = dynamic_cast<GVertex *>(entities[i]);
         if(gv && gv->edges().size() > 0) {
-          Octree_Insert(entities[i]->getMeshElement(j), _octree);
+          _elems.push_back(entities[i]->getMeshElement(j));
         }
       }
       else
-        Octree_Insert(entities[i]->getMeshElement(j), _octree);
+        _elems.push_back(entities[i]->getMeshElement(j));
     }
   }
-  // exit(1);
-  Octree_Arrange(_octree);
+  _build();
 }
 
 MElementOctree::MElementOctree(const std::vector<MElement *> &v)
   : _gm(0), _elems(v)
 {
-  SBoundingBox3d bb;
-  for(std::size_t i = 0; i < v.size(); i++) {
-    for(std::size_t j = 0; j < v[i]->getNumVertices(); j++) {
-      // if (!_gm) _gm = v[i]->getVertex(j)->onWhat()->model();
-      bb += SPoint3(v[i]->getVertex(j)->x(), v[i]->getVertex(j)->y(),
-                    v[i]->getVertex(j)->z());
-    }
-  }
-  // make bounding box larger up to (absolute) geometrical tolerance
-  double eps = CTX::instance()->geom.tolerance;
-  SPoint3 bbmin = bb.min(), bbmax = bb.max(), bbeps(eps, eps, eps);
-  bbmin -= bbeps;
-  bbmax += bbeps;
-  double min[3] = {bbmin.x(), bbmin.y(), bbmin.z()};
-  double size[3] = {bbmax.x() - bbmin.x(), bbmax.y() - bbmin.y(),
-                    bbmax.z() - bbmin.z()};
-  const int maxElePerBucket = 100; // memory vs. speed trade-off
-  _octree = Octree_Create(maxElePerBucket, min, size, MElementBB,
-                          MElementCentroid, MElementInEle);
-  for(std::size_t i = 0; i < v.size(); i++) Octree_Insert(v[i], _octree);
-  Octree_Arrange(_octree);
+  _build();
 }
 
-MElementOctree::~MElementOctree() { Octree_Delete(_octree); }
+MElementOctree::~MElementOctree() {}
+
+void MElementOctree::_build()
+{
+  // create the bases of the elements beforehand, so that the threads only read
+  // the basis cache (when computing the bounding boxes of high-order elements,
+  // and when inverting the parametrization of the elements in the searches)
+  std::set<int> types;
+  for(std::size_t i = 0; i < _elems.size(); i++)
+    types.insert(_elems[i]->getTypeForMSH());
+  BasisFactory::preload(std::vector<int>(types.begin(), types.end()));
+
+  const int n = (int)_elems.size();
+  std::vector<double> bbs(6 * n);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+  for(int i = 0; i < n; i++) MElementBB(_elems[i], &bbs[6 * i], &bbs[6 * i + 3]);
+  _tree.build(bbs);
+}
+
+MElement *MElementOctree::_find(const double P[3], int dim,
+                                double uvw[3]) const
+{
+  firstElementInside f(_elems, P, dim);
+  _tree.search(P, f);
+  if(f.best < 0) return 0;
+  for(int i = 0; i < 3; i++) uvw[i] = f.uvw[i];
+  return _elems[f.best];
+}
 
 std::vector<MElement *> MElementOctree::findAll(double x, double y, double z,
                                                 int dim, bool strict)
@@ -155,39 +190,14 @@ std::vector<MElement *> MElementOctree::findAll(double x, double y, double z,
   double tolIncr = 10.;
 
   double P[3] = {x, y, z};
-  std::vector<void *> v;
+  allElementsInside f(_elems, P, dim);
+  _tree.search(P, f);
+  // return the elements in the order in which they were inserted
+  std::sort(f.found.begin(), f.found.end());
   std::vector<MElement *> e;
-  Octree_SearchAll(P, _octree, &v);
-  for(std::vector<void *>::iterator it = v.begin(); it != v.end(); ++it) {
-    MElement *el = (MElement *)*it;
-    if(dim == -1 || el->getDim() == dim) e.push_back(el);
-  }
-  if(e.empty() && !strict && _gm) {
-    double initialTol = MElement::getTolerance();
-    double tol = initialTol;
-    while(tol < maxTol) {
-      tol *= tolIncr;
-      MElement::setTolerance(tol);
-      std::vector<GEntity *> entities;
-      _gm->getEntities(entities);
-      for(std::size_t i = 0; i < entities.size(); i++) {
-        for(std::size_t j = 0; j < entities[i]->getNumMeshElements(); j++) {
-          MElement *el = entities[i]->getMeshElement(j);
-          if(dim == -1 || el->getDim() == dim) {
-            if(MElementInEle(el, P)) {
-              e.push_back(el);
-            }
-          }
-        }
-      }
-      if(!e.empty()) {
-        MElement::setTolerance(initialTol);
-        return e;
-      }
-    }
-    MElement::setTolerance(initialTol);
-  }
-  else if(e.empty() && !strict && !_gm) {
+  for(std::size_t i = 0; i < f.found.size(); i++)
+    e.push_back(_elems[f.found[i]]);
+  if(e.empty() && !strict) {
     double initialTol = MElement::getTolerance();
     double tol = initialTol;
     while(tol < maxTol) {
@@ -215,60 +225,49 @@ std::vector<MElement *> MElementOctree::findAll(double x, double y, double z,
 MElement *MElementOctree::find(double x, double y, double z, int dim,
                                bool strict) const
 {
-  double P[3] = {x, y, z};
-  MElement *e = (MElement *)Octree_Search(P, _octree);
-  if(e && (dim == -1 || e->getDim() == dim)) return e;
-  std::vector<void *> l;
-  if(e && e->getDim() != dim) {
-    Octree_SearchAll(P, _octree, &l);
-    for(std::vector<void *>::iterator it = l.begin(); it != l.end(); it++) {
-      MElement *el = (MElement *)*it;
-      if(el->getDim() == dim) {
-        return el;
-      }
-    }
-  }
-  if(!strict && _gm) {
-    double initialTol = MElement::getTolerance();
-    double tol = initialTol;
-    while(tol < 1.) {
-      tol *= 10;
-      MElement::setTolerance(tol);
-      std::vector<GEntity *> entities;
-      _gm->getEntities(entities);
-      for(std::size_t i = 0; i < entities.size(); i++) {
-        for(std::size_t j = 0; j < entities[i]->getNumMeshElements(); j++) {
-          e = entities[i]->getMeshElement(j);
-          if(dim == -1 || e->getDim() == dim) {
-            if(MElementInEle(e, P)) {
-              MElement::setTolerance(initialTol);
-              return e;
-            }
-          }
-        }
-      }
-    }
-    MElement::setTolerance(initialTol);
-    // Msg::Warning("Point %g %g %g not found",x,y,z);
-  }
-  else if(!strict && !_gm) {
-    double initialTol = MElement::getTolerance();
-    double tol = initialTol;
-    while(tol < 0.1) {
-      tol *= 10.0;
-      MElement::setTolerance(tol);
-      for(std::size_t i = 0; i < _elems.size(); i++) {
-        e = _elems[i];
-        if(dim == -1 || e->getDim() == dim) {
-          if(MElementInEle(e, P)) {
-            MElement::setTolerance(initialTol);
-            return e;
-          }
+  double P[3] = {x, y, z}, uvw[3];
+  MElement *e = _find(P, dim, uvw);
+  if(e || strict) return e;
+
+  // retry with increasing tolerances on the isInside() test (this modifies the
+  // global tolerance, and is thus not thread-safe)
+  double initialTol = MElement::getTolerance();
+  double tol = initialTol;
+  double maxTol = _gm ? 1. : 0.1;
+  while(tol < maxTol) {
+    tol *= 10.;
+    MElement::setTolerance(tol);
+    for(std::size_t i = 0; i < _elems.size(); i++) {
+      e = _elems[i];
+      if(dim == -1 || e->getDim() == dim) {
+        if(MElementInEle(e, P)) {
+          MElement::setTolerance(initialTol);
+          return e;
         }
       }
     }
-    MElement::setTolerance(initialTol);
-    // Msg::Warning("Point %g %g %g not found",x,y,z);
   }
+  MElement::setTolerance(initialTol);
+  // Msg::Warning("Point %g %g %g not found",x,y,z);
   return NULL;
 }
+
+void MElementOctree::find(const std::vector<double> &xyz,
+                          std::vector<MElement *> &elements,
+                          std::vector<double> &uvw, int dim, bool strict) const
+{
+  const int n = (int)(xyz.size() / 3);
+  elements.resize(n);
+  uvw.resize(3 * n);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+  for(int i = 0; i < n; i++) elements[i] = _find(&xyz[3 * i], dim, &uvw[3 * i]);
+  if(strict) return;
+  // non-strict searches change the global tolerance: perform them serially
+  for(int i = 0; i < n; i++) {
+    if(elements[i]) continue;
+    elements[i] = find(xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2], dim, false);
+    if(elements[i]) MElementInEle(elements[i], &xyz[3 * i], &uvw[3 * i]);
+  }
+}
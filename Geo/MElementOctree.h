@@ -7,16 +7,22 @@
 #define _MELEMENT_OCTREE_
 
 #include <vector>
+#include "BoundingBoxTree.h"
 
-class Octree;
 class GModel;
 class MElement;
 
+// Locate mesh elements by coordinates, using a bounding volume hierarchy of
+// the element bounding boxes. Strict searches do not modify the locator and
+// can be performed concurrently. When several elements contain a point, the
+// one that was inserted first is returned.
 class MElementOctree {
 private:
-  Octree *_octree;
   GModel *_gm;
   std::vector<MElement *> _elems;
+  BoundingBoxTree _tree;
+  void _build();
+  MElement *_find(const double P[3], int dim, double uvw[3]) const;
 
 public:
   MElementOctree(GModel *);
@@ -24,8 +30,13 @@ public:
   ~MElementOctree();
   MElement *find(double x, double y, double z, int dim = -1,
                  bool strict = false) const;
-  Octree *getInternalOctree() { return _octree; }
   std::vector<MElement *> findAll(double x, double y, double z, int dim,
                                   bool strict = false);
+  // locate the points xyz (3 coordinates per point) in parallel: elements[i]
+  // is the element containing point i (0 if none is found), and uvw[3 * i],
+  // uvw[3 * i + 1], uvw[3 * i + 2] are the parametric coordinates of the
+  // point in that element
+  void find(const std::vector<double> &xyz, std::vector<MElement *> &elements,
+            std::vector<double> &uvw, int dim = -1, bool strict = false) const;
 };
 #endif
@@ -0,0 +1,175 @@
+// Gmsh - Copyright (C) 1997-2019 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
+
+#ifndef _MTAG_INDEX_H_
+#define _MTAG_INDEX_H_
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+// Maps the tags of mesh vertices or elements to the corresponding objects.
+// Tags that form (nearly) contiguous ranges are stored in offset tables,
+// directly indexed by the tag; the remaining tags are stored in an
+// open-addressing hash table. For the usual dense numberings a lookup is thus
+// a single array access, and sparse numberings do not require a std::map.
+template <class T> class MTagIndex {
+private:
+  struct tagRange {
+    std::size_t first, last, offset;
+  };
+  std::vector<tagRange> _ranges;
+  std::vector<T *> _table;
+  std::vector<std::size_t> _hashKeys;
+  std::vector<T *> _hashValues;
+  std::size_t _size;
+  static std::size_t _emptyKey() { return (std::size_t)-1; }
+  static std::size_t _hash(std::size_t tag)
+  {
+    tag ^= tag >> 16;
+    tag *= 0x45d9f3b;
+    tag ^= tag >> 16;
+    return tag;
+  }
+  static bool _lessTag(const std::pair<std::size_t, T *> &a,
+                       const std::pair<std::size_t, T *> &b)
+  {
+    return a.first < b.first;
+  }
+  void _insertHash(std::size_t tag, T *t)
+  {
+    std::size_t mask = _hashKeys.size() - 1;
+    std::size_t i = _hash(tag) & mask;
+    while(_hashKeys[i] != _emptyKey()) i = (i + 1) & mask;
+    _hashKeys[i] = tag;
+    _hashValues[i] = t;
+  }
+  std::size_t _buildDense(std::vector<std::pair<std::size_t, T *> > &entries,
+                          std::size_t minTag, std::size_t maxTag,
+                          bool keepFirst)
+  {
+    tagRange r = {minTag, maxTag, 0};
+    _ranges.push_back(r);
+    _table.resize(maxTag - minTag + 1, (T *)0);
+    std::size_t numDuplicates = 0;
+    for(std::size_t i = 0; i < entries.size(); i++) {
+      T *&t = _table[entries[i].first - minTag];
+      if(t) {
+        numDuplicates++;
+        if(keepFirst) continue;
+      }
+      t = entries[i].second;
+    }
+    return numDuplicates;
+  }
+  std::size_t _buildSparse(std::vector<std::pair<std::size_t, T *> > &entries,
+                           bool keepFirst)
+  {
+    // a range is a run of at least minRange tags, with gaps of at most maxGap
+    const std::size_t minRange = 16, maxGap = 4;
+    std::stable_sort(entries.begin(), entries.end(), _lessTag);
+    std::size_t numDuplicates = 0, numUnique = 0;
+    for(std::size_t i = 0; i < entries.size(); i++) {
+      if(numUnique && entries[i].first == entries[numUnique - 1].first) {
+        numDuplicates++;
+        if(!keepFirst) entries[numUnique - 1] = entries[i];
+      }
+      else
+        entries[numUnique++] = entries[i];
+    }
+    entries.resize(numUnique);
+    std::vector<std::pair<std::size_t, std::size_t> > runs, outliers;
+    std::size_t start = 0, numOutliers = 0;
+    for(std::size_t i = 1; i <= numUnique; i++) {
+      if(i < numUnique && entries[i].first - entries[i - 1].first <= maxGap)
+        continue;
+      if(i - start >= minRange)
+        runs.push_back(std::make_pair(start, i));
+      else {
+        outliers.push_back(std::make_pair(start, i));
+        numOutliers += i - start;
+      }
+      start = i;
+    }
+    for(std::size_t i = 0; i < runs.size(); i++) {
+      std::size_t first = entries[runs[i].first].first;
+      std::size_t last = entries[runs[i].second - 1].first;
+      tagRange r = {first, last, _table.size()};
+      _ranges.push_back(r);
+      _table.resize(_table.size() + last - first + 1, (T *)0);
+      for(std::size_t j = runs[i].first; j < runs[i].second; j++)
+        _table[r.offset + entries[j].first - first] = entries[j].second;
+    }
+    if(numOutliers) {
+      std::size_t capacity = 16;
+      while(capacity < 2 * numOutliers) capacity *= 2;
+      _hashKeys.resize(capacity, _emptyKey());
+      _hashValues.resize(capacity, (T *)0);
+      for(std::size_t i = 0; i < outliers.size(); i++)
+        for(std::size_t j = outliers[i].first; j < outliers[i].second; j++)
+          _insertHash(entries[j].first, entries[j].second);
+    }
+    return numDuplicates;
+  }
+
+public:
+  MTagIndex() : _size(0) {}
+  void clear()
+  {
+    std::vector<tagRange>().swap(_ranges);
+    std::vector<T *>().swap(_table);
+    std::vector<std::size_t>().swap(_hashKeys);
+    std::vector<T *>().swap(_hashValues);
+    _size = 0;
+  }
+  bool empty() const { return _size == 0; }
+  // number of entries given to build(), including duplicates
+  std::size_t size() const { return _size; }
+  // build the index from (tag, object) pairs, which might be reordered; if a
+  // tag appears more than once, the first object is kept if keepFirst is set,
+  // and the last one otherwise. Returns the number of ignored duplicate
+  // entries.
+  std::size_t build(std::vector<std::pair<std::size_t, T *> > &entries,
+                    bool keepFirst = true)
+  {
+    clear();
+    _size = entries.size();
+    if(entries.empty()) return 0;
+    std::size_t minTag = entries[0].first, maxTag = entries[0].first;
+    for(std::size_t i = 1; i < entries.size(); i++) {
+      minTag = std::min(minTag, entries[i].first);
+      maxTag = std::max(maxTag, entries[i].first);
+    }
+    // fairly dense numbering: use a single range
+    if(maxTag - minTag < 4 * entries.size())
+      return _buildDense(entries, minTag, maxTag, keepFirst);
+    return _buildSparse(entries, keepFirst);
+  }
+  T *find(std::size_t tag) const
+  {
+    // last range starting before (or at) tag
+    std::size_t lo = 0, hi = _ranges.size();
+    while(lo < hi) {
+      std::size_t mid = (lo + hi) / 2;
+      if(_ranges[mid].first <= tag)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    if(lo && tag <= _ranges[lo - 1].last)
+      return _table[_ranges[lo - 1].offset + tag - _ranges[lo - 1].first];
+    if(_hashKeys.empty()) return 0;
+    std::size_t mask = _hashKeys.size() - 1;
+    std::size_t i = _hash(tag) & mask;
+    while(_hashKeys[i] != _emptyKey()) {
+      if(_hashKeys[i] == tag) return _hashValues[i];
+      i = (i + 1) & mask;
+    }
+    return 0;
+  }
+};
+
+#endif
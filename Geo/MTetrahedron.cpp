@@ -7,6 +7,7 @@
 #include "MTetrahedron.h"
 #include "Numeric.h"
 #include "Context.h"
+#include "MallocUtils.h"
 #include "BasisFactory.h"
 #include "pointsGenerators.h"
 
@@ -20,6 +21,28 @@
 
 std::map<int, IndicesReversed> MTetrahedronN::_order2indicesReversedTet;
 
+#if defined(HAVE_MESH_POOL)
+static MemoryPool *tetrahedronPool()
+{
+  static MemoryPool *pool = new MemoryPool(sizeof(MTetrahedron));
+  return pool;
+}
+
+void *MTetrahedron::operator new(std::size_t size)
+{
+  if(size == sizeof(MTetrahedron)) return tetrahedronPool()->allocate();
+  return ::operator new(size);
+}
+
+void MTetrahedron::operator delete(void *ptr, std::size_t size)
+{
+  if(size == sizeof(MTetrahedron))
+    tetrahedronPool()->deallocate(ptr);
+  else
+    ::operator delete(ptr);
+}
+#endif
+
 void MTetrahedron::getEdgeRep(bool curved, int num, double *x, double *y,
                               double *z, SVector3 *n)
 {
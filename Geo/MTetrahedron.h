@@ -6,6 +6,7 @@
 #ifndef _MTETRAHEDRON_H_
 #define _MTETRAHEDRON_H_
 
+#include "GmshConfig.h"
 #include "MElement.h"
 
 /*
@@ -62,6 +63,12 @@ public:
     for(int i = 0; i < 4; i++) _v[i] = v[i];
   }
   ~MTetrahedron() {}
+#if defined(HAVE_MESH_POOL)
+  // first-order tetrahedra come from a memory pool, like first-order
+  // triangles and nodes
+  static void *operator new(std::size_t size);
+  static void operator delete(void *ptr, std::size_t size);
+#endif
   virtual int getDim() const { return 3; }
   virtual std::size_t getNumVertices() const { return 4; }
   virtual MVertex *getVertex(int num) { return _v[num]; }
@@ -7,6 +7,7 @@
 #include "MTriangle.h"
 #include "Numeric.h"
 #include "Context.h"
+#include "MallocUtils.h"
 #include "BasisFactory.h"
 #include "pointsGenerators.h"
 
@@ -18,6 +19,28 @@
 #include <cmath>
 #include <cstring>
 
+#if defined(HAVE_MESH_POOL)
+static MemoryPool *trianglePool()
+{
+  static MemoryPool *pool = new MemoryPool(sizeof(MTriangle));
+  return pool;
+}
+
+void *MTriangle::operator new(std::size_t size)
+{
+  if(size == sizeof(MTriangle)) return trianglePool()->allocate();
+  return ::operator new(size);
+}
+
+void MTriangle::operator delete(void *ptr, std::size_t size)
+{
+  if(size == sizeof(MTriangle))
+    trianglePool()->deallocate(ptr);
+  else
+    ::operator delete(ptr);
+}
+#endif
+
 void MTriangle::getEdgeRep(bool curved, int num, double *x, double *y,
                            double *z, SVector3 *n)
 {
@@ -6,6 +6,7 @@
 #ifndef _MTRIANGLE_H_
 #define _MTRIANGLE_H_
 
+#include "GmshConfig.h"
 #include "MElement.h"
 
 /*
@@ -52,6 +53,12 @@ public:
     for(int i = 0; i < 3; i++) _v[i] = v[i];
   }
   ~MTriangle() {}
+#if defined(HAVE_MESH_POOL)
+  // first-order triangles are allocated in a memory pool (high-order
+  // triangles, which are larger, use the default allocator)
+  static void *operator new(std::size_t size);
+  static void operator delete(void *ptr, std::size_t size);
+#endif
   virtual int getDim() const { return 2; }
   virtual double etaShapeMeasure();
   virtual double gammaShapeMeasure();
@@ -12,6 +12,11 @@
 #include "GFace.h"
 #include "GmshMessage.h"
 #include "StringUtils.h"
+#include "MallocUtils.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 double angle3Vertices(const MVertex *p1, const MVertex *p2, const MVertex *p3)
 {
@@ -23,50 +28,83 @@ double angle3Vertices(const MVertex *p1, const MVertex *p2, const MVertex *p3)
   return std::atan2(sinA, cosA);
 }
 
-MVertex::MVertex(double x, double y, double z, GEntity *ge, std::size_t num)
-  : _visible(1), _order(1), _x(x), _y(y), _z(z), _ge(ge)
-{
 #if defined(_OPENMP)
-#pragma omp critical
+// in parallel regions vertex numbers are reserved by chunks, so that threads
+// creating vertices concurrently do not all contend on the model counter
+struct vertexNumberRange {
+  GModel *model;
+  std::size_t epoch, next, last;
+};
+static vertexNumberRange threadVertexRange = {0, 0, 1, 0};
+#pragma omp threadprivate(threadVertexRange)
 #endif
-  {
-    // we should make GModel a mandatory argument to the constructor
-    GModel *m = GModel::current();
-    if(num) {
-      _num = num;
-      m->setMaxVertexNumber(std::max(m->getMaxVertexNumber(), _num));
-    }
-    else {
-      m->setMaxVertexNumber(m->getMaxVertexNumber() + 1);
-      _num = m->getMaxVertexNumber();
+
+static std::size_t newVertexNumber(GModel *m)
+{
+#if defined(_OPENMP)
+  if(omp_in_parallel()) {
+    vertexNumberRange &r = threadVertexRange;
+    if(r.model != m || r.epoch != m->getVertexNumberEpoch() ||
+       r.next > r.last) {
+      const std::size_t chunk = 64;
+      r.model = m;
+      r.epoch = m->getVertexNumberEpoch();
+      r.next = m->reserveVertexNumbers(chunk);
+      r.last = r.next + chunk - 1;
     }
-    _index = (long int)num;
+    return r.next++;
   }
+#endif
+  return m->reserveVertexNumbers(1);
 }
 
-void MVertex::deleteLast()
+MVertex::MVertex(double x, double y, double z, GEntity *ge, std::size_t num,
+                 GModel *model)
+  : _visible(1), _order(1), _x(x), _y(y), _z(z), _ge(ge)
 {
-#if defined(_OPENMP)
-#pragma omp critical
-#endif
-  {
-    GModel *m = GModel::current();
-    if(_num == m->getMaxVertexNumber())
-      m->setMaxVertexNumber(m->getMaxVertexNumber() - 1);
-    delete this;
+  GModel *m = model ? model : GModel::current();
+  if(num) {
+    _num = num;
+    m->updateMaxVertexNumber(_num);
+  }
+  else {
+    _num = newVertexNumber(m);
   }
+  _index = (long int)num;
 }
 
-void MVertex::forceNum(std::size_t num)
+#if defined(HAVE_MESH_POOL)
+static MemoryPool *vertexPool()
 {
-#if defined(_OPENMP)
-#pragma omp critical
+  static MemoryPool *pool = new MemoryPool(sizeof(MVertex));
+  return pool;
+}
+
+void *MVertex::operator new(std::size_t size)
+{
+  if(size == sizeof(MVertex)) return vertexPool()->allocate();
+  return ::operator new(size);
+}
+
+void MVertex::operator delete(void *ptr, std::size_t size)
+{
+  if(size == sizeof(MVertex))
+    vertexPool()->deallocate(ptr);
+  else
+    ::operator delete(ptr);
+}
 #endif
-  {
-    GModel *m = GModel::current();
-    _num = num;
-    m->setMaxVertexNumber(std::max(m->getMaxVertexNumber(), _num));
-  }
+
+void MVertex::deleteLast()
+{
+  GModel::current()->releaseVertexNumber(_num);
+  delete this;
+}
+
+void MVertex::forceNum(std::size_t num)
+{
+  _num = num;
+  GModel::current()->updateMaxVertexNumber(_num);
 }
 
 void MVertex::writeMSH(FILE *fp, bool binary, bool saveParametric,
@@ -11,10 +11,12 @@
 #include <set>
 #include <map>
 #include <fstream>
+#include "GmshConfig.h"
 #include "SPoint2.h"
 #include "SPoint3.h"
 #include "MVertexBoundaryLayerData.h"
 
+class GModel;
 class GEntity;
 class GEdge;
 class GFace;
@@ -43,8 +45,17 @@ protected:
   GEntity *_ge;
 
 public:
-  MVertex(double x, double y, double z, GEntity *ge = 0, std::size_t num = 0);
+  // if num is zero a new number is allocated in the model (the current model
+  // if model is not provided)
+  MVertex(double x, double y, double z, GEntity *ge = 0, std::size_t num = 0,
+          GModel *model = 0);
   virtual ~MVertex() {}
+#if defined(HAVE_MESH_POOL)
+  // nodes are allocated in a memory pool (derived classes, whose size
+  // is different, use the default allocator)
+  static void *operator new(std::size_t size);
+  static void operator delete(void *ptr, std::size_t size);
+#endif
   void deleteLast();
 
   // get/set the visibility flag
@@ -135,8 +146,8 @@ public:
   MVertexBoundaryLayerData *bl_data;
 
   MEdgeVertex(double x, double y, double z, GEntity *ge, double u,
-              std::size_t num = 0, double lc = -1.0)
-    : MVertex(x, y, z, ge, num), _u(u), _lc(lc), bl_data(0)
+              std::size_t num = 0, double lc = -1.0, GModel *model = 0)
+    : MVertex(x, y, z, ge, num, model), _u(u), _lc(lc), bl_data(0)
   {
   }
   virtual ~MEdgeVertex()
@@ -164,8 +175,8 @@ public:
   MVertexBoundaryLayerData *bl_data;
 
   MFaceVertex(double x, double y, double z, GEntity *ge, double u, double v,
-              std::size_t num = 0)
-    : MVertex(x, y, z, ge, num), _u(u), _v(v), bl_data(0)
+              std::size_t num = 0, GModel *model = 0)
+    : MVertex(x, y, z, ge, num, model), _u(u), _v(v), bl_data(0)
   {
   }
   virtual ~MFaceVertex()
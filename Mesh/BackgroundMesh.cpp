@@ -29,9 +29,7 @@
 #include "linearSystemPETSc.h"
 #endif
 
-#if defined(HAVE_ANN)
 static const int _NBANN = 2;
-#endif
 
 static const int _MAX_THREADS = 256;
 
@@ -74,9 +72,8 @@ backgroundMesh *backgroundMesh::current()
 }
 
 backgroundMesh::backgroundMesh(GFace *_gf, bool cfd)
-#if defined(HAVE_ANN)
-  : _octree(0), uv_kdtree(0), nodes(0), angle_nodes(0), angle_kdtree(0)
-#endif
+  : _octree(0), _uvAdaptor(_uvNodes), _uvKdtree(0),
+    _angleAdaptor(_angleNodes), _angleKdtree(0)
 {
   if(cfd) {
     Msg::Debug("Building cross field using closest distance");
@@ -100,6 +97,7 @@ backgroundMesh::backgroundMesh(GFace *_gf, bool cfd)
         SPoint2 p;
         reparamMeshVertexOnFace(v, _gf, p);
         newv = new MVertex(p.x(), p.y(), 0.0);
+        newv->setIndex(_vertices.size());
         _vertices.push_back(newv);
         _3Dto2D[v] = newv;
         _2Dto3D[newv] = v;
@@ -113,22 +111,14 @@ backgroundMesh::backgroundMesh(GFace *_gf, bool cfd)
     _triangles.push_back(T2D);
   }
 
-#if defined(HAVE_ANN)
-  index = new ANNidx[2];
-  dist = new ANNdist[2];
-  nodes = annAllocPts(myBCNodes.size(), 3);
-  std::set<SPoint2>::iterator itp = myBCNodes.begin();
-  int ind = 0;
-  while(itp != myBCNodes.end()) {
-    SPoint2 pt = *itp;
-    nodes[ind][0] = pt.x();
-    nodes[ind][1] = pt.y();
-    nodes[ind][2] = 0.0;
-    itp++;
-    ind++;
-  }
-  uv_kdtree = new ANNkd_tree(nodes, myBCNodes.size(), 3);
-#endif
+  for(std::set<SPoint2>::iterator itp = myBCNodes.begin();
+      itp != myBCNodes.end(); ++itp)
+    _uvNodes.pts.push_back(SPoint3(itp->x(), itp->y(), 0.0));
+  if(_uvNodes.pts.size() >= 2) {
+    _uvKdtree = new my_kd_tree_t(3, _uvAdaptor,
+                                 nanoflann::KDTreeSingleIndexAdaptorParams(10));
+    _uvKdtree->buildIndex();
+  }
 
   // build a search structure
   _octree = new MElementOctree(_triangles);
@@ -138,10 +128,7 @@ backgroundMesh::backgroundMesh(GFace *_gf, bool cfd)
     propagate1dMesh(_gf);
   }
   else {
-    std::map<MVertex *, MVertex *>::iterator itv2 = _2Dto3D.begin();
-    for(; itv2 != _2Dto3D.end(); ++itv2) {
-      _sizes[itv2->first] = CTX::instance()->mesh.lcMax;
-    }
+    _sizes.assign(_vertices.size(), CTX::instance()->mesh.lcMax);
   }
   // ensure that other criteria are fullfilled
   updateSizes(_gf);
@@ -158,14 +145,8 @@ backgroundMesh::~backgroundMesh()
   for(std::size_t i = 0; i < _vertices.size(); i++) delete _vertices[i];
   for(std::size_t i = 0; i < _triangles.size(); i++) delete _triangles[i];
   if(_octree) delete _octree;
-#if defined(HAVE_ANN)
-  if(uv_kdtree) delete uv_kdtree;
-  if(angle_kdtree) delete angle_kdtree;
-  if(nodes) annDeallocPts(nodes);
-  if(angle_nodes) annDeallocPts(angle_nodes);
-  delete[] index;
-  delete[] dist;
-#endif
+  if(_uvKdtree) delete _uvKdtree;
+  if(_angleKdtree) delete _angleKdtree;
 }
 
 static void propagateValuesOnFace(GFace *_gf,
@@ -272,11 +253,12 @@ void backgroundMesh::propagate1dMesh(GFace *_gf)
   simpleFunction<double> ONE(1.0);
   propagateValuesOnFace(_gf, sizes, &ONE);
 
+  _sizes.resize(_vertices.size());
   std::map<MVertex *, MVertex *>::iterator itv2 = _2Dto3D.begin();
   for(; itv2 != _2Dto3D.end(); ++itv2) {
     MVertex *v_2D = itv2->first;
     MVertex *v_3D = itv2->second;
-    _sizes[v_2D] = exp(sizes[v_3D]);
+    _sizes[v_2D->getIndex()] = exp(sizes[v_3D]);
   }
 }
 
@@ -337,29 +319,24 @@ void backgroundMesh::propagateCrossFieldByDistance(GFace *_gf)
     }
   }
 
-#if defined(HAVE_ANN)
-  index = new ANNidx[_NBANN];
-  dist = new ANNdist[_NBANN];
-  angle_nodes = annAllocPts(_cosines4.size(), 3);
   std::map<MVertex *, double>::iterator itp = _cosines4.begin();
-  int ind = 0;
+  _angleNodes.pts.clear();
   _sin.clear();
   _cos.clear();
-  while(itp != _cosines4.end()) {
+  for(; itp != _cosines4.end(); ++itp) {
     MVertex *v = itp->first;
-    double c = itp->second;
     SPoint2 pt = _param[v];
-    double s = _sines4[v];
-    angle_nodes[ind][0] = pt.x();
-    angle_nodes[ind][1] = pt.y();
-    angle_nodes[ind][2] = 0.0;
-    _cos.push_back(c);
-    _sin.push_back(s);
-    itp++;
-    ind++;
-  }
-  angle_kdtree = new ANNkd_tree(angle_nodes, _cosines4.size(), 3);
-#endif
+    _angleNodes.pts.push_back(SPoint3(pt.x(), pt.y(), 0.0));
+    _cos.push_back(itp->second);
+    _sin.push_back(_sines4[v]);
+  }
+  if(_angleKdtree) delete _angleKdtree;
+  _angleKdtree = 0;
+  if(_angleNodes.pts.size() >= _NBANN) {
+    _angleKdtree = new my_kd_tree_t(
+      3, _angleAdaptor, nanoflann::KDTreeSingleIndexAdaptorParams(10));
+    _angleKdtree->buildIndex();
+  }
 }
 
 inline double myAngle(const SVector3 &a, const SVector3 &b, const SVector3 &d)
@@ -376,14 +353,11 @@ inline double myAngle(const SVector3 &a, const SVector3 &b, const SVector3 &d)
 // L --> domain size
 double backgroundMesh::getSmoothness(MElement *e)
 {
-  MVertex *v0 = _3Dto2D[e->getVertex(0)];
-  MVertex *v1 = _3Dto2D[e->getVertex(1)];
-  MVertex *v2 = _3Dto2D[e->getVertex(2)];
-  std::map<MVertex *, double>::const_iterator i0 = _angles.find(v0);
-  std::map<MVertex *, double>::const_iterator i1 = _angles.find(v1);
-  std::map<MVertex *, double>::const_iterator i2 = _angles.find(v2);
-  double a[3] = {cos(4 * i0->second), cos(4 * i1->second), cos(4 * i2->second)};
-  double b[3] = {sin(4 * i0->second), sin(4 * i1->second), sin(4 * i2->second)};
+  double a0 = _angles[_3Dto2D[e->getVertex(0)]->getIndex()];
+  double a1 = _angles[_3Dto2D[e->getVertex(1)]->getIndex()];
+  double a2 = _angles[_3Dto2D[e->getVertex(2)]->getIndex()];
+  double a[3] = {cos(4 * a0), cos(4 * a1), cos(4 * a2)};
+  double b[3] = {sin(4 * a0), sin(4 * a1), sin(4 * a2)};
   double f[3];
   e->interpolateGrad(a, 0, 0, 0, f);
   const double gradcos = sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
@@ -398,14 +372,11 @@ double backgroundMesh::getSmoothness(double u, double v, double w)
   if(!_octree) return 0.;
   MElement *e = _octree->find(u, v, w, 2, true);
   if(!e) return -1.0;
-  MVertex *v0 = e->getVertex(0);
-  MVertex *v1 = e->getVertex(1);
-  MVertex *v2 = e->getVertex(2);
-  std::map<MVertex *, double>::const_iterator i0 = _angles.find(v0);
-  std::map<MVertex *, double>::const_iterator i1 = _angles.find(v1);
-  std::map<MVertex *, double>::const_iterator i2 = _angles.find(v2);
-  double a[3] = {cos(4 * i0->second), cos(4 * i1->second), cos(4 * i2->second)};
-  double b[3] = {sin(4 * i0->second), sin(4 * i1->second), sin(4 * i2->second)};
+  double a0 = _angles[e->getVertex(0)->getIndex()];
+  double a1 = _angles[e->getVertex(1)->getIndex()];
+  double a2 = _angles[e->getVertex(2)->getIndex()];
+  double a[3] = {cos(4 * a0), cos(4 * a1), cos(4 * a2)};
+  double b[3] = {sin(4 * a0), sin(4 * a1), sin(4 * a2)};
   double f[3];
   e->interpolateGrad(a, 0, 0, 0, f);
   const double gradcos = sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
@@ -499,22 +470,33 @@ void backgroundMesh::propagateCrossField(GFace *_gf,
   //    print("cos4.pos",0,_cosines4,0);
   //    print("sin4.pos",0,_sines4,0);
 
+  _angles.resize(_vertices.size());
   std::map<MVertex *, MVertex *>::iterator itv2 = _2Dto3D.begin();
   for(; itv2 != _2Dto3D.end(); ++itv2) {
     MVertex *v_2D = itv2->first;
     MVertex *v_3D = itv2->second;
     double angle = atan2(_sines4[v_3D], _cosines4[v_3D]) / 4.0;
     crossField2d::normalizeAngle(angle);
-    _angles[v_2D] = angle;
+    _angles[v_2D->getIndex()] = angle;
   }
 }
 
+static void updateSize(double &size, double lc)
+{
+  size = std::min(lc, size);
+  size = std::max(size, CTX::instance()->mesh.lcMin);
+  size = std::min(size, CTX::instance()->mesh.lcMax);
+}
+
 void backgroundMesh::updateSizes(GFace *_gf)
 {
-  std::map<MVertex *, double>::iterator itv = _sizes.begin();
-  for(; itv != _sizes.end(); ++itv) {
+  // the sizes at the vertices classified on the surface are evaluated by
+  // batch, after the loop
+  std::vector<std::size_t> sizes;
+  std::vector<double> uv, xyz;
+  for(std::size_t i = 0; i < _vertices.size(); i++) {
     SPoint2 p;
-    MVertex *v = _2Dto3D[itv->first];
+    MVertex *v = _2Dto3D[_vertices[i]];
     double lc;
     if(v->onWhat()->dim() == 0) {
       lc = BGM_MeshSize(v->onWhat(), 0, 0, v->x(), v->y(), v->z());
@@ -526,11 +508,21 @@ void backgroundMesh::updateSizes(GFace *_gf)
     }
     else {
       reparamMeshVertexOnFace(v, _gf, p);
-      lc = BGM_MeshSize(_gf, p.x(), p.y(), v->x(), v->y(), v->z());
+      sizes.push_back(i);
+      uv.push_back(p.x());
+      uv.push_back(p.y());
+      xyz.push_back(v->x());
+      xyz.push_back(v->y());
+      xyz.push_back(v->z());
+      continue;
     }
-    itv->second = std::min(lc, itv->second);
-    itv->second = std::max(itv->second, CTX::instance()->mesh.lcMin);
-    itv->second = std::min(itv->second, CTX::instance()->mesh.lcMax);
+    updateSize(_sizes[i], lc);
+  }
+  if(sizes.size()) {
+    std::vector<double> lc(sizes.size());
+    BGM_MeshSize(_gf, sizes.size(), &uv[0], &xyz[0], &lc[0]);
+    for(std::size_t i = 0; i < sizes.size(); i++)
+      updateSize(_sizes[sizes[i]], lc[i]);
   }
   // do not allow large variations in the size field
   // (Int. J. Numer. Meth. Engng. 43, 1143-1165 (1998) MESH GRADATION
@@ -545,16 +537,12 @@ void backgroundMesh::updateSizes(GFace *_gf)
   for(int i = 0; i < 3; i++) {
     std::set<MEdge, Less_Edge>::iterator it = edges.begin();
     for(; it != edges.end(); ++it) {
-      MVertex *v0 = it->getVertex(0);
-      MVertex *v1 = it->getVertex(1);
-      MVertex *V0 = _2Dto3D[v0];
-      MVertex *V1 = _2Dto3D[v1];
-      std::map<MVertex *, double>::iterator s0 = _sizes.find(V0);
-      std::map<MVertex *, double>::iterator s1 = _sizes.find(V1);
-      if(s0->second < s1->second)
-        s1->second = std::min(s1->second, _beta * s0->second);
+      double &s0 = _sizes[it->getVertex(0)->getIndex()];
+      double &s1 = _sizes[it->getVertex(1)->getIndex()];
+      if(s0 < s1)
+        s1 = std::min(s1, _beta * s0);
       else
-        s0->second = std::min(s0->second, _beta * s1->second);
+        s0 = std::min(s0, _beta * s1);
     }
   }
 }
@@ -565,6 +553,24 @@ bool backgroundMesh::inDomain(double u, double v, double w) const
   return _octree->find(u, v, w, 2, true) != 0;
 }
 
+MElement *backgroundMesh::_findElement(double u, double v, double w) const
+{
+  MElement *e = _octree->find(u, v, w, 2, true);
+  if(e || !_uvKdtree) return e;
+  // project the point on the segment joining the two closest boundary nodes
+  std::size_t index[2];
+  double distSqr[2];
+  nanoflann::KNNResultSet<double> resultSet(2);
+  resultSet.init(index, distSqr);
+  double pt[3] = {u, v, 0.0};
+  _uvKdtree->findNeighbors(resultSet, pt, nanoflann::SearchParams(10));
+  SPoint3 pnew;
+  double d;
+  signedDistancePointLine(_uvNodes.pts[index[0]], _uvNodes.pts[index[1]],
+                          SPoint3(u, v, 0.), d, pnew);
+  return _octree->find(pnew.x(), pnew.y(), 0.0, 2, true);
+}
+
 double backgroundMesh::operator()(double u, double v, double w) const
 {
   if(!_octree){
@@ -573,36 +579,15 @@ double backgroundMesh::operator()(double u, double v, double w) const
   }
   double uv[3] = {u, v, w};
   double uv2[3];
-  MElement *e = _octree->find(u, v, w, 2, true);
+  MElement *e = _findElement(u, v, w);
   if(!e) {
-#if defined(HAVE_ANN)
-    if(uv_kdtree->nPoints() < 2) return -1000.;
-    double pt[3] = {u, v, 0.0};
-#if defined(_OPENMP)
-#pragma omp critical // just to avoid crash (still incorrect) - should use nanoflann
-#endif
-    uv_kdtree->annkSearch(pt, 2, index, dist);
-    SPoint3 p1(nodes[index[0]][0], nodes[index[0]][1], nodes[index[0]][2]);
-    SPoint3 p2(nodes[index[1]][0], nodes[index[1]][1], nodes[index[1]][2]);
-    SPoint3 pnew;
-    double d;
-    signedDistancePointLine(p1, p2, SPoint3(u, v, 0.), d, pnew);
-    e = _octree->find(pnew.x(), pnew.y(), 0.0, 2, true);
-#endif
-    if(!e) {
-      Msg::Error("BGM octree: cannot find UVW=%g %g %g", u, v, w);
-      return -1000.0; // 0.4;
-    }
+    if(_uvKdtree) Msg::Error("BGM octree: cannot find UVW=%g %g %g", u, v, w);
+    return -1000.0; // 0.4;
   }
   e->xyz2uvw(uv, uv2);
-  std::map<MVertex *, double>::const_iterator itv1 =
-    _sizes.find(e->getVertex(0));
-  std::map<MVertex *, double>::const_iterator itv2 =
-    _sizes.find(e->getVertex(1));
-  std::map<MVertex *, double>::const_iterator itv3 =
-    _sizes.find(e->getVertex(2));
-  return itv1->second * (1 - uv2[0] - uv2[1]) + itv2->second * uv2[0] +
-         itv3->second * uv2[1];
+  return _sizes[e->getVertex(0)->getIndex()] * (1 - uv2[0] - uv2[1]) +
+         _sizes[e->getVertex(1)->getIndex()] * uv2[0] +
+         _sizes[e->getVertex(2)->getIndex()] * uv2[1];
 }
 
 double backgroundMesh::getAngle(double u, double v, double w) const
@@ -610,14 +595,14 @@ double backgroundMesh::getAngle(double u, double v, double w) const
   // use closest point for computing cross field angles: this allows NOT to
   // generate a spurious mesh and solve a PDE
   if(!_octree) {
-#if defined(HAVE_ANN)
     double angle = 0.;
-    if(angle_kdtree->nPoints() >= _NBANN) {
+    if(_angleKdtree) {
+      std::size_t index[_NBANN];
+      double distSqr[_NBANN];
+      nanoflann::KNNResultSet<double> resultSet(_NBANN);
+      resultSet.init(index, distSqr);
       double pt[3] = {u, v, 0.0};
-#if defined(_OPENMP)
-#pragma omp critical // just to avoid crash (still incorrect) - should use nanoflann
-#endif
-      angle_kdtree->annkSearch(pt, _NBANN, index, dist);
+      _angleKdtree->findNeighbors(resultSet, pt, nanoflann::SearchParams(10));
       double SINE = 0.0, COSINE = 0.0;
       for(int i = 0; i < _NBANN; i++) {
         SINE += _sin[index[i]];
@@ -627,7 +612,6 @@ double backgroundMesh::getAngle(double u, double v, double w) const
     }
     crossField2d::normalizeAngle(angle);
     return angle;
-#endif
   }
 
   // HACK FOR LEWIS
@@ -642,39 +626,21 @@ double backgroundMesh::getAngle(double u, double v, double w) const
 
   double uv[3] = {u, v, w};
   double uv2[3];
-  MElement *e = _octree->find(u, v, w, 2, true);
+  MElement *e = _findElement(u, v, w);
   if(!e) {
-#if defined(HAVE_ANN)
-    if(uv_kdtree->nPoints() < 2) return -1000.0;
-    double pt[3] = {u, v, 0.0};
-#if defined(_OPENMP)
-#pragma omp critical // just to avoid crash (still incorrect) - should use nanoflann
-#endif
-    uv_kdtree->annkSearch(pt, 2, index, dist);
-    SPoint3 p1(nodes[index[0]][0], nodes[index[0]][1], nodes[index[0]][2]);
-    SPoint3 p2(nodes[index[1]][0], nodes[index[1]][1], nodes[index[1]][2]);
-    SPoint3 pnew;
-    double d;
-    signedDistancePointLine(p1, p2, SPoint3(u, v, 0.), d, pnew);
-    e = _octree->find(pnew.x(), pnew.y(), 0., 2, true);
-#endif
-    if(!e) {
+    if(_uvKdtree)
       Msg::Error("BGM octree angle: cannot find UVW=%g %g %g", u, v, w);
-      return -1000.0;
-    }
+    return -1000.0;
   }
   e->xyz2uvw(uv, uv2);
-  std::map<MVertex *, double>::const_iterator itv1 =
-    _angles.find(e->getVertex(0));
-  std::map<MVertex *, double>::const_iterator itv2 =
-    _angles.find(e->getVertex(1));
-  std::map<MVertex *, double>::const_iterator itv3 =
-    _angles.find(e->getVertex(2));
-
-  double cos4 = cos(4 * itv1->second) * (1 - uv2[0] - uv2[1]) +
-                cos(4 * itv2->second) * uv2[0] + cos(4 * itv3->second) * uv2[1];
-  double sin4 = sin(4 * itv1->second) * (1 - uv2[0] - uv2[1]) +
-                sin(4 * itv2->second) * uv2[0] + sin(4 * itv3->second) * uv2[1];
+  double a1 = _angles[e->getVertex(0)->getIndex()];
+  double a2 = _angles[e->getVertex(1)->getIndex()];
+  double a3 = _angles[e->getVertex(2)->getIndex()];
+
+  double cos4 = cos(4 * a1) * (1 - uv2[0] - uv2[1]) + cos(4 * a2) * uv2[0] +
+                cos(4 * a3) * uv2[1];
+  double sin4 = sin(4 * a1) * (1 - uv2[0] - uv2[1]) + sin(4 * a2) * uv2[0] +
+                sin(4 * a3) * uv2[1];
   double angle = atan2(sin4, cos4) / 4.0;
   crossField2d::normalizeAngle(angle);
 
@@ -682,7 +648,7 @@ double backgroundMesh::getAngle(double u, double v, double w) const
 }
 
 void backgroundMesh::print(const std::string &filename, GFace *gf,
-                           const std::map<MVertex *, double> &_whatToPrint,
+                           const std::vector<double> &_whatToPrint,
                            int smooth)
 {
   FILE *f = Fopen(filename.c_str(), "w");
@@ -707,13 +673,13 @@ void backgroundMesh::print(const std::string &filename, GFace *gf,
       MVertex *v1 = _triangles[i]->getVertex(0);
       MVertex *v2 = _triangles[i]->getVertex(1);
       MVertex *v3 = _triangles[i]->getVertex(2);
-      std::map<MVertex *, double>::const_iterator itv1 = _whatToPrint.find(v1);
-      std::map<MVertex *, double>::const_iterator itv2 = _whatToPrint.find(v2);
-      std::map<MVertex *, double>::const_iterator itv3 = _whatToPrint.find(v3);
+      double s1 = _whatToPrint[v1->getIndex()];
+      double s2 = _whatToPrint[v2->getIndex()];
+      double s3 = _whatToPrint[v3->getIndex()];
       if(!gf) {
         fprintf(f, "ST(%g,%g,%g,%g,%g,%g,%g,%g,%g) {%g,%g,%g};\n", v1->x(),
                 v1->y(), v1->z(), v2->x(), v2->y(), v2->z(), v3->x(), v3->y(),
-                v3->z(), itv1->second, itv2->second, itv3->second);
+                v3->z(), s1, s2, s3);
       }
       else {
         GPoint p1 = gf->point(SPoint2(v1->x(), v1->y()));
@@ -721,7 +687,7 @@ void backgroundMesh::print(const std::string &filename, GFace *gf,
         GPoint p3 = gf->point(SPoint2(v3->x(), v3->y()));
         fprintf(f, "ST(%g,%g,%g,%g,%g,%g,%g,%g,%g) {%g,%g,%g};\n", p1.x(),
                 p1.y(), p1.z(), p2.x(), p2.y(), p2.z(), p3.x(), p3.y(), p3.z(),
-                itv1->second, itv2->second, itv3->second);
+                s1, s2, s3);
       }
     }
   }
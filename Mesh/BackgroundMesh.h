@@ -11,11 +11,7 @@
 #include <list>
 #include "simpleFunction.h"
 #include "BackgroundMeshTools.h"
-
-#if defined(HAVE_ANN)
-#include "ANN/ANN.h"
-class ANNkd_tree;
-#endif
+#include "pointCloud.h"
 
 class MElementOctree;
 class GFace;
@@ -37,27 +33,32 @@ struct crossField2d {
   crossField2d &operator+=(const crossField2d &);
 };
 
+// The background mesh is made of triangles in the parametric plane of the
+// surface; the sizes and cross field angles are stored in flat arrays
+// addressed by the index of the (local) background mesh vertices. Once
+// built, the background mesh is only read by the queries, which are thus
+// reentrant.
 class backgroundMesh : public simpleFunction<double> {
   MElementOctree *_octree;
   std::vector<MVertex *> _vertices;
   std::vector<MElement *> _triangles;
-  std::map<MVertex *, double> _sizes;
+  std::vector<double> _sizes;
   std::map<MVertex *, MVertex *> _3Dto2D;
   std::map<MVertex *, MVertex *> _2Dto3D;
-  std::map<MVertex *, double> _distance;
-  std::map<MVertex *, double> _angles;
+  std::vector<double> _angles;
   static std::vector<backgroundMesh *> _current;
   backgroundMesh(GFace *, bool dist = false);
   ~backgroundMesh();
-#if defined(HAVE_ANN)
-  mutable ANNkd_tree *uv_kdtree;
-  mutable ANNpointArray nodes;
-  ANNidxArray index;
-  ANNdistArray dist;
-  mutable ANNpointArray angle_nodes;
-  mutable ANNkd_tree *angle_kdtree;
+  // boundary nodes (used when a point falls outside of the background mesh)
+  PointCloud _uvNodes;
+  PC2KD _uvAdaptor;
+  my_kd_tree_t *_uvKdtree;
+  // boundary nodes and cross field (when no background mesh is built)
+  PointCloud _angleNodes;
+  PC2KD _angleAdaptor;
+  my_kd_tree_t *_angleKdtree;
   std::vector<double> _cos, _sin;
-#endif
+  MElement *_findElement(double u, double v, double w) const;
 public:
   static void set(GFace *);
   static void setCrossFieldsByDistance(GFace *);
@@ -76,7 +77,7 @@ public:
   double getSmoothness(double u, double v, double w);
   double getSmoothness(MElement *);
   void print(const std::string &filename, GFace *gf,
-             const std::map<MVertex *, double> &, int smooth = 0);
+             const std::vector<double> &, int smooth = 0);
   void print(const std::string &filename, GFace *gf, int choice = 0)
   {
     switch(choice) {
@@ -252,6 +252,54 @@ double BGM_MeshSize(GEntity *ge, double U, double V, double X, double Y,
   return lc * CTX::instance()->mesh.lcFactor;
 }
 
+void BGM_MeshSize(GEntity *ge, std::size_t n, const double *uv,
+                  const double *xyz, double *lc)
+{
+  if(!n) return;
+  if(!ge) {
+    for(std::size_t i = 0; i < n; i++)
+      lc[i] = BGM_MeshSize(ge, uv[2 * i], uv[2 * i + 1], xyz[3 * i],
+                           xyz[3 * i + 1], xyz[3 * i + 2]);
+    return;
+  }
+
+  // lc from fields, evaluated for all the points at once
+  std::vector<double> l4(n, MAX_LC);
+  FieldManager *fields = ge->model()->getFields();
+  if(fields->getBackgroundField() > 0) {
+    Field *f = fields->get(fields->getBackgroundField());
+    if(f) f->evaluate(xyz, n, &l4[0], ge);
+  }
+
+  // default lc and global lc from entity
+  double l15 = std::min(CTX::instance()->lc, ge->getMeshSize());
+
+  for(std::size_t i = 0; i < n; i++) {
+    // lc from points
+    double l2 = MAX_LC;
+    if(CTX::instance()->mesh.lcFromPoints && ge->dim() < 2)
+      l2 = LC_MVertex_PNTS(ge, uv[2 * i], uv[2 * i + 1]);
+
+    // lc from curvature
+    double l3 = MAX_LC;
+    if(CTX::instance()->mesh.lcFromCurvature && ge->dim() < 3)
+      l3 = LC_MVertex_CURV(ge, uv[2 * i], uv[2 * i + 1]);
+
+    // take the minimum, then constrain by lcMin and lcMax
+    double l = std::min(std::min(std::min(l15, l2), l3), l4[i]);
+    l = std::max(l, CTX::instance()->mesh.lcMin);
+    l = std::min(l, CTX::instance()->mesh.lcMax);
+
+    if(l <= 0.) {
+      Msg::Error("Wrong mesh element size lc = %g (lcmin = %g, lcmax = %g)", l,
+                 CTX::instance()->mesh.lcMin, CTX::instance()->mesh.lcMax);
+      l = CTX::instance()->lc;
+    }
+
+    lc[i] = l * CTX::instance()->mesh.lcFactor;
+  }
+}
+
 // anisotropic version of the background field
 SMetric3 BGM_MeshMetric(GEntity *ge, double U, double V, double X, double Y,
                         double Z)
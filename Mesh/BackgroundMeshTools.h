@@ -6,6 +6,7 @@
 #ifndef _BACKGROUND_MESH_TOOLS_H_
 #define _BACKGROUND_MESH_TOOLS_H_
 
+#include <cstddef>
 #include "STensor3.h"
 
 class GFace;
@@ -18,6 +19,10 @@ SMetric3 buildMetricTangentToSurface(SVector3 &t1, SVector3 &t2, double l_t1,
                                      double l_t2, double l_n);
 double BGM_MeshSize(GEntity *ge, double U, double V, double X, double Y,
                     double Z);
+// same as above for n points on the same entity, with parametric coordinates
+// uv = [u1, v1, u2, ...] and coordinates xyz = [x1, y1, z1, x2, ...]
+void BGM_MeshSize(GEntity *ge, std::size_t n, const double *uv,
+                  const double *xyz, double *lc);
 SMetric3 BGM_MeshMetric(GEntity *ge, double U, double V, double X, double Y,
                         double Z);
 bool Extend1dMeshIn2dSurfaces();
@@ -27,7 +27,7 @@
 #include "BackgroundMeshTools.h"
 #include "STensor3.h"
 #include "ExtrudeParams.h"
-#include "nanoflann.hpp"
+#include "pointCloud.h"
 
 #if defined(HAVE_POST)
 #include "PView.h"
@@ -43,10 +43,6 @@
 #include <unistd.h>
 #endif
 
-#if defined(HAVE_ANN)
-#include "ANN/ANN.h"
-#endif
-
 Field::~Field()
 {
   for(std::map<std::string, FieldOption *>::iterator it = options.begin();
@@ -67,6 +63,13 @@ FieldOption *Field::getOption(const std::string &optionName)
   return it->second;
 }
 
+void Field::evaluate(const double *xyz, std::size_t n, double *val,
+                     GEntity *ge)
+{
+  for(std::size_t i = 0; i < n; i++)
+    val[i] = (*this)(xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2], ge);
+}
+
 void FieldManager::reset()
 {
   for(std::map<int, Field *>::iterator it = begin(); it != end(); it++) {
@@ -421,6 +424,17 @@ public:
              v_in :
              v_out;
   }
+  void evaluate(const double *xyz, std::size_t n, double *val,
+                GEntity *ge = 0)
+  {
+    for(std::size_t i = 0; i < n; i++) {
+      const double *p = &xyz[3 * i];
+      val[i] = (p[0] <= x_max && p[0] >= x_min && p[1] <= y_max &&
+                p[1] >= y_min && p[2] <= z_max && p[2] >= z_min) ?
+                 v_in :
+                 v_out;
+    }
+  }
 };
 
 class CylinderField : public Field {
@@ -481,6 +495,22 @@ public:
     return ((dx * dx + dy * dy + dz * dz < R * R) && fabs(adx) < 1) ? v_in :
                                                                       v_out;
   }
+  void evaluate(const double *xyz, std::size_t n, double *val,
+                GEntity *ge = 0)
+  {
+    const double a2 = xa * xa + ya * ya + za * za, R2 = R * R;
+    for(std::size_t i = 0; i < n; i++) {
+      double dx = xyz[3 * i] - xc;
+      double dy = xyz[3 * i + 1] - yc;
+      double dz = xyz[3 * i + 2] - zc;
+      double adx = (xa * dx + ya * dy + za * dz) / a2;
+      dx -= adx * xa;
+      dy -= adx * ya;
+      dz -= adx * za;
+      val[i] = ((dx * dx + dy * dy + dz * dz < R2) && fabs(adx) < 1) ? v_in :
+                                                                      v_out;
+    }
+  }
 };
 
 class BallField : public Field {
@@ -523,6 +553,17 @@ public:
 
     return ((dx * dx + dy * dy + dz * dz < R * R)) ? v_in : v_out;
   }
+  void evaluate(const double *xyz, std::size_t n, double *val,
+                GEntity *ge = 0)
+  {
+    const double R2 = R * R;
+    for(std::size_t i = 0; i < n; i++) {
+      double dx = xyz[3 * i] - xc;
+      double dy = xyz[3 * i + 1] - yc;
+      double dz = xyz[3 * i + 2] - zc;
+      val[i] = (dx * dx + dy * dy + dz * dz < R2) ? v_in : v_out;
+    }
+  }
 };
 
 class FrustumField : public Field {
@@ -657,7 +698,25 @@ public:
   {
     Field *field = GModel::current()->getFields()->get(iField);
     if(!field || iField == id) return MAX_LC;
-    double r = ((*field)(x, y, z) - dmin) / (dmax - dmin);
+    return threshold((*field)(x, y, z));
+  }
+  void evaluate(const double *xyz, std::size_t n, double *val,
+                GEntity *ge = 0)
+  {
+    Field *field = GModel::current()->getFields()->get(iField);
+    if(!field || iField == id) {
+      for(std::size_t i = 0; i < n; i++) val[i] = MAX_LC;
+      return;
+    }
+    field->evaluate(xyz, n, val);
+    for(std::size_t i = 0; i < n; i++) val[i] = threshold(val[i]);
+  }
+
+protected:
+  // element size for the given value of Field[IField]
+  double threshold(double d) const
+  {
+    double r = (d - dmin) / (dmax - dmin);
     r = std::max(std::min(r, 1.), 0.);
     double lc;
     if(stopAtDistMax && r >= 1.) {
@@ -891,19 +950,55 @@ public:
   }
 };
 
+// A mathematical expression of x, y, z and of other fields F0, F1, ... The
+// expression is compiled once by set_function(); each thread then evaluates
+// its own copy of the compiled expression (created on first use), so that
+// evaluate() can be called concurrently without locking. Threads beyond the
+// number of copies share an additional copy, under a lock.
 class MathEvalExpression {
 private:
-  mathEvaluator *_f;
+  std::vector<std::string> _expressions, _variables;
+  std::vector<mathEvaluator *> _f;
+  mathEvaluator *_shared;
   std::set<int> _fields;
-
-public:
-  MathEvalExpression() : _f(0) {}
-  ~MathEvalExpression()
+  void _clear()
   {
-    if(_f) delete _f;
+    for(std::size_t i = 0; i < _f.size(); i++)
+      if(_f[i]) delete _f[i];
+    _f.clear();
+    if(_shared) delete _shared;
+    _shared = 0;
   }
+  mathEvaluator *_getEvaluator(int thread)
+  {
+    if(!_f[thread]) {
+      std::vector<std::string> expressions(_expressions);
+      _f[thread] = new mathEvaluator(expressions, _variables);
+    }
+    return _f[thread];
+  }
+  bool _evalShared(const std::vector<double> &values, std::vector<double> &res)
+  {
+    bool ok = false;
+#if defined(_OPENMP)
+#pragma omp critical(MathEvalExpression)
+#endif
+    {
+      if(!_shared) {
+        std::vector<std::string> expressions(_expressions);
+        _shared = new mathEvaluator(expressions, _variables);
+      }
+      ok = _shared->eval(values, res);
+    }
+    return ok;
+  }
+
+public:
+  MathEvalExpression() : _shared(0) {}
+  ~MathEvalExpression() { _clear(); }
   bool set_function(const std::string &f)
   {
+    _clear();
     // get id numbers of fields appearing in the function
     _fields.clear();
     unsigned int i = 0;
@@ -920,30 +1015,34 @@ public:
       }
       i += j + 1;
     }
-    std::vector<std::string> expressions(1), variables(3 + _fields.size());
-    expressions[0] = f;
-    variables[0] = "x";
-    variables[1] = "y";
-    variables[2] = "z";
+    _expressions.resize(1);
+    _expressions[0] = f;
+    _variables.resize(3 + _fields.size());
+    _variables[0] = "x";
+    _variables[1] = "y";
+    _variables[2] = "z";
     i = 3;
     for(std::set<int>::iterator it = _fields.begin(); it != _fields.end();
         it++) {
       std::ostringstream sstream;
       sstream << "F" << *it;
-      variables[i++] = sstream.str();
+      _variables[i++] = sstream.str();
     }
-    if(_f) delete _f;
-    _f = new mathEvaluator(expressions, variables);
+    // compile the expression once to check it (and report errors); the
+    // copies for the other threads are created when first needed
+    std::vector<std::string> expressions(_expressions);
+    mathEvaluator *f0 = new mathEvaluator(expressions, _variables);
     if(expressions.empty()) {
-      delete _f;
-      _f = 0;
+      delete f0;
       return false;
     }
+    _f.resize(std::max(1, Msg::GetMaxThreads()), (mathEvaluator *)0);
+    _f[0] = f0;
     return true;
   }
   double evaluate(double x, double y, double z)
   {
-    if(!_f) return MAX_LC;
+    if(_f.empty()) return MAX_LC;
     std::vector<double> values(3 + _fields.size()), res(1);
     values[0] = x;
     values[1] = y;
@@ -954,91 +1053,67 @@ public:
       Field *field = GModel::current()->getFields()->get(*it);
       values[i++] = field ? (*field)(x, y, z) : MAX_LC;
     }
-    if(_f->eval(values, res))
-      return res[0];
-    else
-      return MAX_LC;
+    bool ok = false;
+    int thread = Msg::GetThreadNum();
+    if(thread < (int)_f.size())
+      ok = _getEvaluator(thread)->eval(values, res);
+    else // more threads than when the expression was compiled
+      ok = _evalShared(values, res);
+    return ok ? res[0] : MAX_LC;
+  }
+  // evaluate the expression at n points: the fields the expression depends on
+  // are themselves evaluated by batch
+  void evaluate(const double *xyz, std::size_t n, double *val)
+  {
+    if(_f.empty() || !n) {
+      for(std::size_t i = 0; i < n; i++) val[i] = MAX_LC;
+      return;
+    }
+    std::vector<double> fields(_fields.size() * n);
+    int j = 0;
+    for(std::set<int>::iterator it = _fields.begin(); it != _fields.end();
+        it++, j++) {
+      Field *field = GModel::current()->getFields()->get(*it);
+      if(field)
+        field->evaluate(xyz, n, &fields[j * n]);
+      else
+        for(std::size_t i = 0; i < n; i++) fields[j * n + i] = MAX_LC;
+    }
+    int thread = Msg::GetThreadNum();
+    mathEvaluator *f = 0;
+    if(thread < (int)_f.size()) f = _getEvaluator(thread);
+    std::vector<double> values(3 + _fields.size()), res(1);
+    for(std::size_t i = 0; i < n; i++) {
+      values[0] = xyz[3 * i];
+      values[1] = xyz[3 * i + 1];
+      values[2] = xyz[3 * i + 2];
+      for(std::size_t k = 0; k < _fields.size(); k++)
+        values[3 + k] = fields[k * n + i];
+      bool ok = false;
+      if(f)
+        ok = f->eval(values, res);
+      else
+        ok = _evalShared(values, res);
+      val[i] = ok ? res[0] : MAX_LC;
+    }
   }
 };
 
 class MathEvalExpressionAniso {
 private:
-  mathEvaluator *_f[6];
-  std::set<int> _fields[6];
+  MathEvalExpression _f[6];
 
 public:
-  MathEvalExpressionAniso()
-  {
-    for(int i = 0; i < 6; i++) _f[i] = 0;
-  }
-  ~MathEvalExpressionAniso()
-  {
-    for(int i = 0; i < 6; i++)
-      if(_f[i]) delete _f[i];
-  }
   bool set_function(int iFunction, const std::string &f)
   {
-    // get id numbers of fields appearing in the function
-    _fields[iFunction].clear();
-    unsigned int i = 0;
-    while(i < f.size()) {
-      unsigned int j = 0;
-      if(f[i] == 'F') {
-        std::string id("");
-        while(i + 1 + j < f.size() && f[i + 1 + j] >= '0' &&
-              f[i + 1 + j] <= '9') {
-          id += f[i + 1 + j];
-          j++;
-        }
-        _fields[iFunction].insert(atoi(id.c_str()));
-      }
-      i += j + 1;
-    }
-    std::vector<std::string> expressions(1),
-      variables(3 + _fields[iFunction].size());
-    expressions[0] = f;
-    variables[0] = "x";
-    variables[1] = "y";
-    variables[2] = "z";
-    i = 3;
-    for(std::set<int>::iterator it = _fields[iFunction].begin();
-        it != _fields[iFunction].end(); it++) {
-      std::ostringstream sstream;
-      sstream << "F" << *it;
-      variables[i++] = sstream.str();
-    }
-    if(_f[iFunction]) delete _f[iFunction];
-    _f[iFunction] = new mathEvaluator(expressions, variables);
-    if(expressions.empty()) {
-      delete _f[iFunction];
-      _f[iFunction] = 0;
-      return false;
-    }
-    return true;
+    return _f[iFunction].set_function(f);
   }
   void evaluate(double x, double y, double z, SMetric3 &metr)
   {
     const int index[6][2] = {{0, 0}, {1, 1}, {2, 2}, {0, 1}, {0, 2}, {1, 2}};
-    for(int iFunction = 0; iFunction < 6; iFunction++) {
-      if(!_f[iFunction])
-        metr(index[iFunction][0], index[iFunction][1]) = MAX_LC;
-      else {
-        std::vector<double> values(3 + _fields[iFunction].size()), res(1);
-        values[0] = x;
-        values[1] = y;
-        values[2] = z;
-        int i = 3;
-        for(std::set<int>::iterator it = _fields[iFunction].begin();
-            it != _fields[iFunction].end(); it++) {
-          Field *field = GModel::current()->getFields()->get(*it);
-          values[i++] = field ? (*field)(x, y, z) : MAX_LC;
-        }
-        if(_f[iFunction]->eval(values, res))
-          metr(index[iFunction][0], index[iFunction][1]) = res[0];
-        else
-          metr(index[iFunction][0], index[iFunction][1]) = MAX_LC;
-      }
-    }
+    for(int iFunction = 0; iFunction < 6; iFunction++)
+      metr(index[iFunction][0], index[iFunction][1]) =
+        _f[iFunction].evaluate(x, y, z);
   }
 };
 
@@ -1053,12 +1128,12 @@ public:
       f, "Mathematical function to evaluate.", &update_needed);
     f = "F2 + Sin(z)";
   }
-  using Field::operator();
-  double operator()(double x, double y, double z, GEntity *ge = 0)
+  void update()
   {
-    double ret = 0;
+    // only the compilation of the expression needs to be protected: the
+    // evaluation itself is reentrant
 #if defined(_OPENMP)
-#pragma omp critical
+#pragma omp critical(MathEvalField)
 #endif
     {
       if(update_needed) {
@@ -1067,9 +1142,19 @@ public:
                      f.c_str());
         update_needed = false;
       }
-      ret = expr.evaluate(x, y, z);
     }
-    return ret;
+  }
+  using Field::operator();
+  double operator()(double x, double y, double z, GEntity *ge = 0)
+  {
+    if(update_needed) update();
+    return expr.evaluate(x, y, z);
+  }
+  void evaluate(const double *xyz, std::size_t n, double *val,
+                GEntity *ge = 0)
+  {
+    if(update_needed) update();
+    expr.evaluate(xyz, n, val);
   }
   const char *getName() { return "MathEval"; }
   std::string getDescription()
@@ -1107,10 +1192,10 @@ public:
       f[5], "element 23 of the metric tensor.", &update_needed);
     f[5] = "F2 + Sin(z)";
   }
-  void operator()(double x, double y, double z, SMetric3 &metr, GEntity *ge = 0)
+  void update()
   {
 #if defined(_OPENMP)
-#pragma omp critical
+#pragma omp critical(MathEvalField)
 #endif
     {
       if(update_needed) {
@@ -1121,26 +1206,18 @@ public:
         }
         update_needed = false;
       }
-      expr.evaluate(x, y, z, metr);
     }
   }
+  void operator()(double x, double y, double z, SMetric3 &metr, GEntity *ge = 0)
+  {
+    if(update_needed) update();
+    expr.evaluate(x, y, z, metr);
+  }
   double operator()(double x, double y, double z, GEntity *ge = 0)
   {
     SMetric3 metr;
-#if defined(_OPENMP)
-#pragma omp critical
-#endif
-    {
-      if(update_needed) {
-        for(int i = 0; i < 6; i++) {
-          if(!expr.set_function(i, f[i]))
-            Msg::Error("Field %i: Invalid matheval expression \"%s\"", this->id,
-                       f[i].c_str());
-        }
-        update_needed = false;
-      }
-      expr.evaluate(x, y, z, metr);
-    }
+    if(update_needed) update();
+    expr.evaluate(x, y, z, metr);
     return metr(0, 0);
   }
   const char *getName() { return "MathEvalAniso"; }
@@ -1409,17 +1486,26 @@ public:
            "See the MathEval Field help to get a description of valid FX, FY "
            "and FZ expressions.";
   }
-  using Field::operator();
-  double operator()(double x, double y, double z, GEntity *ge = 0)
+  void update()
   {
-    if(update_needed) {
-      for(int i = 0; i < 3; i++) {
-        if(!expr[i].set_function(f[i]))
-          Msg::Error("Field %i : Invalid matheval expression \"%s\"", this->id,
-                     f[i].c_str());
+#if defined(_OPENMP)
+#pragma omp critical(MathEvalField)
+#endif
+    {
+      if(update_needed) {
+        for(int i = 0; i < 3; i++) {
+          if(!expr[i].set_function(f[i]))
+            Msg::Error("Field %i : Invalid matheval expression \"%s\"",
+                       this->id, f[i].c_str());
+        }
+        update_needed = false;
       }
-      update_needed = false;
     }
+  }
+  using Field::operator();
+  double operator()(double x, double y, double z, GEntity *ge = 0)
+  {
+    if(update_needed) update();
     Field *field = GModel::current()->getFields()->get(iField);
     if(!field || iField == id) return MAX_LC;
     return (*field)(expr[0].evaluate(x, y, z), expr[1].evaluate(x, y, z),
@@ -1709,6 +1795,31 @@ public:
     }
     return v;
   }
+  void evaluate(const double *xyz, std::size_t n, double *val,
+                GEntity *ge = 0)
+  {
+    for(std::size_t i = 0; i < n; i++) val[i] = MAX_LC;
+    std::vector<double> v(n);
+    for(std::list<int>::iterator it = idlist.begin(); it != idlist.end();
+        it++) {
+      Field *f = (GModel::current()->getFields()->get(*it));
+      if(!f || *it == id) continue;
+      if(f->isotropic()) {
+        f->evaluate(xyz, n, &v[0], ge);
+        for(std::size_t i = 0; i < n; i++) val[i] = std::min(val[i], v[i]);
+      }
+      else {
+        for(std::size_t i = 0; i < n; i++) {
+          SMetric3 ff;
+          (*f)(xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2], ff, ge);
+          fullMatrix<double> V(3, 3);
+          fullVector<double> S(3);
+          ff.eig(V, S, 1);
+          val[i] = std::min(val[i], sqrt(1. / S(2)));
+        }
+      }
+    }
+  }
   const char *getName() { return "Min"; }
 };
 
@@ -1747,6 +1858,31 @@ public:
     }
     return v;
   }
+  void evaluate(const double *xyz, std::size_t n, double *val,
+                GEntity *ge = 0)
+  {
+    for(std::size_t i = 0; i < n; i++) val[i] = -MAX_LC;
+    std::vector<double> v(n);
+    for(std::list<int>::iterator it = idlist.begin(); it != idlist.end();
+        it++) {
+      Field *f = (GModel::current()->getFields()->get(*it));
+      if(!f || *it == id) continue;
+      if(f->isotropic()) {
+        f->evaluate(xyz, n, &v[0], ge);
+        for(std::size_t i = 0; i < n; i++) val[i] = std::max(val[i], v[i]);
+      }
+      else {
+        for(std::size_t i = 0; i < n; i++) {
+          SMetric3 ff;
+          (*f)(xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2], ff, ge);
+          fullMatrix<double> V(3, 3);
+          fullVector<double> S(3);
+          ff.eig(V, S, 1);
+          val[i] = std::max(val[i], sqrt(1. / S(0)));
+        }
+      }
+    }
+  }
   const char *getName() { return "Max"; }
 };
 
@@ -1774,18 +1910,32 @@ public:
   {
     Field *f = (GModel::current()->getFields()->get(iField));
     if(!f || iField == id) return MAX_LC;
-    if(!ge) return (*f)(x, y, z);
-    if((ge->dim() == 0 && std::find(vertices.begin(), vertices.end(),
-                                    ge->tag()) != vertices.end()) ||
-       (ge->dim() == 1 &&
-        std::find(edges.begin(), edges.end(), ge->tag()) != edges.end()) ||
-       (ge->dim() == 2 &&
-        std::find(faces.begin(), faces.end(), ge->tag()) != faces.end()) ||
-       (ge->dim() == 3 &&
-        std::find(regions.begin(), regions.end(), ge->tag()) != regions.end()))
-      return (*f)(x, y, z);
+    if(applies(ge)) return (*f)(x, y, z);
     return MAX_LC;
   }
+  void evaluate(const double *xyz, std::size_t n, double *val,
+                GEntity *ge = 0)
+  {
+    // the restriction only depends on the entity, so it is checked once for
+    // the whole batch
+    Field *f = (GModel::current()->getFields()->get(iField));
+    if(f && iField != id && applies(ge))
+      f->evaluate(xyz, n, val);
+    else
+      for(std::size_t i = 0; i < n; i++) val[i] = MAX_LC;
+  }
+  bool applies(GEntity *ge) const
+  {
+    if(!ge) return true;
+    return (ge->dim() == 0 && std::find(vertices.begin(), vertices.end(),
+                                        ge->tag()) != vertices.end()) ||
+           (ge->dim() == 1 &&
+            std::find(edges.begin(), edges.end(), ge->tag()) != edges.end()) ||
+           (ge->dim() == 2 &&
+            std::find(faces.begin(), faces.end(), ge->tag()) != faces.end()) ||
+           (ge->dim() == 3 && std::find(regions.begin(), regions.end(),
+                                        ge->tag()) != regions.end());
+  }
   const char *getName() { return "Restrict"; }
 };
 
@@ -1798,23 +1948,32 @@ struct AttractorInfo {
   double u, v;
 };
 
-#if defined(HAVE_ANN)
+// find the point of the cloud closest to xyz, and return its distance: the
+// kd-tree is not modified by the query, which can thus be performed
+// concurrently by several threads
+static double closestPoint(const my_kd_tree_t *index, const double *xyz,
+                           std::size_t &closest)
+{
+  closest = 0;
+  double distSqr = 0.;
+  nanoflann::KNNResultSet<double> resultSet(1);
+  resultSet.init(&closest, &distSqr);
+  index->findNeighbors(resultSet, xyz, nanoflann::SearchParams(10));
+  return sqrt(distSqr);
+}
 
 class AttractorAnisoCurveField : public Field {
-  ANNkd_tree *kdtree;
-  ANNpointArray zeronodes;
-  ANNidxArray index;
-  ANNdistArray dist;
+  PointCloud P;
+  PC2KD pc2kd;
+  my_kd_tree_t *index;
   std::list<int> edges_id;
   double dMin, dMax, lMinTangent, lMaxTangent, lMinNormal, lMaxNormal;
   int n_nodes_by_edge;
   std::vector<SVector3> tg;
 
 public:
-  AttractorAnisoCurveField() : kdtree(0), zeronodes(0)
+  AttractorAnisoCurveField() : pc2kd(P), index(0)
   {
-    index = new ANNidx[1];
-    dist = new ANNdist[1];
     n_nodes_by_edge = 20;
     update_needed = true;
     dMin = 0.1;
@@ -1852,10 +2011,7 @@ public:
   virtual bool isotropic() const { return false; }
   ~AttractorAnisoCurveField()
   {
-    if(kdtree) delete kdtree;
-    if(zeronodes) annDeallocPts(zeronodes);
-    delete[] index;
-    delete[] dist;
+    if(index) delete index;
   }
   const char *getName() { return "AttractorAnisoCurve"; }
   std::string getDescription()
@@ -1871,47 +2027,50 @@ public:
   }
   void update()
   {
-    if(zeronodes) {
-      annDeallocPts(zeronodes);
-      delete kdtree;
-    }
-    int totpoints = n_nodes_by_edge * edges_id.size();
-    if(totpoints) {
-      zeronodes = annAllocPts(totpoints, 3);
-    }
-    tg.resize(totpoints);
-    int k = 0;
-    for(std::list<int>::iterator it = edges_id.begin(); it != edges_id.end();
-        ++it) {
-      GEdge *e = GModel::current()->getEdgeByTag(*it);
-      if(e) {
-        for(int i = 1; i < n_nodes_by_edge - 1; i++) {
-          double u = (double)i / (n_nodes_by_edge - 1);
-          Range<double> b = e->parBounds(0);
-          double t = b.low() + u * (b.high() - b.low());
-          GPoint gp = e->point(t);
-          SVector3 d = e->firstDer(t);
-          zeronodes[k][0] = gp.x();
-          zeronodes[k][1] = gp.y();
-          zeronodes[k][2] = gp.z();
-          tg[k] = d;
-          tg[k].normalize();
-          k++;
+#if defined(_OPENMP)
+#pragma omp critical(AttractorField)
+#endif
+    {
+      if(update_needed) {
+        if(index) delete index;
+        index = 0;
+        P.pts.clear();
+        tg.clear();
+        for(std::list<int>::iterator it = edges_id.begin();
+            it != edges_id.end(); ++it) {
+          GEdge *e = GModel::current()->getEdgeByTag(*it);
+          if(e) {
+            for(int i = 1; i < n_nodes_by_edge - 1; i++) {
+              double u = (double)i / (n_nodes_by_edge - 1);
+              Range<double> b = e->parBounds(0);
+              double t = b.low() + u * (b.high() - b.low());
+              GPoint gp = e->point(t);
+              SVector3 d = e->firstDer(t);
+              d.normalize();
+              P.pts.push_back(SPoint3(gp.x(), gp.y(), gp.z()));
+              tg.push_back(d);
+            }
+          }
+        }
+        if(P.pts.size()) {
+          index = new my_kd_tree_t(3, pc2kd,
+                                   nanoflann::KDTreeSingleIndexAdaptorParams(10));
+          index->buildIndex();
         }
+        update_needed = false;
       }
     }
-    kdtree = new ANNkd_tree(zeronodes, totpoints, 3);
-    update_needed = false;
   }
   void operator()(double x, double y, double z, SMetric3 &metr, GEntity *ge = 0)
   {
     if(update_needed) update();
+    if(!index) {
+      metr = SMetric3(1 / (lMaxNormal * lMaxNormal));
+      return;
+    }
     double xyz[3] = {x, y, z};
-#if defined(_OPENMP)
-#pragma omp critical // just to avoid crash (still incorrect) - should use nanoflann
-#endif
-    kdtree->annkSearch(xyz, 1, index, dist);
-    double d = sqrt(dist[0]);
+    std::size_t closest;
+    double d = closestPoint(index, xyz, closest);
     double lTg = d < dMin ?
                    lMinTangent :
                    d > dMax ? lMaxTangent :
@@ -1921,7 +2080,7 @@ public:
                            d > dMax ? lMaxNormal :
                                       lMinNormal + (lMaxNormal - lMinNormal) *
                                                      (d - dMin) / (dMax - dMin);
-    SVector3 t = tg[index[0]];
+    SVector3 t = tg[closest];
     SVector3 n0 = crossprod(t, fabs(t(0)) > fabs(t(1)) ? SVector3(0, 1, 0) :
                                                          SVector3(1, 0, 0));
     SVector3 n1 = crossprod(t, n0);
@@ -1930,33 +2089,28 @@ public:
   virtual double operator()(double X, double Y, double Z, GEntity *ge = 0)
   {
     if(update_needed) update();
+    if(!index) return MAX_LC;
     double xyz[3] = {X, Y, Z};
-#if defined(_OPENMP)
-#pragma omp critical // just to avoid crash (still incorrect) - should use nanoflann
-#endif
-    kdtree->annkSearch(xyz, 1, index, dist);
-    double d = sqrt(dist[0]);
+    std::size_t closest;
+    double d = closestPoint(index, xyz, closest);
     return std::max(d, 0.05);
   }
 };
 
 class AttractorField : public Field {
-  ANNkd_tree *kdtree;
-  ANNpointArray zeronodes;
+  PointCloud P;
+  PC2KD pc2kd;
+  my_kd_tree_t *index;
   std::list<int> nodes_id, edges_id, faces_id;
   std::vector<AttractorInfo> _infos;
   int _xFieldId, _yFieldId, _zFieldId;
   Field *_xField, *_yField, *_zField;
   int n_nodes_by_edge;
-  ANNidxArray index;
-  ANNdistArray dist;
 
 public:
   AttractorField(int dim, int tag, int nbe)
-    : kdtree(0), zeronodes(0), n_nodes_by_edge(nbe)
+    : pc2kd(P), index(0), n_nodes_by_edge(nbe)
   {
-    index = new ANNidx[1];
-    dist = new ANNdist[1];
     if(dim == 0)
       nodes_id.push_back(tag);
     else if(dim == 1)
@@ -1967,10 +2121,8 @@ public:
     _xFieldId = _yFieldId = _zFieldId = -1;
     update_needed = true;
   }
-  AttractorField() : kdtree(0), zeronodes(0)
+  AttractorField() : pc2kd(P), index(0)
   {
-    index = new ANNidx[1];
-    dist = new ANNdist[1];
     n_nodes_by_edge = 20;
     options["NodesList"] = new FieldOptionList(
       nodes_id, "Tags of points in the geometric model", &update_needed);
@@ -1996,10 +2148,7 @@ public:
   }
   ~AttractorField()
   {
-    delete[] index;
-    delete[] dist;
-    if(kdtree) delete kdtree;
-    if(zeronodes) annDeallocPts(zeronodes);
+    if(index) delete index;
   }
   const char *getName() { return "Attractor"; }
   std::string getDescription()
@@ -2017,11 +2166,11 @@ public:
     cy = _yField ? (*_yField)(x, y, z, ge) : y;
     cz = _zField ? (*_zField)(x, y, z, ge) : z;
   }
-  std::pair<AttractorInfo, SPoint3> getAttractorInfo() const
+  std::pair<AttractorInfo, SPoint3> getAttractorInfo(std::size_t i) const
   {
-    return std::make_pair(_infos[index[0]], SPoint3(zeronodes[index[0]][0],
-                                                    zeronodes[index[0]][1],
-                                                    zeronodes[index[0]][2]));
+    if(i < _infos.size() && i < P.pts.size())
+      return std::make_pair(_infos[i], P.pts[i]);
+    return std::make_pair(AttractorInfo(), SPoint3());
   }
   void update()
   {
@@ -2032,10 +2181,8 @@ public:
         NULL;
       _zField = _zFieldId >= 0 ? (GModel::current()->getFields()->get(_zFieldId)) :
         NULL;
-      if(zeronodes) {
-        annDeallocPts(zeronodes);
-        delete kdtree;
-      }
+      if(index) delete index;
+      _infos.clear();
       std::vector<SPoint3> points;
       std::vector<SPoint2> uvpoints;
       std::vector<int> offset;
@@ -2158,13 +2305,12 @@ public:
         pz.push_back(0.);
       }
 
-      zeronodes = annAllocPts(totpoints, 3);
-      for(int i = 0; i < totpoints; i++) {
-        zeronodes[i][0] = px[i];
-        zeronodes[i][1] = py[i];
-        zeronodes[i][2] = pz[i];
-      }
-      kdtree = new ANNkd_tree(zeronodes, totpoints, 3);
+      P.pts.resize(totpoints);
+      for(int i = 0; i < totpoints; i++)
+        P.pts[i] = SPoint3(px[i], py[i], pz[i]);
+      index = new my_kd_tree_t(3, pc2kd,
+                               nanoflann::KDTreeSingleIndexAdaptorParams(10));
+      index->buildIndex();
       update_needed = false;
     }
   }
@@ -2172,25 +2318,43 @@ public:
   using Field::operator();
   virtual double operator()(double X, double Y, double Z, GEntity *ge = 0)
   {
+    if(update_needed) {
 #if defined(_OPENMP)
-#pragma omp critical
+#pragma omp critical(AttractorField)
 #endif
-    {
       update();
     }
     double xyz[3];
     getCoord(X, Y, Z, xyz[0], xyz[1], xyz[2], ge);
+    std::size_t closest;
+    return closestPoint(index, xyz, closest);
+  }
+  void evaluate(const double *xyz, std::size_t n, double *val,
+                GEntity *ge = 0)
+  {
+    if(update_needed) {
 #if defined(_OPENMP)
-#pragma omp critical // just to avoid crash (still incorrect) - should use nanoflann
+#pragma omp critical(AttractorField)
 #endif
-    kdtree->annkSearch(xyz, 1, index, dist);
-    double d = dist[0];
-    return sqrt(d);
+      update();
+    }
+    if(!n) return;
+    // the coordinate fields are evaluated by batch, then the kd-tree is
+    // queried for all the points
+    std::vector<double> coord(xyz, xyz + 3 * n), c(n);
+    Field *f[3] = {_xField, _yField, _zField};
+    for(int j = 0; j < 3; j++) {
+      if(!f[j]) continue;
+      f[j]->evaluate(xyz, n, &c[0], ge);
+      for(std::size_t i = 0; i < n; i++) coord[3 * i + j] = c[i];
+    }
+    for(std::size_t i = 0; i < n; i++) {
+      std::size_t closest;
+      val[i] = closestPoint(index, &coord[3 * i], closest);
+    }
   }
 };
 
-#endif // ANN
-
 class OctreeField : public Field {
   // octree field
   class Cell {
@@ -2349,63 +2513,6 @@ public:
   }
 };
 
-struct PointCloud {
-  std::vector<SPoint3> pts;
-};
-
-// And this is the "dataset to kd-tree" adaptor class:
-template <typename Derived> struct PointCloudAdaptor {
-  const Derived &obj; //!< A const ref to the data set origin
-
-  // The constructor that sets the data set source
-  PointCloudAdaptor(const Derived &obj_) : obj(obj_) {}
-
-  // CRTP helper method
-  inline const Derived &derived() const { return obj; }
-
-  // Must return the number of data points
-  inline size_t kdtree_get_point_count() const { return derived().pts.size(); }
-
-  // Returns the distance between the vector "p1[0:size-1]" and the data point
-  // with index "idx_p2" stored in the class:
-  inline double kdtree_distance(const double *p1, const size_t idx_p2,
-                                size_t /*size*/) const
-  {
-    const double d0 = p1[0] - derived().pts[idx_p2].x();
-    const double d1 = p1[1] - derived().pts[idx_p2].y();
-    const double d2 = p1[2] - derived().pts[idx_p2].z();
-    return d0 * d0 + d1 * d1 + d2 * d2;
-  }
-
-  // Returns the dim'th component of the idx'th point in the class: Since this
-  // is inlined and the "dim" argument is typically an immediate value, the
-  // "if/else's" are actually solved at compile time.
-  inline double kdtree_get_pt(const size_t idx, int dim) const
-  {
-    if(dim == 0)
-      return derived().pts[idx].x();
-    else if(dim == 1)
-      return derived().pts[idx].y();
-    else
-      return derived().pts[idx].z();
-  }
-
-  // Optional bounding-box computation: return false to default to a standard
-  // bbox computation loop.  Return true if the BBOX was already computed by the
-  // class and returned in "bb" so it can be avoided to redo it again.  Look at
-  // bb.size() to find out the expected dimensionality (e.g. 2 or 3 for point
-  // clouds)
-  template <class BBOX> bool kdtree_get_bbox(BBOX & /*bb*/) const
-  {
-    return false;
-  }
-
-}; // end of PointCloudAdaptor
-
-typedef PointCloudAdaptor<PointCloud> PC2KD;
-typedef nanoflann::KDTreeSingleIndexAdaptor<nanoflann::L2_Simple_Adaptor<double, PC2KD>,
-                                            PC2KD, 3> my_kd_tree_t;
-
 class DistanceField : public Field {
   std::list<int> nodes_id, edges_id, faces_id;
   std::vector<AttractorInfo> _infos;
@@ -2415,12 +2522,10 @@ class DistanceField : public Field {
   PointCloud P;
   my_kd_tree_t *index;
   PC2KD pc2kd;
-  std::size_t out_index;
-  double out_dist_sqr;
 
 public:
   DistanceField()
-    : index(NULL), pc2kd(P), out_index(0), out_dist_sqr(0)
+    : index(NULL), pc2kd(P)
   {
     n_nodes_by_edge = 20;
     options["NodesList"] = new FieldOptionList(
@@ -2446,13 +2551,13 @@ public:
       _zFieldId, "Id of the field to use as z coordinate.", &update_needed);
   }
   DistanceField(int dim, int tag, int nbe)
-    : n_nodes_by_edge(nbe), index(NULL), pc2kd(P), out_index(0), out_dist_sqr(0)
+    : n_nodes_by_edge(nbe), index(NULL), pc2kd(P)
   {
     if(dim == 0)
       nodes_id.push_back(tag);
-    else if(dim == 2)
+    else if(dim == 1)
       edges_id.push_back(tag);
-    else if(dim == 3)
+    else if(dim == 2)
       faces_id.push_back(tag);
     _xField = _yField = _zField = NULL;
     _xFieldId = _yFieldId = _zFieldId = -1;
@@ -2470,10 +2575,10 @@ public:
            "curve is replaced by NNodesByEdge equidistant nodes and the distance "
            "from those nodes is computed.";
   }
-  std::pair<AttractorInfo, SPoint3> getAttractorInfo() const
+  std::pair<AttractorInfo, SPoint3> getAttractorInfo(std::size_t i) const
   {
-    if(out_index < _infos.size() && out_index < P.pts.size())
-      return std::make_pair(_infos[out_index], P.pts[out_index]);
+    if(i < _infos.size() && i < P.pts.size())
+      return std::make_pair(_infos[i], P.pts[i]);
     return std::make_pair(AttractorInfo(), SPoint3());
   }
   void update()
@@ -2486,7 +2591,11 @@ public:
       _zField = _zFieldId >= 0 ? (GModel::current()->getFields()->get(_zFieldId)) :
         NULL;
 
+      if(index) delete index;
+      index = NULL;
+      _infos.clear();
       std::vector<SPoint3> &points = P.pts;
+      points.clear();
       for(std::list<int>::iterator it = faces_id.begin(); it != faces_id.end();
           ++it) {
         GFace *f = GModel::current()->getFaceByTag(*it);
@@ -2550,21 +2659,35 @@ public:
       }
 
       // construct a kd-tree index:
-      index = new my_kd_tree_t(3, pc2kd, nanoflann::KDTreeSingleIndexAdaptorParams(10));
-      index->buildIndex();
+      if(points.size()) {
+        index = new my_kd_tree_t(3, pc2kd,
+                                 nanoflann::KDTreeSingleIndexAdaptorParams(10));
+        index->buildIndex();
+      }
       update_needed = false;
     }
   }
+  // distance to the closest point of the cloud, whose index is returned in
+  // "closest" (to be used with getAttractorInfo)
+  double distance(double X, double Y, double Z, std::size_t &closest) const
+  {
+    closest = 0;
+    if(!index) return MAX_LC;
+    double xyz[3] = {X, Y, Z};
+    return closestPoint(index, xyz, closest);
+  }
   using Field::operator();
   virtual double operator()(double X, double Y, double Z, GEntity *ge = 0)
   {
-    if(!index) return MAX_LC;
-    double query_pt[3] = {X, Y, Z};
-    const size_t num_results = 1;
-    nanoflann::KNNResultSet<double> resultSet(num_results);
-    resultSet.init(&out_index, &out_dist_sqr);
-    index->findNeighbors(resultSet, &query_pt[0], nanoflann::SearchParams(10));
-    return sqrt(out_dist_sqr);
+    std::size_t closest;
+    return distance(X, Y, Z, closest);
+  }
+  void evaluate(const double *xyz, std::size_t n, double *val,
+                GEntity *ge = 0)
+  {
+    std::size_t closest;
+    for(std::size_t i = 0; i < n; i++)
+      val[i] = distance(xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2], closest);
   }
 };
 
@@ -2741,7 +2864,8 @@ double BoundaryLayerField::operator()(double x, double y, double z, GEntity *ge)
   if(_att_fields.empty()) return dist;
   for(std::list<DistanceField *>::iterator it = _att_fields.begin();
       it != _att_fields.end(); ++it) {
-    double cdist = (*(*it))(x, y, z);
+    std::size_t closest;
+    double cdist = (*it)->distance(x, y, z, closest);
     if(cdist < dist) {
       dist = cdist;
     }
@@ -2790,9 +2914,9 @@ void BoundaryLayerField::computeFor1dMesh(double x, double y, double z,
   metr = buildMetricTangentToCurve(t1, lc_n, lc_n);
 }
 
-void BoundaryLayerField::operator()(DistanceField *cc, double dist, double x,
-                                    double y, double z, SMetric3 &metr,
-                                    GEntity *ge)
+void BoundaryLayerField::operator()(DistanceField *cc, std::size_t closest,
+                                    double dist, double x, double y, double z,
+                                    SMetric3 &metr, GEntity *ge)
 {
   // dist = hwall -> lc = hwall * ratio
   // dist = hwall (1+ratio) -> lc = hwall ratio ^ 2
@@ -2813,7 +2937,7 @@ void BoundaryLayerField::operator()(DistanceField *cc, double dist, double x,
   lc_t = std::max(lc_t, CTX::instance()->mesh.lcMin);
   lc_t = std::min(lc_t, CTX::instance()->mesh.lcMax);
 
-  std::pair<AttractorInfo, SPoint3> pp = cc->getAttractorInfo();
+  std::pair<AttractorInfo, SPoint3> pp = cc->getAttractorInfo(closest);
   double beta = CTX::instance()->mesh.smoothRatio;
   if(pp.first.dim == 0) {
     GVertex *v = GModel::current()->getVertexByTag(pp.first.ent);
@@ -2902,15 +3026,16 @@ void BoundaryLayerField::operator()(double x, double y, double z,
   hop.push_back(v);
   for(std::list<DistanceField *>::iterator it = _att_fields.begin();
       it != _att_fields.end(); ++it) {
-    double cdist = (*(*it))(x, y, z);
-    SPoint3 CLOSEST = (*it)->getAttractorInfo().second;
+    std::size_t closest;
+    double cdist = (*it)->distance(x, y, z, closest);
+    SPoint3 CLOSEST = (*it)->getAttractorInfo(closest).second;
     SMetric3 localMetric;
     if(iIntersect) {
-      (*this)(*it, cdist, x, y, z, localMetric, ge);
+      (*this)(*it, closest, cdist, x, y, z, localMetric, ge);
       hop.push_back(localMetric);
     }
     if(cdist < current_distance) {
-      if(!iIntersect) (*this)(*it, cdist, x, y, z, localMetric, ge);
+      if(!iIntersect) (*this)(*it, closest, cdist, x, y, z, localMetric, ge);
       current_distance = cdist;
       current_closest = *it;
       v = localMetric;
@@ -2951,10 +3076,8 @@ FieldManager::FieldManager()
   map_type_name["ExternalProcess"] = new FieldFactoryT<ExternalProcessField>();
   map_type_name["MathEval"] = new FieldFactoryT<MathEvalField>();
   map_type_name["MathEvalAniso"] = new FieldFactoryT<MathEvalFieldAniso>();
-#if defined(HAVE_ANN)
   map_type_name["Attractor"] = new FieldFactoryT<AttractorField>();
   map_type_name["AttractorAnisoCurve"] = new FieldFactoryT<AttractorAnisoCurveField>();
-#endif
   map_type_name["MaxEigenHessian"] = new FieldFactoryT<MaxEigenHessianField>();
   _background_field = -1;
 }
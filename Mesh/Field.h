@@ -113,6 +113,12 @@ public:
                           GEntity *ge = 0)
   {
   }
+  // isotropic, for n points with coordinates xyz = [x1, y1, z1, x2, ...]: the
+  // default implementation evaluates the points one by one, but fields can
+  // override it to avoid a virtual call per point and to share work between
+  // the points
+  virtual void evaluate(const double *xyz, std::size_t n, double *val,
+                        GEntity *ge = 0);
   bool update_needed;
   virtual const char *getName() = 0;
 #if defined(HAVE_POST)
@@ -182,8 +188,8 @@ private:
   std::list<int> nodes_id, edges_id;
   std::list<int> edges_id_saved, nodes_id_saved, fan_nodes_id;
   std::list<int> excluded_faces_id;
-  void operator()(DistanceField *cc, double dist, double x, double y, double z,
-                  SMetric3 &metr, GEntity *ge);
+  void operator()(DistanceField *cc, std::size_t closest, double dist,
+                  double x, double y, double z, SMetric3 &metr, GEntity *ge);
 
 public:
   double hwall_n, ratio, hfar, thickness;
@@ -31,9 +31,11 @@
 #include "BoundaryLayers.h"
 #include "ExtrudeParams.h"
 #include "HighOrder.h"
+#include "BasisFactory.h"
 #include "Generator.h"
 #include "Field.h"
 #include "Options.h"
+#include "robustPredicates.h"
 
 #if defined(_OPENMP)
 #include <omp.h>
@@ -149,16 +151,35 @@ GetQualityMeasure(std::vector<T *> &ele, double &gamma, double &gammaMin,
                   double &minSICNMax, double &minSIGE, double &minSIGEMin,
                   double &minSIGEMax, double quality[3][100])
 {
-  for(std::size_t i = 0; i < ele.size(); i++) {
-    double g = ele[i]->gammaShapeMeasure();
+  if(ele.empty()) return;
+
+  // compute the measures in parallel (the bases used by the Jacobian-based
+  // measures are created beforehand, so that threads only read the basis
+  // cache), then accumulate them serially so that the statistics do not
+  // depend on the number of threads
+  std::vector<int> types(1, ele[0]->getTypeForMSH());
+  BasisFactory::preload(types);
+  const int n = ele.size();
+  std::vector<double> measures(3 * n);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+  for(int i = 0; i < n; i++) {
+    measures[3 * i] = ele[i]->gammaShapeMeasure();
+    measures[3 * i + 1] = ele[i]->minSICNShapeMeasure();
+    measures[3 * i + 2] = ele[i]->minSIGEShapeMeasure();
+  }
+
+  for(int i = 0; i < n; i++) {
+    double g = measures[3 * i];
     gamma += g;
     gammaMin = std::min(gammaMin, g);
     gammaMax = std::max(gammaMax, g);
-    double s = ele[i]->minSICNShapeMeasure();
+    double s = measures[3 * i + 1];
     minSICN += s;
     minSICNMin = std::min(minSICNMin, s);
     minSICNMax = std::max(minSICNMax, s);
-    double e = ele[i]->minSIGEShapeMeasure();
+    double e = measures[3 * i + 2];
     minSIGE += e;
     minSIGEMin = std::min(minSIGEMin, e);
     minSIGEMax = std::max(minSIGEMax, e);
@@ -303,6 +324,57 @@ static bool TooManyElements(GModel *m, int dim)
   return false;
 }
 
+struct MElementLessThanNum {
+  bool operator()(const MElement *e1, const MElement *e2) const
+  {
+    return e1->getNum() < e2->getNum();
+  }
+};
+
+// renumber the mesh vertices and elements created in the groups of entities
+// (i.e. with a number larger than maxVertexNum and maxElementNum) group by
+// group, in the order of their creation in each group: provided that the groups
+// processed concurrently do not share any entity, and that the per-thread
+// number reservations are invalidated between two concurrent passes, the
+// numbering does not depend on the number of threads
+static void
+RenumberNewMeshEntities(GModel *m,
+                        const std::vector<std::vector<GEntity *> > &groups,
+                        std::size_t maxVertexNum, std::size_t maxElementNum)
+{
+  // new entities created outside of the groups (if any) come last
+  std::vector<std::vector<GEntity *> > all(groups);
+  all.push_back(std::vector<GEntity *>());
+  m->getEntities(all.back());
+
+  std::size_t nv = maxVertexNum, ne = maxElementNum;
+  std::set<GEntity *> done;
+  for(std::size_t i = 0; i < all.size(); i++) {
+    std::vector<MVertex *> verts;
+    std::vector<MElement *> elems;
+    for(std::size_t j = 0; j < all[i].size(); j++) {
+      GEntity *ge = all[i][j];
+      if(!done.insert(ge).second) continue;
+      for(std::size_t k = 0; k < ge->getNumMeshVertices(); k++) {
+        MVertex *v = ge->getMeshVertex(k);
+        if(v->getNum() > maxVertexNum) verts.push_back(v);
+      }
+      for(std::size_t k = 0; k < ge->getNumMeshElements(); k++) {
+        MElement *e = ge->getMeshElement(k);
+        if(e->getNum() > maxElementNum) elems.push_back(e);
+      }
+    }
+    std::sort(verts.begin(), verts.end(), MVertexLessThanNum());
+    std::sort(elems.begin(), elems.end(), MElementLessThanNum());
+    for(std::size_t j = 0; j < verts.size(); j++) verts[j]->forceNum(++nv);
+    for(std::size_t j = 0; j < elems.size(); j++) elems[j]->forceNum(++ne);
+  }
+  // reset the maximum numbers, which might have been increased by the
+  // per-thread reservations and by the deleted entities
+  m->setMaxVertexNumber(nv);
+  m->setMaxElementNumber(ne);
+}
+
 static void Mesh0D(GModel *m)
 {
   m->getFields()->initialize();
@@ -359,6 +431,14 @@ static void Mesh1D(GModel *m)
 
   Msg::ResetProgressMeter();
 
+  // the curves are meshed concurrently: invalidate the per-thread number
+  // reservations, and renumber the new vertices and elements curve by curve
+  // afterwards, so that the numbering does not depend on the number of threads
+  std::size_t maxVertexNum = m->getMaxVertexNumber();
+  std::size_t maxElementNum = m->getMaxElementNumber();
+  m->setMaxVertexNumber(maxVertexNum);
+  m->setMaxElementNumber(maxElementNum);
+
   int nIter = 0, nTot = m->getNumEdges();
   while(1) {
     int nPending = 0;
@@ -384,6 +464,11 @@ static void Mesh1D(GModel *m)
     if(nIter++ > 10) break;
   }
 
+  std::vector<std::vector<GEntity *> > groups;
+  for(std::size_t i = 0; i < temp.size(); i++)
+    groups.push_back(std::vector<GEntity *>(1, temp[i]));
+  RenumberNewMeshEntities(m, groups, maxVertexNum, maxElementNum);
+
   Msg::SetNumThreads(prevNumThreads);
 
   double t2 = Cpu();
@@ -506,6 +591,13 @@ static void Mesh2D(GModel *m)
 
     Msg::ResetProgressMeter();
 
+    // as in 1D, renumber the new vertices and elements surface by surface
+    // once all the surfaces are meshed
+    std::size_t maxVertexNum = m->getMaxVertexNumber();
+    std::size_t maxElementNum = m->getMaxElementNumber();
+    m->setMaxVertexNumber(maxVertexNum);
+    m->setMaxElementNumber(maxElementNum);
+
     int nIter = 0, nTot = m->getNumFaces();
     while(1) {
       int nPending = 0;
@@ -533,6 +625,12 @@ static void Mesh2D(GModel *m)
       if(nIter > 2) Msg::SetNumThreads(1);
       if(nIter++ > 10) break;
     }
+
+    std::vector<std::vector<GEntity *> > groups;
+    for(std::set<GFace *, GEntityLessThan>::iterator it = f.begin();
+        it != f.end(); ++it)
+      groups.push_back(std::vector<GEntity *>(1, *it));
+    RenumberNewMeshEntities(m, groups, maxVertexNum, maxElementNum);
   }
 
   Msg::SetNumThreads(prevNumThreads);
@@ -587,6 +685,66 @@ FindConnectedRegions(const std::vector<GRegion *> &del,
             nbVolumes, connected.size());
 }
 
+// group the connected sets of regions into batches of sets that do not share
+// any model entity (and thus any mesh vertex), so that all the sets in a batch
+// can be meshed concurrently; the batches are built greedily, in the order of
+// the sets, so that they do not depend on the number of threads. The closure
+// of each set (the regions and all their bounding and embedded entities) is
+// also returned.
+static void
+FindIndependentRegionSets(const std::vector<std::vector<GRegion *> > &connected,
+                          std::vector<std::vector<std::size_t> > &batches,
+                          std::vector<std::vector<GEntity *> > &closures)
+{
+  std::vector<std::set<GEntity *> > used;
+  for(std::size_t i = 0; i < connected.size(); i++) {
+    std::set<GEntity *> closure;
+    for(std::size_t j = 0; j < connected[i].size(); j++) {
+      GRegion *gr = connected[i][j];
+      closure.insert(gr);
+      std::vector<GFace *> f = gr->faces();
+      std::vector<GFace *> const &f_e = gr->embeddedFaces();
+      f.insert(f.end(), f_e.begin(), f_e.end());
+      std::vector<GEdge *> e = gr->embeddedEdges();
+      std::vector<GVertex *> v = gr->embeddedVertices();
+      for(std::size_t k = 0; k < f.size(); k++) {
+        closure.insert(f[k]);
+        std::vector<GEdge *> const &fe = f[k]->edges();
+        std::vector<GEdge *> fe_e = f[k]->embeddedEdges();
+        std::set<GVertex *, GEntityLessThan> fv_e = f[k]->embeddedVertices();
+        e.insert(e.end(), fe.begin(), fe.end());
+        e.insert(e.end(), fe_e.begin(), fe_e.end());
+        v.insert(v.end(), fv_e.begin(), fv_e.end());
+      }
+      for(std::size_t k = 0; k < e.size(); k++) {
+        closure.insert(e[k]);
+        std::vector<GVertex *> ev = e[k]->vertices();
+        v.insert(v.end(), ev.begin(), ev.end());
+      }
+      closure.insert(v.begin(), v.end());
+    }
+    std::size_t b = 0;
+    for(; b < used.size(); b++) {
+      bool independent = true;
+      for(std::set<GEntity *>::iterator it = closure.begin();
+          it != closure.end(); ++it) {
+        if(used[b].find(*it) != used[b].end()) {
+          independent = false;
+          break;
+        }
+      }
+      if(independent) break;
+    }
+    if(b == used.size()) {
+      used.push_back(std::set<GEntity *>());
+      batches.push_back(std::vector<std::size_t>());
+    }
+    used[b].insert(closure.begin(), closure.end());
+    batches[b].push_back(i);
+    closures.push_back(std::vector<GEntity *>(closure.begin(), closure.end()));
+  }
+}
+
 // JFR : use hex-splitting to resolve non conformity
 //     : if howto == 1 ---> split hexes
 //     : if howto == 2 ---> create transition elements
@@ -854,61 +1012,113 @@ static void Mesh3D(GModel *m)
   int nb_elements_recombination = 0, nb_hexa_recombination = 0;
 #endif
 
-  for(std::size_t i = 0; i < connected.size(); i++) {
-    MeshDelaunayVolume(connected[i]);
+  // independent sets of connected regions are meshed concurrently, batch by
+  // batch; HXT is parallel internally, and MMG3D and the experimental hex
+  // mesher are not thread-safe
+  std::vector<std::vector<std::size_t> > batches;
+  std::vector<std::vector<GEntity *> > closures;
+  FindIndependentRegionSets(connected, batches, closures);
+  bool threadSafe = (CTX::instance()->mesh.algo3d != ALGO_3D_HXT &&
+                     CTX::instance()->mesh.algo3d != ALGO_3D_MMG3D &&
+                     CTX::instance()->mesh.algo3d != ALGO_3D_RTREE);
+  if(!threadSafe) {
+    batches.clear();
+    for(std::size_t i = 0; i < connected.size(); i++)
+      batches.push_back(std::vector<std::size_t>(1, i));
+  }
 
-#if defined(HAVE_DOMHEX)
-    // additional code for experimental hex mesh - will eventually be replaced
-    // by new HXT-based code
-    for(std::size_t j = 0; j < connected[i].size(); j++) {
-      GRegion *gr = connected[i][j];
-      bool treat_region_ok = false;
-      if(CTX::instance()->mesh.algo3d == ALGO_3D_RTREE) {
-        if(old_algo_hexa()) {
-          Filler f;
-          f.treat_region(gr);
-          treat_region_ok = true;
-        }
-        else {
-          Filler3D f;
-          treat_region_ok = f.treat_region(gr);
-        }
+  // the robust predicates use global static filters, which must not be
+  // reinitialized while regions are meshed concurrently: initialize them once
+  // with the bounding box of the whole mesh (so that they are also identical
+  // for any number of threads)
+  if(threadSafe && !connected.empty()) {
+    double maxx = 0, maxy = 0, maxz = 0;
+    std::vector<GEntity *> entities;
+    m->getEntities(entities);
+    for(std::size_t i = 0; i < entities.size(); i++) {
+      for(std::size_t j = 0; j < entities[i]->mesh_vertices.size(); j++) {
+        MVertex *v = entities[i]->mesh_vertices[j];
+        maxx = std::max(maxx, fabs(v->x()));
+        maxy = std::max(maxy, fabs(v->y()));
+        maxz = std::max(maxz, fabs(v->z()));
       }
-      if(treat_region_ok && (CTX::instance()->mesh.recombine3DAll ||
-                             gr->meshAttributes.recombine3D)) {
-        if(CTX::instance()->mesh.optimize) {
-          optimizeMeshGRegion opt;
-          opt(gr);
-        }
-        double a = Cpu();
-        // CTX::instance()->mesh.recombine3DLevel = 2;
-        if(CTX::instance()->mesh.recombine3DLevel >= 0) {
-          Recombinator rec;
-          rec.execute(gr);
+    }
+    robustPredicates::exactinit(1, maxx, maxy, maxz);
+  }
+
+  std::size_t maxVertexNum = m->getMaxVertexNumber();
+  std::size_t maxElementNum = m->getMaxElementNumber();
+  for(std::size_t b = 0; b < batches.size(); b++) {
+    // invalidate the per-thread number reservations, so that the entities
+    // created in this batch are numbered after those of the previous batches
+    m->setMaxVertexNumber(m->getMaxVertexNumber());
+    m->setMaxElementNumber(m->getMaxElementNumber());
+    const std::vector<std::size_t> &batch = batches[b];
+    bool parallel = (batch.size() > 1);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) if(parallel)
+#endif
+    for(std::size_t k = 0; k < batch.size(); k++) {
+      std::size_t i = batch[k];
+      MeshDelaunayVolume(connected[i]);
+
+#if defined(HAVE_DOMHEX)
+      // additional code for experimental hex mesh - will eventually be
+      // replaced by new HXT-based code
+      for(std::size_t j = 0; j < connected[i].size(); j++) {
+        GRegion *gr = connected[i][j];
+        bool treat_region_ok = false;
+        if(CTX::instance()->mesh.algo3d == ALGO_3D_RTREE) {
+          if(old_algo_hexa()) {
+            Filler f;
+            f.treat_region(gr);
+            treat_region_ok = true;
+          }
+          else {
+            Filler3D f;
+            treat_region_ok = f.treat_region(gr);
+          }
         }
-        if(CTX::instance()->mesh.recombine3DLevel >= 1) {
-          Supplementary sup;
-          sup.execute(gr);
+        if(treat_region_ok && (CTX::instance()->mesh.recombine3DAll ||
+                               gr->meshAttributes.recombine3D)) {
+          if(CTX::instance()->mesh.optimize) {
+            optimizeMeshGRegion opt;
+            opt(gr);
+          }
+          double a = Cpu();
+          // CTX::instance()->mesh.recombine3DLevel = 2;
+          if(CTX::instance()->mesh.recombine3DLevel >= 0) {
+            Recombinator rec;
+            rec.execute(gr);
+          }
+          if(CTX::instance()->mesh.recombine3DLevel >= 1) {
+            Supplementary sup;
+            sup.execute(gr);
+          }
+          PostOp post;
+          post.execute(gr, CTX::instance()->mesh.recombine3DLevel,
+                       CTX::instance()->mesh.recombine3DConformity);
+          // CTX::instance()->mesh.recombine3DConformity);
+          // 0: no pyramid, 1: single-step, 2: two-steps (conforming),
+          // true: fill non-conformities with trihedra
+          RelocateVertices(gr, CTX::instance()->mesh.nbSmoothing);
+          // while(LaplaceSmoothing (gr)){
+          // }
+          nb_elements_recombination += post.get_nb_elements();
+          nb_hexa_recombination += post.get_nb_hexahedra();
+          vol_element_recombination += post.get_vol_elements();
+          vol_hexa_recombination += post.get_vol_hexahedra();
+          time_recombination += (Cpu() - a);
         }
-        PostOp post;
-        post.execute(gr, CTX::instance()->mesh.recombine3DLevel,
-                     CTX::instance()->mesh.recombine3DConformity);
-        // CTX::instance()->mesh.recombine3DConformity);
-        // 0: no pyramid, 1: single-step, 2: two-steps (conforming),
-        // true: fill non-conformities with trihedra
-        RelocateVertices(gr, CTX::instance()->mesh.nbSmoothing);
-        // while(LaplaceSmoothing (gr)){
-        // }
-        nb_elements_recombination += post.get_nb_elements();
-        nb_hexa_recombination += post.get_nb_hexahedra();
-        vol_element_recombination += post.get_vol_elements();
-        vol_hexa_recombination += post.get_vol_hexahedra();
-        time_recombination += (Cpu() - a);
       }
-    }
 #endif
+    }
   }
 
+  // number the new mesh vertices and elements as if the sets of regions had
+  // been meshed sequentially
+  RenumberNewMeshEntities(m, closures, maxVertexNum, maxElementNum);
+
 #if defined(HAVE_DOMHEX)
   if(CTX::instance()->mesh.recombine3DAll) {
     Msg::Info("Recombination timing:");
@@ -978,7 +1188,25 @@ void OptimizeMesh(GModel *m)
   Msg::StatusBar(true, "Optimizing 3D mesh...");
   double t1 = Cpu();
 
-  std::for_each(m->firstRegion(), m->lastRegion(), optimizeMeshGRegion());
+  // regions only share boundary vertices, which are not modified by the
+  // optimizer, and can thus be optimized concurrently
+  std::vector<GRegion *> regions(m->firstRegion(), m->lastRegion());
+  std::vector<std::vector<GEntity *> > groups;
+  for(std::size_t i = 0; i < regions.size(); i++)
+    groups.push_back(std::vector<GEntity *>(1, regions[i]));
+  std::size_t maxVertexNum = m->getMaxVertexNumber();
+  std::size_t maxElementNum = m->getMaxElementNumber();
+  m->setMaxVertexNumber(maxVertexNum);
+  m->setMaxElementNumber(maxElementNum);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(std::size_t i = 0; i < regions.size(); i++) {
+    optimizeMeshGRegion opt;
+    opt(regions[i]);
+  }
+  RenumberNewMeshEntities(m, groups, maxVertexNum, maxElementNum);
+
   // Ensure that all volume Jacobians are positive
   m->setAllVolumesPositive();
 
@@ -1132,8 +1360,8 @@ void GenerateMesh(GModel *m, int ask)
   }
 
   if(CTX::instance()->mesh.renumber){
-    m->renumberMeshVertices();
-    m->renumberMeshElements();
+    m->renumberMeshVertices(CTX::instance()->mesh.renumber - 1);
+    m->renumberMeshElements(CTX::instance()->mesh.renumber - 1);
   }
 
   // Compute homology if necessary
@@ -7,6 +7,7 @@
 //   Koen Hillewaert
 //
 
+#include <algorithm>
 #include <sstream>
 #include <vector>
 #include "GmshConfig.h"
@@ -22,6 +23,7 @@
 #include "OS.h"
 #include "fullMatrix.h"
 #include "BasisFactory.h"
+#include "ElementType.h"
 #include "InnerVertexPlacement.h"
 #include "Context.h"
 
@@ -249,8 +251,16 @@ void createMatLob2LagP6()
 
 // Creation of high-order edge vertices
 
+// Number of the k-th new vertex, when the numbers of the new vertices start at
+// first (or 0 if the vertices should be numbered automatically)
+static std::size_t vertexNum(std::size_t first, int k)
+{
+  return first ? first + k : 0;
+}
+
 static bool getEdgeVerticesOnGeo(GEdge *ge, MVertex *v0, MVertex *v1,
-                                 std::vector<MVertex *> &ve, int nPts = 1)
+                                 std::vector<MVertex *> &ve, int nPts = 1,
+                                 std::size_t num = 0)
 {
   static bool GLLquad = false;
   static const double relaxFail = 1e-2;
@@ -314,7 +324,7 @@ static bool getEdgeVerticesOnGeo(GEdge *ge, MVertex *v0, MVertex *v1,
       int count = u0 < u1 ? j + 1 : nPts + 1 - (j + 1);
       // FIXME US[count] false!!!
       v = new MEdgeVertex(Mlag(count, 0), Mlag(count, 1), Mlag(count, 2), ge,
-                          US[count]);
+                          US[count], vertexNum(num, j));
       // this destroys the ordering of the mesh vertices on the edge
       ve.push_back(v);
     }
@@ -324,7 +334,8 @@ static bool getEdgeVerticesOnGeo(GEdge *ge, MVertex *v0, MVertex *v1,
       MVertex *v;
       int count = u0 < u1 ? j + 1 : nPts + 1 - (j + 1);
       GPoint pc = ge->point(US[count]);
-      v = new MEdgeVertex(pc.x(), pc.y(), pc.z(), ge, US[count]);
+      v = new MEdgeVertex(pc.x(), pc.y(), pc.z(), ge, US[count],
+                          vertexNum(num, j));
       // this destroys the ordering of the mesh vertices on the edge
       ve.push_back(v);
     }
@@ -335,7 +346,8 @@ static bool getEdgeVerticesOnGeo(GEdge *ge, MVertex *v0, MVertex *v1,
 }
 
 static bool getEdgeVerticesOnGeo(GFace *gf, MVertex *v0, MVertex *v1,
-                                 std::vector<MVertex *> &ve, int nPts = 1)
+                                 std::vector<MVertex *> &ve, int nPts = 1,
+                                 std::size_t num = 0)
 {
   SPoint2 p0, p1;
   double US[100], VS[100];
@@ -361,8 +373,8 @@ static bool getEdgeVerticesOnGeo(GFace *gf, MVertex *v0, MVertex *v1,
 
   for(int j = 0; j < nPts; j++) {
     GPoint pc = gf->point(US[j + 1], VS[j + 1]);
-    MVertex *v =
-      new MFaceVertex(pc.x(), pc.y(), pc.z(), gf, US[j + 1], VS[j + 1]);
+    MVertex *v = new MFaceVertex(pc.x(), pc.y(), pc.z(), gf, US[j + 1],
+                                 VS[j + 1], vertexNum(num, j));
     ve.push_back(v);
   }
 
@@ -371,14 +383,15 @@ static bool getEdgeVerticesOnGeo(GFace *gf, MVertex *v0, MVertex *v1,
 
 static void interpVerticesInExistingEdge(GEntity *ge, const MElement *edgeEl,
                                          std::vector<MVertex *> &veEdge,
-                                         int nPts)
+                                         int nPts, std::size_t num = 0)
 {
   fullMatrix<double> points;
   points = edgeEl->getFunctionSpace(nPts + 1)->points;
   for(int k = 2; k < nPts + 2; k++) {
     SPoint3 pos;
     edgeEl->pnt(points(k, 0), 0., 0., pos);
-    MVertex *v = new MVertex(pos.x(), pos.y(), pos.z(), ge);
+    MVertex *v =
+      new MVertex(pos.x(), pos.y(), pos.z(), ge, vertexNum(num, k - 2));
     veEdge.push_back(v);
   }
 }
@@ -398,134 +411,6 @@ inline static bool getMinMaxVert(MVertex *v0, MVertex *v1, MVertex *&vMin,
   return increasing;
 }
 
-// Get new interior vertices for a 1D element
-static void getEdgeVertices(GEdge *ge, MElement *ele,
-                            std::vector<MVertex *> &ve,
-                            std::vector<MVertex *> &newHOVert,
-                            edgeContainer &edgeVertices, bool linear,
-                            int nPts = 1)
-{
-  if(ge->geomType() == GEntity::DiscreteCurve ||
-     ge->geomType() == GEntity::BoundaryLayerCurve ||
-     ge->geomType() == GEntity::CompoundCurve ||
-     ge->geomType() == GEntity::PartitionCurve)
-    linear = true;
-
-  std::vector<MVertex *> veOld;
-  ele->getVertices(veOld);
-  MVertex *vMin, *vMax;
-  const bool increasing = getMinMaxVert(veOld[0], veOld[1], vMin, vMax);
-  std::pair<MVertex *, MVertex *> p(vMin, vMax);
-  std::vector<MVertex *> veEdge;
-  // Get vertices on geometry if asked
-  bool gotVertOnGeo =
-    linear ? false : getEdgeVerticesOnGeo(ge, veOld[0], veOld[1], veEdge, nPts);
-  // If not on geometry, create from mesh interpolation
-  if(!gotVertOnGeo) interpVerticesInExistingEdge(ge, ele, veEdge, nPts);
-  newHOVert.insert(newHOVert.end(), veEdge.begin(), veEdge.end());
-  if(edgeVertices.count(p) == 0) {
-    if(increasing) // Add newly created vertices to list
-      edgeVertices[p].insert(edgeVertices[p].end(), veEdge.begin(),
-                             veEdge.end());
-    else
-      edgeVertices[p].insert(edgeVertices[p].end(), veEdge.rbegin(),
-                             veEdge.rend());
-  }
-  else if(p.first != p.second) {
-    // Vertices already exist and edge is not a degenerated edge
-    Msg::Error("Edges from different entities share vertices: create a finer mesh "
-               "(curve involved: %d)", ge->tag());
-  }
-  ve.insert(ve.end(), veEdge.begin(), veEdge.end());
-}
-
-// Get new interior vertices for an edge in a 2D element
-static void getEdgeVertices(GFace *gf, MElement *ele,
-                            std::vector<MVertex *> &ve,
-                            std::vector<MVertex *> &newHOVert,
-                            edgeContainer &edgeVertices, bool linear,
-                            int nPts = 1)
-{
-  if(gf->geomType() == GEntity::DiscreteSurface ||
-     gf->geomType() == GEntity::BoundaryLayerSurface ||
-     gf->geomType() == GEntity::CompoundSurface ||
-     gf->geomType() == GEntity::PartitionSurface)
-    linear = true;
-
-  for(int i = 0; i < ele->getNumEdges(); i++) {
-    std::vector<MVertex *> veOld;
-    ele->getEdgeVertices(i, veOld);
-    MVertex *vMin, *vMax;
-    const bool increasing = getMinMaxVert(veOld[0], veOld[1], vMin, vMax);
-    std::pair<MVertex *, MVertex *> p(vMin, vMax);
-    std::vector<MVertex *> veEdge;
-
-    edgeContainer::iterator eIter = edgeVertices.find(p);
-
-    if(eIter != edgeVertices.end()) { // Vertices already exist
-      std::vector<MVertex *> &eVtcs = eIter->second;
-      if(increasing)
-        veEdge.assign(eVtcs.begin(), eVtcs.end());
-      else
-        veEdge.assign(eVtcs.rbegin(), eVtcs.rend());
-    }
-    else { // Vertices do not exist, create them
-      // Get vertices on geometry if asked
-      bool gotVertOnGeo =
-        linear ? false :
-                 getEdgeVerticesOnGeo(gf, veOld[0], veOld[1], veEdge, nPts);
-      if(!gotVertOnGeo) {
-        // If not on geometry, create from mesh interpolation
-        const MLineN edgeEl(veOld, ele->getPolynomialOrder());
-        interpVerticesInExistingEdge(gf, &edgeEl, veEdge, nPts);
-      }
-      newHOVert.insert(newHOVert.end(), veEdge.begin(), veEdge.end());
-
-      std::vector<MVertex *> &eVtcs = edgeVertices[p];
-
-      if(increasing) // Add newly created vertices to list
-        eVtcs.insert(eVtcs.end(), veEdge.begin(), veEdge.end());
-      else
-        eVtcs.insert(eVtcs.end(), veEdge.rbegin(), veEdge.rend());
-    }
-    ve.insert(ve.end(), veEdge.begin(), veEdge.end());
-  }
-}
-
-// Get new interior vertices for an edge in a 3D element
-static void getEdgeVertices(GRegion *gr, MElement *ele,
-                            std::vector<MVertex *> &ve,
-                            std::vector<MVertex *> &newHOVert,
-                            edgeContainer &edgeVertices, int nPts = 1)
-{
-  for(int i = 0; i < ele->getNumEdges(); i++) {
-    std::vector<MVertex *> veOld;
-    ele->getEdgeVertices(i, veOld);
-    MVertex *vMin, *vMax;
-    const bool increasing = getMinMaxVert(veOld[0], veOld[1], vMin, vMax);
-    std::pair<MVertex *, MVertex *> p(vMin, vMax);
-    std::vector<MVertex *> veEdge;
-    if(edgeVertices.count(p)) { // Vertices already exist
-      if(increasing)
-        veEdge.assign(edgeVertices[p].begin(), edgeVertices[p].end());
-      else
-        veEdge.assign(edgeVertices[p].rbegin(), edgeVertices[p].rend());
-    }
-    else { // Vertices do not exist, create them
-      const MLineN edgeEl(veOld, ele->getPolynomialOrder());
-      interpVerticesInExistingEdge(gr, &edgeEl, veEdge, nPts);
-      newHOVert.insert(newHOVert.end(), veEdge.begin(), veEdge.end());
-      if(increasing) // Add newly created vertices to list
-        edgeVertices[p].insert(edgeVertices[p].end(), veEdge.begin(),
-                               veEdge.end());
-      else
-        edgeVertices[p].insert(edgeVertices[p].end(), veEdge.rbegin(),
-                               veEdge.rend());
-    }
-    ve.insert(ve.end(), veEdge.begin(), veEdge.end());
-  }
-}
-
 // Creation of high-order face vertices
 
 static void reorientTrianglePoints(std::vector<MVertex *> &vtcs,
@@ -683,7 +568,8 @@ static void reorientQuadPoints(std::vector<MVertex *> &vtcs, int orientation,
 static void getFaceVerticesOnGeo(GFace *gf,
                                  const fullMatrix<double> &coefficients,
                                  const std::vector<MVertex *> &vertices,
-                                 std::vector<MVertex *> &vf)
+                                 std::vector<MVertex *> &vf,
+                                 std::size_t num = 0)
 {
   SPoint2 pts[1000];
   bool reparamOK = true;
@@ -711,18 +597,19 @@ static void getFaceVerticesOnGeo(GFace *gf,
       // AJ: ClosestPoint is absolutely necessary when the parameterization
       // is degenerate...
       if(gp.g()) {
-        v = new MFaceVertex(gp.x(), gp.y(), gp.z(), gf, gp.u(), gp.v());
+        v = new MFaceVertex(gp.x(), gp.y(), gp.z(), gf, gp.u(), gp.v(),
+                            vertexNum(num, k));
       }
       else {
-        v = new MVertex(X, Y, Z, gf);
+        v = new MVertex(X, Y, Z, gf, vertexNum(num, k));
       }
     }
     else {
       GPoint gp = gf->closestPoint(SPoint3(X, Y, Z), GUESS);
       if(gp.succeeded())
-        v = new MVertex(gp.x(), gp.y(), gp.z(), gf);
+        v = new MVertex(gp.x(), gp.y(), gp.z(), gf, vertexNum(num, k));
       else
-        v = new MVertex(X, Y, Z, gf);
+        v = new MVertex(X, Y, Z, gf, vertexNum(num, k));
     }
     vf.push_back(v);
   }
@@ -731,7 +618,8 @@ static void getFaceVerticesOnGeo(GFace *gf,
 static void interpVerticesInExistingFace(GEntity *ge,
                                          const fullMatrix<double> &coefficients,
                                          const std::vector<MVertex *> &vertices,
-                                         std::vector<MVertex *> &vFace)
+                                         std::vector<MVertex *> &vFace,
+                                         std::size_t num = 0)
 {
   for(int k = 0; k < coefficients.size1(); k++) {
     double x(0), y(0), z(0);
@@ -741,7 +629,7 @@ static void interpVerticesInExistingFace(GEntity *ge,
       y += coefficients(k, j) * v->y();
       z += coefficients(k, j) * v->z();
     }
-    vFace.push_back(new MVertex(x, y, z, ge));
+    vFace.push_back(new MVertex(x, y, z, ge, vertexNum(num, k)));
   }
 }
 
@@ -848,357 +736,459 @@ static int retrieveFaceBoundaryVertices(int k, int type, int nPts,
   }
 }
 
-// Get new face (excluding edge) vertices for a face of a 3D element
-static void getFaceVertices(GRegion *gr, MElement *ele,
-                            std::vector<MVertex *> &newVertices,
-                            std::vector<MVertex *> &newHOVert,
-                            faceContainer &faceVertices, int nPts = 1)
+// Creation of high-order elements
+//
+// The elements of an entity are processed in three steps. The mesh edges and
+// faces without high-order vertices are first identified serially, in the
+// order of the elements, which fixes the numbers of all the new vertices. The
+// new vertices on the edges, on the faces and inside the elements (which
+// require CAD evaluations on curves and surfaces) are then created in
+// parallel, followed by the new elements. The resulting mesh is thus the same
+// whatever the number of threads.
+
+// Mesh edge or face whose high-order vertices are created from the index-th
+// edge or face of the element ele, with numbers starting at first + num
+struct newHighOrderVertices {
+  MElement *ele;
+  int index;
+  std::size_t num;
+  std::vector<MVertex *> *vertices;
+};
+
+// Check if the high-order element replacing ele needs vertices on its faces
+// (for 3D elements) and in its interior
+static void needsHighOrderVertices(MElement *ele, bool incomplete, int nPts,
+                                   bool &faces, bool &interior)
 {
-  std::vector<MVertex *> vCorner;
-  ele->getVertices(vCorner);
-  // NB: We can get more than corner vertices but we use only corners
-
-  for(int i = 0; i < ele->getNumFaces(); i++) {
-    MFace face = ele->getFace(i);
-    std::vector<MVertex *> vFace;
-    faceContainer::iterator fIter = faceVertices.find(face);
-    if(fIter != faceVertices.end()) { // Vertices already exist
-      std::vector<MVertex *> vtcs = fIter->second;
-      int orientation;
-      bool swap;
-      if(fIter->first.computeCorrespondence(face, orientation, swap)) {
-        // Check correspondence and apply permutation if needed
-        if(face.getNumVertices() == 3 && nPts > 1)
-          reorientTrianglePoints(vtcs, orientation, swap);
-        else if(face.getNumVertices() == 4)
-          reorientQuadPoints(vtcs, orientation, swap, nPts - 1);
-      }
-      else
-        Msg::Error(
-          "Error in face lookup for recuperation of high order face nodes");
-      vFace.assign(vtcs.begin(), vtcs.end());
-    }
-    else { // Vertices do not exist, create them by interpolation
-      std::vector<MVertex *> faceBoundaryVertices;
-      int type = retrieveFaceBoundaryVertices(
-        i, ele->getType(), nPts, vCorner, newVertices, faceBoundaryVertices);
-      fullMatrix<double> *coefficients =
-        getInnerVertexPlacement(type, nPts + 1);
-      interpVerticesInExistingFace(gr, *coefficients, faceBoundaryVertices,
-                                   vFace);
-      newHOVert.insert(newHOVert.end(), vFace.begin(), vFace.end());
-      faceVertices[face].insert(faceVertices[face].end(), vFace.begin(),
-                                vFace.end());
-    }
-    newVertices.insert(newVertices.end(), vFace.begin(), vFace.end());
+  faces = interior = false;
+  if(incomplete) return;
+  switch(ele->getType()) {
+  case TYPE_TRI: interior = (nPts > 1); break;
+  case TYPE_QUA: interior = true; break;
+  case TYPE_TET: faces = interior = (nPts > 1); break;
+  case TYPE_HEX: faces = interior = true; break;
+  case TYPE_PRI:
+  case TYPE_PYR:
+    faces = true;
+    interior = (nPts > 1);
+    break;
   }
 }
 
-// Get new interior vertices for a 3D element
-static void getVolumeVertices(GRegion *gr, MElement *ele,
-                              std::vector<MVertex *> &newVertices,
-                              std::vector<MVertex *> &newHOVert, int nPts = 1)
+// Get the high-order vertices of the edges of ele, in the orientation of ele
+static void getExistingEdgeVertices(MElement *ele,
+                                    const edgeContainer &edgeVertices,
+                                    std::vector<MVertex *> &v)
 {
-  std::vector<MVertex *> boundaryVertices;
-  {
-    int nCorner = ele->getNumPrimaryVertices();
-    boundaryVertices.reserve(nCorner + newVertices.size());
-    ele->getVertices(boundaryVertices);
-    boundaryVertices.resize(nCorner);
-    boundaryVertices.insert(boundaryVertices.end(), newVertices.begin(),
-                            newVertices.end());
-  }
-  int type = ele->getType();
-  fullMatrix<double> &coefficients = *getInnerVertexPlacement(type, nPts + 1);
-
-  for(int k = 0; k < coefficients.size1(); k++) {
-    double x(0), y(0), z(0);
-    for(int j = 0; j < coefficients.size2(); j++) {
-      MVertex *v = boundaryVertices[j];
-      x += coefficients(k, j) * v->x();
-      y += coefficients(k, j) * v->y();
-      z += coefficients(k, j) * v->z();
+  for(int i = 0; i < ele->getNumEdges(); i++) {
+    MEdge edge = ele->getEdge(i);
+    MVertex *vMin, *vMax;
+    const bool increasing =
+      getMinMaxVert(edge.getVertex(0), edge.getVertex(1), vMin, vMax);
+    edgeContainer::const_iterator eIter =
+      edgeVertices.find(std::make_pair(vMin, vMax));
+    if(eIter == edgeVertices.end()) {
+      Msg::Error("Error in edge lookup for recuperation of high order edge "
+                 "nodes");
+      continue;
     }
-    MVertex *v = new MVertex(x, y, z, gr);
-    newHOVert.push_back(v);
-    newVertices.push_back(v);
+    const std::vector<MVertex *> &eVtcs = eIter->second;
+    if(increasing)
+      v.insert(v.end(), eVtcs.begin(), eVtcs.end());
+    else
+      v.insert(v.end(), eVtcs.rbegin(), eVtcs.rend());
   }
 }
 
-// Creation of high-order elements
-
-static void setHighOrder(GEdge *ge, std::vector<MVertex *> &newHOVert,
-                         edgeContainer &edgeVertices, bool linear,
-                         int nbPts = 1)
+// Get the high-order vertices of the faces of a 3D element, in the
+// orientation of ele
+static void getExistingFaceVertices(MElement *ele,
+                                    const faceContainer &faceVertices,
+                                    int nPts, std::vector<MVertex *> &v)
 {
-  std::vector<MLine *> lines2;
-  for(std::size_t i = 0; i < ge->lines.size(); i++) {
-    MLine *l = ge->lines[i];
-    std::vector<MVertex *> ve;
-    getEdgeVertices(ge, l, ve, newHOVert, edgeVertices, linear, nbPts);
-    if(nbPts == 1)
-      lines2.push_back(
-        new MLine3(l->getVertex(0), l->getVertex(1), ve[0], l->getPartition()));
+  for(int i = 0; i < ele->getNumFaces(); i++) {
+    MFace face = ele->getFace(i);
+    faceContainer::const_iterator fIter = faceVertices.find(face);
+    if(fIter == faceVertices.end()) {
+      Msg::Error(
+        "Error in face lookup for recuperation of high order face nodes");
+      continue;
+    }
+    std::vector<MVertex *> vtcs = fIter->second;
+    int orientation;
+    bool swap;
+    if(fIter->first.computeCorrespondence(face, orientation, swap)) {
+      // Check correspondence and apply permutation if needed
+      if(face.getNumVertices() == 3 && nPts > 1)
+        reorientTrianglePoints(vtcs, orientation, swap);
+      else if(face.getNumVertices() == 4)
+        reorientQuadPoints(vtcs, orientation, swap, nPts - 1);
+    }
     else
-      lines2.push_back(
-        new MLineN(l->getVertex(0), l->getVertex(1), ve, l->getPartition()));
-    delete l;
+      Msg::Error(
+        "Error in face lookup for recuperation of high order face nodes");
+    v.insert(v.end(), vtcs.begin(), vtcs.end());
   }
-  ge->lines = lines2;
-  ge->deleteVertexArrays();
 }
 
-static MTriangle *setHighOrder(MTriangle *t, GFace *gf,
-                               std::vector<MVertex *> &newHOVert,
-                               edgeContainer &edgeVertices,
-                               faceContainer &faceVertices, bool linear,
-                               bool incomplete, int nPts)
+static MElement *newHighOrderElement(MElement *e, std::vector<MVertex *> &v,
+                                     bool incomplete, int nPts,
+                                     std::size_t num)
 {
-  std::vector<MVertex *> v;
-  getEdgeVertices(gf, t, v, newHOVert, edgeVertices, linear, nPts);
-  if(nPts == 1) {
-    return new MTriangle6(t->getVertex(0), t->getVertex(1), t->getVertex(2),
-                          v[0], v[1], v[2], 0, t->getPartition());
-  }
-  else {
-    if(!incomplete)
-      getFaceVertices(gf, t, v, newHOVert, faceVertices, linear, nPts);
-    return new MTriangleN(t->getVertex(0), t->getVertex(1), t->getVertex(2), v,
-                          nPts + 1, 0, t->getPartition());
+  const int part = e->getPartition();
+  switch(e->getType()) {
+  case TYPE_TRI:
+    if(nPts == 1)
+      return new MTriangle6(e->getVertex(0), e->getVertex(1), e->getVertex(2),
+                            v[0], v[1], v[2], num, part);
+    return new MTriangleN(e->getVertex(0), e->getVertex(1), e->getVertex(2), v,
+                          nPts + 1, num, part);
+  case TYPE_QUA:
+    if(nPts == 1 && incomplete)
+      return new MQuadrangle8(e->getVertex(0), e->getVertex(1),
+                              e->getVertex(2), e->getVertex(3), v[0], v[1],
+                              v[2], v[3], num, part);
+    if(nPts == 1)
+      return new MQuadrangle9(e->getVertex(0), e->getVertex(1),
+                              e->getVertex(2), e->getVertex(3), v[0], v[1],
+                              v[2], v[3], v[4], num, part);
+    return new MQuadrangleN(e->getVertex(0), e->getVertex(1), e->getVertex(2),
+                            e->getVertex(3), v, nPts + 1, num, part);
+  case TYPE_TET:
+    if(nPts == 1)
+      return new MTetrahedron10(e->getVertex(0), e->getVertex(1),
+                                e->getVertex(2), e->getVertex(3), v[0], v[1],
+                                v[2], v[3], v[4], v[5], num, part);
+    return new MTetrahedronN(e->getVertex(0), e->getVertex(1), e->getVertex(2),
+                             e->getVertex(3), v, nPts + 1, num, part);
+  case TYPE_HEX:
+    if(nPts == 1 && incomplete)
+      return new MHexahedron20(
+        e->getVertex(0), e->getVertex(1), e->getVertex(2), e->getVertex(3),
+        e->getVertex(4), e->getVertex(5), e->getVertex(6), e->getVertex(7),
+        v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9], v[10],
+        v[11], num, part);
+    if(nPts == 1)
+      return new MHexahedron27(
+        e->getVertex(0), e->getVertex(1), e->getVertex(2), e->getVertex(3),
+        e->getVertex(4), e->getVertex(5), e->getVertex(6), e->getVertex(7),
+        v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9], v[10],
+        v[11], v[12], v[13], v[14], v[15], v[16], v[17], v[18], num, part);
+    return new MHexahedronN(e->getVertex(0), e->getVertex(1), e->getVertex(2),
+                            e->getVertex(3), e->getVertex(4), e->getVertex(5),
+                            e->getVertex(6), e->getVertex(7), v, nPts + 1, num,
+                            part);
+  case TYPE_PRI:
+    if(nPts == 1 && incomplete)
+      return new MPrism15(e->getVertex(0), e->getVertex(1), e->getVertex(2),
+                          e->getVertex(3), e->getVertex(4), e->getVertex(5),
+                          v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8],
+                          num, part);
+    if(nPts == 1)
+      return new MPrism18(e->getVertex(0), e->getVertex(1), e->getVertex(2),
+                          e->getVertex(3), e->getVertex(4), e->getVertex(5),
+                          v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8],
+                          v[9], v[10], v[11], num, part);
+    return new MPrismN(e->getVertex(0), e->getVertex(1), e->getVertex(2),
+                       e->getVertex(3), e->getVertex(4), e->getVertex(5), v,
+                       nPts + 1, num, part);
+  case TYPE_PYR:
+    return new MPyramidN(e->getVertex(0), e->getVertex(1), e->getVertex(2),
+                         e->getVertex(3), e->getVertex(4), v, nPts + 1, num,
+                         part);
+  default: return 0;
   }
 }
 
-static MQuadrangle *setHighOrder(MQuadrangle *q, GFace *gf,
-                                 std::vector<MVertex *> &newHOVert,
-                                 edgeContainer &edgeVertices,
-                                 faceContainer &faceVertices, bool linear,
-                                 bool incomplete, int nPts)
+// Create the nodal bases of the lines up to the given order, which are used to
+// interpolate the new edge vertices, before the parallel loops
+static void preloadLineBases(int order)
 {
-  std::vector<MVertex *> v;
-  getEdgeVertices(gf, q, v, newHOVert, edgeVertices, linear, nPts);
-  if(incomplete) {
-    if(nPts == 1) {
-      return new MQuadrangle8(q->getVertex(0), q->getVertex(1), q->getVertex(2),
-                              q->getVertex(3), v[0], v[1], v[2], v[3], 0,
-                              q->getPartition());
-    }
-    else {
-      return new MQuadrangleN(q->getVertex(0), q->getVertex(1), q->getVertex(2),
-                              q->getVertex(3), v, nPts + 1, 0,
-                              q->getPartition());
-    }
-  }
-  else {
-    getFaceVertices(gf, q, v, newHOVert, faceVertices, linear, nPts);
-    if(nPts == 1) {
-      return new MQuadrangle9(q->getVertex(0), q->getVertex(1), q->getVertex(2),
-                              q->getVertex(3), v[0], v[1], v[2], v[3], v[4], 0,
-                              q->getPartition());
-    }
-    else {
-      return new MQuadrangleN(q->getVertex(0), q->getVertex(1), q->getVertex(2),
-                              q->getVertex(3), v, nPts + 1, 0,
-                              q->getPartition());
-    }
-  }
+  std::vector<int> types;
+  for(int o = 1; o <= order; o++)
+    types.push_back(ElementType::getType(TYPE_LIN, o));
+  BasisFactory::preload(types);
 }
 
-static void setHighOrder(GFace *gf, std::vector<MVertex *> &newHOVert,
-                         edgeContainer &edgeVertices,
-                         faceContainer &faceVertices, bool linear,
-                         bool incomplete, int nPts = 1)
+static void setHighOrder(GModel *m, GEdge *ge,
+                         std::vector<MVertex *> &newHOVert,
+                         edgeContainer &edgeVertices, bool linear,
+                         int nbPts = 1)
 {
-  std::vector<MTriangle *> triangles2;
-  for(std::size_t i = 0; i < gf->triangles.size(); i++) {
-    MTriangle *t = gf->triangles[i];
-    MTriangle *tNew = setHighOrder(t, gf, newHOVert, edgeVertices, faceVertices,
-                                   linear, incomplete, nPts);
-    triangles2.push_back(tNew);
-    delete t;
-  }
-  gf->triangles = triangles2;
-
-  std::vector<MQuadrangle *> quadrangles2;
-  for(std::size_t i = 0; i < gf->quadrangles.size(); i++) {
-    MQuadrangle *q = gf->quadrangles[i];
-    MQuadrangle *qNew = setHighOrder(q, gf, newHOVert, edgeVertices,
-                                     faceVertices, linear, incomplete, nPts);
-    quadrangles2.push_back(qNew);
-    delete q;
-  }
-  gf->quadrangles = quadrangles2;
-  gf->deleteVertexArrays();
-}
+  if(ge->geomType() == GEntity::DiscreteCurve ||
+     ge->geomType() == GEntity::BoundaryLayerCurve ||
+     ge->geomType() == GEntity::CompoundCurve ||
+     ge->geomType() == GEntity::PartitionCurve)
+    linear = true;
 
-static MTetrahedron *setHighOrder(MTetrahedron *t, GRegion *gr,
-                                  std::vector<MVertex *> &newHOVert,
-                                  edgeContainer &edgeVertices,
-                                  faceContainer &faceVertices, bool incomplete,
-                                  int nPts)
-{
-  std::vector<MVertex *> v;
-  getEdgeVertices(gr, t, v, newHOVert, edgeVertices, nPts);
-  if(nPts == 1) {
-    return new MTetrahedron10(t->getVertex(0), t->getVertex(1), t->getVertex(2),
-                              t->getVertex(3), v[0], v[1], v[2], v[3], v[4],
-                              v[5], 0, t->getPartition());
+  const int n = ge->lines.size();
+  if(!n) return;
+  int maxOrder = nbPts + 1;
+  for(int i = 0; i < n; i++)
+    maxOrder = std::max(maxOrder, ge->lines[i]->getPolynomialOrder());
+  preloadLineBases(maxOrder);
+
+  const std::size_t firstVertex =
+    nbPts ? m->reserveVertexNumbers(n * nbPts) : 0;
+  const std::size_t firstElement = m->reserveElementNumbers(n);
+  const std::size_t offset = newHOVert.size();
+  newHOVert.resize(offset + n * nbPts);
+
+  std::vector<MLine *> lines2(n);
+  std::vector<std::vector<MVertex *> > ve(n);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(int i = 0; i < n; i++) {
+    MLine *l = ge->lines[i];
+    const std::size_t num = firstVertex + i * nbPts;
+    // Get vertices on geometry if asked
+    bool gotVertOnGeo =
+      linear ? false :
+               getEdgeVerticesOnGeo(ge, l->getVertex(0), l->getVertex(1), ve[i],
+                                    nbPts, num);
+    // If not on geometry, create from mesh interpolation
+    if(!gotVertOnGeo) interpVerticesInExistingEdge(ge, l, ve[i], nbPts, num);
+    std::copy(ve[i].begin(), ve[i].end(),
+              newHOVert.begin() + offset + i * nbPts);
+    if(nbPts == 1)
+      lines2[i] = new MLine3(l->getVertex(0), l->getVertex(1), ve[i][0],
+                             firstElement + i, l->getPartition());
+    else
+      lines2[i] = new MLineN(l->getVertex(0), l->getVertex(1), ve[i],
+                             firstElement + i, l->getPartition());
   }
-  else {
-    if(!incomplete) {
-      getFaceVertices(gr, t, v, newHOVert, faceVertices, nPts);
-      getVolumeVertices(gr, t, v, newHOVert, nPts);
+
+  for(int i = 0; i < n; i++) {
+    MLine *l = ge->lines[i];
+    MVertex *vMin, *vMax;
+    const bool increasing =
+      getMinMaxVert(l->getVertex(0), l->getVertex(1), vMin, vMax);
+    std::pair<MVertex *, MVertex *> p(vMin, vMax);
+    if(edgeVertices.count(p) == 0) {
+      if(increasing) // Add newly created vertices to list
+        edgeVertices[p].assign(ve[i].begin(), ve[i].end());
+      else
+        edgeVertices[p].assign(ve[i].rbegin(), ve[i].rend());
+    }
+    else if(p.first != p.second) {
+      // Vertices already exist and edge is not a degenerated edge
+      Msg::Error("Edges from different entities share vertices: create a "
+                 "finer mesh (curve involved: %d)",
+                 ge->tag());
     }
-    return new MTetrahedronN(t->getVertex(0), t->getVertex(1), t->getVertex(2),
-                             t->getVertex(3), v, nPts + 1, 0,
-                             t->getPartition());
+    delete l;
   }
+  ge->lines = lines2;
+  ge->deleteVertexArrays();
 }
 
-static MHexahedron *setHighOrder(MHexahedron *h, GRegion *gr,
-                                 std::vector<MVertex *> &newHOVert,
-                                 edgeContainer &edgeVertices,
-                                 faceContainer &faceVertices, bool incomplete,
-                                 int nPts)
+// Replace the elements of a surface or a volume by high-order elements
+static void setHighOrder(GModel *m, GEntity *ge,
+                         std::vector<MElement *> &elements,
+                         std::vector<MVertex *> &newHOVert,
+                         edgeContainer &edgeVertices,
+                         faceContainer &faceVertices, bool linearEdges,
+                         bool linearFaces, bool incomplete, int nPts)
 {
-  std::vector<MVertex *> v;
-  getEdgeVertices(gr, h, v, newHOVert, edgeVertices, nPts);
-  if(incomplete) {
-    if(nPts == 1) {
-      return new MHexahedron20(
-        h->getVertex(0), h->getVertex(1), h->getVertex(2), h->getVertex(3),
-        h->getVertex(4), h->getVertex(5), h->getVertex(6), h->getVertex(7),
-        v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9], v[10],
-        v[11], 0, h->getPartition());
-    }
-    else {
-      return new MHexahedronN(h->getVertex(0), h->getVertex(1), h->getVertex(2),
-                              h->getVertex(3), h->getVertex(4), h->getVertex(5),
-                              h->getVertex(6), h->getVertex(7), v, nPts + 1, 0,
-                              h->getPartition());
-    }
-  }
-  else {
-    getFaceVertices(gr, h, v, newHOVert, faceVertices, nPts);
-    getVolumeVertices(gr, h, v, newHOVert, nPts);
-    if(nPts == 1) {
-      return new MHexahedron27(
-        h->getVertex(0), h->getVertex(1), h->getVertex(2), h->getVertex(3),
-        h->getVertex(4), h->getVertex(5), h->getVertex(6), h->getVertex(7),
-        v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9], v[10],
-        v[11], v[12], v[13], v[14], v[15], v[16], v[17], v[18], 0,
-        h->getPartition());
+  const int n = elements.size();
+  if(!n) return;
+  GFace *gf = (ge->dim() == 2) ? static_cast<GFace *>(ge) : 0;
+
+  // identify the new edges and faces and number the new vertices
+  std::vector<newHighOrderVertices> newEdges, newFaces;
+  std::vector<std::size_t> interiorNum(n);
+  std::size_t numVertices = 0;
+  int maxOrder = nPts + 1;
+  for(int i = 0; i < n; i++) {
+    MElement *e = elements[i];
+    maxOrder = std::max(maxOrder, e->getPolynomialOrder());
+    for(int j = 0; j < e->getNumEdges(); j++) {
+      MEdge edge = e->getEdge(j);
+      MVertex *vMin, *vMax;
+      getMinMaxVert(edge.getVertex(0), edge.getVertex(1), vMin, vMax);
+      std::pair<edgeContainer::iterator, bool> it = edgeVertices.insert(
+        std::make_pair(std::make_pair(vMin, vMax), std::vector<MVertex *>()));
+      if(!it.second) continue;
+      it.first->second.resize(nPts);
+      newHighOrderVertices nv = {e, j, numVertices, &it.first->second};
+      newEdges.push_back(nv);
+      numVertices += nPts;
     }
-    else {
-      return new MHexahedronN(h->getVertex(0), h->getVertex(1), h->getVertex(2),
-                              h->getVertex(3), h->getVertex(4), h->getVertex(5),
-                              h->getVertex(6), h->getVertex(7), v, nPts + 1, 0,
-                              h->getPartition());
+    bool faces, interior;
+    needsHighOrderVertices(e, incomplete, nPts, faces, interior);
+    for(int j = 0; faces && j < e->getNumFaces(); j++) {
+      MFace face = e->getFace(j);
+      std::pair<faceContainer::iterator, bool> it = faceVertices.insert(
+        std::make_pair(face, std::vector<MVertex *>()));
+      if(!it.second) continue;
+      const int type = (face.getNumVertices() == 3) ? TYPE_TRI : TYPE_QUA;
+      const int nf = getInnerVertexPlacement(type, nPts + 1)->size1();
+      it.first->second.resize(nf);
+      newHighOrderVertices nv = {e, j, numVertices, &it.first->second};
+      newFaces.push_back(nv);
+      numVertices += nf;
     }
+    interiorNum[i] = numVertices;
+    if(interior)
+      numVertices += getInnerVertexPlacement(e->getType(), nPts + 1)->size1();
   }
-}
+  preloadLineBases(maxOrder);
 
-static MPrism *setHighOrder(MPrism *p, GRegion *gr,
-                            std::vector<MVertex *> &newHOVert,
-                            edgeContainer &edgeVertices,
-                            faceContainer &faceVertices, bool incomplete,
-                            int nPts)
-{
-  std::vector<MVertex *> v;
-  getEdgeVertices(gr, p, v, newHOVert, edgeVertices, nPts);
-  if(incomplete) {
-    if(nPts == 1) {
-      return new MPrism15(p->getVertex(0), p->getVertex(1), p->getVertex(2),
-                          p->getVertex(3), p->getVertex(4), p->getVertex(5),
-                          v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8],
-                          0, p->getPartition());
-    }
-    else {
-      return new MPrismN(p->getVertex(0), p->getVertex(1), p->getVertex(2),
-                         p->getVertex(3), p->getVertex(4), p->getVertex(5), v,
-                         nPts + 1, 0, p->getPartition());
+  const std::size_t first =
+    numVertices ? m->reserveVertexNumbers(numVertices) : 0;
+  const std::size_t offset = newHOVert.size();
+  newHOVert.resize(offset + numVertices);
+
+  // create the new edge vertices
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(int i = 0; i < (int)newEdges.size(); i++) {
+    const newHighOrderVertices &nv = newEdges[i];
+    std::vector<MVertex *> veOld, veEdge;
+    nv.ele->getEdgeVertices(nv.index, veOld);
+    // Get vertices on geometry if asked
+    bool gotVertOnGeo = (!gf || linearEdges) ?
+                          false :
+                          getEdgeVerticesOnGeo(gf, veOld[0], veOld[1], veEdge,
+                                               nPts, first + nv.num);
+    if(!gotVertOnGeo) {
+      // If not on geometry, create from mesh interpolation
+      const MLineN edgeEl(veOld, nv.ele->getPolynomialOrder());
+      interpVerticesInExistingEdge(ge, &edgeEl, veEdge, nPts,
+                                   first + nv.num);
     }
+    std::copy(veEdge.begin(), veEdge.end(),
+              newHOVert.begin() + offset + nv.num);
+    if(veOld[0]->getNum() < veOld[1]->getNum())
+      std::copy(veEdge.begin(), veEdge.end(), nv.vertices->begin());
+    else
+      std::copy(veEdge.rbegin(), veEdge.rend(), nv.vertices->begin());
   }
-  else {
-    getFaceVertices(gr, p, v, newHOVert, faceVertices, nPts);
-    if(nPts == 1) {
-      return new MPrism18(p->getVertex(0), p->getVertex(1), p->getVertex(2),
-                          p->getVertex(3), p->getVertex(4), p->getVertex(5),
-                          v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8],
-                          v[9], v[10], v[11], 0, p->getPartition());
+
+  // create the new face vertices of 3D elements by interpolation
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(int i = 0; i < (int)newFaces.size(); i++) {
+    const newHighOrderVertices &nv = newFaces[i];
+    std::vector<MVertex *> vCorner, vEdges, faceBoundaryVertices, vFace;
+    // NB: We can get more than corner vertices but we use only corners
+    nv.ele->getVertices(vCorner);
+    getExistingEdgeVertices(nv.ele, edgeVertices, vEdges);
+    int type = retrieveFaceBoundaryVertices(
+      nv.index, nv.ele->getType(), nPts, vCorner, vEdges, faceBoundaryVertices);
+    fullMatrix<double> *coefficients = getInnerVertexPlacement(type, nPts + 1);
+    interpVerticesInExistingFace(ge, *coefficients, faceBoundaryVertices, vFace,
+                                 first + nv.num);
+    std::copy(vFace.begin(), vFace.end(), newHOVert.begin() + offset + nv.num);
+    std::copy(vFace.begin(), vFace.end(), nv.vertices->begin());
+  }
+
+  // create the interior vertices and the new elements
+  const std::size_t firstElement = m->reserveElementNumbers(n);
+  std::vector<MElement *> elements2(n);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(int i = 0; i < n; i++) {
+    MElement *e = elements[i];
+    std::vector<MVertex *> v;
+    getExistingEdgeVertices(e, edgeVertices, v);
+    bool faces, interior;
+    needsHighOrderVertices(e, incomplete, nPts, faces, interior);
+    if(faces) getExistingFaceVertices(e, faceVertices, nPts, v);
+    if(interior) {
+      std::vector<MVertex *> boundaryVertices, vInterior;
+      const int nCorner = e->getNumPrimaryVertices();
+      boundaryVertices.reserve(nCorner + v.size());
+      for(int j = 0; j < nCorner; j++)
+        boundaryVertices.push_back(e->getVertex(j));
+      boundaryVertices.insert(boundaryVertices.end(), v.begin(), v.end());
+      fullMatrix<double> *coefficients =
+        getInnerVertexPlacement(e->getType(), nPts + 1);
+      if(gf && !linearFaces) // Get vertices on geometry if asked...
+        getFaceVerticesOnGeo(gf, *coefficients, boundaryVertices, vInterior,
+                             first + interiorNum[i]);
+      else // ... otherwise, create from mesh interpolation
+        interpVerticesInExistingFace(ge, *coefficients, boundaryVertices,
+                                     vInterior, first + interiorNum[i]);
+      std::copy(vInterior.begin(), vInterior.end(),
+                newHOVert.begin() + offset + interiorNum[i]);
+      v.insert(v.end(), vInterior.begin(), vInterior.end());
     }
-    else {
-      getVolumeVertices(gr, p, v, newHOVert, nPts);
-      return new MPrismN(p->getVertex(0), p->getVertex(1), p->getVertex(2),
-                         p->getVertex(3), p->getVertex(4), p->getVertex(5), v,
-                         nPts + 1, 0, p->getPartition());
+    elements2[i] =
+      newHighOrderElement(e, v, incomplete, nPts, firstElement + i);
+  }
+
+  for(int i = 0; i < n; i++) {
+    MElement *e = elements[i];
+    bool faces, interior;
+    needsHighOrderVertices(e, incomplete, nPts, faces, interior);
+    if(gf && interior) {
+      // the interior vertices of surface elements are shared with the faces
+      // of the volume elements
+      std::vector<MVertex *>::iterator it =
+        newHOVert.begin() + offset + interiorNum[i];
+      const int nInterior =
+        getInnerVertexPlacement(e->getType(), nPts + 1)->size1();
+      std::vector<MVertex *> &fVtcs = faceVertices[e->getFace(0)];
+      fVtcs.insert(fVtcs.end(), it, it + nInterior);
     }
+    delete e;
+    elements[i] = elements2[i];
   }
 }
 
-static MPyramid *setHighOrder(MPyramid *p, GRegion *gr,
-                              std::vector<MVertex *> &newHOVert,
-                              edgeContainer &edgeVertices,
-                              faceContainer &faceVertices, bool incomplete,
-                              int nPts)
+static void setHighOrder(GModel *m, GFace *gf,
+                         std::vector<MVertex *> &newHOVert,
+                         edgeContainer &edgeVertices,
+                         faceContainer &faceVertices, bool linear,
+                         bool incomplete, int nPts = 1)
 {
-  std::vector<MVertex *> v;
-  getEdgeVertices(gr, p, v, newHOVert, edgeVertices, nPts);
-  if(!incomplete) {
-    getFaceVertices(gr, p, v, newHOVert, faceVertices, nPts);
-    if(nPts > 1) {
-      getVolumeVertices(gr, p, v, newHOVert, nPts);
-    }
-  }
-  return new MPyramidN(p->getVertex(0), p->getVertex(1), p->getVertex(2),
-                       p->getVertex(3), p->getVertex(4), v, nPts + 1, 0,
-                       p->getPartition());
+  bool linearEdges = linear, linearFaces = linear;
+  if(gf->geomType() == GEntity::DiscreteSurface ||
+     gf->geomType() == GEntity::BoundaryLayerSurface ||
+     gf->geomType() == GEntity::CompoundSurface)
+    linearEdges = linearFaces = true;
+  if(gf->geomType() == GEntity::PartitionSurface) linearEdges = true;
+
+  std::vector<MElement *> elements(gf->triangles.begin(), gf->triangles.end());
+  elements.insert(elements.end(), gf->quadrangles.begin(),
+                  gf->quadrangles.end());
+  setHighOrder(m, gf, elements, newHOVert, edgeVertices, faceVertices,
+               linearEdges, linearFaces, incomplete, nPts);
+  std::size_t k = 0;
+  for(std::size_t i = 0; i < gf->triangles.size(); i++)
+    gf->triangles[i] = static_cast<MTriangle *>(elements[k++]);
+  for(std::size_t i = 0; i < gf->quadrangles.size(); i++)
+    gf->quadrangles[i] = static_cast<MQuadrangle *>(elements[k++]);
+  gf->deleteVertexArrays();
 }
 
-static void setHighOrder(GRegion *gr, std::vector<MVertex *> &newHOVert,
+static void setHighOrder(GModel *m, GRegion *gr,
+                         std::vector<MVertex *> &newHOVert,
                          edgeContainer &edgeVertices,
                          faceContainer &faceVertices, bool incomplete,
                          int nPts = 1)
 {
-  std::vector<MTetrahedron *> tetrahedra2;
-  for(std::size_t i = 0; i < gr->tetrahedra.size(); i++) {
-    MTetrahedron *t = gr->tetrahedra[i];
-    MTetrahedron *tNew = setHighOrder(t, gr, newHOVert, edgeVertices,
-                                      faceVertices, incomplete, nPts);
-    tetrahedra2.push_back(tNew);
-    delete t;
-  }
-  gr->tetrahedra = tetrahedra2;
-
-  std::vector<MHexahedron *> hexahedra2;
-  for(std::size_t i = 0; i < gr->hexahedra.size(); i++) {
-    MHexahedron *h = gr->hexahedra[i];
-    MHexahedron *hNew = setHighOrder(h, gr, newHOVert, edgeVertices,
-                                     faceVertices, incomplete, nPts);
-    hexahedra2.push_back(hNew);
-    delete h;
-  }
-  gr->hexahedra = hexahedra2;
-
-  std::vector<MPrism *> prisms2;
-  for(std::size_t i = 0; i < gr->prisms.size(); i++) {
-    MPrism *p = gr->prisms[i];
-    MPrism *pNew = setHighOrder(p, gr, newHOVert, edgeVertices, faceVertices,
-                                incomplete, nPts);
-    prisms2.push_back(pNew);
-    delete p;
-  }
-  gr->prisms = prisms2;
-
-  std::vector<MPyramid *> pyramids2;
-  for(std::size_t i = 0; i < gr->pyramids.size(); i++) {
-    MPyramid *p = gr->pyramids[i];
-    MPyramid *pNew = setHighOrder(p, gr, newHOVert, edgeVertices, faceVertices,
-                                  incomplete, nPts);
-    pyramids2.push_back(pNew);
-    delete p;
-  }
-  gr->pyramids = pyramids2;
-
+  std::vector<MElement *> elements(gr->tetrahedra.begin(),
+                                   gr->tetrahedra.end());
+  elements.insert(elements.end(), gr->hexahedra.begin(), gr->hexahedra.end());
+  elements.insert(elements.end(), gr->prisms.begin(), gr->prisms.end());
+  elements.insert(elements.end(), gr->pyramids.begin(), gr->pyramids.end());
+  setHighOrder(m, gr, elements, newHOVert, edgeVertices, faceVertices, true,
+               true, incomplete, nPts);
+  std::size_t k = 0;
+  for(std::size_t i = 0; i < gr->tetrahedra.size(); i++)
+    gr->tetrahedra[i] = static_cast<MTetrahedron *>(elements[k++]);
+  for(std::size_t i = 0; i < gr->hexahedra.size(); i++)
+    gr->hexahedra[i] = static_cast<MHexahedron *>(elements[k++]);
+  for(std::size_t i = 0; i < gr->prisms.size(); i++)
+    gr->prisms[i] = static_cast<MPrism *>(elements[k++]);
+  for(std::size_t i = 0; i < gr->pyramids.size(); i++)
+    gr->pyramids[i] = static_cast<MPyramid *>(elements[k++]);
   gr->deleteVertexArrays();
 }
 
@@ -1592,14 +1582,14 @@ void SetOrderN(GModel *m, int order, bool linear, bool incomplete,
     Msg::Info("Meshing curve %d order %d", (*it)->tag(), order);
     Msg::ProgressMeter(++counter, nTot, false, msg);
     if(onlyVisible && !(*it)->getVisibility()) continue;
-    setHighOrder(*it, newHOVert[*it], edgeVertices, linear, nPts);
+    setHighOrder(m, *it, newHOVert[*it], edgeVertices, linear, nPts);
   }
 
   for(GModel::fiter it = m->firstFace(); it != m->lastFace(); ++it) {
     Msg::Info("Meshing surface %d order %d", (*it)->tag(), order);
     Msg::ProgressMeter(++counter, nTot, false, msg);
     if(onlyVisible && !(*it)->getVisibility()) continue;
-    setHighOrder(*it, newHOVert[*it], edgeVertices, faceVertices, linear,
+    setHighOrder(m, *it, newHOVert[*it], edgeVertices, faceVertices, linear,
                  incomplete, nPts);
     if((*it)->getColumns() != 0) (*it)->getColumns()->clearElementData();
   }
@@ -1608,8 +1598,8 @@ void SetOrderN(GModel *m, int order, bool linear, bool incomplete,
     Msg::Info("Meshing volume %d order %d", (*it)->tag(), order);
     Msg::ProgressMeter(++counter, nTot, false, msg);
     if(onlyVisible && !(*it)->getVisibility()) continue;
-    setHighOrder(*it, newHOVert[*it], edgeVertices, faceVertices, incomplete,
-                 nPts);
+    setHighOrder(m, *it, newHOVert[*it], edgeVertices, faceVertices,
+                 incomplete, nPts);
     if((*it)->getColumns() != 0) (*it)->getColumns()->clearElementData();
   }
 
@@ -1640,7 +1630,7 @@ void SetOrderN(GModel *m, int order, bool linear, bool incomplete,
           p.dim = 2;
           break;
         }
-    if(p.dim == 2) HighOrderMeshFastCurving(GModel::current(), p, true);
+    if(p.dim == 2) HighOrderMeshFastCurving(m, p, true);
 #else
   // Msg::Error("High-order mesh optimization requires the OPTHOM module");
 #endif
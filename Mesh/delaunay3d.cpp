@@ -985,12 +985,20 @@ static int checkLocalDelaunayness(tetContainer &c, int thread, char *msg)
 }
 */
 
-static Tet *randomTet(int thread, tetContainer &allocator)
+// pseudo-random numbers with a local state (rand() is not thread-safe, and its
+// sequence would depend on the order in which the regions are meshed)
+static inline unsigned int nextRandom(unsigned int &seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return (seed / 65536u) % 32768u;
+}
+
+static Tet *randomTet(int thread, tetContainer &allocator, unsigned int &seed)
 {
   std::size_t N = allocator.size(thread);
   //  printf("coucou random TET %d %d\n",thread,N);
   while(1) {
-    Tet *t = allocator(thread, rand() % N);
+    Tet *t = allocator(thread, nextRandom(seed) % N);
     if(t->V[0]) return t;
   }
 }
@@ -1036,8 +1044,9 @@ void delaunayTrgl(const std::size_t numThreads,
     std::vector<bool> ok(NPTS_AT_ONCE);
     connContainer faceToTet;
     std::vector<Tet *> Choice(NPTS_AT_ONCE);
+    unsigned int seed = myThread + 1;
     for(std::size_t K = 0; K < NPTS_AT_ONCE; K++)
-      Choice[K] = randomTet(0, allocator);
+      Choice[K] = randomTet(0, allocator, seed);
 
     invalidCavities[myThread] = 0;
     for(std::size_t K = 0; K < NPTS_AT_ONCE; K++) {
@@ -1068,13 +1077,13 @@ void delaunayTrgl(const std::size_t numThreads,
 
         if(vToAdd[K]) {
           // In 3D, insertion of a point may lead to deletion of tets !!
-          if(!Choice[K]->V[0]) Choice[K] = randomTet(0, allocator);
+          if(!Choice[K]->V[0]) Choice[K] = randomTet(0, allocator, seed);
           while(1) {
             t[K] = walk(Choice[K], vToAdd[K], Npts, totSearch, myThread);
             if(t[K]) break;
             // the domain may not be convex. we then start from a random tet and
             // walk from there
-            Choice[K] = randomTet(0, allocator);
+            Choice[K] = randomTet(0, allocator, seed);
           }
         }
       }
@@ -1288,11 +1297,15 @@ void delaunayTriangulation(const int numThreads, const int nptsatonce,
 
   tetContainer allocator(numThreads, S.size() * 10);
 
+  unsigned int seed = 1;
   for(std::size_t i = 0; i < N; i++) {
     MVertex *mv = S[i];
-    double dx = d * CTX::instance()->mesh.randFactor3d * (double)rand() / RAND_MAX;
-    double dy = d * CTX::instance()->mesh.randFactor3d * (double)rand() / RAND_MAX;
-    double dz = d * CTX::instance()->mesh.randFactor3d * (double)rand() / RAND_MAX;
+    double dx = d * CTX::instance()->mesh.randFactor3d *
+                (double)nextRandom(seed) / 32767.;
+    double dy = d * CTX::instance()->mesh.randFactor3d *
+                (double)nextRandom(seed) / 32767.;
+    double dz = d * CTX::instance()->mesh.randFactor3d *
+                (double)nextRandom(seed) / 32767.;
     mv->x() += dx;
     mv->y() += dy;
     mv->z() += dz;
@@ -1301,7 +1314,11 @@ void delaunayTriangulation(const int numThreads, const int nptsatonce,
     _temp[v->getNum()] = mv;
   }
 
-  robustPredicates::exactinit(1, maxx, maxy, maxz);
+  // Mesh3D() initializes the predicates once for the whole model before
+  // meshing regions concurrently: only reinitialize them (which modifies
+  // global state) if the current filters do not cover these points
+  if(!robustPredicates::exactinitcovers(maxx, maxy, maxz))
+    robustPredicates::exactinit(1, maxx, maxy, maxz);
 
   Vert *box[8];
   delaunayTriangulation(numThreads, nptsatonce, _vertices, box, allocator);
@@ -86,6 +86,10 @@ struct F_LcB {
 };
 
 struct F_Lc {
+  // mesh sizes computed beforehand for some values of the parameter (see
+  // precomputeMeshSizes())
+  const std::map<double, double> *lc;
+  F_Lc(const std::map<double, double> *l = 0) : lc(l) {}
   double operator()(GEdge *ge, double t)
   {
     GPoint p = ge->point(t);
@@ -93,7 +97,10 @@ struct F_Lc {
     double t_begin = bounds.low();
     double t_end = bounds.high();
     double lc_here;
-    if(t == t_begin && ge->getBeginVertex())
+    std::map<double, double>::const_iterator it;
+    if(lc && (it = lc->find(t)) != lc->end())
+      lc_here = it->second;
+    else if(t == t_begin && ge->getBeginVertex())
       lc_here = BGM_MeshSize(ge->getBeginVertex(), t, 0, p.x(), p.y(), p.z());
     else if(t == t_end && ge->getEndVertex())
       lc_here = BGM_MeshSize(ge->getEndVertex(), t, 0, p.x(), p.y(), p.z());
@@ -252,6 +259,43 @@ static void RecursiveIntegration(GEdge *ge, IntPoint *from, IntPoint *to,
   (*depth)--;
 }
 
+// the parameters of the points at which the integrand is always evaluated by
+// RecursiveIntegration, which refines the interval at least down to depth 7
+static void uniformMidpoints(double t1, double t2, int depth,
+                             std::vector<double> &t)
+{
+  double tm = 0.5 * (t1 + t2);
+  t.push_back(tm);
+  if(depth < 7) {
+    uniformMidpoints(t1, tm, depth + 1, t);
+    uniformMidpoints(tm, t2, depth + 1, t);
+  }
+}
+
+// evaluate the mesh size at all these points with a single call to the
+// background field, instead of one call per point
+static void precomputeMeshSizes(GEdge *ge, double t1, double t2,
+                                std::map<double, double> &lc)
+{
+  std::vector<double> t;
+  uniformMidpoints(t1, t2, 1, t);
+  // the sizes at the end points of the curve are computed on the end vertices
+  t.erase(std::remove(t.begin(), t.end(), t1), t.end());
+  t.erase(std::remove(t.begin(), t.end(), t2), t.end());
+  const std::size_t n = t.size();
+  if(!n) return;
+  std::vector<double> uv(2 * n, 0.), xyz(3 * n), l(n);
+  for(std::size_t i = 0; i < n; i++) {
+    GPoint p = ge->point(t[i]);
+    uv[2 * i] = t[i];
+    xyz[3 * i] = p.x();
+    xyz[3 * i + 1] = p.y();
+    xyz[3 * i + 2] = p.z();
+  }
+  BGM_MeshSize(ge, n, &uv[0], &xyz[0], &l[0]);
+  for(std::size_t i = 0; i < n; i++) lc[t[i]] = l[i];
+}
+
 template <typename function>
 static double Integration(GEdge *ge, double t1, double t2, function f,
                           std::vector<IntPoint> &Points, double Prec)
@@ -640,7 +684,9 @@ void meshGEdge::operator()(GEdge *ge)
                       CTX::instance()->mesh.lcIntegrationPrecision);
     }
     else {
-      a = Integration(ge, t_begin, t_end, F_Lc(), Points,
+      std::map<double, double> lc;
+      precomputeMeshSizes(ge, t_begin, t_end, lc);
+      a = Integration(ge, t_begin, t_end, F_Lc(&lc), Points,
                       CTX::instance()->mesh.lcIntegrationPrecision);
     }
 
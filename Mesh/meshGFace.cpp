@@ -1112,7 +1112,9 @@ BDS2GMSH(BDS_Mesh *m, GFace *gf,
 
 static void _deleteUnusedVertices(GFace *gf)
 {
-  std::set<MVertex *> allverts;
+  // keep the vertices in their order of creation (and not of their address,
+  // which depends on the other surfaces meshed concurrently)
+  std::set<MVertex *, MVertexLessThanNum> allverts;
   for(std::size_t i = 0; i < gf->triangles.size(); i++) {
     for(int j = 0; j < 3; j++){
       if(gf->triangles[i]->getVertex(j)->onWhat() == gf)
@@ -2061,6 +2063,14 @@ static GEdge *getGEdge(GFace *gf, MVertex *v1, MVertex *v2)
   return NULL;
 }
 
+// pseudo-random numbers in [0, 1] with a local state (rand() is not
+// thread-safe, and surfaces are meshed concurrently)
+static inline double nextRandom(unsigned int &seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return (double)((seed / 65536u) % 32768u) / 32767.;
+}
+
 static bool meshGeneratorPeriodic(GFace *gf, int RECUR_ITER,
                                   bool repairSelfIntersecting1dMesh,
                                   bool debug = true)
@@ -2086,6 +2096,9 @@ static bool meshGeneratorPeriodic(GFace *gf, int RECUR_ITER,
 
   const double LC2D = std::sqrt(du * du + dv * dv);
 
+  // the perturbation of the points only depends on the surface
+  unsigned int seed = gf->tag();
+
   // Buid a BDS_Mesh structure that is convenient for doing the actual meshing
   // procedure
   BDS_Mesh *m = new BDS_Mesh;
@@ -2214,10 +2227,8 @@ static bool meshGeneratorPeriodic(GFace *gf, int RECUR_ITER,
       pp->lcBGM() = BGM_MeshSize(*itvx, 0, 0, v->x(), v->y(), v->z());
       pp->lc() = pp->lcBGM();
       recoverMap[pp] = v;
-      double XX = CTX::instance()->mesh.randFactor * LC2D * (double)rand() /
-                  (double)RAND_MAX;
-      double YY = CTX::instance()->mesh.randFactor * LC2D * (double)rand() /
-                  (double)RAND_MAX;
+      double XX = CTX::instance()->mesh.randFactor * LC2D * nextRandom(seed);
+      double YY = CTX::instance()->mesh.randFactor * LC2D * nextRandom(seed);
       doc.points[count].where.h = pp->u + XX;
       doc.points[count].where.v = pp->v + YY;
       doc.points[count].adjacent = NULL;
@@ -2298,9 +2309,9 @@ static bool meshGeneratorPeriodic(GFace *gf, int RECUR_ITER,
             recoverMap[pp] = v;
             facile[v] = pp;
             double XX = CTX::instance()->mesh.randFactor * LC2D *
-                        (double)rand() / (double)RAND_MAX;
+                        nextRandom(seed);
             double YY = CTX::instance()->mesh.randFactor * LC2D *
-                        (double)rand() / (double)RAND_MAX;
+                        nextRandom(seed);
             doc.points[count].where.h = pp->u + XX;
             doc.points[count].where.v = pp->v + YY;
             doc.points[count].adjacent = NULL;
@@ -2322,10 +2333,8 @@ static bool meshGeneratorPeriodic(GFace *gf, int RECUR_ITER,
       std::vector<BDS_Point *> &edgeLoop_BDS = edgeLoops_BDS[i];
       for(std::size_t j = 0; j < edgeLoop_BDS.size(); j++) {
         BDS_Point *pp = edgeLoop_BDS[j];
-        double XX = CTX::instance()->mesh.randFactor * LC2D * (double)rand() /
-                    (double)RAND_MAX;
-        double YY = CTX::instance()->mesh.randFactor * LC2D * (double)rand() /
-                    (double)RAND_MAX;
+        double XX = CTX::instance()->mesh.randFactor * LC2D * nextRandom(seed);
+        double YY = CTX::instance()->mesh.randFactor * LC2D * nextRandom(seed);
         doc.points[count].where.h = pp->u + XX;
         doc.points[count].where.v = pp->v + YY;
         doc.points[count].adjacent = NULL;
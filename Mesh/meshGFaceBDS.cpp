@@ -93,18 +93,19 @@ double NewGetLc(BDS_Point *point)
                                       point->lcBGM();
 }
 
-static double correctLC_(BDS_Point *p1, BDS_Point *p2, GFace *f)
+static void midPoint_(BDS_Point *p1, BDS_Point *p2, double &U, double &V)
+{
+  const double coord = 0.5;
+  U = coord * p1->u + (1 - coord) * p2->u;
+  V = coord * p1->v + (1 - coord) * p2->v;
+}
+
+// lmid is the background mesh size at the middle of p1 and p2
+static double correctLC_(BDS_Point *p1, BDS_Point *p2, double lmid)
 {
   double l1 = NewGetLc(p1);
   double l2 = NewGetLc(p2);
   double l = .5 * (l1 + l2);
-
-  const double coord = 0.5;
-  double U = coord * p1->u + (1 - coord) * p2->u;
-  double V = coord * p1->v + (1 - coord) * p2->v;
-
-  GPoint gpp = f->point(U, V);
-  double lmid = BGM_MeshSize(f, U, V, gpp.x(), gpp.y(), gpp.z());
   l = std::min(l, lmid);
 
   if(CTX::instance()->mesh.lcFromCurvature) {
@@ -118,12 +119,43 @@ static double correctLC_(BDS_Point *p1, BDS_Point *p2, GFace *f)
   return l;
 }
 
+static double correctLC_(BDS_Point *p1, BDS_Point *p2, GFace *f)
+{
+  double U, V;
+  midPoint_(p1, p2, U, V);
+  GPoint gpp = f->point(U, V);
+  double lmid = BGM_MeshSize(f, U, V, gpp.x(), gpp.y(), gpp.z());
+  return correctLC_(p1, p2, lmid);
+}
+
 double NewGetLc(BDS_Edge *const edge, GFace *const face)
 {
   return computeEdgeLinearLength(edge, face) /
          correctLC_(edge->p1, edge->p2, face);
 }
 
+// same as above for a set of edges, with a single evaluation of the
+// background mesh size at all the edge midpoints
+static void NewGetLc(const std::vector<BDS_Edge *> &edges, GFace *const face,
+                     std::vector<double> &lone)
+{
+  const std::size_t n = edges.size();
+  lone.resize(n);
+  if(!n) return;
+  std::vector<double> uv(2 * n), xyz(3 * n), lmid(n);
+  for(std::size_t i = 0; i < n; i++) {
+    midPoint_(edges[i]->p1, edges[i]->p2, uv[2 * i], uv[2 * i + 1]);
+    GPoint gpp = face->point(uv[2 * i], uv[2 * i + 1]);
+    xyz[3 * i] = gpp.x();
+    xyz[3 * i + 1] = gpp.y();
+    xyz[3 * i + 2] = gpp.z();
+  }
+  BGM_MeshSize(face, n, &uv[0], &xyz[0], &lmid[0]);
+  for(std::size_t i = 0; i < n; i++)
+    lone[i] = computeEdgeLinearLength(edges[i], face) /
+              correctLC_(edges[i]->p1, edges[i]->p2, lmid[i]);
+}
+
 double NewGetLc(BDS_Point *p1, BDS_Point *p2, GFace *f)
 {
   double linearLength = computeEdgeLinearLength(p1, p2, f);
@@ -343,20 +375,27 @@ static void splitEdgePass(GFace *gf, BDS_Mesh &m, double MAXE_, int &nb_split,
     }
   }
 
+  std::vector<BDS_Edge *> candidates;
   std::vector<BDS_Edge *>::const_iterator it = m.edges.begin();
   while(it != m.edges.end()) {
     if(!(*it)->deleted && (*it)->numfaces() == 2 &&
-       (*it)->g->classif_degree == 2) {
-      double lone = NewGetLc(*it, gf);
-      if(lone > MAXE_) edges.push_back(std::make_pair(-lone, *it));
-    }
+       (*it)->g->classif_degree == 2)
+      candidates.push_back(*it);
     ++it;
   }
+  std::vector<double> lone;
+  NewGetLc(candidates, gf, lone);
+  for(std::size_t i = 0; i < candidates.size(); i++) {
+    if(lone[i] > MAXE_)
+      edges.push_back(std::make_pair(-lone[i], candidates[i]));
+  }
 
   std::sort(edges.begin(), edges.end(), edges_sort);
 
   std::vector<BDS_Point *> mids(edges.size());
 
+  std::vector<BDS_Point *> newPoints;
+
   bool faceDiscrete = gf->geomType() == GEntity::DiscreteSurface;
 
   for(std::size_t i = 0; i < edges.size(); ++i) {
@@ -392,12 +431,27 @@ static void splitEdgePass(GFace *gf, BDS_Mesh &m, double MAXE_, int &nb_split,
         mid->u = U;
         mid->v = V;
         mid->lc() = 0.5 * (e->p1->lc() + e->p2->lc());
-        mid->lcBGM() = BGM_MeshSize(gf, U, V, mid->X, mid->Y, mid->Z);
+        newPoints.push_back(mid);
       }
     }
     mids[i] = mid;
   }
 
+  // background mesh size at the new points, evaluated by batch
+  std::vector<double> uv(2 * newPoints.size()), xyz(3 * newPoints.size());
+  std::vector<double> lc(newPoints.size());
+  for(std::size_t i = 0; i < newPoints.size(); i++) {
+    uv[2 * i] = newPoints[i]->u;
+    uv[2 * i + 1] = newPoints[i]->v;
+    xyz[3 * i] = newPoints[i]->X;
+    xyz[3 * i + 1] = newPoints[i]->Y;
+    xyz[3 * i + 2] = newPoints[i]->Z;
+  }
+  if(newPoints.size())
+    BGM_MeshSize(gf, newPoints.size(), &uv[0], &xyz[0], &lc[0]);
+  for(std::size_t i = 0; i < newPoints.size(); i++)
+    newPoints[i]->lcBGM() = lc[i];
+
   for(std::size_t i = 0; i < edges.size(); ++i) {
     BDS_Edge *e = edges[i].second;
     if(!e->deleted) {
@@ -477,14 +531,19 @@ void collapseEdgePass(GFace *gf, BDS_Mesh &m, double MINE_, int MAXNP,
   std::vector<BDS_Edge *>::const_iterator it = m.edges.begin();
   std::vector<std::pair<double, BDS_Edge *> > edges;
 
+  std::vector<BDS_Edge *> candidates;
   while(it != m.edges.end()) {
     if(!(*it)->deleted && (*it)->numfaces() == 2 &&
-       (*it)->g->classif_degree == 2) {
-      double lone = NewGetLc(*it, gf);
-      if(lone < MINE_) edges.push_back(std::make_pair(lone, *it));
-    }
+       (*it)->g->classif_degree == 2)
+      candidates.push_back(*it);
     ++it;
   }
+  std::vector<double> lone;
+  NewGetLc(candidates, gf, lone);
+  for(std::size_t i = 0; i < candidates.size(); i++) {
+    if(lone[i] < MINE_)
+      edges.push_back(std::make_pair(lone[i], candidates[i]));
+  }
 
   std::sort(edges.begin(), edges.end(), edges_sort);
 
@@ -739,18 +798,23 @@ void refineMeshBDS(GFace *gf, BDS_Mesh &m, const int NIT,
     int NN1 = m.edges.size();
     int NN2 = 0;
     std::vector<BDS_Edge *>::iterator it = m.edges.begin();
+    std::vector<BDS_Edge *> candidates;
 
     while(1) {
       if(NN2++ >= NN1) break;
       if(!(*it)->deleted) {
         (*it)->p1->config_modified = false;
         (*it)->p2->config_modified = false;
-        double lone = NewGetLc(*it, gf);
-        maxL = std::max(maxL, lone);
-        minL = std::min(minL, lone);
+        candidates.push_back(*it);
       }
       ++it;
     }
+    std::vector<double> lone;
+    NewGetLc(candidates, gf, lone);
+    for(std::size_t i = 0; i < lone.size(); i++) {
+      maxL = std::max(maxL, lone[i]);
+      minL = std::min(minL, lone[i]);
+    }
 
     if((minL > MINE_ && maxL < MAXE_) || IT > (abs(NIT))) break;
     double maxE = MAXE_;
@@ -41,14 +41,14 @@ void splitQuadRecovery::add(const MFace &f, MVertex *v, GFace *gf)
   _tri[f3] = gf;
 }
 
-int splitQuadRecovery::buildPyramids(GModel *gm)
+int splitQuadRecovery::buildPyramids(const std::vector<GRegion *> &regions)
 {
   if(_quad.empty()) return 0;
 
   Msg::Info("Generating pyramids for hybrid mesh...");
   int npyram = 0;
-  for(GModel::riter it = gm->firstRegion(); it != gm->lastRegion(); it++){
-    GRegion *gr = *it;
+  for(std::size_t k = 0; k < regions.size(); k++){
+    GRegion *gr = regions[k];
     if(gr->meshAttributes.method == MESH_TRANSFINITE) continue;
     if(gr->geomType() == GEntity::DiscreteVolume) continue;
     ExtrudeParams *ep = gr->meshAttributes.extrude;
@@ -153,11 +153,15 @@ void MeshDelaunayVolume(std::vector<GRegion *> &regions)
     refineMeshMMG(gr);
   }
   else{
-    insertVerticesInRegion(gr, 2000000000, true, &sqr);
+    // only consider the regions meshed together, so that independent sets of
+    // regions can be meshed concurrently
+    insertVerticesInRegion(gr, 2000000000, true, &sqr, &regions);
 
-    if(sqr.buildPyramids(gr->model())){
+    if(sqr.buildPyramids(regions)){
       Msg::Info("Optimizing pyramids for hybrid mesh...");
-      gr->model()->setAllVolumesPositive();
+      for(std::size_t i = 0; i < regions.size(); i++)
+        for(std::size_t j = 0; j < regions[i]->getNumMeshElements(); j++)
+          regions[i]->getMeshElement(j)->setVolumePositive();
       RelocateVerticesOfPyramids(regions, 3);
       //RelocateVertices(regions, 3);
       Msg::Info("Done optimizing pyramids for hybrid mesh");
@@ -217,15 +221,20 @@ void optimizeMeshGRegion::operator()(GRegion *gr, bool always)
 
 bool buildFaceSearchStructure(GModel *model, fs_cont &search,
                               bool onlyTriangles)
+{
+  std::vector<GRegion *> regions(model->firstRegion(), model->lastRegion());
+  return buildFaceSearchStructure(regions, search, onlyTriangles);
+}
+
+bool buildFaceSearchStructure(const std::vector<GRegion *> &regions,
+                              fs_cont &search, bool onlyTriangles)
 {
   search.clear();
 
   std::set<GFace *> faces_to_consider;
-  GModel::riter rit = model->firstRegion();
-  while(rit != model->lastRegion()) {
-    std::vector<GFace *> _faces = (*rit)->faces();
+  for(std::size_t i = 0; i < regions.size(); i++) {
+    std::vector<GFace *> _faces = regions[i]->faces();
     faces_to_consider.insert(_faces.begin(), _faces.end());
-    rit++;
   }
 
   std::set<GFace *>::iterator fit = faces_to_consider.begin();
@@ -65,6 +65,8 @@ GFace *findInFaceSearchStructure(const MFace &f, const fs_cont &search);
 GEdge *findInEdgeSearchStructure(MVertex *p1, MVertex *p2,
                                  const es_cont &search);
 bool buildFaceSearchStructure(GModel *model, fs_cont &search, bool onlyTriangles = false);
+bool buildFaceSearchStructure(const std::vector<GRegion *> &regions,
+                              fs_cont &search, bool onlyTriangles = false);
 bool buildEdgeSearchStructure(GModel *model, es_cont &search);
 
 // hybrid mesh recovery structure
@@ -77,7 +79,7 @@ public:
   void add(const MFace &f, MVertex *v, GFace *gf);
   std::map<MFace, GFace *, Less_Face> &getTri() { return _tri; }
   std::map<MFace, MVertex *, Less_Face> &getQuad() { return _quad; }
-  int buildPyramids(GModel *gm);
+  int buildPyramids(const std::vector<GRegion *> &regions);
 };
 
 // adapt the mesh of a region
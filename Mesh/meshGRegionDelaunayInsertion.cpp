@@ -625,12 +625,13 @@ static void completeTheSetOfFaces(GModel *model, std::set<GFace *> &faces_bound)
 }
 
 GRegion *getRegionFromBoundingFaces(GModel *model,
-                                    std::set<GFace *> &faces_bound)
+                                    std::set<GFace *> &faces_bound,
+                                    const std::vector<GRegion *> &regions)
 {
   completeTheSetOfFaces(model, faces_bound);
 
-  GModel::riter git = model->firstRegion();
-  while(git != model->lastRegion()) {
+  std::vector<GRegion *>::const_iterator git = regions.begin();
+  while(git != regions.end()) {
     GRegion *gr = *git;
     ExtrudeParams *ep = gr->meshAttributes.extrude;
     if((ep && ep->mesh.ExtrudeMesh) ||
@@ -1201,7 +1202,9 @@ static int isCavityCompatibleWithEmbeddedFace(
 
 static void _deleteUnusedVertices(GRegion *gr)
 {
-  std::set<MVertex *> allverts;
+  // sort by number, so that the order of the vertices does not depend on their
+  // memory location
+  std::set<MVertex *, MVertexLessThanNum> allverts;
   for(std::size_t i = 0; i < gr->tetrahedra.size(); i++) {
     for(int j = 0; j < 4; j++) {
       if(gr->tetrahedra[i]->getVertex(j)->onWhat() == gr)
@@ -1219,8 +1222,28 @@ static void _deleteUnusedVertices(GRegion *gr)
 }
 
 void insertVerticesInRegion(GRegion *gr, int maxVert, bool _classify,
-                            splitQuadRecovery *sqr)
+                            splitQuadRecovery *sqr,
+                            const std::vector<GRegion *> *regions)
 {
+  // the tets can only be classified on the regions meshed together (all the
+  // regions of the model by default); nothing outside of these regions is
+  // accessed, so that independent sets of regions can be meshed concurrently
+  std::vector<GRegion *> allRegions;
+  std::set<GFace *, GEntityLessThan> faces;
+  if(!regions) {
+    allRegions.insert(allRegions.end(), gr->model()->firstRegion(),
+                      gr->model()->lastRegion());
+    regions = &allRegions;
+    faces.insert(gr->model()->firstFace(), gr->model()->lastFace());
+  }
+  else {
+    for(std::size_t i = 0; i < regions->size(); i++) {
+      std::vector<GFace *> const &f = (*regions)[i]->faces();
+      std::vector<GFace *> const &f_e = (*regions)[i]->embeddedFaces();
+      faces.insert(f.begin(), f.end());
+      faces.insert(f_e.begin(), f_e.end());
+    }
+  }
 
 #ifdef DEBUG_BOUNDARY_RECOVERY
   testIfBoundaryIsRecovered(gr);
@@ -1236,8 +1259,8 @@ void insertVerticesInRegion(GRegion *gr, int maxVert, bool _classify,
     std::map<MVertex *, double, MVertexLessThanNum> vSizesMap;
     std::set<MVertex *, MVertexLessThanNum> bndVertices;
 
-    for(GModel::riter rit = gr->model()->firstRegion();
-        rit != gr->model()->lastRegion(); ++rit) {
+    for(std::vector<GRegion *>::const_iterator rit = regions->begin();
+        rit != regions->end(); ++rit) {
       std::vector<GEdge *> const &e = (*rit)->embeddedEdges();
       for(std::vector<GEdge *>::const_iterator it = e.begin(); it != e.end();
           ++it) {
@@ -1261,8 +1284,8 @@ void insertVerticesInRegion(GRegion *gr, int maxVert, bool _classify,
       }
     }
 
-    for(GModel::riter rit = gr->model()->firstRegion();
-        rit != gr->model()->lastRegion(); ++rit) {
+    for(std::vector<GRegion *>::const_iterator rit = regions->begin();
+        rit != regions->end(); ++rit) {
       std::vector<GVertex *> const &vertices = (*rit)->embeddedVertices();
       for(std::vector<GVertex *>::const_iterator it = vertices.begin();
           it != vertices.end(); ++it) {
@@ -1274,8 +1297,8 @@ void insertVerticesInRegion(GRegion *gr, int maxVert, bool _classify,
       }
     }
 
-    for(GModel::fiter it = gr->model()->firstFace();
-        it != gr->model()->lastFace(); ++it) {
+    for(std::set<GFace *, GEntityLessThan>::iterator it = faces.begin();
+        it != faces.end(); ++it) {
       GFace *gf = *it;
       for(std::size_t i = 0; i < gf->triangles.size(); i++) {
         setLcs(gf->triangles[i], vSizesMap, bndVertices);
@@ -1307,7 +1330,7 @@ void insertVerticesInRegion(GRegion *gr, int maxVert, bool _classify,
 
   if(_classify) {
     fs_cont search;
-    buildFaceSearchStructure(gr->model(), search, true); // only triangles
+    buildFaceSearchStructure(*regions, search, true); // only triangles
     if(sqr) search.insert(sqr->getTri().begin(), sqr->getTri().end());
 
     for(MTet4Factory::iterator it = allTets.begin(); it != allTets.end();
@@ -1325,7 +1348,7 @@ void insertVerticesInRegion(GRegion *gr, int maxVert, bool _classify,
           "found %d tets with %d faces (%g sec for the classification)",
           theRegion.size(), faces_bound.size(), _t2 - _t1);
         GRegion *myGRegion =
-          getRegionFromBoundingFaces(gr->model(), faces_bound);
+          getRegionFromBoundingFaces(gr->model(), faces_bound, *regions);
         if(myGRegion) { // a geometrical region associated to the list of faces
                         // has been found
           Msg::Info("Found region %d", myGRegion->tag());
@@ -1372,8 +1395,8 @@ void insertVerticesInRegion(GRegion *gr, int maxVert, bool _classify,
   // store all embedded faces
   std::set<MFace, Less_Face> allEmbeddedFaces;
   edgeContainerB allEmbeddedEdges;
-  for(GModel::riter it = gr->model()->firstRegion();
-      it != gr->model()->lastRegion(); ++it) {
+  for(std::vector<GRegion *>::const_iterator it = regions->begin();
+      it != regions->end(); ++it) {
     createAllEmbeddedFaces((*it), allEmbeddedFaces);
     createAllEmbeddedEdges((*it), allEmbeddedEdges);
   }
@@ -1598,7 +1598,18 @@ void tetgenmesh::initializepools()
     printf("  tetrahedron per block: %d.\n", b->tetrahedraperblock);
   }
 
-  inittables();
+  // the look-up tables are shared by all the instances: only initialize them
+  // once, as several meshes can be built concurrently
+#if defined(_OPENMP)
+#pragma omp critical(tetgenBR_inittables)
+#endif
+  {
+    static bool tablesInitialized = false;
+    if(!tablesInitialized) {
+      inittables();
+      tablesInitialized = true;
+    }
+  }
 
   // There are three input point lists available, which are in, addin,
   //   and bgm->in. These point lists may have different number of
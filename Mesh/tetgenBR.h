@@ -1552,7 +1552,12 @@ public:
   }
 };
 
+// each thread reports its own self-intersection event
+#if __cplusplus >= 201103L
+static thread_local selfint_event sevent;
+#else
 static selfint_event sevent;
+#endif
 
 inline void terminatetetgen(tetgenmesh *m, int x)
 {
@@ -12,21 +12,92 @@
 #include "CondNumBasis.h"
 #include "JacobianBasis.h"
 #include <map>
+#include <vector>
 #include <cstddef>
+#if __cplusplus >= 201103L
+#include <atomic>
+#endif
+
+namespace {
+  // A read-mostly cache of bases: readers look up the current version of the
+  // map without taking any lock, while a writer copies the map, inserts the
+  // new basis in the copy and publishes it. Previous versions of the map are
+  // kept until clear(), as other threads might still be reading them (only a
+  // few dozen bases are ever created, so this is cheap).
+  template <class K, class B> class basisCache {
+  private:
+    typedef std::map<K, B *> mapType;
+#if __cplusplus >= 201103L
+    std::atomic<mapType *> _map;
+#else
+    mapType *_map;
+#endif
+    std::vector<mapType *> _old;
+
+  public:
+    basisCache() : _map(new mapType()) {}
+    B *find(const K &key)
+    {
+      B *b = NULL;
+#if __cplusplus < 201103L && defined(_OPENMP)
+#pragma omp critical(BasisFactory)
+#endif
+      {
+        const mapType *m = _map;
+        typename mapType::const_iterator it = m->find(key);
+        if(it != m->end()) b = it->second;
+      }
+      return b;
+    }
+    // Insert a basis created by the caller: bases must be constructed outside
+    // of the critical section, as their constructors call the factory. If
+    // another thread has inserted a basis with the same key in the meantime,
+    // b is deleted and the existing basis is returned.
+    B *insert(const K &key, B *b)
+    {
+      B *ret = b;
+#if defined(_OPENMP)
+#pragma omp critical(BasisFactory)
+#endif
+      {
+        mapType *m = _map;
+        typename mapType::const_iterator it = m->find(key);
+        if(it != m->end())
+          ret = it->second;
+        else {
+          mapType *copy = new mapType(*m);
+          (*copy)[key] = b;
+          _old.push_back(m);
+          _map = copy;
+        }
+      }
+      if(ret != b) delete b;
+      return ret;
+    }
+    void clear()
+    {
+      mapType *m = _map;
+      for(typename mapType::iterator it = m->begin(); it != m->end(); it++)
+        delete it->second;
+      delete m;
+      for(std::size_t i = 0; i < _old.size(); i++) delete _old[i];
+      _old.clear();
+      _map = new mapType();
+    }
+  };
 
-std::map<int, nodalBasis *> BasisFactory::fs;
-std::map<int, CondNumBasis *> BasisFactory::cs;
-std::map<FuncSpaceData, JacobianBasis *> BasisFactory::js;
-std::map<FuncSpaceData, bezierBasis *> BasisFactory::bs;
-std::map<FuncSpaceData, GradientBasis *> BasisFactory::gs;
+  basisCache<int, nodalBasis> fs;
+  basisCache<int, CondNumBasis> cs;
+  basisCache<FuncSpaceData, JacobianBasis> js;
+  basisCache<FuncSpaceData, bezierBasis> bs;
+  basisCache<FuncSpaceData, GradientBasis> gs;
+} // namespace
 
 const nodalBasis *BasisFactory::getNodalBasis(int tag)
 {
   // If the Basis has already been built, return it.
-  std::map<int, nodalBasis *>::const_iterator it = fs.find(tag);
-  if(it != fs.end()) {
-    return it->second;
-  }
+  nodalBasis *basis = fs.find(tag);
+  if(basis) return basis;
   // Get the parent type to see which kind of basis
   // we want to create
   nodalBasis *F = NULL;
@@ -51,30 +122,17 @@ const nodalBasis *BasisFactory::getNodalBasis(int tag)
     }
   }
 
-  std::pair<std::map<int, nodalBasis *>::const_iterator, bool> inserted;
-
-#if defined(_OPENMP)
-#pragma omp critical
-#endif
-  {
-    inserted = fs.insert(std::make_pair(tag, F));
-
-    if(!inserted.second) delete F;
-  }
-
-  return inserted.first->second;
+  return fs.insert(tag, F);
 }
 
 const JacobianBasis *BasisFactory::getJacobianBasis(FuncSpaceData fsd)
 {
   FuncSpaceData data = fsd.getForNonSerendipitySpace();
 
-  std::map<FuncSpaceData, JacobianBasis *>::const_iterator it = js.find(data);
-  if(it != js.end()) return it->second;
+  JacobianBasis *J = js.find(data);
+  if(J) return J;
 
-  JacobianBasis *J = new JacobianBasis(data);
-  js.insert(std::make_pair(data, J));
-  return J;
+  return js.insert(data, new JacobianBasis(data));
 }
 
 const JacobianBasis *BasisFactory::getJacobianBasis(int tag, int order)
@@ -99,22 +157,18 @@ const JacobianBasis *BasisFactory::getJacobianBasis(int tag)
 
 const CondNumBasis *BasisFactory::getCondNumBasis(int tag, int cnOrder)
 {
-  std::map<int, CondNumBasis *>::const_iterator it = cs.find(tag);
-  if(it != cs.end()) return it->second;
+  CondNumBasis *M = cs.find(tag);
+  if(M) return M;
 
-  CondNumBasis *M = new CondNumBasis(tag, cnOrder);
-  cs.insert(std::make_pair(tag, M));
-  return M;
+  return cs.insert(tag, new CondNumBasis(tag, cnOrder));
 }
 
 const GradientBasis *BasisFactory::getGradientBasis(FuncSpaceData data)
 {
-  std::map<FuncSpaceData, GradientBasis *>::const_iterator it = gs.find(data);
-  if(it != gs.end()) return it->second;
+  GradientBasis *G = gs.find(data);
+  if(G) return G;
 
-  GradientBasis *G = new GradientBasis(data);
-  gs.insert(std::make_pair(data, G));
-  return G;
+  return gs.insert(data, new GradientBasis(data));
 }
 
 const GradientBasis *BasisFactory::getGradientBasis(int tag, int order)
@@ -131,12 +185,10 @@ const bezierBasis *BasisFactory::getBezierBasis(FuncSpaceData fsd)
 {
   FuncSpaceData data = fsd.getForPrimaryElement();
 
-  std::map<FuncSpaceData, bezierBasis *>::const_iterator it = bs.find(data);
-  if(it != bs.end()) return it->second;
+  bezierBasis *B = bs.find(data);
+  if(B) return B;
 
-  bezierBasis *B = new bezierBasis(data);
-  bs.insert(std::make_pair(data, B));
-  return B;
+  return bs.insert(data, new bezierBasis(data));
 }
 
 const bezierBasis *BasisFactory::getBezierBasis(int parentTag, int order)
@@ -150,33 +202,23 @@ const bezierBasis *BasisFactory::getBezierBasis(int tag)
   return getBezierBasis(FuncSpaceData(tag));
 }
 
-void BasisFactory::clearAll()
+void BasisFactory::preload(const std::vector<int> &tags)
 {
-  std::map<int, nodalBasis *>::iterator itF = fs.begin();
-  while(itF != fs.end()) {
-    delete itF->second;
-    itF++;
+  for(std::size_t i = 0; i < tags.size(); i++) {
+    if(!getNodalBasis(tags[i])) continue;
+    if(tags[i] == MSH_TRI_MINI || tags[i] == MSH_TET_MINI) continue;
+    if(ElementType::getDimension(tags[i]) < 1) continue;
+    getJacobianBasis(tags[i]);
+    getGradientBasis(tags[i]);
+    getBezierBasis(tags[i]);
   }
-  fs.clear();
+}
 
-  std::map<FuncSpaceData, JacobianBasis *>::iterator itJ = js.begin();
-  while(itJ != js.end()) {
-    delete itJ->second;
-    itJ++;
-  }
+void BasisFactory::clearAll()
+{
+  fs.clear();
+  cs.clear();
   js.clear();
-
-  std::map<FuncSpaceData, GradientBasis *>::iterator itG = gs.begin();
-  while(itG != gs.end()) {
-    delete itG->second;
-    itG++;
-  }
   gs.clear();
-
-  std::map<FuncSpaceData, bezierBasis *>::iterator itB = bs.begin();
-  while(itB != bs.end()) {
-    delete itB->second;
-    itB++;
-  }
   bs.clear();
 }
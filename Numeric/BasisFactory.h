@@ -6,7 +6,7 @@
 #ifndef BASISFACTORY_H
 #define BASISFACTORY_H
 
-#include <map>
+#include <vector>
 class nodalBasis;
 class GradientBasis;
 class bezierBasis;
@@ -14,14 +14,12 @@ class CondNumBasis;
 class JacobianBasis;
 class FuncSpaceData;
 
+// The bases are created on demand and cached for the lifetime of the program
+// (or until clearAll() is called). All the get functions can be called
+// concurrently from several threads: lookups of existing bases do not take any
+// lock, and a basis requested simultaneously by several threads is only kept
+// once.
 class BasisFactory {
-private:
-  static std::map<int, nodalBasis *> fs;
-  static std::map<int, CondNumBasis *> cs;
-  static std::map<FuncSpaceData, JacobianBasis *> js;
-  static std::map<FuncSpaceData, bezierBasis *> bs;
-  static std::map<FuncSpaceData, GradientBasis *> gs;
-
 public:
   // Caution: the returned pointer can be NULL
 
@@ -48,6 +46,11 @@ public:
   static const bezierBasis *getBezierBasis(int parentTag, int order);
   static const bezierBasis *getBezierBasis(int tag);
 
+  // Create the nodal, Jacobian, gradient and Bezier bases of the given element
+  // types (in MSH numbering), e.g. before a parallel loop over elements
+  static void preload(const std::vector<int> &tags);
+
+  // Not thread-safe: no other thread should use the factory at the same time
   static void clearAll();
 };
 
@@ -3,8 +3,10 @@
 // See the LICENSE.txt file for license information. Please report all
 // issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
 
+#include <algorithm>
 #include "SBoundingBox3d.h"
 #include "MVertex.h"
+#include "HilbertCurve.h"
 
 struct HilbertSort {
   // The code for generating table transgc
@@ -281,3 +283,49 @@ void SortHilbert(std::vector<MVertex *> &v)
   // HilbertSort h;
   h.Apply(v);
 }
+
+// Hilbert index computed by transposing the coordinates (J. Skilling,
+// "Programming the Hilbert curve", AIP Conference Proceedings 707, 2004)
+
+uint64_t HilbertIndex(const SPoint3 &p, const SBoundingBox3d &bbox)
+{
+  const int bits = 21;
+  const uint32_t maxCoord = (1u << bits) - 1;
+  uint32_t X[3];
+  for(int i = 0; i < 3; i++) {
+    double lo = bbox.min()[i], hi = bbox.max()[i];
+    double t = (hi > lo) ? (p[i] - lo) / (hi - lo) : 0.;
+    t = std::min(1., std::max(0., t));
+    X[i] = (uint32_t)(t * maxCoord);
+  }
+
+  // inverse undo
+  const uint32_t M = 1u << (bits - 1);
+  uint32_t P, Q, t;
+  for(Q = M; Q > 1; Q >>= 1) {
+    P = Q - 1;
+    for(int i = 0; i < 3; i++) {
+      if(X[i] & Q) { X[0] ^= P; }
+      else {
+        t = (X[0] ^ X[i]) & P;
+        X[0] ^= t;
+        X[i] ^= t;
+      }
+    }
+  }
+
+  // Gray encode
+  for(int i = 1; i < 3; i++) X[i] ^= X[i - 1];
+  t = 0;
+  for(Q = M; Q > 1; Q >>= 1) {
+    if(X[2] & Q) t ^= Q - 1;
+  }
+  for(int i = 0; i < 3; i++) X[i] ^= t;
+
+  // interleave the bits of the transposed coordinates
+  uint64_t h = 0;
+  for(int b = bits - 1; b >= 0; b--) {
+    for(int i = 0; i < 3; i++) h = (h << 1) | ((X[i] >> b) & 1);
+  }
+  return h;
+}
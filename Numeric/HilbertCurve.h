@@ -6,6 +6,18 @@
 #ifndef _HILBERT_CURVE_
 #define _HILBERT_CURVE_
 
+#include <vector>
+#include <stdint.h>
+
+class MVertex;
+class SPoint3;
+class SBoundingBox3d;
+
 void SortHilbert(std::vector<MVertex *> &);
 
+// index of the point p along a 3D Hilbert curve covering the bounding box bbox
+// (with 21 bits per coordinate): sorting points by increasing index orders them
+// along the curve
+uint64_t HilbertIndex(const SPoint3 &p, const SBoundingBox3d &bbox);
+
 #endif
@@ -703,10 +703,23 @@ void bezierBasis::_constructPyr()
 
 bezierBasisRaiser *bezierBasis::getRaiser() const
 {
-  if(!_raiser) {
-    const_cast<bezierBasis *>(this)->_raiser = new bezierBasisRaiser(this);
+  bezierBasisRaiser *raiser = NULL;
+#if __cplusplus >= 201103L
+  raiser = _raiser;
+  if(raiser) return raiser;
+#endif
+  // the raiser is expensive for high orders, so it is only built if needed
+#if defined(_OPENMP)
+#pragma omp critical(bezierBasisRaiser)
+#endif
+  {
+    raiser = _raiser;
+    if(!raiser) {
+      raiser = new bezierBasisRaiser(this);
+      _raiser = raiser;
+    }
   }
-  return _raiser;
+  return raiser;
 }
 
 // const bezierBasis* bezierBasisRaiser::getRaisedBezierBasis(int raised) const
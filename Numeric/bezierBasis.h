@@ -9,6 +9,9 @@
 #include <vector>
 #include "fullMatrix.h"
 #include "FuncSpaceData.h"
+#if __cplusplus >= 201103L
+#include <atomic>
+#endif
 
 class MElement;
 class bezierBasisRaiser;
@@ -19,7 +22,12 @@ private:
   int _numLagCoeff;
   int _numDivisions, _dimSimplex;
   const FuncSpaceData _data;
-  bezierBasisRaiser *_raiser;
+  // created on first use by getRaiser(), which can be called concurrently
+#if __cplusplus >= 201103L
+  mutable std::atomic<bezierBasisRaiser *> _raiser;
+#else
+  mutable bezierBasisRaiser *_raiser;
+#endif
 
   friend class bezierBasisRaiser;
   fullMatrix<double> _exponents;
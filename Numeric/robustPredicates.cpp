@@ -755,6 +755,20 @@ REAL exactinit(int filter, REAL maxx, REAL maxy, REAL maxz)
   return epsilon; /* Added by H. Si 30 Juli, 2004. */
 }
 
+// Check whether the static filters are enabled and valid for coordinates
+// bounded by maxx, maxy and maxz, i.e. whether exactinit() has already been
+// called with a larger box. Only reads the filters, so it can be used
+// concurrently as long as nobody calls exactinit() at the same time.
+int exactinitcovers(REAL maxx, REAL maxy, REAL maxz)
+{
+  if (!_use_static_filter) return 0;
+  REAL m = maxx;
+  if (maxy > m) m = maxy;
+  if (maxz > m) m = maxz;
+  return (5.1107127829973299e-15 * maxx * maxy * maxz <= o3dstaticfilter) &&
+    (1.2466136531027298e-13 * maxx * maxy * maxz * (m * m) <= ispstaticfilter);
+}
+
 /*****************************************************************************/
 /*                                                                           */
 /*  grow_expansion()   Add a scalar to an expansion.                         */
@@ -9,6 +9,7 @@
 // namespace necessary to avoid conflicts with predicates used by Tetgen
 namespace robustPredicates{
   double exactinit(int filter, double maxx, double maxy, double maxz);
+  int exactinitcovers(double maxx, double maxy, double maxz);
   double incircle(double *pa, double *pb, double *pc, double *pd);
   double insphere(double *pa, double *pb, double *pc, double *pd, double *pe);
   double orient2d(double *pa, double *pb, double *pc);
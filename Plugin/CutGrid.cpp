@@ -304,6 +304,14 @@ void GMSH_CutGridPlugin::addInView(int numsteps, int connect, int nbcomp,
   }
 }
 
+static void copyValues(const std::vector<double> &values, int nbU, int nbV,
+                       int n, double ***vals)
+{
+  for(int i = 0; i < nbU; i++)
+    for(int j = 0; j < nbV; j++)
+      for(int k = 0; k < n; k++) vals[i][j][k] = values[(i * nbV + j) * n + k];
+}
+
 PView *GMSH_CutGridPlugin::GenerateView(PView *v1, int connect)
 {
   if(getNbU() <= 0 || getNbV() <= 0) return v1;
@@ -333,26 +341,30 @@ PView *GMSH_CutGridPlugin::GenerateView(PView *v1, int connect)
     }
   }
 
+  // search for the values at all the grid points at once
+  std::vector<double> xyz, values;
+  xyz.reserve(3 * getNbU() * getNbV());
+  for(int i = 0; i < getNbU(); i++)
+    for(int j = 0; j < getNbV(); j++)
+      for(int k = 0; k < 3; k++) xyz.push_back(pnts[i][j][k]);
+
   if(nbs) {
-    for(int i = 0; i < getNbU(); i++)
-      for(int j = 0; j < getNbV(); j++)
-        o.searchScalar(pnts[i][j][0], pnts[i][j][1], pnts[i][j][2], vals[i][j]);
+    o.searchScalar(xyz, values);
+    copyValues(values, getNbU(), getNbV(), 1 * numsteps, vals);
     addInView(numsteps, connect, 1, pnts, vals, data2->SP, &data2->NbSP,
               data2->SL, &data2->NbSL, data2->SQ, &data2->NbSQ);
   }
 
   if(nbv) {
-    for(int i = 0; i < getNbU(); i++)
-      for(int j = 0; j < getNbV(); j++)
-        o.searchVector(pnts[i][j][0], pnts[i][j][1], pnts[i][j][2], vals[i][j]);
+    o.searchVector(xyz, values);
+    copyValues(values, getNbU(), getNbV(), 3 * numsteps, vals);
     addInView(numsteps, connect, 3, pnts, vals, data2->VP, &data2->NbVP,
               data2->VL, &data2->NbVL, data2->VQ, &data2->NbVQ);
   }
 
   if(nbt) {
-    for(int i = 0; i < getNbU(); i++)
-      for(int j = 0; j < getNbV(); j++)
-        o.searchTensor(pnts[i][j][0], pnts[i][j][1], pnts[i][j][2], vals[i][j]);
+    o.searchTensor(xyz, values);
+    copyValues(values, getNbU(), getNbV(), 9 * numsteps, vals);
     addInView(numsteps, connect, 9, pnts, vals, data2->TP, &data2->NbTP,
               data2->TL, &data2->NbTL, data2->TQ, &data2->NbTQ);
   }
@@ -216,13 +216,16 @@ PView *GMSH_DistancePlugin::execute(PView *v)
 #if defined(HAVE_SOLVER)
 #if defined(HAVE_PETSC)
   linearSystemPETSc<double> *lsys = new linearSystemPETSc<double>;
-#elif defined(HAVE_GMM)
+#elif defined(HAVE_GMM) && !defined(_OPENMP)
   linearSystemCSRGmm<double> *lsys = new linearSystemCSRGmm<double>;
   lsys->setNoisy(1);
   lsys->setGmres(1);
   lsys->setPrec(5.e-8);
 #else
-  linearSystemFull<double> *lsys = new linearSystemFull<double>;
+  linearSystemCSRKrylov<double> *lsys = new linearSystemCSRKrylov<double>;
+  lsys->setNoisy(1);
+  lsys->setMethod(linearSystemCSRKrylov<double>::GMRES);
+  lsys->setPrec(5.e-8);
 #endif
   dofManager<double> *dofView = new dofManager<double>(lsys);
 #endif
@@ -443,13 +446,16 @@ PView *GMSH_DistancePlugin::execute(PView *v)
 
 #if defined(HAVE_PETSC)
     linearSystemPETSc<double> *lsys2 = new linearSystemPETSc<double>;
-#elif defined(HAVE_GMM)
+#elif defined(HAVE_GMM) && !defined(_OPENMP)
     linearSystemCSRGmm<double> *lsys2 = new linearSystemCSRGmm<double>;
     lsys->setNoisy(1);
     lsys->setGmres(1);
     lsys->setPrec(5.e-8);
 #else
-    linearSystemFull<double> *lsys2 = new linearSystemFull<double>;
+    linearSystemCSRKrylov<double> *lsys2 = new linearSystemCSRKrylov<double>;
+    lsys2->setNoisy(1);
+    lsys2->setMethod(linearSystemCSRKrylov<double>::GMRES);
+    lsys2->setPrec(5.e-8);
 #endif
     dofManager<double> myAssembler(lsys2);
     simpleFunction<double> ONE(1.0);
@@ -4,6 +4,7 @@
 // issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
 
 #include <cmath>
+#include <algorithm>
 #include "GmshConfig.h"
 #include "StreamLines.h"
 #include "OctreePost.h"
@@ -30,7 +31,8 @@ StringXNumber StreamLinesOptions_Number[] = {
   {GMSH_FULLRC, "MaxIter", NULL, 100},
   {GMSH_FULLRC, "TimeStep", NULL, 0},
   {GMSH_FULLRC, "View", NULL, -1.},
-  {GMSH_FULLRC, "OtherView", NULL, -1.}};
+  {GMSH_FULLRC, "OtherView", NULL, -1.},
+  {GMSH_FULLRC, "Tolerance", NULL, 0.}};
 
 extern "C" {
 GMSH_Plugin *GMSH_RegisterStreamLinesPlugin()
@@ -163,6 +165,14 @@ std::string GMSH_StreamLinesPlugin::getHelp() const
          "on the vector view.\n\n"
          "The time stepping scheme is a RK44 with step size "
          "`DT' and `MaxIter' maximum number of iterations.\n\n"
+         "If `Tolerance' > 0 and `TimeStep' >= 0, an adaptive "
+         "RK45 (Dormand-Prince) scheme is used instead, starting "
+         "with step size |`DT'| and adapting it so that the "
+         "estimated local error stays below `Tolerance', while "
+         "keeping the sign of `DT' (negative `DT' gives backward "
+         "stream lines with both schemes). The "
+         "step is also limited so that a point does not cross "
+         "more than one element per iteration.\n\n"
          "If `TimeStep' < 0, the plugin tries to compute "
          "streamlines of the unsteady flow.\n\n"
          "If `View' < 0, the plugin is run on the current view.\n\n"
@@ -209,6 +219,157 @@ void GMSH_StreamLinesPlugin::getPoint(int iU, int iV, double *X)
     v * (StreamLinesOptions_Number[8].def - StreamLinesOptions_Number[2].def);
 }
 
+// velocity at point X, starting the search in element e
+static void getVelocity(OctreePost &o, const double X[3], int step, void **e,
+                        double V[3], double *size = 0)
+{
+  o.searchVectorFromElement(X[0], X[1], X[2], V, step, size, e);
+}
+
+// classical fixed-step RK4 scheme
+static void stepRK4(OctreePost &o, int step, void **e, double DT, double X[3])
+{
+  // dX/dt = V
+  // X1 = X + a1 * DT * V(X)
+  // X2 = X + a2 * DT * V(X1)
+  // X3 = X + a3 * DT * V(X2)
+  // X4 = X + a4 * DT * V(X3)
+  // X = X + b1 X1 + b2 X2 + b3 X3 + b4 x4
+  const double b1 = 1. / 3., b2 = 2. / 3., b3 = 1. / 3., b4 = 1. / 6.;
+  const double a1 = 0.5, a2 = 0.5, a3 = 1., a4 = 1.;
+  double X1[3], X2[3], X3[3], X4[3], val[3];
+  getVelocity(o, X, step, e, val);
+  for(int k = 0; k < 3; k++) X1[k] = X[k] + DT * val[k] * a1;
+  getVelocity(o, X1, step, e, val);
+  for(int k = 0; k < 3; k++) X2[k] = X[k] + DT * val[k] * a2;
+  getVelocity(o, X2, step, e, val);
+  for(int k = 0; k < 3; k++) X3[k] = X[k] + DT * val[k] * a3;
+  getVelocity(o, X3, step, e, val);
+  for(int k = 0; k < 3; k++) X4[k] = X[k] + DT * val[k] * a4;
+  for(int k = 0; k < 3; k++)
+    X[k] += (b1 * (X1[k] - X[k]) + b2 * (X2[k] - X[k]) + b3 * (X3[k] - X[k]) +
+             b4 * (X4[k] - X[k]));
+}
+
+// adaptive Dormand-Prince RK5(4) scheme: advance X by one accepted step, with
+// an estimated local error smaller than tol, and update the step size h. The
+// step sizes h and hmin are positive, the step being taken in the direction
+// dir (1 for forward, -1 for backward stream lines)
+static void stepRK45(OctreePost &o, int step, void **e, double tol,
+                     double hmin, double dir, double &h, double X[3])
+{
+  static const double c[7][6] = {
+    {0., 0., 0., 0., 0., 0.},
+    {1. / 5., 0., 0., 0., 0., 0.},
+    {3. / 40., 9. / 40., 0., 0., 0., 0.},
+    {44. / 45., -56. / 15., 32. / 9., 0., 0., 0.},
+    {19372. / 6561., -25360. / 2187., 64448. / 6561., -212. / 729., 0., 0.},
+    {9017. / 3168., -355. / 33., 46732. / 5247., 49. / 176.,
+     -5103. / 18656., 0.},
+    {35. / 384., 0., 500. / 1113., 125. / 192., -2187. / 6784., 11. / 84.}};
+  // difference between the 5th and the 4th order weights
+  static const double err[7] = {71. / 57600.,       0.,
+                                -71. / 16695.,      71. / 1920.,
+                                -17253. / 339200., 22. / 525.,
+                                -1. / 40.};
+  double k[7][3], size = 0.;
+  getVelocity(o, X, step, e, k[0], &size);
+  // do not cross more than one element per step, so that the variations of
+  // the field are not missed
+  double norm = sqrt(k[0][0] * k[0][0] + k[0][1] * k[0][1] +
+                     k[0][2] * k[0][2]);
+  if(norm > 0. && size > 0.) h = std::max(hmin, std::min(h, size / norm));
+  while(true) {
+    double Y[3];
+    for(int s = 1; s < 7; s++) {
+      for(int j = 0; j < 3; j++) {
+        Y[j] = X[j];
+        for(int l = 0; l < s; l++) Y[j] += dir * h * c[s][l] * k[l][j];
+      }
+      getVelocity(o, Y, step, e, k[s]);
+    }
+    // Y is now the 5th order solution
+    double E = 0.;
+    for(int j = 0; j < 3; j++) {
+      double ej = 0.;
+      for(int s = 0; s < 7; s++) ej += err[s] * k[s][j];
+      E += (h * ej) * (h * ej);
+    }
+    E = sqrt(E);
+    double factor = (E > 0.) ? 0.9 * pow(tol / E, 0.2) : 5.;
+    factor = std::min(5., std::max(0.2, factor));
+    if(E <= tol || h <= hmin) {
+      for(int j = 0; j < 3; j++) X[j] = Y[j];
+      h *= factor;
+      return;
+    }
+    h = std::max(hmin, h * factor);
+  }
+}
+
+// compute the stream line starting at XINIT. Without other view, out
+// contains XINIT followed by the displacement after each iteration; with
+// another view, out contains the line segments followed by the values of the
+// other view at their nodes
+static void computeStreamLine(OctreePost &o1, PViewData *data1,
+                              OctreePost *o2, int numSteps2,
+                              const double XINIT[3], double DT, int maxIter,
+                              int timeStep, double tol,
+                              std::vector<double> &out)
+{
+  double X[3] = {XINIT[0], XINIT[1], XINIT[2]};
+  void *e1 = 0, *e2 = 0;
+  std::vector<double> val2(numSteps2 ? numSteps2 : 1);
+
+  if(o2)
+    o2->searchScalarFromElement(X[0], X[1], X[2], &val2[0], -1, 0, &e2);
+  else {
+    out.push_back(X[0]);
+    out.push_back(X[1]);
+    out.push_back(X[2]);
+  }
+
+  int currentTimeStep = (timeStep < 0) ? 0 : timeStep;
+  double h = std::fabs(DT), hmin = 1.e-6 * h, dir = (DT < 0.) ? -1. : 1.;
+
+  for(int iter = 0; iter < maxIter; iter++) {
+    double XPREV[3] = {X[0], X[1], X[2]};
+
+    if(timeStep < 0) {
+      double T0 = data1->getTime(0);
+      double currentT = T0 + DT * iter;
+      int previousTimeStep = currentTimeStep;
+      for(; currentTimeStep < data1->getNumTimeSteps() - 1 &&
+            currentT > 0.5 * (data1->getTime(currentTimeStep) +
+                              data1->getTime(currentTimeStep + 1));
+          currentTimeStep++)
+        ;
+      // the time steps can be defined on different meshes
+      if(currentTimeStep != previousTimeStep) e1 = 0;
+    }
+
+    if(tol > 0. && timeStep >= 0)
+      stepRK45(o1, currentTimeStep, &e1, tol, hmin, dir, h, X);
+    else
+      stepRK4(o1, currentTimeStep, &e1, DT, X);
+
+    if(o2) {
+      out.push_back(XPREV[0]);
+      out.push_back(X[0]);
+      out.push_back(XPREV[1]);
+      out.push_back(X[1]);
+      out.push_back(XPREV[2]);
+      out.push_back(X[2]);
+      for(int k = 0; k < numSteps2; k++) out.push_back(val2[k]);
+      o2->searchScalarFromElement(X[0], X[1], X[2], &val2[0], -1, 0, &e2);
+      for(int k = 0; k < numSteps2; k++) out.push_back(val2[k]);
+    }
+    else {
+      for(int k = 0; k < 3; k++) out.push_back(X[k] - XINIT[k]);
+    }
+  }
+}
+
 PView *GMSH_StreamLinesPlugin::execute(PView *v)
 {
   double DT = StreamLinesOptions_Number[11].def;
@@ -216,6 +377,7 @@ PView *GMSH_StreamLinesPlugin::execute(PView *v)
   int timeStep = (int)StreamLinesOptions_Number[13].def;
   int iView = (int)StreamLinesOptions_Number[14].def;
   int otherView = (int)StreamLinesOptions_Number[15].def;
+  double tol = StreamLinesOptions_Number[16].def;
 
   PView *v1 = getView(iView, v);
   if(!v1) return v;
@@ -231,105 +393,61 @@ PView *GMSH_StreamLinesPlugin::execute(PView *v)
   }
 
   OctreePost o1(v1);
-  double *val2 = 0;
   OctreePost *o2 = 0;
+  int numSteps2 = 0;
   if(data2) {
-    val2 = new double[data2->getNumTimeSteps()];
+    numSteps2 = data2->getNumTimeSteps();
     o2 = new OctreePost(v2);
   }
 
-  PView *v3 = new PView();
-  PViewDataList *data3 = getDataList(v3);
-
-  const double b1 = 1. / 3., b2 = 2. / 3., b3 = 1. / 3., b4 = 1. / 6.;
-  const double a1 = 0.5, a2 = 0.5, a3 = 1., a4 = 1.;
-  double XINIT[3], X[3], DX[3], X1[3], X2[3], X3[3], X4[3];
+  const int nbU = getNbU(), nbV = getNbV(), n = nbU * nbV;
+  std::vector<double> seeds(3 * n);
+  for(int i = 0; i < nbU; ++i)
+    for(int j = 0; j < nbV; ++j) getPoint(i, j, &seeds[3 * (i * nbV + j)]);
+
+  if(n) {
+    // search once in each time step beforehand: this creates the element
+    // locators of the underlying meshes, which are then only read concurrently
+    std::vector<double> val(3), val2(numSteps2 ? numSteps2 : 1);
+    for(int step = 0; step < data1->getNumTimeSteps(); step++) {
+      if(timeStep < 0 || step == timeStep)
+        o1.searchVector(seeds[0], seeds[1], seeds[2], &val[0], step);
+    }
+    if(o2) o2->searchScalar(seeds[0], seeds[1], seeds[2], &val2[0], -1);
+  }
 
-  for(int i = 0; i < getNbU(); ++i) {
-    for(int j = 0; j < getNbV(); ++j) {
-      getPoint(i, j, XINIT);
-      getPoint(i, j, X);
+  // the stream lines are independent: compute them concurrently, then gather
+  // them in the order of the seeds
+  std::vector<std::vector<double> > lines(n);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(int i = 0; i < n; i++)
+    computeStreamLine(o1, data1, o2, numSteps2, &seeds[3 * i], DT, maxIter,
+                      timeStep, tol, lines[i]);
 
-      if(data2) {
-        o2->searchScalar(X[0], X[1], X[2], val2, -1);
-      }
-      else {
-        data3->NbVP++;
-        data3->VP.push_back(X[0]);
-        data3->VP.push_back(X[1]);
-        data3->VP.push_back(X[2]);
-      }
+  PView *v3 = new PView();
+  PViewDataList *data3 = getDataList(v3);
 
-      int currentTimeStep = 0;
-
-      for(int iter = 0; iter < maxIter; iter++) {
-        double XPREV[3] = {X[0], X[1], X[2]};
-
-        if(timeStep < 0) {
-          double T0 = data1->getTime(0);
-          double currentT = T0 + DT * iter;
-          data3->Time.push_back(currentT);
-          for(; currentTimeStep < data1->getNumTimeSteps() - 1 &&
-                currentT > 0.5 * (data1->getTime(currentTimeStep) +
-                                  data1->getTime(currentTimeStep + 1));
-              currentTimeStep++)
-            ;
-        }
-        else {
-          currentTimeStep = timeStep;
-        }
-
-        // dX/dt = V
-        // X1 = X + a1 * DT * V(X)
-        // X2 = X + a2 * DT * V(X1)
-        // X3 = X + a3 * DT * V(X2)
-        // X4 = X + a4 * DT * V(X3)
-        // X = X + b1 X1 + b2 X2 + b3 X3 + b4 x4
-        double val[3];
-        o1.searchVector(X[0], X[1], X[2], val, currentTimeStep);
-        for(int k = 0; k < 3; k++) X1[k] = X[k] + DT * val[k] * a1;
-        o1.searchVector(X1[0], X1[1], X1[2], val, currentTimeStep);
-        for(int k = 0; k < 3; k++) X2[k] = X[k] + DT * val[k] * a2;
-        o1.searchVector(X2[0], X2[1], X2[2], val, currentTimeStep);
-        for(int k = 0; k < 3; k++) X3[k] = X[k] + DT * val[k] * a3;
-        o1.searchVector(X3[0], X3[1], X3[2], val, currentTimeStep);
-        for(int k = 0; k < 3; k++) X4[k] = X[k] + DT * val[k] * a4;
-
-        for(int k = 0; k < 3; k++)
-          X[k] += (b1 * (X1[k] - X[k]) + b2 * (X2[k] - X[k]) +
-                   b3 * (X3[k] - X[k]) + b4 * (X4[k] - X[k]));
-        for(int k = 0; k < 3; k++) DX[k] = X[k] - XINIT[k];
-
-        if(data2) {
-          data3->NbSL++;
-          data3->SL.push_back(XPREV[0]);
-          data3->SL.push_back(X[0]);
-          data3->SL.push_back(XPREV[1]);
-          data3->SL.push_back(X[1]);
-          data3->SL.push_back(XPREV[2]);
-          data3->SL.push_back(X[2]);
-          for(int k = 0; k < data2->getNumTimeSteps(); k++)
-            data3->SL.push_back(val2[k]);
-          o2->searchScalar(X[0], X[1], X[2], val2, -1);
-          for(int k = 0; k < data2->getNumTimeSteps(); k++)
-            data3->SL.push_back(val2[k]);
-        }
-        else {
-          data3->VP.push_back(DX[0]);
-          data3->VP.push_back(DX[1]);
-          data3->VP.push_back(DX[2]);
-        }
-      }
+  for(int i = 0; i < n; i++) {
+    if(data2) {
+      data3->NbSL += maxIter;
+      data3->SL.insert(data3->SL.end(), lines[i].begin(), lines[i].end());
+    }
+    else {
+      data3->NbVP++;
+      data3->VP.insert(data3->VP.end(), lines[i].begin(), lines[i].end());
+    }
+    if(timeStep < 0) {
+      for(int iter = 0; iter < maxIter; iter++)
+        data3->Time.push_back(data1->getTime(0) + DT * iter);
     }
   }
 
-  if(data2) {
-    delete[] val2;
+  if(data2)
     delete o2;
-  }
-  else {
+  else
     v3->getOptions()->vectorType = PViewOptions::Displacement;
-  }
 
   data3->setName(data1->getName() + "_StreamLines");
   data3->setFileName(data1->getName() + "_StreamLines.pos");
@@ -3,7 +3,8 @@
 // See the LICENSE.txt file for license information. Please report all
 // issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
 
-#include "Octree.h"
+#include <algorithm>
+#include <set>
 #include "OctreePost.h"
 #include "PView.h"
 #include "PViewData.h"
@@ -14,8 +15,12 @@
 #include "shapeFunctions.h"
 #include "GModel.h"
 #include "MElement.h"
+#include "BasisFactory.h"
 #include "Context.h"
 
+void MElementBB(void *a, double *min, double *max);
+int MElementInEle(void *a, double *x);
+
 // helper routines for list-based views
 
 static void minmax(int n, double *X, double *Y, double *Z, double *min,
@@ -44,72 +49,6 @@ static void minmax(int n, double *X, double *Y, double *Z, double *min,
   }
 }
 
-static void centroid(int n, double *X, double *Y, double *Z, double *c)
-{
-  const double oc = 1. / (double)n;
-  c[0] = X[0];
-  c[1] = Y[0];
-  c[2] = Z[0];
-  for(int i = 1; i < n; i++) {
-    c[0] += X[i];
-    c[1] += Y[i];
-    c[2] += Z[i];
-  }
-  c[0] *= oc;
-  c[1] *= oc;
-  c[2] *= oc;
-}
-
-static void pntBB(void *a, double *min, double *max)
-{
-  double *X = (double *)a, *Y = &X[1], *Z = &X[2];
-  minmax(1, X, Y, Z, min, max);
-}
-
-static void linBB(void *a, double *min, double *max)
-{
-  double *X = (double *)a, *Y = &X[2], *Z = &X[4];
-  minmax(2, X, Y, Z, min, max);
-}
-
-static void triBB(void *a, double *min, double *max)
-{
-  double *X = (double *)a, *Y = &X[3], *Z = &X[6];
-  minmax(3, X, Y, Z, min, max);
-}
-
-static void quaBB(void *a, double *min, double *max)
-{
-  double *X = (double *)a, *Y = &X[4], *Z = &X[8];
-  minmax(4, X, Y, Z, min, max);
-}
-
-static void tetBB(void *a, double *min, double *max)
-{
-  double *X = (double *)a, *Y = &X[4], *Z = &X[8];
-  minmax(4, X, Y, Z, min, max);
-}
-
-static void hexBB(void *a, double *min, double *max)
-{
-  double *X = (double *)a, *Y = &X[8], *Z = &X[16];
-  minmax(8, X, Y, Z, min, max);
-}
-
-static void priBB(void *a, double *min, double *max)
-{
-  double *X = (double *)a, *Y = &X[6], *Z = &X[12];
-  minmax(6, X, Y, Z, min, max);
-}
-
-static void pyrBB(void *a, double *min, double *max)
-{
-  double *X = (double *)a, *Y = &X[5], *Z = &X[10];
-  minmax(5, X, Y, Z, min, max);
-}
-
-static int pntInEle(void *a, double *x) { return 1; }
-
 static int linInEle(void *a, double *x)
 {
   double *X = (double *)a, *Y = &X[2], *Z = &X[4], uvw[3];
@@ -166,88 +105,34 @@ static int pyrInEle(void *a, double *x)
   return pyr.isInside(uvw[0], uvw[1], uvw[2]);
 }
 
-static void pntCentroid(void *a, double *x)
-{
-  double *X = (double *)a, *Y = &X[1], *Z = &X[2];
-  centroid(1, X, Y, Z, x);
-}
-
-static void linCentroid(void *a, double *x)
-{
-  double *X = (double *)a, *Y = &X[2], *Z = &X[4];
-  centroid(2, X, Y, Z, x);
-}
-
-static void triCentroid(void *a, double *x)
-{
-  double *X = (double *)a, *Y = &X[3], *Z = &X[6];
-  centroid(3, X, Y, Z, x);
-}
-
-static void quaCentroid(void *a, double *x)
-{
-  double *X = (double *)a, *Y = &X[4], *Z = &X[8];
-  centroid(4, X, Y, Z, x);
-}
-
-static void tetCentroid(void *a, double *x)
-{
-  double *X = (double *)a, *Y = &X[4], *Z = &X[8];
-  centroid(4, X, Y, Z, x);
-}
-
-static void hexCentroid(void *a, double *x)
-{
-  double *X = (double *)a, *Y = &X[8], *Z = &X[16];
-  centroid(8, X, Y, Z, x);
-}
-
-static void priCentroid(void *a, double *x)
-{
-  double *X = (double *)a, *Y = &X[6], *Z = &X[12];
-  centroid(6, X, Y, Z, x);
-}
 
-static void pyrCentroid(void *a, double *x)
+static int listElementInEle(double *X, int nbNod, int dim, double *x)
 {
-  double *X = (double *)a, *Y = &X[5], *Z = &X[10];
-  centroid(5, X, Y, Z, x);
+  switch(dim) {
+  case 0: return 1;
+  case 1: return linInEle(X, x);
+  case 2: return (nbNod == 3) ? triInEle(X, x) : quaInEle(X, x);
+  case 3:
+    switch(nbNod) {
+    case 4: return tetInEle(X, x);
+    case 8: return hexInEle(X, x);
+    case 6: return priInEle(X, x);
+    case 5: return pyrInEle(X, x);
+    }
+  }
+  return 0;
 }
 
-static void addListOfStuff(Octree *o, std::vector<double> &l, int nbelm)
+static bool inBoundingBox(const double *min, const double *max,
+                          const double *P)
 {
-  for(std::size_t i = 0; i < l.size(); i += nbelm) Octree_Insert(&l[i], o);
+  return P[0] >= min[0] && P[0] <= max[0] && P[1] >= min[1] &&
+         P[1] <= max[1] && P[2] >= min[2] && P[2] <= max[2];
 }
 
 // OctreePost implementation
 
-OctreePost::~OctreePost()
-{
-  Octree_Delete(_SPP);
-  Octree_Delete(_VPP);
-  Octree_Delete(_TPP);
-  Octree_Delete(_SL);
-  Octree_Delete(_VL);
-  Octree_Delete(_TL);
-  Octree_Delete(_ST);
-  Octree_Delete(_VT);
-  Octree_Delete(_TT);
-  Octree_Delete(_SQ);
-  Octree_Delete(_VQ);
-  Octree_Delete(_TQ);
-  Octree_Delete(_SS);
-  Octree_Delete(_VS);
-  Octree_Delete(_TS);
-  Octree_Delete(_SH);
-  Octree_Delete(_VH);
-  Octree_Delete(_TH);
-  Octree_Delete(_SI);
-  Octree_Delete(_VI);
-  Octree_Delete(_TI);
-  Octree_Delete(_SY);
-  Octree_Delete(_VY);
-  Octree_Delete(_TY);
-}
+OctreePost::~OctreePost() {}
 
 OctreePost::OctreePost(PView *v)
 {
@@ -256,11 +141,21 @@ OctreePost::OctreePost(PView *v)
 
 OctreePost::OctreePost(PViewData *data) { _create(data); }
 
+void OctreePost::_addList(int kind, std::vector<double> &list, int nbNod,
+                          int dim, int nbComp)
+{
+  int nb = 3 * nbNod + nbComp * nbNod * _theViewDataList->getNumTimeSteps();
+  for(std::size_t i = 0; i + nb <= list.size(); i += nb) {
+    listElement e;
+    e.data = &list[i];
+    e.nbNod = nbNod;
+    e.dim = dim;
+    _listElements[kind].push_back(e);
+  }
+}
+
 void OctreePost::_create(PViewData *data)
 {
-  _SPP = _VPP = _TPP = _SL = _VL = _TL = _ST = _VT = _TT = 0;
-  _SQ = _VQ = _TQ = _SS = _VS = _TS = _SH = _VH = _TH = 0;
-  _SI = _VI = _TI = _SY = _VY = _TY = 0;
   _theViewDataList = 0;
   _theViewDataGModel = 0;
 
@@ -280,149 +175,128 @@ void OctreePost::_create(PViewData *data)
       return;
     }
 
-    SBoundingBox3d bb = l->getBoundingBox();
-    // make bounding box larger up to (absolute) geometrical tolerance
-    double eps = CTX::instance()->geom.tolerance;
-    SPoint3 bbmin = bb.min(), bbmax = bb.max(), bbeps(eps, eps, eps);
-    bbmin -= bbeps;
-    bbmax += bbeps;
-    double min[3] = {bbmin.x(), bbmin.y(), bbmin.z()};
-    double size[3] = {bbmax.x() - bbmin.x(), bbmax.y() - bbmin.y(),
-                      bbmax.z() - bbmin.z()};
-    const int maxElePerBucket = 100; // memory vs. speed trade-off
-
-    _SPP =
-      Octree_Create(maxElePerBucket, min, size, pntBB, pntCentroid, pntInEle);
-    addListOfStuff(_SPP, l->SP, 3 + 1 * l->getNumTimeSteps());
-    Octree_Arrange(_SPP);
-    _VPP =
-      Octree_Create(maxElePerBucket, min, size, pntBB, pntCentroid, pntInEle);
-    addListOfStuff(_VPP, l->VP, 3 + 3 * l->getNumTimeSteps());
-    Octree_Arrange(_VPP);
-    _TPP =
-      Octree_Create(maxElePerBucket, min, size, pntBB, pntCentroid, pntInEle);
-    addListOfStuff(_TPP, l->TP, 3 + 9 * l->getNumTimeSteps());
-    Octree_Arrange(_TPP);
-
-    _SL =
-      Octree_Create(maxElePerBucket, min, size, linBB, linCentroid, linInEle);
-    addListOfStuff(_SL, l->SL, 6 + 2 * l->getNumTimeSteps());
-    Octree_Arrange(_SL);
-    _VL =
-      Octree_Create(maxElePerBucket, min, size, linBB, linCentroid, linInEle);
-    addListOfStuff(_VL, l->VL, 6 + 6 * l->getNumTimeSteps());
-    Octree_Arrange(_VL);
-    _TL =
-      Octree_Create(maxElePerBucket, min, size, linBB, linCentroid, linInEle);
-    addListOfStuff(_TL, l->TL, 6 + 18 * l->getNumTimeSteps());
-    Octree_Arrange(_TL);
-
-    _ST =
-      Octree_Create(maxElePerBucket, min, size, triBB, triCentroid, triInEle);
-    addListOfStuff(_ST, l->ST, 9 + 3 * l->getNumTimeSteps());
-    Octree_Arrange(_ST);
-    _VT =
-      Octree_Create(maxElePerBucket, min, size, triBB, triCentroid, triInEle);
-    addListOfStuff(_VT, l->VT, 9 + 9 * l->getNumTimeSteps());
-    Octree_Arrange(_VT);
-    _TT =
-      Octree_Create(maxElePerBucket, min, size, triBB, triCentroid, triInEle);
-    addListOfStuff(_TT, l->TT, 9 + 27 * l->getNumTimeSteps());
-    Octree_Arrange(_TT);
-
-    _SQ =
-      Octree_Create(maxElePerBucket, min, size, quaBB, quaCentroid, quaInEle);
-    addListOfStuff(_SQ, l->SQ, 12 + 4 * l->getNumTimeSteps());
-    Octree_Arrange(_SQ);
-    _VQ =
-      Octree_Create(maxElePerBucket, min, size, quaBB, quaCentroid, quaInEle);
-    addListOfStuff(_VQ, l->VQ, 12 + 12 * l->getNumTimeSteps());
-    Octree_Arrange(_VQ);
-    _TQ =
-      Octree_Create(maxElePerBucket, min, size, quaBB, quaCentroid, quaInEle);
-    addListOfStuff(_TQ, l->TQ, 12 + 36 * l->getNumTimeSteps());
-    Octree_Arrange(_TQ);
-
-    _SS =
-      Octree_Create(maxElePerBucket, min, size, tetBB, tetCentroid, tetInEle);
-    addListOfStuff(_SS, l->SS, 12 + 4 * l->getNumTimeSteps());
-    Octree_Arrange(_SS);
-    _VS =
-      Octree_Create(maxElePerBucket, min, size, tetBB, tetCentroid, tetInEle);
-    addListOfStuff(_VS, l->VS, 12 + 12 * l->getNumTimeSteps());
-    Octree_Arrange(_VS);
-    _TS =
-      Octree_Create(maxElePerBucket, min, size, tetBB, tetCentroid, tetInEle);
-    addListOfStuff(_TS, l->TS, 12 + 36 * l->getNumTimeSteps());
-    Octree_Arrange(_TS);
-
-    _SH =
-      Octree_Create(maxElePerBucket, min, size, hexBB, hexCentroid, hexInEle);
-    addListOfStuff(_SH, l->SH, 24 + 8 * l->getNumTimeSteps());
-    Octree_Arrange(_SH);
-    _VH =
-      Octree_Create(maxElePerBucket, min, size, hexBB, hexCentroid, hexInEle);
-    addListOfStuff(_VH, l->VH, 24 + 24 * l->getNumTimeSteps());
-    Octree_Arrange(_VH);
-    _TH =
-      Octree_Create(maxElePerBucket, min, size, hexBB, hexCentroid, hexInEle);
-    addListOfStuff(_TH, l->TH, 24 + 72 * l->getNumTimeSteps());
-    Octree_Arrange(_TH);
-
-    _SI =
-      Octree_Create(maxElePerBucket, min, size, priBB, priCentroid, priInEle);
-    addListOfStuff(_SI, l->SI, 18 + 6 * l->getNumTimeSteps());
-    Octree_Arrange(_SI);
-    _VI =
-      Octree_Create(maxElePerBucket, min, size, priBB, priCentroid, priInEle);
-    addListOfStuff(_VI, l->VI, 18 + 18 * l->getNumTimeSteps());
-    Octree_Arrange(_VI);
-    _TI =
-      Octree_Create(maxElePerBucket, min, size, priBB, priCentroid, priInEle);
-    addListOfStuff(_TI, l->TI, 18 + 54 * l->getNumTimeSteps());
-    Octree_Arrange(_TI);
-
-    _SY =
-      Octree_Create(maxElePerBucket, min, size, pyrBB, pyrCentroid, pyrInEle);
-    addListOfStuff(_SY, l->SY, 15 + 5 * l->getNumTimeSteps());
-    Octree_Arrange(_SY);
-    _VY =
-      Octree_Create(maxElePerBucket, min, size, pyrBB, pyrCentroid, pyrInEle);
-    addListOfStuff(_VY, l->VY, 15 + 15 * l->getNumTimeSteps());
-    Octree_Arrange(_VY);
-    _TY =
-      Octree_Create(maxElePerBucket, min, size, pyrBB, pyrCentroid, pyrInEle);
-    addListOfStuff(_TY, l->TY, 15 + 45 * l->getNumTimeSteps());
-    Octree_Arrange(_TY);
+    // the elements of each kind of field are searched in a single tree: the
+    // search returns the first element containing the point, so their order
+    // gives the priority of the element types
+    _addList(0, l->SS, 4, 3, 1);
+    _addList(0, l->SH, 8, 3, 1);
+    _addList(0, l->SI, 6, 3, 1);
+    _addList(0, l->SY, 5, 3, 1);
+    _addList(0, l->ST, 3, 2, 1);
+    _addList(0, l->SQ, 4, 2, 1);
+    _addList(0, l->SL, 2, 1, 1);
+    _addList(0, l->SP, 1, 0, 1);
+
+    _addList(1, l->VS, 4, 3, 3);
+    _addList(1, l->VH, 8, 3, 3);
+    _addList(1, l->VI, 6, 3, 3);
+    _addList(1, l->VY, 5, 3, 3);
+    _addList(1, l->VT, 3, 2, 3);
+    _addList(1, l->VQ, 4, 2, 3);
+    _addList(1, l->VL, 2, 1, 3);
+    _addList(1, l->VP, 1, 0, 3);
+
+    _addList(2, l->TS, 4, 3, 9);
+    _addList(2, l->TH, 8, 3, 9);
+    _addList(2, l->TI, 6, 3, 9);
+    _addList(2, l->TY, 5, 3, 9);
+    _addList(2, l->TT, 3, 2, 9);
+    _addList(2, l->TQ, 4, 2, 9);
+    _addList(2, l->TL, 2, 1, 9);
+    _addList(2, l->TP, 1, 0, 9);
+
+    for(int kind = 0; kind < 3; kind++) {
+      const std::vector<listElement> &elements = _listElements[kind];
+      const int n = (int)elements.size();
+      std::vector<double> bbs(6 * n);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+      for(int i = 0; i < n; i++) {
+        double *X = elements[i].data;
+        int nbNod = elements[i].nbNod;
+        minmax(nbNod, X, &X[nbNod], &X[2 * nbNod], &bbs[6 * i],
+               &bbs[6 * i + 3]);
+      }
+      _listTrees[kind].build(bbs);
+    }
   }
 }
 
-static void *getElement(double P[3], Octree *octree, int nbNod, int qn,
-                        double *qx, double *qy, double *qz)
+// keep the containing element with the smallest index
+class firstListElement {
+private:
+  const std::vector<OctreePost::listElement> &_elements;
+  double *_P;
+
+public:
+  int best;
+  firstListElement(const std::vector<OctreePost::listElement> &elements,
+                   double *P)
+    : _elements(elements), _P(P), best(-1)
+  {
+  }
+  void operator()(int k)
+  {
+    if(best >= 0 && k >= best) return;
+    const OctreePost::listElement &e = _elements[k];
+    if(listElementInEle(e.data, e.nbNod, e.dim, _P)) best = k;
+  }
+};
+
+// collect the indices of all the containing elements
+class allListElements {
+private:
+  const std::vector<OctreePost::listElement> &_elements;
+  double *_P;
+
+public:
+  std::vector<int> found;
+  allListElements(const std::vector<OctreePost::listElement> &elements,
+                  double *P)
+    : _elements(elements), _P(P)
+  {
+  }
+  void operator()(int k)
+  {
+    const OctreePost::listElement &e = _elements[k];
+    if(listElementInEle(e.data, e.nbNod, e.dim, _P)) found.push_back(k);
+  }
+};
+
+const OctreePost::listElement *
+OctreePost::_getElement(int kind, double P[3], int qn, double *qx, double *qy,
+                        double *qz) const
 {
+  const std::vector<listElement> &elements = _listElements[kind];
   if(qn && qx && qy && qz) {
-    std::vector<void *> v;
-    Octree_SearchAll(P, octree, &v);
-    if(nbNod == qn) {
+    allListElements f(elements, P);
+    _listTrees[kind].search(P, f);
+    if(f.found.empty()) return 0;
+    std::sort(f.found.begin(), f.found.end());
+    // only consider the elements of the first type containing the point
+    const listElement &first = elements[f.found[0]];
+    if(first.nbNod == qn) {
       // try to use the value from the same geometrical element as the one
       // provided in qx/y/z
       double eps = CTX::instance()->geom.tolerance;
-      for(std::size_t i = 0; i < v.size(); i++) {
-        double *X = (double *)v[i], *Y = &X[qn], *Z = &X[2 * qn];
+      for(std::size_t i = 0; i < f.found.size(); i++) {
+        const listElement &e = elements[f.found[i]];
+        if(e.nbNod != first.nbNod || e.dim != first.dim) break;
+        double *X = e.data, *Y = &X[qn], *Z = &X[2 * qn];
         bool ok = true;
         for(int j = 0; j < qn; j++) {
           ok &= (fabs(X[j] - qx[j]) < eps && fabs(Y[j] - qy[j]) < eps &&
                  fabs(Z[j] - qz[j]) < eps);
         }
-        if(ok) return v[i];
+        if(ok) return &e;
       }
     }
-    if(v.size()) return v[0];
+    return &first;
   }
-  else {
-    return Octree_Search(P, octree);
-  }
-  return 0;
+  firstListElement f(elements, P);
+  _listTrees[kind].search(P, f);
+  return (f.best < 0) ? 0 : &elements[f.best];
 }
 
 static MElement *getElement(double P[3], GModel *m, int qn, double *qx,
@@ -556,9 +430,10 @@ bool OctreePost::_getValue(void *in, int nbComp, double P[3], int timestep,
   return true;
 }
 
-bool OctreePost::searchScalar(double x, double y, double z, double *values,
-                              int step, double *size, int qn, double *qx,
-                              double *qy, double *qz, bool grad)
+bool OctreePost::_search(int nbComp, double x, double y, double z,
+                         double *values, int step, double *size, int qn,
+                         double *qx, double *qy, double *qz, bool grad,
+                         void **element)
 {
   double P[3] = {x, y, z};
   int mult = grad ? 3 : 1;
@@ -569,52 +444,105 @@ bool OctreePost::searchScalar(double x, double y, double z, double *values,
       numSteps = _theViewDataList->getNumTimeSteps();
     else if(_theViewDataGModel)
       numSteps = _theViewDataGModel->getNumTimeSteps();
-    for(int i = 0; i < numSteps * mult; i++) {
-      values[i] = 0.;
-    }
+    for(int i = 0; i < nbComp * numSteps * mult; i++) values[i] = 0.;
   }
   else {
-    for(int i = 0; i < mult; i++) values[i] = 0.;
+    for(int i = 0; i < nbComp * mult; i++) values[i] = 0.;
   }
 
   if(_theViewDataList) {
-    if(_getValue(getElement(P, _SS, 4, qn, qx, qy, qz), 3, 4, 1, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _SH, 8, qn, qx, qy, qz), 3, 8, 1, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _SI, 6, qn, qx, qy, qz), 3, 6, 1, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _SY, 5, qn, qx, qy, qz), 3, 5, 1, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _ST, 3, qn, qx, qy, qz), 2, 3, 1, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _SQ, 4, qn, qx, qy, qz), 2, 4, 1, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _SL, 2, qn, qx, qy, qz), 1, 2, 1, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _SPP, 1, qn, qx, qy, qz), 0, 1, 1, P, step,
-                 values, size, grad))
+    int kind = (nbComp == 1) ? 0 : (nbComp == 3) ? 1 : 2;
+    const listElement *e = 0;
+    if(element && *element) {
+      const listElement *prev = (const listElement *)*element;
+      double *X = prev->data, min[3], max[3];
+      minmax(prev->nbNod, X, &X[prev->nbNod], &X[2 * prev->nbNod], min, max);
+      if(inBoundingBox(min, max, P) &&
+         listElementInEle(X, prev->nbNod, prev->dim, P))
+        e = prev;
+    }
+    if(!e) e = _getElement(kind, P, qn, qx, qy, qz);
+    if(element) *element = (void *)e;
+    if(e && _getValue(e->data, e->dim, e->nbNod, nbComp, P, step, values, size,
+                      grad))
       return true;
   }
   else if(_theViewDataGModel) {
     GModel *m = _theViewDataGModel->getModel((step < 0) ? 0 : step);
     if(m) {
-      if(_getValue(getElement(P, m, qn, qx, qy, qz), 1, P, step, values, size,
-                   grad))
-        return true;
+      MElement *e = 0;
+      if(element && *element) {
+        MElement *prev = (MElement *)*element;
+        double min[3], max[3];
+        MElementBB(prev, min, max);
+        if(inBoundingBox(min, max, P) && MElementInEle(prev, P)) e = prev;
+      }
+      if(!e) e = getElement(P, m, qn, qx, qy, qz);
+      if(element) *element = e;
+      if(_getValue(e, nbComp, P, step, values, size, grad)) return true;
     }
   }
 
   return false;
 }
 
+int OctreePost::_search(int nbComp, const std::vector<double> &xyz,
+                        std::vector<double> &values, int step, bool grad)
+{
+  const int n = (int)xyz.size() / 3;
+  int numSteps = 1;
+  if(step < 0) {
+    if(_theViewDataList)
+      numSteps = _theViewDataList->getNumTimeSteps();
+    else if(_theViewDataGModel)
+      numSteps = _theViewDataGModel->getNumTimeSteps();
+  }
+  const int stride = nbComp * (grad ? 3 : 1) * numSteps;
+  values.assign(n * stride, 0.);
+  int found = 0;
+
+  if(_theViewDataList) {
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : found)
+#endif
+    for(int i = 0; i < n; i++) {
+      if(_search(nbComp, xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2],
+                 &values[i * stride], step, 0, 0, 0, 0, 0, grad, 0))
+        found++;
+    }
+  }
+  else if(_theViewDataGModel) {
+    GModel *m = _theViewDataGModel->getModel((step < 0) ? 0 : step);
+    if(!m) return 0;
+    if(_theViewDataGModel->getNumComponents(0, 0, 0) != nbComp) return 0;
+    // locate all the points at once, then interpolate in parallel
+    std::vector<MElement *> elements;
+    std::vector<double> uvw;
+    m->getMeshElementsByCoord(xyz, elements, uvw);
+    std::set<int> types;
+    for(int i = 0; i < n; i++)
+      if(elements[i]) types.insert(elements[i]->getTypeForMSH());
+    BasisFactory::preload(std::vector<int>(types.begin(), types.end()));
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : found)
+#endif
+    for(int i = 0; i < n; i++) {
+      double P[3] = {xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]};
+      if(_getValue(elements[i], nbComp, P, step, &values[i * stride], 0, grad))
+        found++;
+    }
+  }
+
+  return found;
+}
+
+bool OctreePost::searchScalar(double x, double y, double z, double *values,
+                              int step, double *size, int qn, double *qx,
+                              double *qy, double *qz, bool grad)
+{
+  return _search(1, x, y, z, values, step, size, qn, qx, qy, qz, grad, 0);
+}
+
 bool OctreePost::searchScalarWithTol(double x, double y, double z,
                                      double *values, int step, double *size,
                                      double tol, int qn, double *qx, double *qy,
@@ -637,57 +565,7 @@ bool OctreePost::searchVector(double x, double y, double z, double *values,
                               int step, double *size, int qn, double *qx,
                               double *qy, double *qz, bool grad)
 {
-  double P[3] = {x, y, z};
-  int mult = grad ? 3 : 1;
-
-  if(step < 0) {
-    int numSteps = 1;
-    if(_theViewDataList)
-      numSteps = _theViewDataList->getNumTimeSteps();
-    else if(_theViewDataGModel)
-      numSteps = _theViewDataGModel->getNumTimeSteps();
-    for(int i = 0; i < 3 * numSteps * mult; i++) values[i] = 0.;
-  }
-  else {
-    for(int i = 0; i < 3 * mult; i++) values[i] = 0.;
-  }
-
-  if(_theViewDataList) {
-    if(_getValue(getElement(P, _VS, 4, qn, qx, qy, qz), 3, 4, 3, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _VH, 8, qn, qx, qy, qz), 3, 8, 3, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _VI, 6, qn, qx, qy, qz), 3, 6, 3, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _VY, 5, qn, qx, qy, qz), 3, 5, 3, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _VT, 3, qn, qx, qy, qz), 2, 3, 3, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _VQ, 4, qn, qx, qy, qz), 2, 4, 3, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _VL, 2, qn, qx, qy, qz), 1, 2, 3, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _VPP, 1, qn, qx, qy, qz), 0, 1, 3, P, step,
-                 values, size, grad))
-      return true;
-  }
-  else if(_theViewDataGModel) {
-    GModel *m = _theViewDataGModel->getModel((step < 0) ? 0 : step);
-    if(m) {
-      if(_getValue(getElement(P, m, qn, qx, qy, qz), 3, P, step, values, size,
-                   grad))
-        return true;
-    }
-  }
-
-  return false;
+  return _search(3, x, y, z, values, step, size, qn, qx, qy, qz, grad, 0);
 }
 
 bool OctreePost::searchVectorWithTol(double x, double y, double z,
@@ -712,57 +590,7 @@ bool OctreePost::searchTensor(double x, double y, double z, double *values,
                               int step, double *size, int qn, double *qx,
                               double *qy, double *qz, bool grad)
 {
-  double P[3] = {x, y, z};
-  int mult = grad ? 3 : 1;
-
-  if(step < 0) {
-    int numSteps = 1;
-    if(_theViewDataList)
-      numSteps = _theViewDataList->getNumTimeSteps();
-    else if(_theViewDataGModel)
-      numSteps = _theViewDataGModel->getNumTimeSteps();
-    for(int i = 0; i < 9 * numSteps * mult; i++) values[i] = 0.;
-  }
-  else {
-    for(int i = 0; i < 9 * mult; i++) values[i] = 0.;
-  }
-
-  if(_theViewDataList) {
-    if(_getValue(getElement(P, _TS, 4, qn, qx, qy, qz), 3, 4, 9, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _TH, 8, qn, qx, qy, qz), 3, 8, 9, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _TI, 6, qn, qx, qy, qz), 3, 6, 9, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _TY, 5, qn, qx, qy, qz), 3, 5, 9, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _TT, 3, qn, qx, qy, qz), 2, 3, 9, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _TQ, 4, qn, qx, qy, qz), 2, 4, 9, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _TL, 2, qn, qx, qy, qz), 1, 2, 9, P, step,
-                 values, size, grad))
-      return true;
-    if(_getValue(getElement(P, _TPP, 1, qn, qx, qy, qz), 0, 1, 9, P, step,
-                 values, size, grad))
-      return true;
-  }
-  else if(_theViewDataGModel) {
-    GModel *m = _theViewDataGModel->getModel((step < 0) ? 0 : step);
-    if(m) {
-      if(_getValue(getElement(P, m, qn, qx, qy, qz), 9, P, step, values, size,
-                   grad))
-        return true;
-    }
-  }
-
-  return false;
+  return _search(9, x, y, z, values, step, size, qn, qx, qy, qz, grad, 0);
 }
 
 bool OctreePost::searchTensorWithTol(double x, double y, double z,
@@ -782,3 +610,35 @@ bool OctreePost::searchTensorWithTol(double x, double y, double z,
   }
   return a;
 }
+
+bool OctreePost::searchScalarFromElement(double x, double y, double z,
+                                         double *values, int step,
+                                         double *size, void **element)
+{
+  return _search(1, x, y, z, values, step, size, 0, 0, 0, 0, false, element);
+}
+
+bool OctreePost::searchVectorFromElement(double x, double y, double z,
+                                         double *values, int step,
+                                         double *size, void **element)
+{
+  return _search(3, x, y, z, values, step, size, 0, 0, 0, 0, false, element);
+}
+
+int OctreePost::searchScalar(const std::vector<double> &xyz,
+                             std::vector<double> &values, int step, bool grad)
+{
+  return _search(1, xyz, values, step, grad);
+}
+
+int OctreePost::searchVector(const std::vector<double> &xyz,
+                             std::vector<double> &values, int step, bool grad)
+{
+  return _search(3, xyz, values, step, grad);
+}
+
+int OctreePost::searchTensor(const std::vector<double> &xyz,
+                             std::vector<double> &values, int step, bool grad)
+{
+  return _search(9, xyz, values, step, grad);
+}
@@ -6,7 +6,8 @@
 #ifndef _OCTREE_POST_H_
 #define _OCTREE_POST_H_
 
-#include "Octree.h"
+#include <vector>
+#include "BoundingBoxTree.h"
 
 class PView;
 class PViewData;
@@ -15,21 +16,33 @@ class PViewDataGModel;
 
 class OctreePost {
 private:
-  Octree *_SPP, *_VPP, *_TPP; // _SP & co reserved by win32
-  Octree *_SL, *_VL, *_TL;
-  Octree *_ST, *_VT, *_TT;
-  Octree *_SQ, *_VQ, *_TQ;
-  Octree *_SS, *_VS, *_TS;
-  Octree *_SH, *_VH, *_TH;
-  Octree *_SI, *_VI, *_TI;
-  Octree *_SY, *_VY, *_TY;
+  // elements of list-based views, for scalar, vector and tensor fields,
+  // ordered by search priority (volume elements first); data points to the
+  // coordinates of the nodes of the element in the list, followed by its values
+  struct listElement {
+    double *data;
+    int nbNod, dim;
+  };
+  friend class firstListElement;
+  friend class allListElements;
+  std::vector<listElement> _listElements[3];
+  BoundingBoxTree _listTrees[3];
   PViewDataList *_theViewDataList;
   PViewDataGModel *_theViewDataGModel;
   void _create(PViewData *data);
+  void _addList(int kind, std::vector<double> &list, int nbNod, int dim,
+                int nbComp);
+  const listElement *_getElement(int kind, double P[3], int qn, double *qx,
+                                 double *qy, double *qz) const;
   bool _getValue(void *in, int dim, int nbNod, int nbComp, double P[3],
                  int step, double *values, double *elementSize, bool grad);
   bool _getValue(void *in, int nbComp, double P[3], int step, double *values,
                  double *elementSize, bool grad);
+  bool _search(int nbComp, double x, double y, double z, double *values,
+               int step, double *size, int qn, double *qx, double *qy,
+               double *qz, bool grad, void **element);
+  int _search(int nbComp, const std::vector<double> &xyz,
+              std::vector<double> &values, int step, bool grad);
 
 public:
   OctreePost(PView *v);
@@ -63,6 +76,25 @@ public:
                            int step = -1, double *size = 0, double tol = 1.e-2,
                            int qn = 0, double *qx = 0, double *qy = 0,
                            double *qz = 0, bool grad = false);
+  // same as searchScalar and searchVector, but first try the element stored
+  // in element (e.g. the element in which the previous point along a path was
+  // found) before searching the whole view. The element in which the point is
+  // found is stored in element (0 if the point is not found).
+  bool searchScalarFromElement(double x, double y, double z, double *values,
+                               int step, double *size, void **element);
+  bool searchVectorFromElement(double x, double y, double z, double *values,
+                               int step, double *size, void **element);
+  // batched versions of searchScalar, searchVector and searchTensor: search
+  // for the values at the points xyz (3 coordinates per point) in parallel.
+  // The values at point i are stored in values[i * n], where n is the number
+  // of values returned by the single-point version (they are set to zero if
+  // the point is not found). Return the number of points found.
+  int searchScalar(const std::vector<double> &xyz, std::vector<double> &values,
+                   int step = -1, bool grad = false);
+  int searchVector(const std::vector<double> &xyz, std::vector<double> &values,
+                   int step = -1, bool grad = false);
+  int searchTensor(const std::vector<double> &xyz, std::vector<double> &values,
+                   int step = -1, bool grad = false);
 };
 
 #endif
@@ -128,8 +128,10 @@ public:
   // IO read routines (these are global: they can create multiple
   // views)
   static bool readPOS(const std::string &fileName, int fileIndex = -1);
+  // read the views in a MSH file; in lazy mode, the values of the time steps
+  // are only read from the file when they are first accessed
   static bool readMSH(const std::string &fileName, int fileIndex = -1,
-                      int partitionToRead = -1);
+                      int partitionToRead = -1, bool lazy = false);
   static bool readMED(const std::string &fileName, int fileIndex = -1);
   static bool writeX3D(const std::string &fileName);
   // IO write routine
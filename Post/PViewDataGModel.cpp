@@ -3,6 +3,7 @@
 // See the LICENSE.txt file for license information. Please report all
 // issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
 
+#include <algorithm>
 #include "PViewDataGModel.h"
 #include "MPoint.h"
 #include "MLine.h"
@@ -17,6 +18,76 @@
 #include "GmshMessage.h"
 #include "pyramidalBasis.h"
 
+void stepDataIndex::_insertHash(int tag, int entry)
+{
+  const std::size_t mask = _hashTags.size() - 1;
+  std::size_t i = _hash(tag) & mask;
+  while(_hashTags[i] >= 0) i = (i + 1) & mask;
+  _hashTags[i] = tag;
+  _hashEntries[i] = entry;
+}
+
+void stepDataIndex::_rehash(std::size_t capacity)
+{
+  std::size_t n = 16;
+  while(n < capacity) n *= 2;
+  _hashTags.assign(n, -1);
+  _hashEntries.assign(n, -1);
+  for(std::size_t i = 0; i < _tags.size(); i++) _insertHash(_tags[i], i);
+}
+
+int stepDataIndex::insert(int tag, int numValues)
+{
+  const int entry = _tags.size();
+  _tags.push_back(tag);
+  _offsets.push_back(_offsets.back() + numValues);
+  if(tag >= _numTags) _numTags = tag + 1;
+  if(_hashTags.empty()) {
+    // keep the table as long as the numbering is fairly dense
+    if((std::size_t)_numTags <= 4 * std::max(_tags.size(), _expected) + 1024) {
+      if((int)_table.size() < _numTags)
+        _table.resize(std::max((std::size_t)_numTags, 2 * _table.size()), -1);
+      _table[tag] = entry;
+    }
+    else {
+      std::vector<int>().swap(_table);
+      _rehash(2 * _tags.size());
+    }
+  }
+  else if(2 * _tags.size() > _hashTags.size())
+    _rehash(2 * _hashTags.size());
+  else
+    _insertHash(tag, entry);
+  return entry;
+}
+
+void stepDataIndex::reserve(std::size_t n)
+{
+  _tags.reserve(n);
+  _offsets.reserve(n + 1);
+  _expected = std::max(_expected, n);
+}
+
+void stepDataIndex::getSortedTags(std::vector<int> &tags) const
+{
+  tags = _tags;
+  for(std::size_t i = 1; i < tags.size(); i++) {
+    if(tags[i] < tags[i - 1]) {
+      std::sort(tags.begin(), tags.end());
+      break;
+    }
+  }
+}
+
+double stepDataIndex::getMemoryInMb() const
+{
+  double b = _tags.capacity() * sizeof(int) +
+             _offsets.capacity() * sizeof(std::size_t) +
+             _table.capacity() * sizeof(int) +
+             (_hashTags.capacity() + _hashEntries.capacity()) * sizeof(int);
+  return b / 1024. / 1024.;
+}
+
 PViewDataGModel::PViewDataGModel(DataType type)
   : PViewData(), _min(VAL_INF), _max(-VAL_INF), _type(type)
 {
@@ -97,13 +168,13 @@ bool PViewDataGModel::finalize(bool computeMinMax,
       if(_type == NodeData || _type == ElementData) {
         // treat these 2 special cases separately for maximum efficiency
         int numComp = _steps[step]->getNumComponents();
-        for(std::size_t i = 0; i < _steps[step]->getNumData(); i++) {
-          double *d = _steps[step]->getData(i);
-          if(d) {
-            double val = ComputeScalarRep(numComp, d, tensorRep);
-            _steps[step]->setMin(std::min(_steps[step]->getMin(), val));
-            _steps[step]->setMax(std::max(_steps[step]->getMax(), val));
-          }
+        std::vector<int> tags;
+        _steps[step]->getTags(tags);
+        for(std::size_t i = 0; i < tags.size(); i++) {
+          double *d = _steps[step]->getData(tags[i]);
+          double val = ComputeScalarRep(numComp, d, tensorRep);
+          _steps[step]->setMin(std::min(_steps[step]->getMin(), val));
+          _steps[step]->setMax(std::max(_steps[step]->getMax(), val));
         }
       }
       else {
@@ -667,6 +738,7 @@ void PViewDataGModel::setValue(int step, int ent, int ele, int nod, int comp,
                                double val)
 {
   MElement *e = _getElement(step, ent, ele);
+  _steps[step]->setModified(true);
   switch(_type) {
   case NodeData: {
     int num = _getNode(e, nod)->getNum();
@@ -737,13 +809,13 @@ void PViewDataGModel::smooth()
         }
       }
     }
-    for(std::size_t i = 0; i < _steps2.back()->getNumData(); i++) {
-      double *d = _steps2.back()->getData(i);
-      if(d) {
-        double f = nodeConnect[i];
-        if(f)
-          for(int j = 0; j < numComp; j++) d[j] /= f;
-      }
+    std::vector<int> tags;
+    _steps2.back()->getTags(tags);
+    for(std::size_t i = 0; i < tags.size(); i++) {
+      double *d = _steps2.back()->getData(tags[i]);
+      double f = nodeConnect[tags[i]];
+      if(f)
+        for(int j = 0; j < numComp; j++) d[j] /= f;
     }
   }
   for(std::size_t i = 0; i < _steps.size(); i++) delete _steps[i];
@@ -9,6 +9,102 @@
 #include "PViewData.h"
 #include "GModel.h"
 #include "SBoundingBox3d.h"
+#if __cplusplus >= 201103L
+#include <atomic>
+#endif
+
+// The index of the entities (nodes or elements) for which a time step has
+// data: maps the tags of the entities to the position of their values in the
+// contiguous array of values of the step. Tags are looked up in a table
+// indexed by the tag if the numbering is fairly dense, and in an
+// open-addressing hash table otherwise. Steps with the same entities (and the
+// same number of values per entity) share the same index, which is reference
+// counted.
+class stepDataIndex {
+private:
+  int _refs;
+  // the tag and the offset of the values of each entry, in insertion order
+  // (_offsets has one more item, the total number of values)
+  std::vector<int> _tags;
+  std::vector<std::size_t> _offsets;
+  // the largest tag plus one, and the expected number of entries
+  int _numTags;
+  std::size_t _expected;
+  // entry of each tag (-1 if none) for dense numberings...
+  std::vector<int> _table;
+  // ... or hash table of the tags otherwise
+  std::vector<int> _hashTags, _hashEntries;
+  static std::size_t _hash(int tag)
+  {
+    std::size_t h = (std::size_t)tag;
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return h;
+  }
+  void _insertHash(int tag, int entry);
+  void _rehash(std::size_t capacity);
+
+public:
+  stepDataIndex() : _refs(1), _offsets(1, 0), _numTags(0), _expected(0) {}
+  void ref() { _refs++; }
+  // decrease the reference count, and return true if the index is not used
+  // anymore
+  bool unref() { return --_refs == 0; }
+  bool isShared() const { return _refs > 1; }
+  int getNumRefs() const { return _refs; }
+  // get a copy of the index, with a single reference
+  stepDataIndex *clone() const
+  {
+    stepDataIndex *index = new stepDataIndex(*this);
+    index->_refs = 1;
+    return index;
+  }
+  std::size_t size() const { return _tags.size(); }
+  int getNumTags() const { return _numTags; }
+  int getTag(int entry) const { return _tags[entry]; }
+  std::size_t getOffset(int entry) const { return _offsets[entry]; }
+  int getNumValues(int entry) const
+  {
+    return (int)(_offsets[entry + 1] - _offsets[entry]);
+  }
+  // the total number of values
+  std::size_t getNumValues() const { return _offsets.back(); }
+  int find(int tag) const
+  {
+    if(tag < 0 || tag >= _numTags) return -1;
+    if(!_hashTags.empty()) {
+      const std::size_t mask = _hashTags.size() - 1;
+      for(std::size_t i = _hash(tag) & mask; _hashTags[i] >= 0;
+          i = (i + 1) & mask)
+        if(_hashTags[i] == tag) return _hashEntries[i];
+      return -1;
+    }
+    return _table[tag];
+  }
+  // add an entry with numValues values for a tag that is not in the index,
+  // and return it
+  int insert(int tag, int numValues);
+  void reserve(std::size_t n);
+  // return true if both indices have the same entries with the same numbers
+  // of values
+  bool operator==(const stepDataIndex &other) const
+  {
+    return _tags == other._tags && _offsets == other._offsets;
+  }
+  // get the tags in increasing order
+  void getSortedTags(std::vector<int> &tags) const;
+  double getMemoryInMb() const;
+};
+
+// A block of values of a time step in a file, from which the step can be
+// (re)loaded on demand
+struct stepDataBlock {
+  std::string fileName;
+  long int offset; // position of the first value record in the file
+  int numEnt, numComp;
+  bool binary, swap, hasMult;
+};
 
 template <class Real> class stepData {
 private:
@@ -27,36 +123,65 @@ private:
   // the number of components in the data (one stepData contains only
   // a single field type)
   int _numComp;
-  // the values, indexed by MVertex or MElement id numbers (If the
-  // numbering is sparse, or if we only have data for high-id
-  // entities, the vector has zero entries and is thus not
-  // optimal. This is the price to pay if we want 1) rapid access to
-  // the data and 2) not to store any additional info in MVertex or
-  // MElement)
-  //
-  // FIXME: we should change this design and store a vector<int> of tags, and do
-  // indirect addressing, even if it's a bit slower...
-  std::vector<Real *> *_data;
-  // a vector containing the multiplying factor allowing to compute
-  // the number of values stored in _data for each index (number of
-  // values = getMult() * getNumComponents()). If _mult is empty, a
-  // default value of "1" is assumed
-  std::vector<int> _mult;
+  // the index of the entities with data (possibly shared with other steps),
+  // and the values of all the entities, stored contiguously (for each entity,
+  // getMult() * getNumComponents() values)
+  stepDataIndex *_index;
+  std::vector<Real> _values;
+  // the blocks of the file(s) the values were read from; a step whose values
+  // are not in memory is loaded from its blocks the first time the values are
+  // accessed
+  std::vector<stepDataBlock> _blocks;
+  // whether the values differ from the ones in the blocks (the step cannot be
+  // unloaded then)
+  bool _modified;
+  // whether the values are in memory, and the number of loads when the values
+  // were last accessed (see PostProcessing.StepMemoryLimit): these are read
+  // concurrently by getData(), but only modified by load() in a critical
+  // section while other threads can access the step
+#if __cplusplus >= 201103L
+  std::atomic<bool> _loaded;
+  std::atomic<unsigned long> _lastUse;
+  static std::atomic<unsigned long> _numLoads;
+#else
+  bool _loaded;
+  unsigned long _lastUse;
+  static unsigned long _numLoads;
+#endif
   // a vector, indexed by MSH element type, of Gauss point locations
   // in parametric space
   std::vector<std::vector<double> > _gaussPoints;
   // a set of all "partitions" encountered in the data
   std::set<int> _partitions;
+  // get the index for modification (it is copied if it is shared)
+  stepDataIndex *_ownIndex()
+  {
+    if(!_index)
+      _index = new stepDataIndex();
+    else if(_index->isShared()) {
+      _index->unref();
+      _index = _index->clone();
+    }
+    return _index;
+  }
+  void _releaseIndex()
+  {
+    if(_index && _index->unref()) delete _index;
+    _index = 0;
+  }
+  // forget the step in the list of loaded steps that can be unloaded
+  void _uncache();
 
 public:
   stepData(GModel *model, int numComp, const std::string &fileName = "",
            int fileIndex = -1, double time = 0., double min = VAL_INF,
            double max = -VAL_INF)
     : _model(model), _fileName(fileName), _fileIndex(fileIndex), _time(time),
-      _min(min), _max(max), _numComp(numComp), _data(0)
+      _min(min), _max(max), _numComp(numComp), _index(0), _modified(false),
+      _loaded(true), _lastUse(0)
   {
   }
-  stepData(stepData<Real> &other) : _data(0)
+  stepData(stepData<Real> &other)
   {
     _model = other._model;
     _entities = other._entities;
@@ -67,19 +192,13 @@ public:
     _min = other._min;
     _max = other._max;
     _numComp = other._numComp;
-    if(other._data) {
-      std::size_t n = other.getNumData();
-      _data = new std::vector<Real *>(n, (Real *)0);
-      for(std::size_t i = 0; i < n; i++) {
-        Real *d = other.getData(i);
-        if(d) {
-          int m = other.getMult(i) * _numComp;
-          (*_data)[i] = new Real[m];
-          for(int j = 0; j < m; j++) (*_data)[i][j] = d[j];
-        }
-      }
-    }
-    _mult = other._mult;
+    _index = other._index;
+    if(_index) _index->ref();
+    _values = other._values;
+    _blocks = other._blocks;
+    _modified = other._modified;
+    _loaded = (bool)other._loaded;
+    _lastUse = (unsigned long)other._lastUse;
     _gaussPoints = other._gaussPoints;
     _partitions = other._partitions;
   }
@@ -93,8 +212,9 @@ public:
   int getNumComponents() { return _numComp; }
   int getMult(int index)
   {
-    if(index < 0 || index >= (int)_mult.size()) return 1;
-    return _mult[index];
+    int entry = _index ? _index->find(index) : -1;
+    if(entry < 0) return 1;
+    return _index->getNumValues(entry) / _numComp;
   }
   std::string getFileName() { return _fileName; }
   void setFileName(const std::string &name) { _fileName = name; }
@@ -106,45 +226,85 @@ public:
   void setMin(double min) { _min = min; }
   double getMax() { return _max; }
   void setMax(double max) { _max = max; }
-  std::size_t getNumData()
+  // the largest tag with data plus one
+  std::size_t getNumData() { return _index ? _index->getNumTags() : 0; }
+  // the number of entities with data
+  std::size_t getNumEntries() { return _index ? _index->size() : 0; }
+  // get the tags of the entities with data, in increasing order
+  void getTags(std::vector<int> &tags)
   {
-    if(!_data) return 0;
-    return _data->size();
+    tags.clear();
+    if(_index) _index->getSortedTags(tags);
   }
+  // reserve memory for n entities
   void resizeData(int n)
   {
-    if(!_data) _data = new std::vector<Real *>(n, (Real *)0);
-    if(n > (int)_data->size()) _data->resize(n, (Real *)0);
+    if(n <= 0) return;
+    _ownIndex()->reserve(n);
+    if(_loaded) _values.reserve(n * _numComp);
+  }
+  // add an entity with mult * getNumComponents() values (initialized to zero)
+  // if it has no values yet, without loading the step
+  void addEntry(int index, int mult = 1)
+  {
+    if(index < 0 || (_index && _index->find(index) >= 0)) return;
+    _ownIndex()->insert(index, _numComp * mult);
+    if(_loaded) {
+      _values.resize(_index->getNumValues(), (Real)0.);
+      _modified = true;
+    }
   }
   Real *getData(int index, bool allocIfNeeded = false, int mult = 1)
   {
     if(index < 0) return 0;
-    if(allocIfNeeded) {
-      if(index >= (int)getNumData()) resizeData(index + 100); // optimize this
-      if(!(*_data)[index]) {
-        (*_data)[index] = new Real[_numComp * mult];
-        for(int i = 0; i < _numComp * mult; i++) (*_data)[index][i] = 0.;
-      }
-      if(mult > 1) {
-        if(index >= (int)_mult.size())
-          _mult.resize(index + 100, 1); // optimize this
-        _mult[index] = mult;
-      }
-    }
-    else {
-      if(index >= (int)getNumData()) return 0;
+    if(!_loaded || _lastUse != _numLoads) load();
+    int entry = _index ? _index->find(index) : -1;
+    if(entry < 0) {
+      if(!allocIfNeeded) return 0;
+      addEntry(index, mult);
+      entry = _index->size() - 1;
     }
-    return (*_data)[index];
+    return &_values[_index->getOffset(entry)];
   }
   void destroyData()
   {
-    if(_data) {
-      for(unsigned int i = 0; i < _data->size(); i++)
-        if((*_data)[i]) delete[](*_data)[i];
-      delete _data;
-      _data = 0;
-    }
+    _uncache();
+    _releaseIndex();
+    std::vector<Real>().swap(_values);
+    _blocks.clear();
+    _loaded = true;
+    _modified = false;
+  }
+  // share the index of another step if it is identical
+  void shareIndex(stepData<Real> &other)
+  {
+    if(_index == other._index || !_index || !other._index) return;
+    if(_numComp != other._numComp || !(*_index == *other._index)) return;
+    _releaseIndex();
+    _index = other._index;
+    _index->ref();
   }
+  // record a block of the file the values were read from
+  void addBlock(const stepDataBlock &block) { _blocks.push_back(block); }
+  bool isLoaded() { return _loaded; }
+  // values modified in place (e.g. through PViewData::setValue()) are kept in
+  // memory
+  bool isModified() { return _modified; }
+  void setModified(bool modified) { _modified = modified; }
+  // mark the values as not in memory: they will be read from the blocks of
+  // the step when they are first accessed
+  void unload()
+  {
+    if(_blocks.empty() || _modified) return;
+    _uncache();
+    std::vector<Real>().swap(_values);
+    _loaded = false;
+  }
+  // read the values from the blocks of the step (or only mark them as
+  // accessed if they are in memory); if the steps loaded this way use more
+  // than PostProcessing.StepMemoryLimit, the least recently accessed ones are
+  // unloaded
+  bool load();
   std::vector<double> &getGaussPoints(int msh)
   {
     if((int)_gaussPoints.size() <= msh) _gaussPoints.resize(msh + 1);
@@ -153,12 +313,20 @@ public:
   std::set<int> &getPartitions() { return _partitions; }
   double getMemoryInMb()
   {
-    double b = 0.;
-    for(std::size_t i = 0; i < getNumData(); i++) b += getMult(i);
-    return b * getNumComponents() * sizeof(Real) / 1024. / 1024.;
+    double m = _values.capacity() * sizeof(Real) / 1024. / 1024.;
+    if(_index) m += _index->getMemoryInMb() / _index->getNumRefs();
+    return m;
   }
 };
 
+#if __cplusplus >= 201103L
+template <class Real> std::atomic<unsigned long> stepData<Real>::_numLoads(0);
+#else
+template <class Real> unsigned long stepData<Real>::_numLoads(0);
+#endif
+template <> void stepData<double>::_uncache();
+template <> bool stepData<double>::load();
+
 // The data container using elements from one or more GModel(s).
 class PViewDataGModel : public PViewData {
 public:
@@ -267,7 +435,7 @@ public:
   bool readMSH(const std::string &viewName, const std::string &fileName,
                int fileIndex, FILE *fp, bool binary, bool swap, int step,
                double time, int partition, int numComp, int numNodes,
-               const std::string &interpolationScheme);
+               const std::string &interpolationScheme, bool lazy = false);
   virtual bool writeMSH(const std::string &fileName, double version = 2.2,
                         bool binary = false, bool savemesh = true,
                         bool multipleView = false, int partitionNum = 0,
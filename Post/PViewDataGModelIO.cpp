@@ -3,6 +3,7 @@
 // See the LICENSE.txt file for license information. Please report all
 // issues on https://gitlab.onelab.info/gmsh/gmsh/issues.
 
+#include <algorithm>
 #include "GmshConfig.h"
 #include "GmshMessage.h"
 #include "PViewDataGModel.h"
@@ -13,6 +14,10 @@
 #include "OS.h"
 #include "Context.h"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 bool PViewDataGModel::addData(GModel *model,
                               const std::map<int, std::vector<double> > &data,
                               int step, double time, int partition, int numComp)
@@ -85,23 +90,160 @@ void PViewDataGModel::destroyData()
   for(std::size_t i = 0; i < _steps.size(); i++) _steps[i]->destroyData();
 }
 
+// read the tag and, if hasMult, the multiplicity of a record in a $NodeData,
+// $ElementData or $ElementNodeData section
+static bool readMSHRecordHeader(FILE *fp, bool binary, bool swap, bool hasMult,
+                                int &num, int &mult)
+{
+  if(binary) {
+    if(fread(&num, sizeof(int), 1, fp) != 1) return false;
+    if(swap) SwapBytes((char *)&num, sizeof(int), 1);
+  }
+  else {
+    if(fscanf(fp, "%d", &num) != 1) return false;
+  }
+  if(num < 0) return false;
+  mult = 1;
+  if(hasMult) {
+    if(binary) {
+      if(fread(&mult, sizeof(int), 1, fp) != 1) return false;
+      if(swap) SwapBytes((char *)&mult, sizeof(int), 1);
+    }
+    else {
+      if(fscanf(fp, "%d", &mult) != 1) return false;
+    }
+  }
+  return true;
+}
+
+static bool readMSHRecordValues(FILE *fp, bool binary, bool swap, int n,
+                                double *d)
+{
+  if(binary) {
+    if((int)fread(d, sizeof(double), n, fp) != n) return false;
+    if(swap) SwapBytes((char *)d, sizeof(double), n);
+  }
+  else {
+    for(int j = 0; j < n; j++)
+      if(fscanf(fp, "%lf", &d[j]) != 1) return false;
+  }
+  return true;
+}
+
+static bool readMSHBlock(const stepDataBlock &block, stepDataIndex *index,
+                         std::vector<double> &values)
+{
+  FILE *fp = Fopen(block.fileName.c_str(), "rb");
+  if(!fp) {
+    Msg::Error("Unable to open file '%s'", block.fileName.c_str());
+    return false;
+  }
+  bool ok = !fseek(fp, block.offset, SEEK_SET);
+  for(int i = 0; ok && i < block.numEnt; i++) {
+    int num, mult;
+    ok = readMSHRecordHeader(fp, block.binary, block.swap, block.hasMult, num,
+                             mult);
+    int entry = (ok && index) ? index->find(num) : -1;
+    if(entry < 0 || index->getNumValues(entry) != block.numComp * mult) {
+      ok = false;
+      break;
+    }
+    ok = readMSHRecordValues(fp, block.binary, block.swap,
+                             block.numComp * mult,
+                             &values[index->getOffset(entry)]);
+  }
+  fclose(fp);
+  if(!ok)
+    Msg::Error("Could not read data from file '%s'", block.fileName.c_str());
+  return ok;
+}
+
+// the steps that were loaded from their blocks and are still in memory
+static std::vector<stepData<double> *> loadedSteps;
+
+template <> void stepData<double>::_uncache()
+{
+  if(!_loaded || _blocks.empty()) return;
+#if defined(_OPENMP)
+#pragma omp critical(stepDataLoad)
+#endif
+  {
+    std::vector<stepData<double> *>::iterator it =
+      std::find(loadedSteps.begin(), loadedSteps.end(), this);
+    if(it != loadedSteps.end()) loadedSteps.erase(it);
+  }
+}
+
+template <> bool stepData<double>::load()
+{
+  bool ok = true;
+#if defined(_OPENMP)
+#pragma omp critical(stepDataLoad)
+#endif
+  {
+    if(!_loaded) {
+      Msg::Debug("Loading step data at time %g", _time);
+      _values.assign(_index ? _index->getNumValues() : 0, 0.);
+      for(std::size_t i = 0; ok && i < _blocks.size(); i++)
+        ok = readMSHBlock(_blocks[i], _index, _values);
+      _loaded = true;
+      _lastUse = ++_numLoads;
+      loadedSteps.push_back(this);
+
+      double limit = CTX::instance()->post.stepMemoryLimit;
+#if defined(_OPENMP)
+      // other threads could be accessing any of the loaded steps
+      if(omp_in_parallel()) limit = 0.;
+#endif
+      double mem = 0.;
+      if(limit > 0.)
+        for(std::size_t i = 0; i < loadedSteps.size(); i++)
+          mem += loadedSteps[i]->getMemoryInMb();
+      while(mem > limit && limit > 0.) {
+        // unload the least recently accessed step, but keep the steps
+        // accessed since the previous load: the caller can still hold
+        // pointers to their values (and alternating between two steps should
+        // not reload them each time)
+        int lru = -1;
+        for(std::size_t i = 0; i < loadedSteps.size(); i++) {
+          stepData<double> *sd = loadedSteps[i];
+          if(sd->_modified || sd->_lastUse + 1 >= _numLoads) continue;
+          if(lru < 0 || sd->_lastUse < loadedSteps[lru]->_lastUse) lru = i;
+        }
+        if(lru < 0) break;
+        stepData<double> *sd = loadedSteps[lru];
+        Msg::Debug("Unloading step data at time %g", sd->_time);
+        mem -= sd->getMemoryInMb();
+        std::vector<double>().swap(sd->_values);
+        sd->_loaded = false;
+        loadedSteps.erase(loadedSteps.begin() + lru);
+      }
+    }
+    else
+      _lastUse = (unsigned long)_numLoads;
+  }
+  return ok;
+}
+
 bool PViewDataGModel::readMSH(const std::string &viewName,
                               const std::string &fileName, int fileIndex,
                               FILE *fp, bool binary, bool swap, int step,
                               double time, int partition, int numComp,
                               int numEnt,
-                              const std::string &interpolationScheme)
+                              const std::string &interpolationScheme,
+                              bool lazy)
 {
   Msg::Debug("Reading view `%s' step %d (time %g) partition %d: %d records",
              viewName.c_str(), step, time, partition, numEnt);
 
   while(step >= (int)_steps.size())
     _steps.push_back(new stepData<double>(GModel::current(), numComp));
-  _steps[step]->fillEntities();
-  _steps[step]->computeBoundingBox();
-  _steps[step]->setFileName(fileName);
-  _steps[step]->setFileIndex(fileIndex);
-  _steps[step]->setTime(time);
+  stepData<double> *sd = _steps[step];
+  sd->fillEntities();
+  sd->computeBoundingBox();
+  sd->setFileName(fileName);
+  sd->setFileIndex(fileIndex);
+  sd->setTime(time);
 
   /*
   // if we already have maxSteps for this view, return
@@ -111,39 +253,44 @@ bool PViewDataGModel::readMSH(const std::string &viewName,
   if(numSteps > maxSteps) return true;
   */
 
-  _steps[step]->resizeData(numEnt);
+  sd->resizeData(numEnt);
+
+  // remember where the values are in the file, so that the step can be
+  // reloaded; in lazy mode, the values of a step that is not in memory are
+  // only scanned to index the entities and to compute the min/max, and are
+  // read again when they are first accessed
+  stepDataBlock block;
+  block.fileName = fileName;
+  block.offset = ftell(fp);
+  block.numEnt = numEnt;
+  block.numComp = numComp;
+  block.binary = binary;
+  block.swap = swap;
+  block.hasMult = (_type == ElementNodeData || _type == GaussPointData);
+  const bool deferred = lazy && (!sd->isLoaded() || !sd->getNumEntries());
+  if(!deferred) sd->load();
+  sd->addBlock(block);
+  if(deferred) sd->unload();
+  // the values read here are the ones of the block
+  const bool modified = sd->isModified();
+  std::vector<double> tmp;
 
   Msg::ResetProgressMeter();
   for(int i = 0; i < numEnt; i++) {
-    int num;
-    if(binary) {
-      if(fread(&num, sizeof(int), 1, fp) != 1) return false;
-      if(swap) SwapBytes((char *)&num, sizeof(int), 1);
-    }
-    else {
-      if(fscanf(fp, "%d", &num) != 1) return false;
-    }
-    if(num < 0) return false;
-    int mult = 1;
-    if(_type == ElementNodeData || _type == GaussPointData) {
-      if(binary) {
-        if(fread(&mult, sizeof(int), 1, fp) != 1) return false;
-        if(swap) SwapBytes((char *)&mult, sizeof(int), 1);
-      }
-      else {
-        if(fscanf(fp, "%d", &mult) != 1) return false;
-      }
-    }
-    double *d = _steps[step]->getData(num, true, mult);
-    if(binary) {
-      if((int)fread(d, sizeof(double), numComp * mult, fp) != numComp * mult)
-        return false;
-      if(swap) SwapBytes((char *)d, sizeof(double), numComp * mult);
+    int num, mult;
+    if(!readMSHRecordHeader(fp, binary, swap, block.hasMult, num, mult))
+      return false;
+    double *d;
+    if(deferred) {
+      sd->addEntry(num, mult);
+      tmp.resize(numComp * mult);
+      d = &tmp[0];
     }
     else {
-      for(int j = 0; j < numComp * mult; j++)
-        if(fscanf(fp, "%lf", &d[j]) != 1) return false;
+      d = sd->getData(num, true, mult);
+      if(sd->getMult(num) != mult) return false;
     }
+    if(!readMSHRecordValues(fp, binary, swap, numComp * mult, d)) return false;
     // compute min/max here to avoid calling finalize(true) later:
     // this would be very slow for large multi-step, multi-partition
     // datasets (since we would recompute the min/max for all the
@@ -151,15 +298,19 @@ bool PViewDataGModel::readMSH(const std::string &viewName,
     // elements many times)
     for(int j = 0; j < mult; j++) {
       double val = ComputeScalarRep(numComp, &d[numComp * j]);
-      _steps[step]->setMin(std::min(_steps[step]->getMin(), val));
-      _steps[step]->setMax(std::max(_steps[step]->getMax(), val));
+      sd->setMin(std::min(sd->getMin(), val));
+      sd->setMax(std::max(sd->getMax(), val));
       _min = std::min(_min, val);
       _max = std::max(_max, val);
     }
     if(numEnt > 100000) Msg::ProgressMeter(i + 1, numEnt, true, "Reading data");
   }
 
-  if(partition >= 0) _steps[step]->getPartitions().insert(partition);
+  if(partition >= 0) sd->getPartitions().insert(partition);
+  sd->setModified(modified);
+
+  // steps with the same entities share their index
+  if(step > 0) sd->shareIndex(*_steps[step - 1]);
 
   finalize(false, interpolationScheme);
   return true;
@@ -248,9 +399,10 @@ bool PViewDataGModel::writeMSH(const std::string &fileName, double version,
   }
 
   for(std::size_t step = 0; step < _steps.size(); step++) {
-    int numEnt = 0, numComp = _steps[step]->getNumComponents();
-    for(std::size_t i = 0; i < _steps[step]->getNumData(); i++)
-      if(_steps[step]->getData(i)) numEnt++;
+    int numComp = _steps[step]->getNumComponents();
+    std::vector<int> tags;
+    _steps[step]->getTags(tags);
+    int numEnt = tags.size();
     if(numEnt) {
       if(_type == NodeData) {
         fprintf(fp, "$NodeData\n");
@@ -261,25 +413,24 @@ bool PViewDataGModel::writeMSH(const std::string &fileName, double version,
                   partitionNum);
         else
           fprintf(fp, "3\n%lu\n%d\n%d\n", step, numComp, numEnt);
-        for(std::size_t i = 0; i < _steps[step]->getNumData(); i++) {
-          if(_steps[step]->getData(i)) {
-            MVertex *v = _steps[step]->getModel()->getMeshVertexByTag(i);
-            if(!v) {
-              Msg::Error("Unknown vertex %d in data", i);
-              fclose(fp);
-              return false;
-            }
-            int num = version >= 3.0 ? v->getNum() : v->getIndex();
-            if(binary) {
-              fwrite(&num, sizeof(int), 1, fp);
-              fwrite(_steps[step]->getData(i), sizeof(double), numComp, fp);
-            }
-            else {
-              fprintf(fp, "%d", num);
-              for(int k = 0; k < numComp; k++)
-                fprintf(fp, " %.16g", _steps[step]->getData(i)[k]);
-              fprintf(fp, "\n");
-            }
+        for(std::size_t j = 0; j < tags.size(); j++) {
+          const int i = tags[j];
+          MVertex *v = _steps[step]->getModel()->getMeshVertexByTag(i);
+          if(!v) {
+            Msg::Error("Unknown vertex %d in data", i);
+            fclose(fp);
+            return false;
+          }
+          int num = version >= 3.0 ? v->getNum() : v->getIndex();
+          if(binary) {
+            fwrite(&num, sizeof(int), 1, fp);
+            fwrite(_steps[step]->getData(i), sizeof(double), numComp, fp);
+          }
+          else {
+            fprintf(fp, "%d", num);
+            for(int k = 0; k < numComp; k++)
+              fprintf(fp, " %.16g", _steps[step]->getData(i)[k]);
+            fprintf(fp, "\n");
           }
         }
         if(binary) fprintf(fp, "\n");
@@ -302,29 +453,28 @@ bool PViewDataGModel::writeMSH(const std::string &fileName, double version,
                   partitionNum);
         else
           fprintf(fp, "3\n%lu\n%d\n%d\n", step, numComp, numEnt);
-        for(std::size_t i = 0; i < _steps[step]->getNumData(); i++) {
-          if(_steps[step]->getData(i)) {
-            MElement *e = model->getMeshElementByTag(i);
-            if(!e) {
-              Msg::Error("Unknown element %d in data", i);
-              fclose(fp);
-              return false;
-            }
-            int mult = _steps[step]->getMult(i);
-            int num = model->getMeshElementIndex(e);
-            if(binary) {
-              fwrite(&num, sizeof(int), 1, fp);
-              if(_type == ElementNodeData) fwrite(&mult, sizeof(int), 1, fp);
-              fwrite(_steps[step]->getData(i), sizeof(double), numComp * mult,
-                     fp);
-            }
-            else {
-              fprintf(fp, "%d", num);
-              if(_type == ElementNodeData) fprintf(fp, " %d", mult);
-              for(int k = 0; k < numComp * mult; k++)
-                fprintf(fp, " %.16g", _steps[step]->getData(i)[k]);
-              fprintf(fp, "\n");
-            }
+        for(std::size_t j = 0; j < tags.size(); j++) {
+          const int i = tags[j];
+          MElement *e = model->getMeshElementByTag(i);
+          if(!e) {
+            Msg::Error("Unknown element %d in data", i);
+            fclose(fp);
+            return false;
+          }
+          int mult = _steps[step]->getMult(i);
+          int num = model->getMeshElementIndex(e);
+          if(binary) {
+            fwrite(&num, sizeof(int), 1, fp);
+            if(_type == ElementNodeData) fwrite(&mult, sizeof(int), 1, fp);
+            fwrite(_steps[step]->getData(i), sizeof(double), numComp * mult,
+                   fp);
+          }
+          else {
+            fprintf(fp, "%d", num);
+            if(_type == ElementNodeData) fprintf(fp, " %d", mult);
+            for(int k = 0; k < numComp * mult; k++)
+              fprintf(fp, " %.16g", _steps[step]->getData(i)[k]);
+            fprintf(fp, "\n");
           }
         }
         if(binary) fprintf(fp, "\n");
@@ -926,16 +1076,17 @@ bool PViewDataGModel::writeMED(const std::string &fileName)
   // compute profile
   char *profileName = (char *)"nodeProfile";
   std::vector<med_int> profile, indices;
-  for(std::size_t i = 0; i < _steps[0]->getNumData(); i++) {
-    if(_steps[0]->getData(i)) {
-      MVertex *v = _steps[0]->getModel()->getMeshVertexByTag(i);
-      if(!v) {
-        Msg::Error("Unknown vertex %d in data", i);
-        return false;
-      }
-      profile.push_back(v->getIndex());
-      indices.push_back(i);
+  std::vector<int> tags;
+  _steps[0]->getTags(tags);
+  for(std::size_t j = 0; j < tags.size(); j++) {
+    const int i = tags[j];
+    MVertex *v = _steps[0]->getModel()->getMeshVertexByTag(i);
+    if(!v) {
+      Msg::Error("Unknown vertex %d in data", i);
+      return false;
     }
+    profile.push_back(v->getIndex());
+    indices.push_back(i);
   }
 
   if(profile.empty()) {
@@ -980,9 +1131,7 @@ bool PViewDataGModel::writeMED(const std::string &fileName)
     return false;
   }
   for(std::size_t step = 0; step < _steps.size(); step++) {
-    std::size_t n = 0;
-    for(std::size_t i = 0; i < _steps[step]->getNumData(); i++)
-      if(_steps[step]->getData(i)) n++;
+    std::size_t n = _steps[step]->getNumEntries();
     if(n != profile.size() || numComp != _steps[step]->getNumComponents()) {
       Msg::Error("Skipping incompatible step");
       continue;
@@ -1048,9 +1197,7 @@ void PViewDataGModel::sendToServer(const std::string &name)
   int numEnt = 0, numComp = 0;
   for(std::size_t step = 0; step < _steps.size(); step++) {
     int nc = _steps[step]->getNumComponents();
-    int ne = 0;
-    for(std::size_t i = 0; i < _steps[step]->getNumData(); i++)
-      if(_steps[step]->getData(i)) ne++;
+    int ne = _steps[step]->getNumEntries();
     if(!step){
       numEnt = ne;
       numComp = nc;
@@ -1066,20 +1213,21 @@ void PViewDataGModel::sendToServer(const std::string &name)
   std::vector<double> exp;
   exp.push_back(numEnt);
 
-  for(std::size_t i = 0; i < _steps[0]->getNumData(); i++) {
-    if(_steps[0]->getData(i)) {
-      MVertex *v = _steps[0]->getModel()->getMeshVertexByTag(i);
-      if(!v) {
-        Msg::Error("Unknown vertex %d in data", i);
-        return;
-      }
-      int num = v->getNum();
-      exp.push_back(num);
-      for(std::size_t step = 0; step < _steps.size(); step++){
-        for(int k = 0; k < numComp; k++){
-          double data = _steps[step]->getData(i)[k];
-          exp.push_back(data);
-        }
+  std::vector<int> tags;
+  _steps[0]->getTags(tags);
+  for(std::size_t j = 0; j < tags.size(); j++) {
+    const int i = tags[j];
+    MVertex *v = _steps[0]->getModel()->getMeshVertexByTag(i);
+    if(!v) {
+      Msg::Error("Unknown vertex %d in data", i);
+      return;
+    }
+    int num = v->getNum();
+    exp.push_back(num);
+    for(std::size_t step = 0; step < _steps.size(); step++){
+      for(int k = 0; k < numComp; k++){
+        double data = _steps[step]->getData(i)[k];
+        exp.push_back(data);
       }
     }
   }
@@ -81,7 +81,8 @@ bool PView::readPOS(const std::string &fileName, int fileIndex)
   return true;
 }
 
-bool PView::readMSH(const std::string &fileName, int fileIndex, int partitionToRead)
+bool PView::readMSH(const std::string &fileName, int fileIndex,
+                    int partitionToRead, bool lazy)
 {
   FILE *fp = Fopen(fileName.c_str(), "rb");
   if(!fp) {
@@ -287,7 +288,7 @@ bool PView::readMSH(const std::string &fileName, int fileIndex, int partitionToR
             if(create) d = new PViewDataGModel(type);
             if(!d->readMSH(viewName, fileName, fileIndex, fp, binary, swap,
                            timeStep, time, partition, numComp, numEnt,
-                           interpolationScheme)) {
+                           interpolationScheme, lazy)) {
               Msg::Error("Could not read data in msh file");
               if(create) delete d;
               fclose(fp);
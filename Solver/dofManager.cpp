@@ -11,6 +11,48 @@
 
 #include <dofManager.h>
 
+void DofHashTable::_rehash(std::size_t numSlots)
+{
+  std::vector<entry> old;
+  old.swap(_entries);
+  entry e = {0, 0, _empty};
+  _entries.resize(numSlots, e);
+  _size = 0;
+  for(std::size_t i = 0; i < old.size(); i++) {
+    if(old[i].value != _empty)
+      insert(Dof(old[i].entity, old[i].type), old[i].value);
+  }
+}
+
+void DofHashTable::reserve(std::size_t n)
+{
+  // keep the load factor below 1/2, so that probe sequences remain short
+  std::size_t numSlots = 16;
+  while(numSlots < 2 * n) numSlots *= 2;
+  if(numSlots > _entries.size()) _rehash(numSlots);
+}
+
+void DofHashTable::insert(const Dof &key, int value)
+{
+  if(2 * (_size + 1) > _entries.size()) reserve(_size + 1);
+  const std::size_t mask = _entries.size() - 1;
+  for(std::size_t i = _slot(key.getEntity(), key.getType());;
+      i = (i + 1) & mask) {
+    entry &e = _entries[i];
+    if(e.value == _empty) {
+      e.entity = key.getEntity();
+      e.type = key.getType();
+      e.value = value;
+      _size++;
+      return;
+    }
+    if(e.entity == key.getEntity() && e.type == key.getType()) {
+      e.value = value;
+      return;
+    }
+  }
+}
+
 template <> void dofManager<double>::scatterSolution()
 {
 #ifdef HAVE_MPI
@@ -11,6 +11,7 @@
 #include <complex>
 #include <map>
 #include <list>
+#include <climits>
 #include <iostream>
 #include "MVertex.h"
 #include "linearSystem.h"
@@ -47,6 +48,53 @@ public:
   }
 };
 
+// Open addressing hash table associating an integer to each Dof, so that the
+// Dofs of the elements can be resolved in constant time during assembly
+class DofHashTable {
+private:
+  struct entry {
+    long int entity;
+    int type;
+    int value;
+  };
+  static const int _empty = INT_MIN; // value of the free slots
+  std::vector<entry> _entries; // the number of slots is a power of 2
+  std::size_t _size;
+  std::size_t _slot(long int entity, int type) const
+  {
+    std::size_t h =
+      (std::size_t)entity * 2654435761u + (std::size_t)type * 40503u;
+    return (h ^ (h >> 15)) & (_entries.size() - 1);
+  }
+  void _rehash(std::size_t numSlots);
+
+public:
+  DofHashTable() : _size(0) {}
+  std::size_t size() const { return _size; }
+  void clear()
+  {
+    _entries.clear();
+    _size = 0;
+  }
+  // prepare the table for n entries, without rehashing later on
+  void reserve(std::size_t n);
+  // associate value to key, replacing its current value if any
+  void insert(const Dof &key, int value);
+  // return the value associated to key, or notFound if there is none
+  int find(const Dof &key, int notFound = -1) const
+  {
+    if(_entries.empty()) return notFound;
+    const std::size_t mask = _entries.size() - 1;
+    for(std::size_t i = _slot(key.getEntity(), key.getType());;
+        i = (i + 1) & mask) {
+      const entry &e = _entries[i];
+      if(e.value == _empty) return notFound;
+      if(e.entity == key.getEntity() && e.type == key.getType())
+        return e.value;
+    }
+  }
+};
+
 template <class T> struct dofTraits {
   typedef T VecType;
   typedef T MatType;
@@ -134,17 +182,59 @@ protected:
 
   std::map<Dof, T> ghostValue;
 
+  // index of the unknown and fixed Dofs used during assembly, built when the
+  // assembly starts (once the Dofs are numbered) and kept up to date
+  // afterwards: an unknown is associated to its number, and a fixed Dof to
+  // -2 - i, where i is the position of its value in _fixedValues
+  DofHashTable _dofIndex;
+  std::vector<const dataVec *> _fixedValues;
+  bool _dofIndexBuilt;
+  void _indexFixedDof(const Dof &key, const dataVec &value)
+  {
+    _dofIndex.insert(key, -2 - (int)_fixedValues.size());
+    _fixedValues.push_back(&value);
+  }
+  void _buildDofIndex()
+  {
+    _dofIndex.clear();
+    _fixedValues.clear();
+    _dofIndex.reserve(unknown.size() + fixed.size());
+    for(std::map<Dof, int>::iterator it = unknown.begin(); it != unknown.end();
+        ++it)
+      _dofIndex.insert(it->first, it->second);
+    for(typename std::map<Dof, dataVec>::iterator it = fixed.begin();
+        it != fixed.end(); ++it)
+      _indexFixedDof(it->first, it->second);
+    _dofIndexBuilt = true;
+  }
+  void _prepareAssembly()
+  {
+    if(_isParallel && !_parallelFinalized) _parallelFinalize();
+    if(!_current->isAllocated()) _current->allocate(sizeOfR());
+    if(!_dofIndexBuilt) _buildDofIndex();
+  }
+  const dataVec &_fixedValue(int index) const
+  {
+    return *_fixedValues[-2 - index];
+  }
+  // resolve the Dofs of an element once, before assembling its contributions
+  void _getDofIndices(const std::vector<Dof> &R, std::vector<int> &NR) const
+  {
+    NR.resize(R.size());
+    for(std::size_t i = 0; i < R.size(); i++) NR[i] = _dofIndex.find(R[i]);
+  }
+
 public:
   void scatterSolution();
 
 public:
   dofManager(linearSystem<dataMat> *l, bool isParallel = false)
-    : dofManagerBase(isParallel), _current(l)
+    : dofManagerBase(isParallel), _current(l), _dofIndexBuilt(false)
   {
     _linearSystems["A"] = l;
   }
   dofManager(linearSystem<dataMat> *l1, linearSystem<dataMat> *l2)
-    : dofManagerBase(false), _current(l1)
+    : dofManagerBase(false), _current(l1), _dofIndexBuilt(false)
   {
     _linearSystems.insert(std::make_pair("A", l1));
     _linearSystems.insert(std::make_pair("B", l2));
@@ -153,7 +243,10 @@ public:
   virtual inline void fixDof(Dof key, const dataVec &value)
   {
     if(unknown.find(key) != unknown.end()) return;
-    fixed[key] = value;
+    const std::size_t n = fixed.size();
+    dataVec &v = fixed[key];
+    v = value;
+    if(_dofIndexBuilt && fixed.size() != n) _indexFixedDof(key, v);
   }
   inline void fixDof(long int ent, int type, const dataVec &value)
   {
@@ -212,6 +305,7 @@ public:
     if(it == unknown.end()) {
       std::size_t size = unknown.size();
       unknown[key] = size;
+      if(_dofIndexBuilt) _dofIndex.insert(key, size);
     }
   }
   virtual inline void numberDof(const std::vector<Dof> &R)
@@ -334,102 +428,124 @@ public:
 
   virtual inline void insertInSparsityPattern(const Dof &R, const Dof &C)
   {
-    if(_isParallel && !_parallelFinalized) _parallelFinalize();
-    if(!_current->isAllocated()) _current->allocate(sizeOfR());
-    std::map<Dof, int>::iterator itR = unknown.find(R);
-    if(itR != unknown.end()) {
-      std::map<Dof, int>::iterator itC = unknown.find(C);
-      if(itC != unknown.end()) {
-        _current->insertInSparsityPattern(itR->second, itC->second);
-      }
-      else {
-        typename std::map<Dof, dataVec>::iterator itFixed = fixed.find(C);
-        if(itFixed != fixed.end()) {
-        }
-        else
-          insertInSparsityPatternLinConst(R, C);
+    _prepareAssembly();
+    const int NR = _dofIndex.find(R);
+    if(NR >= 0) {
+      const int NC = _dofIndex.find(C);
+      if(NC >= 0) {
+        _current->insertInSparsityPattern(NR, NC);
       }
+      else if(NC == -1)
+        insertInSparsityPatternLinConst(R, C);
     }
-    if(itR == unknown.end()) {
+    else {
       insertInSparsityPatternLinConst(R, C);
     }
   }
 
   virtual inline void sparsityDof(const std::vector<Dof> &keys)
   {
+    _prepareAssembly();
+    std::vector<int> NR;
+    _getDofIndices(keys, NR);
     for(std::size_t itR = 0; itR < keys.size(); itR++) {
       for(std::size_t itC = 0; itC < keys.size(); itC++) {
-        insertInSparsityPattern(keys[itR], keys[itC]);
+        if(NR[itR] >= 0 && NR[itC] >= 0)
+          _current->insertInSparsityPattern(NR[itR], NR[itC]);
+        else if(NR[itR] < 0 || NR[itC] == -1)
+          insertInSparsityPatternLinConst(keys[itR], keys[itC]);
       }
     }
   }
 
+  // insert the contributions of a set of elements in the sparsity pattern, the
+  // Dofs of element e being keys[ptr[e]], ..., keys[ptr[e + 1] - 1]
+  virtual void sparsityDof(const std::vector<int> &ptr,
+                           const std::vector<Dof> &keys)
+  {
+    _prepareAssembly();
+    if(!constraints.empty()) {
+      // the constraints couple the Dofs of different elements
+      std::vector<Dof> R;
+      for(std::size_t e = 0; e + 1 < ptr.size(); e++) {
+        R.assign(keys.begin() + ptr[e], keys.begin() + ptr[e + 1]);
+        sparsityDof(R);
+      }
+      return;
+    }
+    std::vector<int> NR;
+    getDofNumbers(keys, NR);
+    _current->insertBlocksInSparsityPattern(ptr, NR);
+  }
+
+  // get the numbers of the unknowns R (-1 for the Dofs that are not unknowns)
+  void getDofNumbers(const std::vector<Dof> &R, std::vector<int> &NR)
+  {
+    _prepareAssembly();
+    _getDofIndices(R, NR);
+    for(std::size_t i = 0; i < NR.size(); i++)
+      if(NR[i] < 0) NR[i] = -1;
+  }
+
+  // prepare the concurrent assembly of element contributions, and return true
+  // if assemble() can then be called concurrently for elements that do not
+  // share unknowns, provided that their contributions were inserted in the
+  // sparsity pattern beforehand
+  virtual bool prepareConcurrentAssembly()
+  {
+    _prepareAssembly();
+    if(_isParallel || !constraints.empty()) return false;
+    _current->preAllocateEntries();
+    return _current->allowsConcurrentAssembly();
+  }
+
   virtual inline void assemble(const Dof &R, const Dof &C, const dataMat &value)
   {
-    if(_isParallel && !_parallelFinalized) _parallelFinalize();
-    if(!_current->isAllocated()) _current->allocate(sizeOfR());
-    std::map<Dof, int>::iterator itR = unknown.find(R);
-    if(itR != unknown.end()) {
-      std::map<Dof, int>::iterator itC = unknown.find(C);
-      if(itC != unknown.end()) {
-        _current->addToMatrix(itR->second, itC->second, value);
+    _prepareAssembly();
+    const int NR = _dofIndex.find(R);
+    if(NR >= 0) {
+      const int NC = _dofIndex.find(C);
+      if(NC >= 0) {
+        _current->addToMatrix(NR, NC, value);
       }
-      else {
-        typename std::map<Dof, dataVec>::iterator itFixed = fixed.find(C);
-        if(itFixed != fixed.end()) {
-          // tmp = -value * itFixed->second
-          dataVec tmp(itFixed->second);
-          dofTraits<T>::gemm(tmp, value, itFixed->second, -1, 0);
-          _current->addToRightHandSide(itR->second, tmp);
-        }
-        else
-          assembleLinConst(R, C, value);
+      else if(NC != -1) {
+        // tmp = -value * fixed value
+        const dataVec &fixedValue = _fixedValue(NC);
+        dataVec tmp(fixedValue);
+        dofTraits<T>::gemm(tmp, value, fixedValue, -1, 0);
+        _current->addToRightHandSide(NR, tmp);
       }
+      else
+        assembleLinConst(R, C, value);
     }
-    if(itR == unknown.end()) {
+    else {
       assembleLinConst(R, C, value);
     }
   }
   virtual inline void assemble(std::vector<Dof> &R, std::vector<Dof> &C,
                                const fullMatrix<dataMat> &m)
   {
-    if(_isParallel && !_parallelFinalized) _parallelFinalize();
-    if(!_current->isAllocated()) _current->allocate(sizeOfR());
+    _prepareAssembly();
 
-    std::vector<int> NR(R.size()), NC(C.size());
+    std::vector<int> NR, NC;
+    _getDofIndices(R, NR);
+    _getDofIndices(C, NC);
 
     for(std::size_t i = 0; i < R.size(); i++) {
-      std::map<Dof, int>::iterator itR = unknown.find(R[i]);
-      if(itR != unknown.end())
-        NR[i] = itR->second;
-      else
-        NR[i] = -1;
-    }
-    for(std::size_t i = 0; i < C.size(); i++) {
-      std::map<Dof, int>::iterator itC = unknown.find(C[i]);
-      if(itC != unknown.end())
-        NC[i] = itC->second;
-      else
-        NC[i] = -1;
-    }
-    for(std::size_t i = 0; i < R.size(); i++) {
-      if(NR[i] != -1) {
+      if(NR[i] >= 0) {
         for(std::size_t j = 0; j < C.size(); j++) {
-          if(NC[j] != -1) {
+          if(NC[j] >= 0) {
             _current->addToMatrix(NR[i], NC[j], m(i, j));
           }
-          else {
-            typename std::map<Dof, dataVec>::iterator itFixed =
-              fixed.find(C[j]);
-            if(itFixed != fixed.end()) {
-              // tmp = -m(i,j) * itFixed->second
-              dataVec tmp(itFixed->second);
-              dofTraits<T>::gemm(tmp, m(i, j), itFixed->second, -1, 0);
-              _current->addToRightHandSide(NR[i], tmp);
-            }
-            else
-              assembleLinConst(R[i], C[j], m(i, j));
+          else if(NC[j] != -1) {
+            // tmp = -m(i,j) * fixed value
+            const dataVec &fixedValue = _fixedValue(NC[j]);
+            dataVec tmp(fixedValue);
+            dofTraits<T>::gemm(tmp, m(i, j), fixedValue, -1, 0);
+            _current->addToRightHandSide(NR[i], tmp);
           }
+          else
+            assembleLinConst(R[i], C[j], m(i, j));
         }
       }
       else {
@@ -443,18 +559,11 @@ public:
   virtual inline void assemble(std::vector<Dof> &R,
                                const fullVector<dataMat> &m)
   {
-    if(_isParallel && !_parallelFinalized) _parallelFinalize();
-    if(!_current->isAllocated()) _current->allocate(sizeOfR());
-    std::vector<int> NR(R.size());
+    _prepareAssembly();
+    std::vector<int> NR;
+    _getDofIndices(R, NR);
     for(std::size_t i = 0; i < R.size(); i++) {
-      std::map<Dof, int>::iterator itR = unknown.find(R[i]);
-      if(itR != unknown.end())
-        NR[i] = itR->second;
-      else
-        NR[i] = -1;
-    }
-    for(std::size_t i = 0; i < R.size(); i++) {
-      if(NR[i] != -1) {
+      if(NR[i] >= 0) {
         _current->addToRightHandSide(NR[i], m(i));
       }
       else {
@@ -475,34 +584,24 @@ public:
   virtual inline void assemble(std::vector<Dof> &R,
                                const fullMatrix<dataMat> &m)
   {
-    if(_isParallel && !_parallelFinalized) _parallelFinalize();
-    if(!_current->isAllocated()) _current->allocate(sizeOfR());
-    std::vector<int> NR(R.size());
+    _prepareAssembly();
+    std::vector<int> NR;
+    _getDofIndices(R, NR);
     for(std::size_t i = 0; i < R.size(); i++) {
-      std::map<Dof, int>::iterator itR = unknown.find(R[i]);
-      if(itR != unknown.end())
-        NR[i] = itR->second;
-      else
-        NR[i] = -1;
-    }
-    for(std::size_t i = 0; i < R.size(); i++) {
-      if(NR[i] != -1) {
+      if(NR[i] >= 0) {
         for(std::size_t j = 0; j < R.size(); j++) {
-          if(NR[j] != -1) {
+          if(NR[j] >= 0) {
             _current->addToMatrix(NR[i], NR[j], m(i, j));
           }
-          else {
-            typename std::map<Dof, dataVec>::iterator itFixed =
-              fixed.find(R[j]);
-            if(itFixed != fixed.end()) {
-              // tmp = -m(i,j) * itFixed->second
-              dataVec tmp(itFixed->second);
-              dofTraits<T>::gemm(tmp, m(i, j), itFixed->second, -1, 0);
-              _current->addToRightHandSide(NR[i], tmp);
-            }
-            else
-              assembleLinConst(R[i], R[j], m(i, j));
+          else if(NR[j] != -1) {
+            // tmp = -m(i,j) * fixed value
+            const dataVec &fixedValue = _fixedValue(NR[j]);
+            dataVec tmp(fixedValue);
+            dofTraits<T>::gemm(tmp, m(i, j), fixedValue, -1, 0);
+            _current->addToRightHandSide(NR[i], tmp);
           }
+          else
+            assembleLinConst(R[i], R[j], m(i, j));
         }
       }
       else {
@@ -525,11 +624,10 @@ public:
   }
   virtual inline void assemble(const Dof &R, const dataMat &value)
   {
-    if(_isParallel && !_parallelFinalized) _parallelFinalize();
-    if(!_current->isAllocated()) _current->allocate(sizeOfR());
-    std::map<Dof, int>::iterator itR = unknown.find(R);
-    if(itR != unknown.end()) {
-      _current->addToRightHandSide(itR->second, value);
+    _prepareAssembly();
+    const int NR = _dofIndex.find(R);
+    if(NR >= 0) {
+      _current->addToRightHandSide(NR, value);
     }
     else {
       typename std::map<Dof, DofAffineConstraint<dataVec> >::iterator
@@ -658,6 +756,10 @@ public:
 
   virtual int getDofNumber(const Dof &key)
   {
+    if(_dofIndexBuilt) {
+      const int n = _dofIndex.find(key);
+      return n >= 0 ? n : -1;
+    }
     std::map<Dof, int>::iterator it = unknown.find(key);
     if(it == unknown.end()) {
       return -1;
@@ -119,11 +119,15 @@ void elasticitySolver::solve()
 
 #if defined(HAVE_PETSC)
   linearSystemPETSc<double> *lsys = new linearSystemPETSc<double>;
-#elif defined(HAVE_GMM)
+#elif defined(HAVE_GMM) && !defined(_OPENMP)
   linearSystemGmm<double> *lsys = new linearSystemGmm<double>;
   lsys->setNoisy(2);
 #else
-  linearSystemFull<double> *lsys = new linearSystemFull<double>;
+  linearSystemCSRKrylov<double> *lsys = new linearSystemCSRKrylov<double>;
+  lsys->setNoisy(1);
+  // the Lagrange multipliers make the system indefinite
+  if(!LagrangeMultiplierFields.empty())
+    lsys->setMethod(linearSystemCSRKrylov<double>::GMRES);
 #endif
 
   assemble(lsys);
@@ -542,6 +546,20 @@ void elasticitySolver::assemble(linearSystem<double> *lsys)
     Assemble(Lterm, *LagSpace, allNeumann[i].g->begin(), allNeumann[i].g->end(),
              Integ_Boundary, *pAssembler);
   }
+  // Sparsity pattern of the bilinear terms, inserted before assembling them
+  for(std::size_t i = 0; i < LagrangeMultiplierFields.size(); i++) {
+    std::size_t j = 0;
+    for(; j < LagrangeMultiplierSpaces.size(); j++)
+      if(LagrangeMultiplierSpaces[j]->getId() ==
+         LagrangeMultiplierFields[i]._tag)
+        break;
+    SparsityDofs(*LagSpace, *(LagrangeMultiplierSpaces[j]),
+                 LagrangeMultiplierFields[i].g->begin(),
+                 LagrangeMultiplierFields[i].g->end(), *pAssembler);
+  }
+  for(std::size_t i = 0; i < elasticFields.size(); i++)
+    SparsityDofs(*LagSpace, elasticFields[i].g->begin(),
+                 elasticFields[i].g->end(), *pAssembler);
   // Assemble cross term, laplace term and rhs term for LM
   GaussQuadrature Integ_LagrangeMult(GaussQuadrature::ValVal);
   GaussQuadrature Integ_Laplace(GaussQuadrature::GradGrad);
@@ -581,7 +599,8 @@ void elasticitySolver::assemble(linearSystem<double> *lsys)
     IsotropicElasticTerm Eterm(*LagSpace, elasticFields[i]._E,
                                elasticFields[i]._nu);
     Assemble(Eterm, *LagSpace, elasticFields[i].g->begin(),
-             elasticFields[i].g->end(), Integ_Bulk, *pAssembler);
+             elasticFields[i].g->end(), Integ_Bulk, *pAssembler,
+             Msg::GetMaxThreads());
   }
 
   printf("nDofs=%d\n", pAssembler->sizeOfR());
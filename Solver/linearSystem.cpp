@@ -14,6 +14,18 @@ void linearSystemBase::setParameter(std::string key, std::string value)
   _parameters[key] = value;
 }
 
+void linearSystemBase::insertBlocksInSparsityPattern(
+  const std::vector<int> &ptr, const std::vector<int> &idx)
+{
+  for(std::size_t e = 0; e + 1 < ptr.size(); e++) {
+    for(int i = ptr[e]; i < ptr[e + 1]; i++) {
+      if(idx[i] < 0) continue;
+      for(int j = ptr[e]; j < ptr[e + 1]; j++)
+        if(idx[j] >= 0) insertInSparsityPattern(idx[i], idx[j]);
+    }
+  }
+}
+
 std::string linearSystemBase::getParameter(std::string key) const
 {
   std::map<std::string, std::string>::const_iterator it;
@@ -8,6 +8,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 // A class that encapsulates a linear system solver interface :
 // building a sparse matrix, solving a linear system
@@ -31,6 +32,15 @@ public:
   void setParameter(std::string key, std::string value);
   std::string getParameter(std::string key) const;
   virtual void insertInSparsityPattern(int _row, int _col){};
+  // insert the dense blocks formed by the indices of a set of elements, the
+  // indices of element e being idx[ptr[e]], ..., idx[ptr[e + 1] - 1] (negative
+  // indices are skipped)
+  virtual void insertBlocksInSparsityPattern(const std::vector<int> &ptr,
+                                             const std::vector<int> &idx);
+  // return true if the matrix and right hand side entries of different rows
+  // can be assembled concurrently, for entries inserted in the sparsity
+  // pattern before preAllocateEntries() was called
+  virtual bool allowsConcurrentAssembly() const { return false; }
   virtual double normInfRightHandSide() const = 0;
   virtual double normInfSolution() const { return 0; };
 };
@@ -6,7 +6,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include <complex>
+#include <vector>
+#include <algorithm>
 #include "GmshConfig.h"
 #include "GmshMessage.h"
 #include "linearSystemCSR.h"
@@ -463,3 +466,414 @@ template <> int linearSystemCSRGmm<double>::systemSolve()
 }
 
 #endif
+
+// Built-in Krylov solvers
+
+// size of the chunks of the reductions, fixed so that their result does not
+// depend on the number of threads
+static const int reductionChunk = 4096;
+
+static double dot(const std::vector<double> &x, const std::vector<double> &y)
+{
+  const int n = x.size();
+  const int nc = (n + reductionChunk - 1) / reductionChunk;
+  std::vector<double> s(nc);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for(int c = 0; c < nc; c++) {
+    const int end = std::min(n, (c + 1) * reductionChunk);
+    double sc = 0.;
+    for(int i = c * reductionChunk; i < end; i++) sc += x[i] * y[i];
+    s[c] = sc;
+  }
+  double sum = 0.;
+  for(int c = 0; c < nc; c++) sum += s[c];
+  return sum;
+}
+
+static double norm(const std::vector<double> &x) { return sqrt(dot(x, x)); }
+
+// y = a * x + b * y
+static void axpby(double a, const std::vector<double> &x, double b,
+                  std::vector<double> &y)
+{
+  const int n = x.size();
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for(int i = 0; i < n; i++) y[i] = a * x[i] + b * y[i];
+}
+
+class csrMatrix {
+public:
+  int n;
+  const INDEX_TYPE *jptr, *ai;
+  const double *a;
+  csrMatrix(int n_, const INDEX_TYPE *jptr_, const INDEX_TYPE *ai_,
+            const double *a_)
+    : n(n_), jptr(jptr_), ai(ai_), a(a_)
+  {
+  }
+  // y = A * x
+  void mult(const std::vector<double> &x, std::vector<double> &y) const
+  {
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 256)
+#endif
+    for(int i = 0; i < n; i++) {
+      double s = 0.;
+      for(INDEX_TYPE k = jptr[i]; k < jptr[i + 1]; k++) s += a[k] * x[ai[k]];
+      y[i] = s;
+    }
+  }
+  // r = b - A * x
+  void residual(const std::vector<double> &b, const std::vector<double> &x,
+                std::vector<double> &r) const
+  {
+    mult(x, r);
+    axpby(1., b, -1., r);
+  }
+};
+
+// Jacobi, block-Jacobi ILU(0) or block SSOR preconditioner; the blocks are
+// ranges of consecutive rows, and the couplings between the blocks are ignored
+// so that the blocks are factored and solved independently
+class csrPreconditioner {
+private:
+  const csrMatrix &_A;
+  int _type;
+  double _omega;
+  std::vector<int> _blocks;
+  std::vector<INDEX_TYPE> _diag; // position of the diagonal entry of the rows
+  std::vector<double> _lu;
+  bool _setup(int nbBlocks)
+  {
+    const int n = _A.n;
+    _diag.resize(n);
+    for(int i = 0; i < n; i++) {
+      _diag[i] = -1;
+      for(INDEX_TYPE k = _A.jptr[i]; k < _A.jptr[i + 1]; k++) {
+        if(_A.ai[k] == i && _A.a[k] != 0.) _diag[i] = k;
+      }
+      if(_diag[i] < 0) return false;
+    }
+    nbBlocks = std::max(1, std::min(nbBlocks, n));
+    _blocks.resize(nbBlocks + 1);
+    for(int k = 0; k <= nbBlocks; k++)
+      _blocks[k] = (int)(((long int)n * k) / nbBlocks);
+    if(_type != linearSystemCSRKrylov<double>::BLOCK_ILU0) return true;
+    _lu.assign(_A.a, _A.a + _A.jptr[n]);
+    bool ok = true;
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) reduction(&& : ok)
+#endif
+    for(int k = 0; k < nbBlocks; k++) {
+      std::vector<INDEX_TYPE> pos(_blocks[k + 1] - _blocks[k], -1);
+      if(!_factorBlock(_blocks[k], _blocks[k + 1], pos)) ok = false;
+    }
+    return ok;
+  }
+  bool _factorBlock(int b, int e, std::vector<INDEX_TYPE> &pos)
+  {
+    // ILU(0) in place in _lu, row by row (the rows are sorted)
+    for(int i = b; i < e; i++) {
+      for(INDEX_TYPE q = _A.jptr[i]; q < _A.jptr[i + 1]; q++)
+        if(_A.ai[q] >= b && _A.ai[q] < e) pos[_A.ai[q] - b] = q;
+      for(INDEX_TYPE p = _A.jptr[i]; p < _diag[i]; p++) {
+        const int k = _A.ai[p];
+        if(k < b) continue;
+        _lu[p] /= _lu[_diag[k]];
+        for(INDEX_TYPE q = _diag[k] + 1; q < _A.jptr[k + 1]; q++) {
+          const int j = _A.ai[q];
+          if(j < e && pos[j - b] >= 0) _lu[pos[j - b]] -= _lu[p] * _lu[q];
+        }
+      }
+      for(INDEX_TYPE q = _A.jptr[i]; q < _A.jptr[i + 1]; q++)
+        if(_A.ai[q] >= b && _A.ai[q] < e) pos[_A.ai[q] - b] = -1;
+      if(_lu[_diag[i]] == 0.) return false;
+    }
+    return true;
+  }
+
+public:
+  csrPreconditioner(const csrMatrix &A, int type, double omega)
+    : _A(A), _type(type), _omega(omega)
+  {
+  }
+  // return false if the preconditioner cannot be built (zero pivot), in which
+  // case it is replaced by the identity
+  bool setup(int nbBlocks)
+  {
+    if(_type == linearSystemCSRKrylov<double>::NONE) return true;
+    if(!_setup(nbBlocks)) {
+      _type = linearSystemCSRKrylov<double>::NONE;
+      return false;
+    }
+    return true;
+  }
+  // z = M^-1 r
+  void apply(const std::vector<double> &r, std::vector<double> &z) const
+  {
+    const int n = _A.n;
+    const INDEX_TYPE *jptr = _A.jptr, *ai = _A.ai;
+    if(_type == linearSystemCSRKrylov<double>::NONE) {
+      z = r;
+      return;
+    }
+    if(_type == linearSystemCSRKrylov<double>::JACOBI) {
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+      for(int i = 0; i < n; i++) z[i] = r[i] / _A.a[_diag[i]];
+      return;
+    }
+    const int nbBlocks = (int)_blocks.size() - 1;
+    if(_type == linearSystemCSRKrylov<double>::BLOCK_ILU0) {
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for(int k = 0; k < nbBlocks; k++) {
+        const int b = _blocks[k], e = _blocks[k + 1];
+        for(int i = b; i < e; i++) {
+          double s = r[i];
+          for(INDEX_TYPE p = jptr[i]; p < _diag[i]; p++)
+            if(ai[p] >= b) s -= _lu[p] * z[ai[p]];
+          z[i] = s;
+        }
+        for(int i = e - 1; i >= b; i--) {
+          double s = z[i];
+          for(INDEX_TYPE p = _diag[i] + 1; p < jptr[i + 1]; p++)
+            if(ai[p] < e) s -= _lu[p] * z[ai[p]];
+          z[i] = s / _lu[_diag[i]];
+        }
+      }
+      return;
+    }
+    // SSOR: M = (D + w L) D^-1 (D + w U) / (w (2 - w))
+    const double *a = _A.a, w = _omega;
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int k = 0; k < nbBlocks; k++) {
+      const int b = _blocks[k], e = _blocks[k + 1];
+      for(int i = b; i < e; i++) {
+        double s = r[i];
+        for(INDEX_TYPE p = jptr[i]; p < _diag[i]; p++)
+          if(ai[p] >= b) s -= w * a[p] * z[ai[p]];
+        z[i] = s / a[_diag[i]];
+      }
+      for(int i = b; i < e; i++) z[i] *= a[_diag[i]];
+      for(int i = e - 1; i >= b; i--) {
+        double s = z[i];
+        for(INDEX_TYPE p = _diag[i] + 1; p < jptr[i + 1]; p++)
+          if(ai[p] < e) s -= w * a[p] * z[ai[p]];
+        z[i] = s / a[_diag[i]];
+      }
+      for(int i = b; i < e; i++) z[i] *= w * (2. - w);
+    }
+  }
+};
+
+static bool converged(const char *name, int it, double res, double tol,
+                      int noisy)
+{
+  if(noisy > 1) Msg::Info("%s iteration %d: residual %g", name, it, res);
+  return res <= tol;
+}
+
+static int solveCG(const csrMatrix &A, const csrPreconditioner &M,
+                   const std::vector<double> &b, std::vector<double> &x,
+                   double bnorm, double tol, int maxIter, int noisy,
+                   int &iter, double &res)
+{
+  const int n = A.n;
+  std::vector<double> r(n), z(n), p(n), q(n);
+  A.residual(b, x, r);
+  res = norm(r) / bnorm;
+  if(converged("CG", 0, res, tol, noisy)) return 1;
+  M.apply(r, z);
+  p = z;
+  double rz = dot(r, z);
+  for(iter = 1; iter <= maxIter; iter++) {
+    A.mult(p, q);
+    const double pq = dot(p, q);
+    if(pq == 0.) return 0;
+    const double alpha = rz / pq;
+    axpby(alpha, p, 1., x);
+    axpby(-alpha, q, 1., r);
+    res = norm(r) / bnorm;
+    if(converged("CG", iter, res, tol, noisy)) return 1;
+    M.apply(r, z);
+    const double rzNew = dot(r, z);
+    axpby(1., z, rzNew / rz, p);
+    rz = rzNew;
+  }
+  iter = maxIter;
+  return 0;
+}
+
+// with right preconditioning, so that the residual is the true residual
+static int solveBiCGStab(const csrMatrix &A, const csrPreconditioner &M,
+                         const std::vector<double> &b, std::vector<double> &x,
+                         double bnorm, double tol, int maxIter, int noisy,
+                         int &iter, double &res)
+{
+  const int n = A.n;
+  std::vector<double> r(n), rhat(n), p(n, 0.), v(n, 0.), phat(n), s(n),
+    shat(n), t(n);
+  A.residual(b, x, r);
+  res = norm(r) / bnorm;
+  if(converged("BiCGStab", 0, res, tol, noisy)) return 1;
+  rhat = r;
+  double rho = 1., alpha = 1., omega = 1.;
+  for(iter = 1; iter <= maxIter; iter++) {
+    const double rhoNew = dot(rhat, r);
+    if(rhoNew == 0. || omega == 0.) return 0; // breakdown
+    const double beta = (rhoNew / rho) * (alpha / omega);
+    axpby(-omega, v, 1., p);
+    axpby(1., r, beta, p);
+    M.apply(p, phat);
+    A.mult(phat, v);
+    const double rv = dot(rhat, v);
+    if(rv == 0.) return 0;
+    alpha = rhoNew / rv;
+    s = r;
+    axpby(-alpha, v, 1., s);
+    res = norm(s) / bnorm;
+    if(res <= tol) {
+      axpby(alpha, phat, 1., x);
+      converged("BiCGStab", iter, res, tol, noisy);
+      return 1;
+    }
+    M.apply(s, shat);
+    A.mult(shat, t);
+    const double tt = dot(t, t);
+    omega = (tt == 0.) ? 0. : dot(t, s) / tt;
+    axpby(alpha, phat, 1., x);
+    axpby(omega, shat, 1., x);
+    r = s;
+    axpby(-omega, t, 1., r);
+    res = norm(r) / bnorm;
+    if(converged("BiCGStab", iter, res, tol, noisy)) return 1;
+    rho = rhoNew;
+  }
+  iter = maxIter;
+  return 0;
+}
+
+// restarted GMRES with right preconditioning, modified Gram-Schmidt and Givens
+// rotations
+static int solveGMRES(const csrMatrix &A, const csrPreconditioner &M,
+                      const std::vector<double> &b, std::vector<double> &x,
+                      double bnorm, double tol, int maxIter, int restart,
+                      int noisy, int &iter, double &res)
+{
+  const int n = A.n, m = std::max(1, restart);
+  std::vector<std::vector<double> > V(m + 1, std::vector<double>(n));
+  std::vector<std::vector<double> > H(m + 1, std::vector<double>(m, 0.));
+  std::vector<double> cs(m), sn(m), g(m + 1), y(m), z(n), w(n);
+  iter = 0;
+  while(true) {
+    A.residual(b, x, V[0]);
+    const double beta = norm(V[0]);
+    res = beta / bnorm;
+    if(converged("GMRES", iter, res, tol, noisy)) return 1;
+    if(iter >= maxIter) return 0;
+    axpby(0., V[0], 1. / beta, V[0]);
+    std::fill(g.begin(), g.end(), 0.);
+    g[0] = beta;
+    int j = 0;
+    while(j < m && iter < maxIter) {
+      M.apply(V[j], z);
+      A.mult(z, w);
+      for(int i = 0; i <= j; i++) {
+        H[i][j] = dot(w, V[i]);
+        axpby(-H[i][j], V[i], 1., w);
+      }
+      H[j + 1][j] = norm(w);
+      if(H[j + 1][j] != 0.) axpby(1. / H[j + 1][j], w, 0., V[j + 1]);
+      for(int i = 0; i < j; i++) {
+        const double h = cs[i] * H[i][j] + sn[i] * H[i + 1][j];
+        H[i + 1][j] = -sn[i] * H[i][j] + cs[i] * H[i + 1][j];
+        H[i][j] = h;
+      }
+      const double d = sqrt(H[j][j] * H[j][j] + H[j + 1][j] * H[j + 1][j]);
+      cs[j] = (d == 0.) ? 1. : H[j][j] / d;
+      sn[j] = (d == 0.) ? 0. : H[j + 1][j] / d;
+      H[j][j] = d;
+      H[j + 1][j] = 0.;
+      g[j + 1] = -sn[j] * g[j];
+      g[j] *= cs[j];
+      iter++;
+      j++;
+      res = fabs(g[j]) / bnorm;
+      if(noisy > 1) Msg::Info("GMRES iteration %d: residual %g", iter, res);
+      if(res <= tol || d == 0.) break;
+    }
+    // x += M^-1 V y, with H y = g
+    for(int i = j - 1; i >= 0; i--) {
+      double s = g[i];
+      for(int k = i + 1; k < j; k++) s -= H[i][k] * y[k];
+      y[i] = (H[i][i] == 0.) ? 0. : s / H[i][i];
+    }
+    std::fill(w.begin(), w.end(), 0.);
+    for(int i = 0; i < j; i++) axpby(y[i], V[i], 1., w);
+    M.apply(w, z);
+    axpby(1., z, 1., x);
+  }
+}
+
+template <> int linearSystemCSRKrylov<double>::systemSolve()
+{
+  if(!_b || !_b->size()) return 0;
+  if(!sorted)
+    sortColumns_(_b->size(), CSRList_Nbr(_a), (INDEX_TYPE *)_ptr->array,
+                 (INDEX_TYPE *)_jptr->array, (INDEX_TYPE *)_ai->array,
+                 (double *)_a->array);
+  sorted = true;
+
+  const csrMatrix A(_b->size(), (INDEX_TYPE *)_jptr->array,
+                    (INDEX_TYPE *)_ai->array, (double *)_a->array);
+  csrPreconditioner M(A, _preconditioner, _omega);
+  if(!M.setup(_blocks))
+    Msg::Warning("Zero pivot in preconditioner: solving without it");
+
+  double t1 = Cpu(), w1 = TimeOfDay();
+  const double bnorm = norm(*_b);
+  int iter = 0, ok = 1;
+  double res = 0.;
+  if(bnorm == 0.)
+    zeroSolution();
+  else if(_method == GMRES)
+    ok = solveGMRES(A, M, *_b, *_x, bnorm, _prec, _maxIter, _restart, _noisy,
+                    iter, res);
+  else if(_method == BICGSTAB)
+    ok = solveBiCGStab(A, M, *_b, *_x, bnorm, _prec, _maxIter, _noisy, iter,
+                       res);
+  else
+    ok = solveCG(A, M, *_b, *_x, bnorm, _prec, _maxIter, _noisy, iter, res);
+  double t2 = Cpu(), w2 = TimeOfDay();
+
+  if(!ok)
+    Msg::Warning("Krylov solver did not converge: residual %g after %d "
+                 "iterations", res, iter);
+  else if(_noisy)
+    Msg::Info("Krylov solver converged in %d iterations, residual %g (Wall "
+              "%gs, CPU %gs)", iter, res, w2 - w1, t2 - t1);
+  return ok;
+}
+
+template <> int linearSystemCSRKrylov<double>::matMult()
+{
+  if(!_b || !_b->size()) return 0;
+  if(!sorted)
+    sortColumns_(_b->size(), CSRList_Nbr(_a), (INDEX_TYPE *)_ptr->array,
+                 (INDEX_TYPE *)_jptr->array, (INDEX_TYPE *)_ai->array,
+                 (double *)_a->array);
+  sorted = true;
+  const csrMatrix A(_b->size(), (INDEX_TYPE *)_jptr->array,
+                    (INDEX_TYPE *)_ai->array, (double *)_a->array);
+  A.mult(*_b, *_x);
+  return 1;
+}
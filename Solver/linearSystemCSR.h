@@ -49,6 +49,17 @@ public:
   {
     _sparsity.insertEntry(i, j);
   }
+  virtual void insertBlocksInSparsityPattern(const std::vector<int> &ptr,
+                                             const std::vector<int> &idx)
+  {
+    _sparsity.insertBlocks(ptr, idx);
+  }
+  // once the entries are preallocated, the rows are sorted and the entries of
+  // the sparsity pattern are added in place
+  virtual bool allowsConcurrentAssembly() const
+  {
+    return _entriesPreAllocated;
+  }
   virtual void preAllocateEntries();
   virtual void addToMatrix(int il, int ic, const scalar &val)
   {
@@ -193,4 +204,47 @@ public:
   ;
 };
 
+// Built-in Krylov solvers (conjugate gradient, restarted GMRES or BiCGStab)
+// operating on the CSR storage, with Jacobi, block-Jacobi ILU(0) or block SSOR
+// preconditioning. The matrix-vector products, the preconditioners and the
+// vector operations are multi-threaded; the reductions are computed by chunks
+// of fixed size, so that the iterates do not depend on the number of threads.
+template <class scalar>
+class linearSystemCSRKrylov : public linearSystemCSR<scalar> {
+public:
+  enum { CG, GMRES, BICGSTAB };
+  enum { NONE, JACOBI, BLOCK_ILU0, SSOR };
+
+private:
+  double _prec, _omega;
+  int _noisy, _method, _preconditioner, _maxIter, _restart, _blocks;
+
+public:
+  linearSystemCSRKrylov()
+    : _prec(1.e-8), _omega(1.), _noisy(0), _method(CG),
+      _preconditioner(BLOCK_ILU0), _maxIter(10000), _restart(100), _blocks(16)
+  {
+  }
+  virtual ~linearSystemCSRKrylov() {}
+  // relative tolerance on the residual
+  void setPrec(double p) { _prec = p; }
+  void setNoisy(int n) { _noisy = n; }
+  void setMethod(int m) { _method = m; }
+  void setPreconditioner(int p) { _preconditioner = p; }
+  void setMaxIterations(int n) { _maxIter = n; }
+  // number of Krylov vectors before GMRES restarts
+  void setRestart(int n) { _restart = n; }
+  // number of blocks (of consecutive unknowns) of the block-Jacobi ILU(0) and
+  // SSOR preconditioners, which are processed in parallel; the default (16)
+  // does not depend on the number of threads, so that neither does the solution
+  void setBlocks(int n) { _blocks = n; }
+  // relaxation parameter of SSOR, in ]0, 2[
+  void setOmega(double w) { _omega = w; }
+  // solve the system, using the current solution as initial guess; return 1
+  // if the solver converged
+  virtual int systemSolve();
+  // x = A * b
+  virtual int matMult();
+};
+
 #endif
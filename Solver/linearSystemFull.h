@@ -22,6 +22,11 @@ private:
 public:
   linearSystemFull() : _a(0), _b(0), _x(0) {}
   virtual bool isAllocated() const { return _a != 0; }
+  virtual void insertBlocksInSparsityPattern(const std::vector<int> &ptr,
+                                             const std::vector<int> &idx)
+  {
+  }
+  virtual bool allowsConcurrentAssembly() const { return true; }
   virtual void allocate(int nbRows)
   {
     clear();
@@ -29,6 +29,12 @@ private:
 public:
   linearSystemGmm() : _x(0), _b(0), _a(0), _prec(1.e-8), _noisy(0), _gmres(0) {}
   virtual bool isAllocated() const { return _a != 0; }
+  virtual void insertBlocksInSparsityPattern(const std::vector<int> &ptr,
+                                             const std::vector<int> &idx)
+  {
+  }
+  // each row of the matrix is stored independently
+  virtual bool allowsConcurrentAssembly() const { return true; }
   virtual void allocate(int nbRows)
   {
     clear();
@@ -10,6 +10,7 @@
 #ifndef _SOLVERALGORITHMS_H_
 #define _SOLVERALGORITHMS_H_
 
+#include <algorithm>
 #include "dofManager.h"
 #include "terms.h"
 #include "quadratureRules.h"
@@ -68,6 +69,89 @@ void Assemble(BilinearTermBase &term, FunctionSpaceBase &space, MElement *e,
   assembler.assemble(R, localMatrix);
 }
 
+// symmetric, with nbThreads threads if the assembler allows it: the elements
+// are colored so that the elements of a color do not share unknowns, and the
+// colors are assembled one after the other. The contributions of the elements
+// must have been inserted in the sparsity pattern beforehand (see
+// SparsityDofs). The assembled system does not depend on the number of threads.
+template <class Iterator, class Assembler>
+void Assemble(BilinearTermBase &term, FunctionSpaceBase &space,
+              Iterator itbegin, Iterator itend, QuadratureBase &integrator,
+              Assembler &assembler, int nbThreads)
+{
+  if(!assembler.prepareConcurrentAssembly()) {
+    Assemble(term, space, itbegin, itend, integrator, assembler);
+    return;
+  }
+
+  // get the integration points and the Dofs of the elements (the integration
+  // rules are created on demand, and are thus not queried concurrently)
+  std::vector<MElement *> elements;
+  std::vector<IntPt *> GPs;
+  std::vector<int> npts, ptr(1, 0), num;
+  std::vector<Dof> R, keys;
+  for(Iterator it = itbegin; it != itend; ++it) {
+    MElement *e = *it;
+    IntPt *GP;
+    npts.push_back(integrator.getIntPoints(e, &GP));
+    GPs.push_back(GP);
+    elements.push_back(e);
+    R.clear();
+    space.getKeys(e, R);
+    keys.insert(keys.end(), R.begin(), R.end());
+    ptr.push_back(keys.size());
+  }
+  assembler.getDofNumbers(keys, num);
+
+  // greedy coloring of the elements, by batches of 32 colors
+  const int nElements = elements.size();
+  std::vector<int> color(nElements, -1);
+  std::vector<unsigned int> used(assembler.sizeOfR());
+  int nColors = 0;
+  for(int nLeft = nElements; nLeft > 0; nColors += 32) {
+    std::fill(used.begin(), used.end(), 0u);
+    for(int e = 0; e < nElements; e++) {
+      if(color[e] >= 0) continue;
+      unsigned int mask = 0;
+      for(int k = ptr[e]; k < ptr[e + 1]; k++)
+        if(num[k] >= 0) mask |= used[num[k]];
+      if(mask == ~0u) continue;
+      int c = 0;
+      while(mask & (1u << c)) c++;
+      color[e] = nColors + c;
+      for(int k = ptr[e]; k < ptr[e + 1]; k++)
+        if(num[k] >= 0) used[num[k]] |= 1u << c;
+      nLeft--;
+    }
+  }
+  std::vector<int> colorPtr(nColors + 1, 0), order(nElements);
+  for(int e = 0; e < nElements; e++) colorPtr[color[e] + 1]++;
+  for(int c = 0; c < nColors; c++) colorPtr[c + 1] += colorPtr[c];
+  std::vector<int> pos(colorPtr.begin(), colorPtr.end() - 1);
+  for(int e = 0; e < nElements; e++) order[pos[color[e]]++] = e;
+
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(nbThreads)
+#endif
+  {
+    BilinearTermBase *t = term.clone();
+    fullMatrix<typename Assembler::dataMat> localMatrix;
+    std::vector<Dof> R;
+    for(int c = 0; c < nColors; c++) {
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic, 16)
+#endif
+      for(int i = colorPtr[c]; i < colorPtr[c + 1]; i++) {
+        const int e = order[i];
+        R.assign(keys.begin() + ptr[e], keys.begin() + ptr[e + 1]);
+        t->get(elements[e], npts[e], GPs[e], localMatrix);
+        assembler.assemble(R, localMatrix);
+      }
+    }
+    delete t;
+  }
+}
+
 template <class Iterator, class Assembler>
 void Assemble(BilinearTermBase &term, FunctionSpaceBase &shapeFcts,
               FunctionSpaceBase &testFcts, Iterator itbegin, Iterator itend,
@@ -323,6 +407,43 @@ void NumberDofs(FunctionSpaceBase &space, Iterator itbegin, Iterator itend,
   }
 }
 
+// insert the contributions of the elements in the sparsity pattern at once,
+// which should be done before assembling any of them
+template <class Iterator, class Assembler>
+void SparsityDofs(FunctionSpaceBase &space, Iterator itbegin, Iterator itend,
+                  Assembler &assembler)
+{
+  // (the function spaces reserve the exact size of the keys they append to,
+  // so that the keys of each element are first gathered separately)
+  std::vector<int> ptr(1, 0);
+  std::vector<Dof> R, keys;
+  for(Iterator it = itbegin; it != itend; ++it) {
+    R.clear();
+    space.getKeys(*it, R);
+    keys.insert(keys.end(), R.begin(), R.end());
+    ptr.push_back(keys.size());
+  }
+  assembler.sparsityDof(ptr, keys);
+}
+
+// non symmetric (the shape and test functions of an element are coupled both
+// ways)
+template <class Iterator, class Assembler>
+void SparsityDofs(FunctionSpaceBase &shapeFcts, FunctionSpaceBase &testFcts,
+                  Iterator itbegin, Iterator itend, Assembler &assembler)
+{
+  std::vector<int> ptr(1, 0);
+  std::vector<Dof> R, keys;
+  for(Iterator it = itbegin; it != itend; ++it) {
+    R.clear();
+    shapeFcts.getKeys(*it, R);
+    testFcts.getKeys(*it, R);
+    keys.insert(keys.end(), R.begin(), R.end());
+    ptr.push_back(keys.size());
+  }
+  assembler.sparsityDof(ptr, keys);
+}
+
   //// Mean HangingNodes
   // template <class Assembler> void FillHangingNodes(FunctionSpaceBase &space,
   // std::map<int,std::vector <int> > &HangingNodes, Assembler &assembler, int
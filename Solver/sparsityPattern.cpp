@@ -11,6 +11,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 
 // this class has been optimized, please before changing anything, check twice :
 // the impact on the performance to assemble typical High Order FE problems
@@ -90,6 +91,92 @@ void sparsityPattern::insertEntry(int i, int j)
   _rowsj[i][k] = j;
 }
 
+void sparsityPattern::insertBlocks(const std::vector<int> &ptr,
+                                   const std::vector<int> &idx)
+{
+  const int nBlocks = (int)ptr.size() - 1;
+  if(nBlocks <= 0) return;
+  int nRows = _nRows;
+  for(std::size_t k = 0; k < idx.size(); k++)
+    if(idx[k] >= nRows) nRows = idx[k] + 1;
+  if(nRows > _nRowsAlloc) {
+    _nRowsAlloc = nRows;
+    _rowsj = (int **)realloc(_rowsj, sizeof(int *) * _nRowsAlloc);
+    _nByRow = (int *)realloc(_nByRow, sizeof(int) * _nRowsAlloc);
+    _nAllocByRow = (int *)realloc(_nAllocByRow, sizeof(int) * _nRowsAlloc);
+  }
+  for(int i = _nRows; i < nRows; i++) {
+    _nByRow[i] = 0;
+    _nAllocByRow[i] = 0;
+    _rowsj[i] = NULL;
+  }
+  _nRows = nRows;
+
+  // first pass: count the blocks touching each row, and compute the offsets of
+  // the lists of blocks of the rows by a prefix sum
+  std::vector<int> rowBlocksPtr(nRows + 1, 0);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for(int e = 0; e < nBlocks; e++) {
+    for(int k = ptr[e]; k < ptr[e + 1]; k++) {
+      if(idx[k] < 0) continue;
+#if defined(_OPENMP)
+#pragma omp atomic
+#endif
+      rowBlocksPtr[idx[k] + 1]++;
+    }
+  }
+  for(int i = 0; i < nRows; i++) rowBlocksPtr[i + 1] += rowBlocksPtr[i];
+
+  // second pass: fill the lists of blocks
+  std::vector<int> rowBlocks(rowBlocksPtr[nRows]);
+  std::vector<int> pos(rowBlocksPtr.begin(), rowBlocksPtr.end() - 1);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for(int e = 0; e < nBlocks; e++) {
+    for(int k = ptr[e]; k < ptr[e + 1]; k++) {
+      if(idx[k] < 0) continue;
+      int p;
+#if defined(_OPENMP)
+#pragma omp atomic capture
+#endif
+      p = pos[idx[k]]++;
+      rowBlocks[p] = e;
+    }
+  }
+
+  // build the sorted rows independently, merging the existing entries
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+  {
+    std::vector<int> row;
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic, 64)
+#endif
+    for(int i = 0; i < nRows; i++) {
+      if(rowBlocksPtr[i] == rowBlocksPtr[i + 1]) continue;
+      row.assign(_rowsj[i], _rowsj[i] + _nByRow[i]);
+      for(int b = rowBlocksPtr[i]; b < rowBlocksPtr[i + 1]; b++) {
+        const int e = rowBlocks[b];
+        for(int k = ptr[e]; k < ptr[e + 1]; k++)
+          if(idx[k] >= 0) row.push_back(idx[k]);
+      }
+      std::sort(row.begin(), row.end());
+      row.erase(std::unique(row.begin(), row.end()), row.end());
+      const int n = row.size();
+      if(n > _nAllocByRow[i]) {
+        _rowsj[i] = (int *)realloc(_rowsj[i], n * sizeof(int));
+        _nAllocByRow[i] = n;
+      }
+      memcpy(_rowsj[i], &row[0], n * sizeof(int));
+      _nByRow[i] = n;
+    }
+  }
+}
+
 sparsityPattern::sparsityPattern()
 {
   _nRows = 0;
@@ -10,6 +10,8 @@
 // - the impact on the performance to assemble typical High Order FE problems
 // - the impact on the memory for this operation
 
+#include <vector>
+
 class sparsityPattern {
   int *_nByRow, *_nAllocByRow;
   int **_rowsj;
@@ -17,6 +19,11 @@ class sparsityPattern {
 
 public:
   void insertEntry(int i, int j);
+  // insert the dense blocks formed by the indices of a set of elements, the
+  // indices of element e being idx[ptr[e]], ..., idx[ptr[e + 1] - 1] (negative
+  // indices are skipped): the rows are built at once and in parallel, which is
+  // much faster than inserting the entries one by one
+  void insertBlocks(const std::vector<int> &ptr, const std::vector<int> &idx);
   const int *getRow(int line, int &size) const;
   void clear();
   sparsityPattern();
@@ -41,11 +41,15 @@ void thermicSolver::solve()
 {
 #if defined(HAVE_PETSC)
   linearSystemPETSc<double> *lsys = new linearSystemPETSc<double>;
-#elif defined(HAVE_GMM)
+#elif defined(HAVE_GMM) && !defined(_OPENMP)
   linearSystemGmm<double> *lsys = new linearSystemGmm<double>;
   lsys->setNoisy(2);
 #else
-  linearSystemFull<double> *lsys = new linearSystemFull<double>;
+  linearSystemCSRKrylov<double> *lsys = new linearSystemCSRKrylov<double>;
+  lsys->setNoisy(1);
+  // the Lagrange multipliers make the system indefinite
+  if(!LagrangeMultiplierFields.empty())
+    lsys->setMethod(linearSystemCSRKrylov<double>::GMRES);
 #endif
   assemble(lsys);
   lsys->systemSolve();
@@ -141,6 +145,14 @@ void thermicSolver::assemble(linearSystem<double> *lsys)
     Assemble(Lterm, *LagSpace, allNeumann[i].g->begin(), allNeumann[i].g->end(),
              Integ_Boundary, *pAssembler);
   }
+  // Sparsity pattern of the bilinear terms, inserted before assembling them
+  for(std::size_t i = 0; i < LagrangeMultiplierFields.size(); i++)
+    SparsityDofs(*LagSpace, *LagrangeMultiplierSpace,
+                 LagrangeMultiplierFields[i].g->begin(),
+                 LagrangeMultiplierFields[i].g->end(), *pAssembler);
+  for(std::size_t i = 0; i < thermicFields.size(); i++)
+    SparsityDofs(*LagSpace, thermicFields[i].g->begin(),
+                 thermicFields[i].g->end(), *pAssembler);
   // Assemble cross term, laplace term and rhs term for LM
   GaussQuadrature Integ_LagrangeMult(GaussQuadrature::ValVal);
   GaussQuadrature Integ_Laplace(GaussQuadrature::GradGrad);
@@ -171,7 +183,8 @@ void thermicSolver::assemble(linearSystem<double> *lsys)
     printf("Thermic Term\n");
     LaplaceTerm<double, double> Tterm(*LagSpace, thermicFields[i]._k);
     Assemble(Tterm, *LagSpace, thermicFields[i].g->begin(),
-             thermicFields[i].g->end(), Integ_Bulk, *pAssembler);
+             thermicFields[i].g->end(), Integ_Bulk, *pAssembler,
+             Msg::GetMaxThreads());
   }
 
   /*for (int i = 0;i<pAssembler->sizeOfR();i++){
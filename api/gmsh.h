@@ -362,6 +362,14 @@ namespace gmsh { // Top-level functions
                              const int tag = -1,
                              const bool includeBoundary = false);
 
+      // Get the version of the mesh of the current model, which changes each time
+      // the mesh is modified. Requests for all the nodes (`getNodes' with `dim' <
+      // 0) or for all the elements of a given type (`getElementsByType' with `tag'
+      // < 0) are served from a contiguous copy of the mesh, built once per mesh
+      // version; repeated queries can thus be skipped altogether as long as the
+      // version does not change.
+      GMSH_API int getVersion();
+
       // Get the coordinates and the parametric coordinates (if any) of the node
       // with tag `tag'. This is a sometimes useful but inefficient way of
       // accessing nodes, as it relies on a cache stored in the model. For large
@@ -494,7 +502,8 @@ namespace gmsh { // Top-level functions
                                       const std::size_t numTasks = 1);
 
       // Preallocate the data for `getElementsByType'. This is necessary only if
-      // `getElementsByType' is called with `numTasks' > 1.
+      // `getElementsByType' is called with `numTasks' > 1, and must then be done
+      // before the (possibly concurrent) calls to `getElementsByType'.
       GMSH_API void preallocateElementsByType(const int elementType,
                                               const bool elementTag,
                                               const bool nodeTag,
@@ -709,11 +718,18 @@ namespace gmsh { // Top-level functions
                                     const int tag,
                                     const std::vector<int> & ordering);
 
-      // Renumber the node tags in a contiunous sequence.
-      GMSH_API void renumberNodes();
-
-      // Renumber the element tags in a contiunous sequence.
-      GMSH_API void renumberElements();
+      // Renumber the node tags in a contiunous sequence. If `method' is "Hilbert",
+      // renumber the nodes of each entity along a Hilbert space-filling curve; if
+      // `method' is "HilbertGlobal", renumber all the nodes along a single Hilbert
+      // curve, ignoring entity boundaries.
+      GMSH_API void renumberNodes(const std::string & method = "");
+
+      // Renumber the element tags in a contiunous sequence. If `method' is
+      // "Hilbert", renumber the elements of each entity along a Hilbert space-
+      // filling curve (using their barycenters); if `method' is "HilbertGlobal",
+      // renumber all the elements along a single Hilbert curve, ignoring entity
+      // boundaries.
+      GMSH_API void renumberElements(const std::string & method = "");
 
       // Set the meshes of the entities of dimension `dim' and tag `tags' as
       // periodic copies of the meshes of entities `tagsSource', using the affine
@@ -953,6 +953,26 @@ function getNodes(dim = -1, tag = -1, includeBoundary = false)
     return nodeTags, coord, parametricCoord
 end
 
+"""
+    gmsh.model.mesh.getVersion()
+
+Get the version of the mesh of the current model, which changes each time the
+mesh is modified. Requests for all the nodes (`getNodes` with `dim` < 0) or for
+all the elements of a given type (`getElementsByType` with `tag` < 0) are served
+from a contiguous copy of the mesh, built once per mesh version; repeated
+queries can thus be skipped altogether as long as the version does not change.
+
+Return an integer value.
+"""
+function getVersion()
+    ierr = Ref{Cint}()
+    api__result__ = ccall((:gmshModelMeshGetVersion, gmsh.lib), Cint,
+          (Ptr{Cint},),
+          ierr)
+    ierr[] != 0 && error("gmshModelMeshGetVersion returned non-zero error code: $(ierr[])")
+    return api__result__
+end
+
 """
     gmsh.model.mesh.getNode(nodeTag)
 
@@ -1263,7 +1283,8 @@ end
     gmsh.model.mesh.preallocateElementsByType(elementType, elementTag, nodeTag, tag = -1)
 
 Preallocate the data for `getElementsByType`. This is necessary only if
-`getElementsByType` is called with `numTasks` > 1.
+`getElementsByType` is called with `numTasks` > 1, and must then be done before
+the (possibly concurrent) calls to `getElementsByType`.
 
 Return `elementTags`, `nodeTags`.
 """
@@ -1708,29 +1729,35 @@ function reorderElements(elementType, tag, ordering)
 end
 
 """
-    gmsh.model.mesh.renumberNodes()
+    gmsh.model.mesh.renumberNodes(method = "")
 
-Renumber the node tags in a contiunous sequence.
+Renumber the node tags in a contiunous sequence. If `method` is "Hilbert",
+renumber the nodes of each entity along a Hilbert space-filling curve; if
+`method` is "HilbertGlobal", renumber all the nodes along a single Hilbert
+curve, ignoring entity boundaries.
 """
-function renumberNodes()
+function renumberNodes(method = "")
     ierr = Ref{Cint}()
     ccall((:gmshModelMeshRenumberNodes, gmsh.lib), Nothing,
-          (Ptr{Cint},),
-          ierr)
+          (Ptr{Cchar}, Ptr{Cint}),
+          method, ierr)
     ierr[] != 0 && error("gmshModelMeshRenumberNodes returned non-zero error code: $(ierr[])")
     return nothing
 end
 
 """
-    gmsh.model.mesh.renumberElements()
+    gmsh.model.mesh.renumberElements(method = "")
 
-Renumber the element tags in a contiunous sequence.
+Renumber the element tags in a contiunous sequence. If `method` is "Hilbert",
+renumber the elements of each entity along a Hilbert space-filling curve (using
+their barycenters); if `method` is "HilbertGlobal", renumber all the elements
+along a single Hilbert curve, ignoring entity boundaries.
 """
-function renumberElements()
+function renumberElements(method = "")
     ierr = Ref{Cint}()
     ccall((:gmshModelMeshRenumberElements, gmsh.lib), Nothing,
-          (Ptr{Cint},),
-          ierr)
+          (Ptr{Cchar}, Ptr{Cint}),
+          method, ierr)
     ierr[] != 0 && error("gmshModelMeshRenumberElements returned non-zero error code: $(ierr[])")
     return nothing
 end
@@ -1174,6 +1174,27 @@ class model:
                 _ovectordouble(api_coord_, api_coord_n_.value),
                 _ovectordouble(api_parametricCoord_, api_parametricCoord_n_.value))
 
+        @staticmethod
+        def getVersion():
+            """
+            Get the version of the mesh of the current model, which changes each time
+            the mesh is modified. Requests for all the nodes (`getNodes' with `dim' <
+            0) or for all the elements of a given type (`getElementsByType' with `tag'
+            < 0) are served from a contiguous copy of the mesh, built once per mesh
+            version; repeated queries can thus be skipped altogether as long as the
+            version does not change.
+
+            Return an integer value.
+            """
+            ierr = c_int()
+            api__result__ = lib.gmshModelMeshGetVersion(
+                byref(ierr))
+            if ierr.value != 0:
+                raise ValueError(
+                    "gmshModelMeshGetVersion returned non-zero error code: ",
+                    ierr.value)
+            return api__result__
+
         @staticmethod
         def getNode(nodeTag):
             """
@@ -1520,7 +1541,8 @@ class model:
         def preallocateElementsByType(elementType, elementTag, nodeTag, tag=-1):
             """
             Preallocate the data for `getElementsByType'. This is necessary only if
-            `getElementsByType' is called with `numTasks' > 1.
+            `getElementsByType' is called with `numTasks' > 1, and must then be done
+            before the (possibly concurrent) calls to `getElementsByType'.
 
             Return `elementTags', `nodeTags'.
             """
@@ -2041,12 +2063,16 @@ class model:
                     ierr.value)
 
         @staticmethod
-        def renumberNodes():
+        def renumberNodes(method=""):
             """
-            Renumber the node tags in a contiunous sequence.
+            Renumber the node tags in a contiunous sequence. If `method' is "Hilbert",
+            renumber the nodes of each entity along a Hilbert space-filling curve; if
+            `method' is "HilbertGlobal", renumber all the nodes along a single Hilbert
+            curve, ignoring entity boundaries.
             """
             ierr = c_int()
             lib.gmshModelMeshRenumberNodes(
+                c_char_p(method.encode()),
                 byref(ierr))
             if ierr.value != 0:
                 raise ValueError(
@@ -2054,12 +2080,17 @@ class model:
                     ierr.value)
 
         @staticmethod
-        def renumberElements():
+        def renumberElements(method=""):
             """
-            Renumber the element tags in a contiunous sequence.
+            Renumber the element tags in a contiunous sequence. If `method' is
+            "Hilbert", renumber the elements of each entity along a Hilbert space-
+            filling curve (using their barycenters); if `method' is "HilbertGlobal",
+            renumber all the elements along a single Hilbert curve, ignoring entity
+            boundaries.
             """
             ierr = c_int()
             lib.gmshModelMeshRenumberElements(
+                c_char_p(method.encode()),
                 byref(ierr))
             if ierr.value != 0:
                 raise ValueError(
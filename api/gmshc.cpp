@@ -694,6 +694,19 @@ GMSH_API void gmshModelMeshGetNodes(size_t ** nodeTags, size_t * nodeTags_n, dou
   }
 }
 
+GMSH_API int gmshModelMeshGetVersion(int * ierr)
+{
+  int result_api_ = 0;
+  if(ierr) *ierr = 0;
+  try {
+    result_api_ = gmsh::model::mesh::getVersion();
+  }
+  catch(int api_ierr_){
+    if(ierr) *ierr = api_ierr_;
+  }
+  return result_api_;
+}
+
 GMSH_API void gmshModelMeshGetNode(const size_t nodeTag, double ** coord, size_t * coord_n, double ** parametricCoord, size_t * parametricCoord_n, int * ierr)
 {
   if(ierr) *ierr = 0;
@@ -1162,22 +1175,22 @@ GMSH_API void gmshModelMeshReorderElements(const int elementType, const int tag,
   }
 }
 
-GMSH_API void gmshModelMeshRenumberNodes(int * ierr)
+GMSH_API void gmshModelMeshRenumberNodes(const char * method, int * ierr)
 {
   if(ierr) *ierr = 0;
   try {
-    gmsh::model::mesh::renumberNodes();
+    gmsh::model::mesh::renumberNodes(method);
   }
   catch(int api_ierr_){
     if(ierr) *ierr = api_ierr_;
   }
 }
 
-GMSH_API void gmshModelMeshRenumberElements(int * ierr)
+GMSH_API void gmshModelMeshRenumberElements(const char * method, int * ierr)
 {
   if(ierr) *ierr = 0;
   try {
-    gmsh::model::mesh::renumberElements();
+    gmsh::model::mesh::renumberElements(method);
   }
   catch(int api_ierr_){
     if(ierr) *ierr = api_ierr_;
@@ -383,6 +383,14 @@ GMSH_API void gmshModelMeshGetNodes(size_t ** nodeTags, size_t * nodeTags_n,
                                     const int includeBoundary,
                                     int * ierr);
 
+/* Get the version of the mesh of the current model, which changes each time
+ * the mesh is modified. Requests for all the nodes (`getNodes' with `dim' <
+ * 0) or for all the elements of a given type (`getElementsByType' with `tag'
+ * < 0) are served from a contiguous copy of the mesh, built once per mesh
+ * version; repeated queries can thus be skipped altogether as long as the
+ * version does not change. */
+GMSH_API int gmshModelMeshGetVersion(int * ierr);
+
 /* Get the coordinates and the parametric coordinates (if any) of the node
  * with tag `tag'. This is a sometimes useful but inefficient way of accessing
  * nodes, as it relies on a cache stored in the model. For large meshes all
@@ -527,7 +535,8 @@ GMSH_API void gmshModelMeshGetElementsByType(const int elementType,
                                              int * ierr);
 
 /* Preallocate the data for `getElementsByType'. This is necessary only if
- * `getElementsByType' is called with `numTasks' > 1. */
+ * `getElementsByType' is called with `numTasks' > 1, and must then be done
+ * before the (possibly concurrent) calls to `getElementsByType'. */
 GMSH_API void gmshModelMeshPreallocateElementsByType(const int elementType,
                                                      const int elementTag,
                                                      const int nodeTag,
@@ -763,11 +772,20 @@ GMSH_API void gmshModelMeshReorderElements(const int elementType,
                                            int * ordering, size_t ordering_n,
                                            int * ierr);
 
-/* Renumber the node tags in a contiunous sequence. */
-GMSH_API void gmshModelMeshRenumberNodes(int * ierr);
+/* Renumber the node tags in a contiunous sequence. If `method' is "Hilbert",
+ * renumber the nodes of each entity along a Hilbert space-filling curve; if
+ * `method' is "HilbertGlobal", renumber all the nodes along a single Hilbert
+ * curve, ignoring entity boundaries. */
+GMSH_API void gmshModelMeshRenumberNodes(const char * method,
+                                         int * ierr);
 
-/* Renumber the element tags in a contiunous sequence. */
-GMSH_API void gmshModelMeshRenumberElements(int * ierr);
+/* Renumber the element tags in a contiunous sequence. If `method' is
+ * "Hilbert", renumber the elements of each entity along a Hilbert space-
+ * filling curve (using their barycenters); if `method' is "HilbertGlobal",
+ * renumber all the elements along a single Hilbert curve, ignoring entity
+ * boundaries. */
+GMSH_API void gmshModelMeshRenumberElements(const char * method,
+                                            int * ierr);
 
 /* Set the meshes of the entities of dimension `dim' and tag `tags' as
  * periodic copies of the meshes of entities `tagsSource', using the affine
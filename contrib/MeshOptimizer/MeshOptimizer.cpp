@@ -467,21 +467,35 @@ namespace {
                            bndElts[iPatch], par);
     }
     if(par.nCurses) displayResultTable(nbPatchSuccess, toOptimize.size());
-    for(int iPatch = 0; iPatch < toOptimize.size(); ++iPatch) {
+
+    // Optimize the patches concurrently. Each optimization works on its own
+    // copy of the vertex positions and of the objective function, and its
+    // result is applied to the mesh in the order of the patches, as soon as
+    // the previous patches are done: the optimized mesh thus does not depend on
+    // the number of threads, and at most one optimization per thread is alive
+    // at a time. With weak merging, patches can share elements and free
+    // vertices, and each patch must start from the mesh updated by the
+    // previous ones: the loop is then serial. The ncurses interface is not
+    // thread-safe and also requires a serial loop, and the detailed output of
+    // each optimization is only printed when running on a single thread.
+    const int nPatch = toOptimize.size();
+    const bool parallel = !par.nCurses && !par.patchDef->weakMerge &&
+                          Msg::GetMaxThreads() > 1;
+    MeshOptParameters patchPar(par);
+    if(parallel) patchPar.verbose = std::min(par.verbose, 2);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) ordered if(parallel)
+#endif
+    for(int iPatch = 0; iPatch < nPatch; ++iPatch) {
       // Initialize optimization and output if asked
       if(par.nCurses) {
         mvbold(true);
         mvprintCenter(10, " PATCH %5i ", iPatch);
         mvbold(false);
       }
-      if(par.verbose > 1)
-        Msg::Info("Optimizing patch %i/%i composed of %i elements, "
-                  "%i boundary elements",
-                  iPatch, toOptimize.size() - 1,
-                  toOptimize[iPatch].first.size(), bndElts[iPatch].size());
       MeshOpt opt(e2eOpt, bndEl2Ent, toOptimize[iPatch].first,
-                  toOptimize[iPatch].second, bndElts[iPatch], par);
-      if(par.verbose > 3) {
+                  toOptimize[iPatch].second, bndElts[iPatch], patchPar);
+      if(patchPar.verbose > 3) {
         std::ostringstream ossI1;
         ossI1 << "initial_patch-" << iPatch << ".msh";
         opt.patch.writeMSH(ossI1.str().c_str());
@@ -489,43 +503,57 @@ namespace {
 
       // Optimize patch
       int success = -1;
-      if(opt.patch.nPC() > 0)
-        success = opt.optimize(par);
-      else if(par.verbose > 1)
-        Msg::Info("Patch %i has no degree of freedom, skipping", iPatch);
+      if(opt.patch.nPC() > 0) success = opt.optimize(patchPar);
 
-      if(par.verbose > 3) {
+      if(patchPar.verbose > 3) {
         std::ostringstream ossI2;
         ossI2 << "final_patch-" << iPatch << ".msh";
         opt.patch.writeMSH(ossI2.str().c_str());
       }
 
-      // Evaluate mesh and update it if (partial) success
+      // Evaluate mesh
       opt.updateResults();
-      if(newObjFunctionRange.size() == 0) {
-        newObjFunctionRange = opt.objFunction()->minMax();
-        objFunctionNames = opt.objFunction()->names();
-      }
-      else {
-        for(int i = 0; i < newObjFunctionRange.size(); i++) {
-          newObjFunctionRange[i].first = std::min(
-            newObjFunctionRange[i].first, opt.objFunction()->minMax()[i].first);
-          newObjFunctionRange[i].second =
-            std::max(newObjFunctionRange[i].second,
-                     opt.objFunction()->minMax()[i].second);
+
+#if defined(_OPENMP)
+#pragma omp ordered
+#endif
+      {
+        if(par.verbose > 1) {
+          Msg::Info("Optimized patch %i/%i composed of %i elements, "
+                    "%i boundary elements",
+                    iPatch, nPatch - 1, toOptimize[iPatch].first.size(),
+                    bndElts[iPatch].size());
+          if(opt.patch.nPC() == 0)
+            Msg::Info("Patch %i has no degree of freedom, skipping", iPatch);
         }
-      }
-      if(success >= 0) opt.patch.updateGEntityPositions();
 
-      //#pragma omp critical
-      par.success = std::min(par.success, success);
+        // Update mesh if (partial) success
+        if(newObjFunctionRange.size() == 0) {
+          newObjFunctionRange = opt.objFunction()->minMax();
+          objFunctionNames = opt.objFunction()->names();
+        }
+        else {
+          for(int i = 0; i < newObjFunctionRange.size(); i++) {
+            newObjFunctionRange[i].first =
+              std::min(newObjFunctionRange[i].first,
+                       opt.objFunction()->minMax()[i].first);
+            newObjFunctionRange[i].second =
+              std::max(newObjFunctionRange[i].second,
+                       opt.objFunction()->minMax()[i].second);
+          }
+        }
+        if(success >= 0) opt.patch.updateGEntityPositions();
 
-      nbPatchSuccess[success + 1]++;
-      if(par.nCurses) {
-        displayMinMaxVal(nbPatchSuccess, objFunctionNames, newObjFunctionRange);
-        displayResultTable(nbPatchSuccess, toOptimize.size());
-        updateDisplayPatchHistory(_patchHistory, opt.objFunction()->minMaxStr(),
-                                  iPatch, -1);
+        par.success = std::min(par.success, success);
+
+        nbPatchSuccess[success + 1]++;
+        if(par.nCurses) {
+          displayMinMaxVal(nbPatchSuccess, objFunctionNames,
+                           newObjFunctionRange);
+          displayResultTable(nbPatchSuccess, toOptimize.size());
+          updateDisplayPatchHistory(_patchHistory,
+                                    opt.objFunction()->minMaxStr(), iPatch, -1);
+        }
       }
     }
     while(_patchHistory.size() > 0) {
@@ -29,6 +29,10 @@
 #include "PViewDataList.h"
 #endif
 
+#if defined(HAVE_ANN)
+#include "ANN/ANN.h"
+#endif
+
 Frame_field::Frame_field() {}
 
 void Frame_field::init_region(GRegion *gr)